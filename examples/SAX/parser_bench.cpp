@@ -0,0 +1,129 @@
+#ifdef _MSC_VER
+#  pragma warning(disable:4786)
+#endif
+
+//////////////////////////////////////////////////
+//
+// Times Garden, Arabica's own parser, against expat_wrapper (when
+// Arabica is built with expat) over the same documents.  Each file is
+// read into memory once and then parsed repeatedly from memory, so the
+// figures are for the parsers alone.  Each parser is timed reading
+// through an istream, and reading the bytes in place as it does for a
+// memory mapped file.
+//
+//   parser_bench [-n iterations] xmlfile ...
+//
+//////////////////////////////////////////////////
+
+#include <SAX/XMLReader.hpp>
+#include <SAX/parsers/saxgarden.hpp>
+#ifdef ARABICA_USE_EXPAT
+#include <SAX/wrappers/saxexpat.hpp>
+#endif
+#include <SAX/InputSource.hpp>
+#include <SAX/helpers/DefaultHandler.hpp>
+#include <SAX/helpers/CatchErrorHandler.hpp>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <ctime>
+
+class CountingHandler : public Arabica::SAX::DefaultHandler<std::string>
+{
+public:
+  CountingHandler() : elements_(0), attributes_(0), characters_(0) { }
+
+  virtual void startElement(const std::string&, const std::string&,
+                            const std::string&, const Arabica::SAX::Attributes<std::string>& atts)
+  {
+    ++elements_;
+    attributes_ += atts.getLength();
+  } // startElement
+
+  virtual void characters(const std::string& ch)
+  {
+    characters_ += ch.length();
+  } // characters
+
+  unsigned long elements_;
+  unsigned long attributes_;
+  unsigned long characters_;
+}; // class CountingHandler
+
+template<class Parser>
+void bench(const char* name, const std::string& document, int iterations, bool inPlace)
+{
+  Parser parser;
+  CountingHandler handler;
+  Arabica::SAX::CatchErrorHandler<std::string> eh;
+  parser.setContentHandler(handler);
+  parser.setErrorHandler(eh);
+
+  std::clock_t start = std::clock();
+  for(int i = 0; i != iterations; ++i)
+  {
+    std::istringstream stream(document);
+    Arabica::SAX::InputSource<std::string> is(stream);
+    if(inPlace)
+      is.setBytes(document.data(), document.size());
+    parser.parse(is);
+  } // for ...
+  double seconds = static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+
+  if(eh.errorsReported())
+  {
+    std::cout << "  " << name << ": " << eh.errors() << std::endl;
+    return;
+  } // if ...
+
+  double megabytes = (static_cast<double>(document.size()) * iterations) / (1024 * 1024);
+  std::cout << "  " << name << ": "
+            << seconds << "s, "
+            << (seconds > 0 ? megabytes / seconds : 0) << " MB/s ("
+            << handler.elements_ / iterations << " elements, "
+            << handler.attributes_ / iterations << " attributes, "
+            << handler.characters_ / iterations << " characters)" << std::endl;
+} // bench
+
+int main(int argc, char* argv[])
+{
+  int iterations = 10;
+  int first = 1;
+  if(argc > 2 && std::string(argv[1]) == "-n")
+  {
+    iterations = std::atoi(argv[2]);
+    first = 3;
+  } // if ...
+
+  if(first >= argc || iterations <= 0)
+  {
+    std::cout << "Usage : " << argv[0] << " [-n iterations] xmlfile ... " << std::endl;
+    return 0;
+  } // if ...
+
+  for(int i = first; i < argc; ++i)
+  {
+    std::ifstream file(argv[i], std::ios::binary);
+    if(!file)
+    {
+      std::cerr << "Couldn't open " << argv[i] << std::endl;
+      continue;
+    } // if ...
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    std::string document = contents.str();
+
+    std::cout << argv[i] << " (" << document.size() << " bytes, " << iterations << " iterations)" << std::endl;
+    bench<Arabica::SAX::Garden<std::string> >("garden (stream)  ", document, iterations, false);
+    bench<Arabica::SAX::Garden<std::string> >("garden (in place)", document, iterations, true);
+#ifdef ARABICA_USE_EXPAT
+    bench<Arabica::SAX::expat_wrapper<std::string> >("expat  (stream)  ", document, iterations, false);
+    bench<Arabica::SAX::expat_wrapper<std::string> >("expat  (in place)", document, iterations, true);
+#endif
+  } // for ...
+
+  return 0;
+} // main
+
+// end of file
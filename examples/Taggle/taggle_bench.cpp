@@ -0,0 +1,200 @@
+#ifdef _MSC_VER
+#pragma warning(disable: 4250)
+#endif
+
+//////////////////////////////////////////////////
+//
+// HTML cleaning throughput.  Each file of the corpus is read into
+// memory once, then run through Taggle repeatedly - once into a handler
+// which only counts what it's given, and once through a Writer, as the
+// taggle example does, to produce well-formed XML.  Then DOMs are
+// built, through SAX2DOM and directly with SAX2DOM::TaggleParser.
+// Totals are given for the whole corpus, followed by timings for the
+// schema's element type and entity lookups on their own.
+//
+//   taggle_bench [-n iterations] htmlfile ...
+//
+//////////////////////////////////////////////////
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cstdlib>
+#include <ctime>
+#include <SAX/filter/Writer.hpp>
+#include <SAX/helpers/DefaultHandler.hpp>
+#include <SAX/helpers/CatchErrorHandler.hpp>
+#include <Taggle/Taggle.hpp>
+#include <DOM/SAX2DOM/SAX2DOM.hpp>
+#include <DOM/SAX2DOM/TaggleParser.hpp>
+
+namespace
+{
+  class CountingHandler : public Arabica::SAX::DefaultHandler<std::string>
+  {
+  public:
+    CountingHandler() : elements_(0), characters_(0) { }
+
+    virtual void startElement(const std::string&, const std::string&,
+                              const std::string&, const Arabica::SAX::Attributes<std::string>&)
+    {
+      ++elements_;
+    } // startElement
+
+    virtual void characters(const std::string& ch)
+    {
+      characters_ += ch.length();
+    } // characters
+
+    unsigned long elements_;
+    unsigned long characters_;
+  }; // class CountingHandler
+
+  double elapsed(std::clock_t start)
+  {
+    return static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+  } // elapsed
+
+  void report(const char* what, double seconds, double bytes)
+  {
+    double megabytes = bytes / (1024 * 1024);
+    std::cout << "  " << what << ": " << seconds << "s, "
+              << (seconds > 0 ? megabytes / seconds : 0) << " MB/s" << std::endl;
+  } // report
+
+  void parse(Arabica::SAX::XMLReaderInterface<std::string, Arabica::default_string_adaptor<std::string> >& reader, const std::string& document)
+  {
+    std::istringstream stream(document);
+    Arabica::SAX::InputSource<std::string> is(stream);
+    reader.parse(is);
+  } // parse
+
+  double bench_scan(const std::vector<std::string>& corpus, int iterations, unsigned long& elements)
+  {
+    Arabica::SAX::Taggle<std::string> parser;
+    CountingHandler handler;
+    parser.setContentHandler(handler);
+
+    std::clock_t start = std::clock();
+    for(int i = 0; i != iterations; ++i)
+      for(size_t d = 0; d != corpus.size(); ++d)
+        parse(parser, corpus[d]);
+    elements = handler.elements_ / iterations;
+    return elapsed(start);
+  } // bench_scan
+
+  double bench_clean(const std::vector<std::string>& corpus, int iterations, size_t& output)
+  {
+    Arabica::SAX::Taggle<std::string> parser;
+    Arabica::SAX::CatchErrorHandler<std::string> eh;
+    output = 0;
+
+    std::clock_t start = std::clock();
+    for(int i = 0; i != iterations; ++i)
+      for(size_t d = 0; d != corpus.size(); ++d)
+      {
+        std::ostringstream sink;
+        Arabica::SAX::Writer<std::string> writer(sink, parser, 0);
+        writer.setErrorHandler(eh);
+        parse(writer, corpus[d]);
+        output += sink.str().length();
+      } // for ...
+    output /= iterations;
+    return elapsed(start);
+  } // bench_clean
+
+  template<class DOMParser>
+  double bench_dom(const std::vector<std::string>& corpus, int iterations)
+  {
+    std::clock_t start = std::clock();
+    for(int i = 0; i != iterations; ++i)
+      for(size_t d = 0; d != corpus.size(); ++d)
+      {
+        DOMParser parser;
+        std::istringstream stream(corpus[d]);
+        Arabica::SAX::InputSource<std::string> is(stream);
+        parser.parse(is);
+      } // for ...
+    return elapsed(start);
+  } // bench_dom
+
+  void bench_lookups(int iterations)
+  {
+    Arabica::SAX::HTMLSchema schema;
+    const char* names[] = { "html", "BODY", "div", "Span", "a", "TD", "tr", "table", "p", "img", "li", "UL", "nosuch", 0 };
+    const char* entities[] = { "amp", "lt", "nbsp", "eacute", "copy", "yuml", "Aring", "nosuch", 0 };
+    std::vector<std::string> elementNames(names, names + 13);
+    std::vector<std::string> entityNames(entities, entities + 8);
+
+    std::cout << "schema lookups" << std::endl;
+    long found = 0;
+    std::clock_t start = std::clock();
+    for(int i = 0; i != iterations; ++i)
+      for(size_t n = 0; n != elementNames.size(); ++n)
+        found += (schema.getElementType(elementNames[n]) == Arabica::SAX::ElementType::Null) ? 0 : 1;
+    double seconds = elapsed(start);
+    std::cout << "  getElementType: " << (seconds * 1e9) / (static_cast<double>(iterations) * elementNames.size()) << " ns each" << std::endl;
+
+    start = std::clock();
+    for(int i = 0; i != iterations; ++i)
+      for(size_t n = 0; n != entityNames.size(); ++n)
+        found += schema.getEntity(entityNames[n]);
+    seconds = elapsed(start);
+    std::cout << "  getEntity:      " << (seconds * 1e9) / (static_cast<double>(iterations) * entityNames.size()) << " ns each" << std::endl;
+
+    if(found == 42)  // keep the optimiser honest
+      std::cout << std::endl;
+  } // bench_lookups
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  int iterations = 10;
+  int first = 1;
+  if(argc > 2 && std::string(argv[1]) == "-n")
+  {
+    iterations = std::atoi(argv[2]);
+    first = 3;
+  } // if ...
+
+  if(first >= argc || iterations <= 0)
+  {
+    std::cout << "Usage : " << argv[0] << " [-n iterations] htmlfile ... " << std::endl;
+    return 0;
+  } // if ...
+
+  std::vector<std::string> corpus;
+  double bytes = 0;
+  for(int i = first; i < argc; ++i)
+  {
+    std::ifstream file(argv[i], std::ios::binary);
+    if(!file)
+    {
+      std::cerr << "Couldn't open " << argv[i] << std::endl;
+      continue;
+    } // if ...
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    corpus.push_back(contents.str());
+    bytes += corpus.back().size();
+  } // for ...
+
+  std::cout << corpus.size() << " documents, " << bytes << " bytes, " << iterations << " iterations" << std::endl;
+  if(!corpus.empty())
+  {
+    unsigned long elements;
+    report("scan ", bench_scan(corpus, iterations, elements), bytes * iterations);
+    size_t output;
+    report("clean", bench_clean(corpus, iterations, output), bytes * iterations);
+    report("SAX2DOM", bench_dom<Arabica::SAX2DOM::Parser<std::string, Arabica::SAX::Taggle<std::string> > >(corpus, iterations), bytes * iterations);
+    report("direct DOM", bench_dom<Arabica::SAX2DOM::TaggleParser<std::string> >(corpus, iterations), bytes * iterations);
+    std::cout << "  " << elements << " elements, " << output << " bytes of XML" << std::endl;
+  } // if ...
+
+  bench_lookups(iterations * 100000);
+
+  return 0;
+} // main
+
+// end of file
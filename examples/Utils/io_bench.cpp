@@ -0,0 +1,221 @@
+//////////////////////////////////////////////////
+//
+// Throughput of the io streams at different buffer sizes.
+//
+// The convert_adaptor figures are for UTF-8 to wchar_t and back through
+// utf8ucs2codecvt.  The socket figures are for reading and writing over
+// a loopback connection to a server forked for the purpose, so they are
+// only available where there are BSD sockets and fork.
+//
+//   io_bench [-m megabytes] [buffersize ...]
+//
+//////////////////////////////////////////////////
+
+#include <SAX/ArabicaConfig.hpp>
+#include <io/convert_adaptor.hpp>
+#include <convert/utf8ucs2codecvt.hpp>
+#ifndef ARABICA_USE_WINSOCK
+#include <io/socket_stream.hpp>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <signal.h>
+#endif
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <ctime>
+
+namespace
+{
+  double elapsed(std::clock_t start)
+  {
+    return static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+  } // elapsed
+
+  void report(const char* what, size_t bufferSize, double megabytes, double seconds)
+  {
+    std::cout << "  " << what << " (buffer " << bufferSize << "): "
+              << seconds << "s, "
+              << (seconds > 0 ? megabytes / seconds : 0) << " MB/s" << std::endl;
+  } // report
+
+#ifndef ARABICA_NO_WCHAR_T
+  typedef Arabica::io::iconvert_adaptor<wchar_t, std::char_traits<wchar_t>, char, std::char_traits<char> > Widener;
+  typedef Arabica::io::oconvert_adaptor<wchar_t, std::char_traits<wchar_t>, char, std::char_traits<char> > Narrower;
+
+  void bench_convert(const std::string& utf8, size_t bufferSize)
+  {
+    double megabytes = static_cast<double>(utf8.size()) / (1024 * 1024);
+
+    std::istringstream in(utf8);
+    Widener widener(in, bufferSize);
+    widener.imbue(std::locale(widener.getloc(), new Arabica::convert::utf8ucs2codecvt()));
+    std::vector<wchar_t> wide(utf8.size());
+    std::clock_t start = std::clock();
+    widener.read(&wide[0], static_cast<std::streamsize>(wide.size()));
+    wide.resize(static_cast<size_t>(widener.gcount()));
+    report("convert in ", bufferSize, megabytes, elapsed(start));
+
+    std::ostringstream out;
+    start = std::clock();
+    {
+      Narrower narrower(out, bufferSize);
+      narrower.imbue(std::locale(narrower.getloc(), new Arabica::convert::utf8ucs2codecvt()));
+      narrower.write(&wide[0], static_cast<std::streamsize>(wide.size()));
+    }
+    report("convert out", bufferSize, megabytes, elapsed(start));
+
+    if(out.str() != utf8)
+      std::cout << "  round trip failed!" << std::endl;
+  } // bench_convert
+#endif
+
+#ifndef ARABICA_USE_WINSOCK
+  // the socket figures are wall clock time, as the work is shared with
+  // the server and the kernel
+  double now()
+  {
+    timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+  } // now
+
+  // Accepts one connection on listener and either sends size bytes
+  // down it, or reads until the client closes.
+  pid_t serve(int listener, size_t size, bool send)
+  {
+    pid_t pid = fork();
+    if(pid != 0)
+      return pid;
+
+    int conn = accept(listener, 0, 0);
+    std::vector<char> buffer(256 * 1024, 'x');
+    if(send)
+      for(size_t sent = 0; sent < size; )
+      {
+        ssize_t n = write(conn, &buffer[0], std::min(buffer.size(), size - sent));
+        if(n <= 0)
+          break;
+        sent += n;
+      } // for ...
+    else
+      while(read(conn, &buffer[0], buffer.size()) > 0)
+        ;
+    close(conn);
+    _exit(0);
+  } // serve
+
+  int listen_on_loopback(unsigned short& port)
+  {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    addr.sin_port = 0;
+    socklen_t length = sizeof(addr);
+    if((listener == -1) ||
+       (bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) ||
+       (listen(listener, 1) != 0) ||
+       (getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &length) != 0))
+      return -1;
+    port = ntohs(addr.sin_port);
+    return listener;
+  } // listen_on_loopback
+
+  void bench_socket(size_t size, size_t bufferSize)
+  {
+    double megabytes = static_cast<double>(size) / (1024 * 1024);
+    unsigned short port;
+    int listener = listen_on_loopback(port);
+    if(listener == -1)
+    {
+      std::cout << "  couldn't listen on loopback" << std::endl;
+      return;
+    } // if ...
+
+    // reading, in the same size pieces as the parsers ask for
+    {
+      pid_t server = serve(listener, size, true);
+      Arabica::io::socketstream stream("127.0.0.1", port, bufferSize);
+      std::vector<char> chunk(16 * 1024);
+      size_t got = 0;
+      double start = now();
+      while(stream.read(&chunk[0], static_cast<std::streamsize>(chunk.size())) || stream.gcount())
+        got += static_cast<size_t>(stream.gcount());
+      report("socket read ", bufferSize, megabytes, now() - start);
+      if(got != size)
+        std::cout << "  only read " << got << " bytes!" << std::endl;
+      waitpid(server, 0, 0);
+    }
+
+    // writing, a line at a time
+    {
+      pid_t server = serve(listener, size, false);
+      std::string line(79, 'x');
+      line += '\n';
+      double start = now();
+      {
+        Arabica::io::socketstream stream("127.0.0.1", port, bufferSize);
+        for(size_t sent = 0; sent < size; sent += line.size())
+          stream << line;
+        stream.flush();
+      }
+      waitpid(server, 0, 0);
+      report("socket write", bufferSize, megabytes, now() - start);
+    }
+
+    close(listener);
+  } // bench_socket
+#endif
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  size_t megabytes = 32;
+  std::vector<size_t> bufferSizes;
+  for(int i = 1; i < argc; ++i)
+  {
+    std::string arg(argv[i]);
+    if(arg == "-m" && i + 1 < argc)
+      megabytes = std::atoi(argv[++i]);
+    else if(std::atoi(argv[i]) > 0)
+      bufferSizes.push_back(std::atoi(argv[i]));
+    else
+    {
+      std::cout << "Usage : " << argv[0] << " [-m megabytes] [buffersize ...]" << std::endl;
+      return 0;
+    } // if ...
+  } // for ...
+  if(bufferSizes.empty())
+  {
+    bufferSizes.push_back(1024);
+    bufferSizes.push_back(16 * 1024);
+    bufferSizes.push_back(64 * 1024);
+  } // if ...
+
+  size_t size = megabytes * 1024 * 1024;
+
+#ifndef ARABICA_NO_WCHAR_T
+  std::string utf8;
+  utf8.reserve(size);
+  while(utf8.size() + 16 < size)
+    utf8 += "h\xC3\xA9llo w\xE2\x82\xACrld ";
+  std::cout << "convert_adaptor, " << utf8.size() << " bytes" << std::endl;
+  for(size_t i = 0; i != bufferSizes.size(); ++i)
+    bench_convert(utf8, bufferSizes[i]);
+#endif
+
+#ifndef ARABICA_USE_WINSOCK
+  signal(SIGPIPE, SIG_IGN);
+  std::cout << "socketstream, " << size << " bytes" << std::endl;
+  for(size_t i = 0; i != bufferSizes.size(); ++i)
+    bench_socket(size, bufferSizes[i]);
+#endif
+
+  return 0;
+} // main
+
+// end of file
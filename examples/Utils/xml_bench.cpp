@@ -0,0 +1,511 @@
+#ifdef _MSC_VER
+#pragma warning(disable: 4786 4250 4503)
+#endif
+
+//////////////////////////////////////////////////
+//
+// Generates documents of a given shape and size, then times, for each
+//   - parsing with each SAX parser Arabica is built with, in events/s
+//   - building a DOM with SAX2DOM, checked and trusted, and the memory
+//     the DOM takes up for each node in it
+//   - XPath expressions walking each axis, with and without predicates
+//   - writing the DOM out again, through DOM::io's operator<< and through
+//     DOM::Writer
+//
+// The shapes are
+//   deep        long chains of nested elements
+//   wide        one element with many small children
+//   attributes  elements carrying lots of attributes
+//   text        paragraphs of text, with markup and entity references
+//   namespaces  elements and attributes spread across namespaces
+//
+// The documents are made from a seeded generator of our own, so a size
+// and seed give the same documents on every platform.  Times are the
+// best of the iterations.  -o writes every figure as CSV, to compare
+// one build against another.
+//
+//   xml_bench [-n iterations] [-size elements] [-seed seed] [-o results.csv] [shape ...]
+//
+//////////////////////////////////////////////////
+
+#include <SAX/XMLReader.hpp>
+#include <SAX/parsers/saxgarden.hpp>
+#ifdef ARABICA_USE_EXPAT
+#include <SAX/wrappers/saxexpat.hpp>
+#endif
+#ifdef ARABICA_USE_LIBXML2
+#include <SAX/wrappers/saxlibxml2.hpp>
+#endif
+#include <SAX/InputSource.hpp>
+#include <SAX/helpers/DefaultHandler.hpp>
+#include <SAX/helpers/CatchErrorHandler.hpp>
+#include <DOM/SAX2DOM/SAX2DOM.hpp>
+#include <DOM/io/Stream.hpp>
+#include <DOM/io/Writer.hpp>
+#include <XPath/XPath.hpp>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <new>
+#include <cstdlib>
+#include <chrono>
+
+namespace
+{
+  // the bytes currently allocated, and the most there have been
+  std::size_t live = 0;
+
+  // each block carries its size in front of it
+  const std::size_t header = 16;
+} // namespace
+
+void* operator new(std::size_t size)
+{
+  char* p = static_cast<char*>(std::malloc(size + header));
+  if(p == 0)
+    throw std::bad_alloc();
+  *reinterpret_cast<std::size_t*>(p) = size;
+  live += size;
+  return p + header;
+} // operator new
+
+void* operator new[](std::size_t size)
+{
+  return operator new(size);
+} // operator new[]
+
+void operator delete(void* p) throw()
+{
+  if(p == 0)
+    return;
+  char* block = static_cast<char*>(p) - header;
+  live -= *reinterpret_cast<std::size_t*>(block);
+  std::free(block);
+} // operator delete
+
+void operator delete[](void* p) throw()
+{
+  operator delete(p);
+} // operator delete[]
+
+void operator delete(void* p, std::size_t) throw()
+{
+  operator delete(p);
+} // operator delete
+
+void operator delete[](void* p, std::size_t) throw()
+{
+  operator delete(p);
+} // operator delete[]
+
+namespace
+{
+  typedef Arabica::DOM::Document<std::string> Document;
+  typedef Arabica::DOM::Node<std::string> Node;
+  typedef std::chrono::steady_clock Clock;
+
+  double since(Clock::time_point start)
+  {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+  } // since
+
+  // A linear congruential generator, giving the same numbers everywhere
+  class Random
+  {
+  public:
+    Random(unsigned long seed) : state_(seed & 0x7fffffffUL) { }
+
+    int below(int n)
+    {
+      state_ = (state_ * 1103515245UL + 12345UL) & 0x7fffffffUL;
+      return static_cast<int>((state_ >> 16) % static_cast<unsigned long>(n));
+    } // below
+
+    int between(int low, int high)
+    {
+      return low + below(high - low + 1);
+    } // between
+
+    const char* word()
+    {
+      static const char* words[] = { "alpha", "bravo", "charlie", "delta", "echo", "foxtrot",
+                                     "golf", "hotel", "india", "juliet", "kilo", "lima",
+                                     "mike", "november", "oscar", "papa" };
+      return words[below(16)];
+    } // word
+
+  private:
+    unsigned long state_;
+  }; // class Random
+
+  void generateDeep(std::ostream& doc, Random& random, int size)
+  {
+    doc << "<root>";
+    for(int elements = 0; elements < size; )
+    {
+      int depth = random.between(50, 200);
+      for(int d = 0; d != depth; ++d, ++elements)
+        doc << "<d" << (d % 8) << '>';
+      doc << random.word();
+      for(int d = depth; d != 0; --d)
+        doc << "</d" << ((d - 1) % 8) << '>';
+    } // for ...
+    doc << "</root>";
+  } // generateDeep
+
+  void generateWide(std::ostream& doc, Random& random, int size)
+  {
+    doc << "<root>";
+    for(int i = 0; i != size; ++i)
+      doc << "<item n='" << i << "'>" << random.word() << "</item>";
+    doc << "</root>";
+  } // generateWide
+
+  void generateAttributes(std::ostream& doc, Random& random, int size)
+  {
+    doc << "<root>";
+    for(int i = 0; i != size; ++i)
+    {
+      doc << "<e";
+      for(int a = random.between(8, 24); a != 0; --a)
+        doc << " a" << a << "='" << random.word() << ' ' << random.below(1000) << '\'';
+      doc << "/>";
+    } // for ...
+    doc << "</root>";
+  } // generateAttributes
+
+  void generateText(std::ostream& doc, Random& random, int size)
+  {
+    doc << "<root>";
+    for(int elements = 0; elements < size; ++elements)
+    {
+      doc << "<p>";
+      for(int w = random.between(20, 200); w != 0; --w)
+      {
+        switch(random.below(20))
+        {
+          case 0: doc << "<b>" << random.word() << "</b> "; ++elements; break;
+          case 1: doc << random.word() << " &amp; "; break;
+          case 2: doc << random.word() << " &lt;" << random.word() << "&gt; "; break;
+          default: doc << random.word() << ' '; break;
+        } // switch
+      } // for ...
+      doc << "</p>\n";
+    } // for ...
+    doc << "</root>";
+  } // generateText
+
+  void generateNamespaces(std::ostream& doc, Random& random, int size)
+  {
+    doc << "<root xmlns='urn:bench:default'";
+    for(int n = 0; n != 4; ++n)
+      doc << " xmlns:ns" << n << "='urn:bench:" << n << '\'';
+    doc << '>';
+    for(int i = 0; i < size; i += 4)
+    {
+      int p = random.below(4);
+      doc << "<ns" << p << ":group";
+      if(i % 40 == 0)
+        doc << " xmlns='urn:bench:" << i << "' xmlns:ns" << p << "='urn:bench:inner'";
+      doc << " ns" << random.below(4) << ":id='" << i << "'>";
+      for(int c = 0; c != 3; ++c)
+        doc << "<entry ns" << random.below(4) << ":kind='" << random.word() << "'>" << random.word() << "</entry>";
+      doc << "</ns" << p << ":group>";
+    } // for ...
+    doc << "</root>";
+  } // generateNamespaces
+
+  class CountingHandler : public Arabica::SAX::DefaultHandler<std::string>
+  {
+  public:
+    CountingHandler() : events_(0) { }
+
+    virtual void startPrefixMapping(const std::string&, const std::string&) { ++events_; }
+    virtual void startElement(const std::string&, const std::string&,
+                              const std::string&, const Arabica::SAX::Attributes<std::string>& atts)
+    {
+      events_ += 1 + atts.getLength();
+    } // startElement
+    virtual void endElement(const std::string&, const std::string&, const std::string&) { ++events_; }
+    virtual void characters(const std::string&) { ++events_; }
+    virtual void ignorableWhitespace(const std::string&) { ++events_; }
+
+    unsigned long events_;
+  }; // class CountingHandler
+
+  class Report
+  {
+  public:
+    Report(std::ostream* csv) : csv_(csv) { }
+
+    void shape(const std::string& shape) { shape_ = shape; }
+
+    void operator()(const std::string& phase, const std::string& name, double value, const std::string& unit)
+    {
+      std::cout << "  " << phase << ' ' << name << ": " << value << ' ' << unit << std::endl;
+      if(csv_)
+        *csv_ << shape_ << ',' << phase << ",\"" << name << "\"," << value << ',' << unit << '\n';
+    } // operator()
+
+  private:
+    std::ostream* csv_;
+    std::string shape_;
+  }; // class Report
+
+  template<class Parser>
+  void saxBench(const char* name, const std::string& document, int iterations, Report& report)
+  {
+    Parser parser;
+    Arabica::SAX::CatchErrorHandler<std::string> eh;
+    parser.setErrorHandler(eh);
+
+    double best = 0;
+    unsigned long events = 0;
+    for(int i = 0; i != iterations; ++i)
+    {
+      CountingHandler handler;
+      parser.setContentHandler(handler);
+      std::istringstream stream(document);
+      Arabica::SAX::InputSource<std::string> is(stream);
+      Clock::time_point start = Clock::now();
+      parser.parse(is);
+      double seconds = since(start);
+      if(i == 0 || seconds < best)
+        best = seconds;
+      events = handler.events_;
+    } // for ...
+
+    if(eh.errorsReported())
+    {
+      std::cout << "  sax " << name << ": " << eh.errors() << std::endl;
+      return;
+    } // if ...
+    report("sax", name, best > 0 ? events / best : 0, "events/s");
+    report("sax", name, best > 0 ? document.size() / (best * 1024 * 1024) : 0, "MB/s");
+  } // saxBench
+
+  Document build(const std::string& document, bool trusted)
+  {
+    Arabica::SAX2DOM::Parser<std::string> parser;
+    parser.setTrusted(trusted);
+    std::istringstream stream(document);
+    Arabica::SAX::InputSource<std::string> is(stream);
+    parser.parse(is);
+    return parser.getDocument();
+  } // build
+
+  unsigned long countNodes(const Node& node)
+  {
+    unsigned long count = 1;
+    if(node.hasAttributes())
+      count += node.getAttributes().getLength();
+    for(Node c = node.getFirstChild(); c != 0; c = c.getNextSibling())
+      count += countNodes(c);
+    return count;
+  } // countNodes
+
+  Document domBench(const std::string& document, int iterations, Report& report)
+  {
+    Document result;
+    double best[2] = { 0, 0 };
+    std::size_t memory = 0;
+    for(int trusted = 0; trusted != 2; ++trusted)
+      for(int i = 0; i != iterations; ++i)
+      {
+        std::size_t before = live;
+        Clock::time_point start = Clock::now();
+        Document d = build(document, trusted != 0);
+        double seconds = since(start);
+        if(i == 0 || seconds < best[trusted])
+          best[trusted] = seconds;
+        memory = live - before;
+        if(!trusted)
+          result = d;
+      } // for ...
+
+    unsigned long nodes = countNodes(result);
+    report("dom", "build", best[0] * 1000, "ms");
+    report("dom", "build trusted", best[1] * 1000, "ms");
+    report("dom", "nodes", nodes, "nodes");
+    report("dom", "memory", nodes ? static_cast<double>(memory) / nodes : 0, "bytes/node");
+    return result;
+  } // domBench
+
+  void xpathBench(const Document& document, int iterations, Report& report)
+  {
+    static const char* expressions[] = {
+      "count(/*/*)",
+      "count(//*)",
+      "count(//@*)",
+      "count(//text())",
+      "count(//text()/ancestor::*)",
+      "count(/*/*/following-sibling::*[1])",
+      "count(//*[@*])",
+      "count(//*[2])",
+      "count(//*[last()])",
+      "count(//*[. = 'alpha'])",
+      "count(//*[starts-with(local-name(), 'e')])",
+      "string-length(normalize-space(/))",
+      0 };
+
+    Arabica::XPath::XPath<std::string> compiler;
+    for(const char** e = expressions; *e != 0; ++e)
+    {
+      Arabica::XPath::XPathExpression<std::string> expr = compiler.compile_expr(*e);
+      double best = 0;
+      double value = 0;
+      for(int i = 0; i != iterations; ++i)
+      {
+        Clock::time_point start = Clock::now();
+        value = expr.evaluateAsNumber(document);
+        double seconds = since(start);
+        if(i == 0 || seconds < best)
+          best = seconds;
+      } // for ...
+      std::ostringstream name;
+      name << *e << " = " << value;
+      report("xpath", name.str(), best * 1000, "ms");
+    } // for ...
+  } // xpathBench
+
+  typedef Arabica::DOM::Writer<std::string> Writer;
+
+  // options -1 is operator<<
+  std::string write(const Document& document, int options, int iterations, double& best)
+  {
+    std::string written;
+    for(int i = 0; i != iterations; ++i)
+    {
+      std::ostringstream out;
+      Clock::time_point start = Clock::now();
+      if(options == -1)
+        out << document;
+      else
+      {
+        Writer writer(out, options);
+        writer.write(document);
+      } // if ...
+      double seconds = since(start);
+      if(i == 0 || seconds < best)
+        best = seconds;
+      written = out.str();
+    } // for ...
+    return written;
+  } // write
+
+  void writeBench(const Document& document, int iterations, Report& report)
+  {
+    static const struct { const char* name; int options; } writers[] = {
+      { "operator<<", -1 },
+      { "Writer sorted", Writer::sort_attributes },
+      { "Writer", Writer::compact },
+      { "Writer pretty", Writer::pretty },
+      { 0, 0 } };
+
+    for(int w = 0; writers[w].name != 0; ++w)
+    {
+      double best = 0;
+      std::string written = write(document, writers[w].options, iterations, best);
+      report("write", writers[w].name, best > 0 ? written.size() / (best * 1024 * 1024) : 0, "MB/s");
+    } // for ...
+  } // writeBench
+
+  typedef void (*Generator)(std::ostream&, Random&, int);
+
+  struct Shape
+  {
+    const char* name;
+    Generator generate;
+  }; // struct Shape
+
+  const Shape shapes[] = {
+    { "deep", generateDeep },
+    { "wide", generateWide },
+    { "attributes", generateAttributes },
+    { "text", generateText },
+    { "namespaces", generateNamespaces },
+    { 0, 0 } };
+
+  void usage(const char* name)
+  {
+    std::cout << "xml_bench times SAX, DOM and XPath over generated documents\n"
+              << name << " [-n iterations] [-size elements] [-seed seed] [-o results.csv] [shape ...]\n"
+              << "  shapes are deep, wide, attributes, text and namespaces" << std::endl;
+  } // usage
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  int iterations = 5;
+  int size = 20000;
+  unsigned long seed = 1;
+  std::string results;
+  std::vector<std::string> wanted;
+  for(int i = 1; i < argc; ++i)
+  {
+    std::string arg(argv[i]);
+    if(arg == "-n" && i + 1 < argc)
+      iterations = std::atoi(argv[++i]);
+    else if(arg == "-size" && i + 1 < argc)
+      size = std::atoi(argv[++i]);
+    else if(arg == "-seed" && i + 1 < argc)
+      seed = std::strtoul(argv[++i], 0, 10);
+    else if(arg == "-o" && i + 1 < argc)
+      results = argv[++i];
+    else if(arg[0] != '-')
+      wanted.push_back(arg);
+    else
+    {
+      usage(argv[0]);
+      return 0;
+    } // if ...
+  } // for ...
+  if(iterations <= 0 || size <= 0)
+  {
+    usage(argv[0]);
+    return 0;
+  } // if ...
+
+  std::ofstream csv;
+  if(!results.empty())
+  {
+    csv.open(results.c_str());
+    csv << "shape,phase,name,value,unit\n";
+  } // if ...
+  Report report(csv.is_open() ? &csv : 0);
+
+  for(const Shape* shape = shapes; shape->name != 0; ++shape)
+  {
+    bool run = wanted.empty();
+    for(size_t w = 0; w != wanted.size(); ++w)
+      run = run || (wanted[w] == shape->name);
+    if(!run)
+      continue;
+
+    Random random(seed);
+    std::ostringstream generated;
+    shape->generate(generated, random, size);
+    std::string document = generated.str();
+
+    std::cout << shape->name << " (" << document.size() << " bytes, seed " << seed << ")" << std::endl;
+    report.shape(shape->name);
+
+    saxBench<Arabica::SAX::Garden<std::string> >("garden", document, iterations, report);
+#ifdef ARABICA_USE_EXPAT
+    saxBench<Arabica::SAX::expat_wrapper<std::string> >("expat", document, iterations, report);
+#endif
+#ifdef ARABICA_USE_LIBXML2
+    saxBench<Arabica::SAX::libxml2_wrapper<std::string> >("libxml2", document, iterations, report);
+#endif
+
+    Document dom = domBench(document, iterations, report);
+    xpathBench(dom, iterations, report);
+    writeBench(dom, iterations, report);
+  } // for ...
+
+  return 0;
+} // main
+
+// end of file
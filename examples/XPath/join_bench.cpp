@@ -0,0 +1,104 @@
+#ifdef _MSC_VER
+#pragma warning(disable: 4786 4250 4503)
+#endif
+
+//////////////////////////////////////////////////
+//
+// Times joins between node-sets - predicates which compare each node
+// against a node-set found from the root - as the document grows.
+// With the inner side evaluated once and hashed, the time should go
+// up in proportion to the size, not its square.
+//
+//   join_bench [-n iterations] [size ...]
+//
+//////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <ctime>
+#include <DOM/SAX2DOM/SAX2DOM.hpp>
+#include <XPath/XPath.hpp>
+
+namespace
+{
+  double elapsed(std::clock_t start)
+  {
+    return static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+  } // elapsed
+
+  Arabica::DOM::Document<std::string> build(int size)
+  {
+    // every third customer is a vip
+    std::ostringstream doc;
+    doc << "<shop><vips>";
+    for(int v = 0; v < size; v += 3)
+      doc << "<vip id='c" << v << "' limit='" << (v % 50) << "'/>";
+    doc << "</vips><orders>";
+    for(int o = 0; o != size; ++o)
+      doc << "<order total='" << (o % 97) << "'><customer id='c" << o << "'/></order>";
+    doc << "</orders></shop>";
+
+    Arabica::SAX2DOM::Parser<std::string> domParser;
+    std::istringstream stream(doc.str());
+    Arabica::SAX::InputSource<std::string> is(stream);
+    domParser.parse(is);
+    return domParser.getDocument();
+  } // build
+
+  void bench(const Arabica::DOM::Document<std::string>& document, const char* xpath, int iterations)
+  {
+    Arabica::XPath::XPath<std::string> compiler;
+    Arabica::XPath::XPathExpression<std::string> expr = compiler.compile_expr(xpath);
+
+    double count = 0;
+    std::clock_t start = std::clock();
+    for(int i = 0; i != iterations; ++i)
+      count = expr.evaluateAsNumber(document);
+    double seconds = elapsed(start);
+
+    std::cout << "  " << xpath << ": " << count << " in "
+              << (iterations > 0 ? (seconds * 1e3) / iterations : 0) << " ms" << std::endl;
+  } // bench
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  int iterations = 10;
+  std::vector<int> sizes;
+  for(int i = 1; i < argc; ++i)
+  {
+    std::string arg(argv[i]);
+    if(arg == "-n" && i + 1 < argc)
+      iterations = std::atoi(argv[++i]);
+    else if(std::atoi(argv[i]) > 0)
+      sizes.push_back(std::atoi(argv[i]));
+    else
+    {
+      std::cout << "Usage : " << argv[0] << " [-n iterations] [size ...]" << std::endl;
+      return 0;
+    } // if ...
+  } // for ...
+  if(sizes.empty())
+  {
+    sizes.push_back(1000);
+    sizes.push_back(2000);
+    sizes.push_back(4000);
+  } // if ...
+
+  for(size_t s = 0; s != sizes.size(); ++s)
+  {
+    std::cout << sizes[s] << " orders" << std::endl;
+    Arabica::DOM::Document<std::string> document = build(sizes[s]);
+    bench(document, "count(//order[customer/@id = //vip/@id])", iterations);
+    bench(document, "count(//order[customer/@id != /shop/vips/vip/@id])", iterations);
+    bench(document, "count(//order[@total > //vip/@limit])", iterations);
+    bench(document, "count(//order[//vip/@limit = @total])", iterations);
+  } // for ...
+
+  return 0;
+} // main
+
+// end of file
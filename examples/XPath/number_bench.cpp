@@ -0,0 +1,167 @@
+#ifdef _MSC_VER
+#pragma warning(disable: 4786 4250 4503)
+#endif
+
+//////////////////////////////////////////////////
+//
+// Microbenchmarks for XPath's string to number and number to string
+// conversions, timed against the boost::lexical_cast route they replace,
+// and a predicate which compares mixed numeric and non-numeric attributes.
+//
+//   number_bench [-n iterations]
+//
+//////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <ctime>
+#include <boost/lexical_cast.hpp>
+#include <DOM/SAX2DOM/SAX2DOM.hpp>
+#include <XPath/XPath.hpp>
+
+namespace
+{
+  typedef Arabica::default_string_adaptor<std::string> SA;
+
+  double elapsed(std::clock_t start)
+  {
+    return static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+  } // elapsed
+
+  void report(const char* what, double seconds, long operations)
+  {
+    std::cout << "  " << what << ": " << seconds << "s, "
+              << (seconds > 0 ? (seconds * 1e9) / operations : 0) << " ns each" << std::endl;
+  } // report
+
+  // how stringAsNumber used to do it
+  double lexicalNumber(const std::string& str)
+  {
+    try {
+      std::string n_str = Arabica::text::normalize_whitespace<std::string, SA>(str);
+      if(n_str.find('+') == 0)
+        return Arabica::XPath::NaN;
+      return boost::lexical_cast<double>(n_str);
+    } // try
+    catch(const boost::bad_lexical_cast&) {
+      return Arabica::XPath::NaN;
+    } // catch
+  } // lexicalNumber
+
+  void bench_parse(const char* what, const std::vector<std::string>& strings, int iterations)
+  {
+    std::cout << what << std::endl;
+    long operations = static_cast<long>(strings.size()) * iterations;
+    double sum = 0;
+
+    std::clock_t start = std::clock();
+    for(int i = 0; i != iterations; ++i)
+      for(size_t s = 0; s != strings.size(); ++s)
+        sum += Arabica::XPath::impl::stringAsNumber<std::string, SA>(strings[s]);
+    report("stringAsNumber", elapsed(start), operations);
+
+    start = std::clock();
+    for(int i = 0; i != iterations; ++i)
+      for(size_t s = 0; s != strings.size(); ++s)
+        sum += lexicalNumber(strings[s]);
+    report("lexical_cast  ", elapsed(start), operations);
+
+    if(sum == 42)  // keep the optimiser honest
+      std::cout << std::endl;
+  } // bench_parse
+
+  void bench_format(const std::vector<double>& numbers, int iterations)
+  {
+    std::cout << "format " << numbers.size() << " numbers" << std::endl;
+    long operations = static_cast<long>(numbers.size()) * iterations;
+    size_t length = 0;
+
+    std::clock_t start = std::clock();
+    for(int i = 0; i != iterations; ++i)
+      for(size_t n = 0; n != numbers.size(); ++n)
+        length += Arabica::XPath::NumericValue<std::string, SA>(numbers[n]).asString().length();
+    report("NumericValue::asString", elapsed(start), operations);
+
+    start = std::clock();
+    for(int i = 0; i != iterations; ++i)
+      for(size_t n = 0; n != numbers.size(); ++n)
+        length += boost::lexical_cast<std::string>(numbers[n]).length();
+    report("lexical_cast          ", elapsed(start), operations);
+
+    if(length == 42)
+      std::cout << std::endl;
+  } // bench_format
+
+  void bench_predicate(int iterations)
+  {
+    // half the prices are numbers, half are not
+    std::ostringstream doc;
+    doc << "<items>";
+    for(int i = 0; i != 1000; ++i)
+      if(i % 2)
+        doc << "<item price='" << (i % 37) << ".99'/>";
+      else
+        doc << "<item price='n/a'/>";
+    doc << "</items>";
+
+    Arabica::SAX2DOM::Parser<std::string> domParser;
+    std::istringstream stream(doc.str());
+    Arabica::SAX::InputSource<std::string> is(stream);
+    domParser.parse(is);
+    Arabica::DOM::Document<std::string> document = domParser.getDocument();
+
+    Arabica::XPath::XPath<std::string> xpath;
+    Arabica::XPath::XPathExpression<std::string> expr = xpath.compile_expr("count(//item[@price > 10])");
+
+    std::cout << "//item[@price > 10] over 1000 items, half non-numeric" << std::endl;
+    double count = 0;
+    std::clock_t start = std::clock();
+    for(int i = 0; i != iterations; ++i)
+      count = expr.evaluateAsNumber(document);
+    report("evaluate", elapsed(start), iterations);
+    std::cout << "  matched " << count << std::endl;
+  } // bench_predicate
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  int iterations = 1000;
+  for(int i = 1; i < argc; ++i)
+  {
+    std::string arg(argv[i]);
+    if(arg == "-n" && i + 1 < argc)
+      iterations = std::atoi(argv[++i]);
+    else
+    {
+      std::cout << "Usage : " << argv[0] << " [-n iterations]" << std::endl;
+      return 0;
+    } // if ...
+  } // for ...
+
+  std::vector<std::string> numeric;
+  std::vector<std::string> nonNumeric;
+  std::vector<double> numbers;
+  std::srand(1);
+  for(int i = 0; i != 1000; ++i)
+  {
+    std::ostringstream s;
+    s << (std::rand() % 100000) << "." << (std::rand() % 100);
+    numeric.push_back(s.str());
+    nonNumeric.push_back(i % 2 ? "n/a" : " 12 apples ");
+
+    numbers.push_back(std::rand() % 1000);
+    numbers.push_back(static_cast<double>(std::rand()) / RAND_MAX * 1000);
+  } // for ...
+
+  bench_parse("parse 1000 numeric strings", numeric, iterations);
+  bench_parse("parse 1000 non-numeric strings", nonNumeric, iterations / 10);
+  bench_format(numbers, iterations / 2);
+  bench_predicate(iterations / 10);
+
+  return 0;
+} // main
+
+// end of file
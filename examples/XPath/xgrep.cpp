@@ -2,84 +2,294 @@
 #pragma warning(disable: 4786 4250 4503)
 #endif
 
+//////////////////////////////////////////////////
+//
+// Evaluates an XPath expression against each of a list of files, on as
+// many threads as asked for.  The expression is compiled once and shared;
+// each thread parses with a parser of its own.  Results come out in the
+// order the files were given, or as each file is finished with -u.  With
+// -b nothing is printed but how quickly the files went through.
+//
+//   xgrep [-j jobs] [-u] [-b] xpath xmlfile ...
+//
+//////////////////////////////////////////////////
+
 #include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 #include <SAX/helpers/CatchErrorHandler.hpp>
 #include <DOM/SAX2DOM/SAX2DOM.hpp>
 #include <DOM/io/Stream.hpp>
 #include <XPath/XPath.hpp>
 
-////////////////////////////////////////////////
-int main(int argc, char* argv[])
+namespace
 {
-  if(argc < 3) 
+  struct Options
   {
-    std::cout << "Usage : " << argv[0] << " xpath xmlfile ... " << std::endl;
-    return 0;
-  } // if(argc < 3)
+    Options() : jobs(0), ordered(true), benchmark(false) { }
 
-  Arabica::XPath::XPath<std::string> xpathParser;
-  Arabica::XPath::XPathExpressionPtr<std::string> xpath;
-  try {
-    //xpath = xpathParser.compile(argv[1]);
-    xpath = xpathParser.compile_expr(argv[1]);
-  }
-  catch(const std::runtime_error& error) {
-    std::cout << "XPath compilation error: " << error.what() << std::endl;
-    return 0;
-  }
-  
-  
-  Arabica::SAX2DOM::Parser<std::string> domParser;
-  Arabica::SAX::CatchErrorHandler<std::string> eh;
-  domParser.setErrorHandler(eh);
+    unsigned int jobs;
+    bool ordered;
+    bool benchmark;
+  }; // struct Options
 
-	for(int i = 2; i < argc; ++i)
+  // What became of one file
+  struct Result
   {
-    std::string file(argv[i]);
-    Arabica::SAX::InputSource<std::string> is;
-    is.setSystemId(file);
+    Result() : done(false), bytes(0) { }
 
-    if(file != "-")
-      domParser.parse(is);
-    else
+    bool done;
+    double bytes;
+    std::string output;
+    std::string errors;
+  }; // struct Result
+
+  class Grep
+  {
+  public:
+    Grep(const Arabica::XPath::XPathExpressionPtr<std::string>& xpath,
+         const std::vector<std::string>& files,
+         const Options& options) :
+      xpath_(xpath),
+      files_(files),
+      options_(options),
+      results_(files.size()),
+      next_(0),
+      printed_(0),
+      window_(0),
+      bytes_(0)
     {
-      is.setSystemId("stdin");
-      is.setByteStream(std::cin);
+    } // Grep
 
-      domParser.parse(is);
-    } // if(file != "-")
+    void run(unsigned int jobs)
+    {
+      window_ = jobs * 4;
+      std::vector<std::thread> workers;
+      for(unsigned int j = 0; j != jobs; ++j)
+        workers.push_back(std::thread(&Grep::work, this));
+
+      if(options_.ordered && !options_.benchmark)
+        printInOrder();
+
+      for(std::vector<std::thread>::iterator w = workers.begin(), we = workers.end(); w != we; ++w)
+        w->join();
+    } // run
+
+    double bytes() const { return bytes_; }
+
+  private:
+    void work()
+    {
+      Arabica::SAX2DOM::Parser<std::string> domParser;
+      Arabica::SAX::CatchErrorHandler<std::string> eh;
+      domParser.setErrorHandler(eh);
+
+      size_t index;
+      while(claim(index))
+      {
+        Result result;
+        grep(files_[index], domParser, eh, result);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        bytes_ += result.bytes;
+        if(options_.benchmark)
+          continue;
+        if(options_.ordered)
+        {
+          results_[index].output.swap(result.output);
+          results_[index].errors.swap(result.errors);
+          results_[index].done = true;
+          done_.notify_all();
+        }
+        else
+          print(result);
+      } // while ...
+    } // work
 
-    if(!eh.errorsReported())
+    // In order, a worker can't get more than window_ files ahead of
+    // the printer, so a slow file doesn't leave everything after it
+    // piling up in memory.
+    bool claim(size_t& index)
     {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if(options_.ordered && !options_.benchmark)
+        while(next_ < files_.size() && next_ >= printed_ + window_)
+          printed_more_.wait(lock);
+      if(next_ == files_.size())
+        return false;
+      index = next_++;
+      return true;
+    } // claim
+
+    void printInOrder()
+    {
+      for(size_t index = 0; index != results_.size(); ++index)
+      {
+        Result result;
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          while(!results_[index].done)
+            done_.wait(lock);
+          result.output.swap(results_[index].output);
+          result.errors.swap(results_[index].errors);
+        }
+
+        print(result);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        printed_ = index + 1;
+        printed_more_.notify_all();
+      } // for ...
+    } // printInOrder
+
+    static void print(const Result& result)
+    {
+      std::cout << result.output << std::flush;
+      if(!result.errors.empty())
+        std::cerr << result.errors << std::endl;
+    } // print
+
+    void grep(const std::string& file,
+              Arabica::SAX2DOM::Parser<std::string>& domParser,
+              Arabica::SAX::CatchErrorHandler<std::string>& eh,
+              Result& result) const
+    {
+      std::ifstream fileStream;
+      std::istringstream stdinStream;
+      Arabica::SAX::InputSource<std::string> is;
+      is.setSystemId(file);
+
+      if(file != "-")
+      {
+        fileStream.open(file.c_str(), std::ios::binary);
+        if(!fileStream)
+        {
+          result.errors = "Couldn't open " + file;
+          return;
+        } // if ...
+        fileStream.seekg(0, std::ios::end);
+        result.bytes = static_cast<double>(fileStream.tellg());
+        fileStream.seekg(0, std::ios::beg);
+        is.setByteStream(fileStream);
+      }
+      else
+      {
+        std::ostringstream contents;
+        contents << std::cin.rdbuf();
+        stdinStream.str(contents.str());
+        result.bytes = static_cast<double>(stdinStream.str().length());
+        is.setSystemId("stdin");
+        is.setByteStream(stdinStream);
+      } // if(file != "-")
+
+      eh.reset();
+      domParser.parse(is);
+      if(eh.errorsReported())
+      {
+        result.errors = eh.errors();
+        return;
+      } // if ...
+
       Arabica::DOM::Document<std::string> doc = domParser.getDocument();
- //     doc.normalize();
-      Arabica::XPath::XPathValuePtr<std::string> result;
-      result = xpath->evaluate(doc);
+      Arabica::XPath::XPathValue<std::string> value = xpath_->evaluate(doc);
+      if(options_.benchmark)
+        return;
 
-      std::cout << file << std::endl;
-      switch(result->type())
+      std::ostringstream out;
+      out << file << std::endl;
+      switch(value.type())
       {
         case Arabica::XPath::NODE_SET:
           {
-            const Arabica::XPath::NodeSet<std::string>& ns = result->asNodeSet();
+            const Arabica::XPath::NodeSet<std::string>& ns = value.asNodeSet();
             for(unsigned int i = 0; i < ns.size(); ++i)
             {
               Arabica::DOM::Node<std::string> n = ns[i];
-              std::cout << n << std::endl;
+              out << n << std::endl;
             }
-          } 
+          }
           break;
         default:
-          std::cout << result->asString() << std::endl;
+          out << value.asString() << std::endl;
       } // switch
-    }
+      result.output = out.str();
+    } // grep
+
+    const Arabica::XPath::XPathExpressionPtr<std::string> xpath_;
+    const std::vector<std::string>& files_;
+    const Options options_;
+
+    std::vector<Result> results_;
+    size_t next_;
+    size_t printed_;
+    size_t window_;
+    double bytes_;
+    std::mutex mutex_;
+    std::condition_variable done_;
+    std::condition_variable printed_more_;
+  }; // class Grep
+} // namespace
+
+////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+  Options options;
+  int arg = 1;
+  for( ; arg < argc && argv[arg][0] == '-' && argv[arg][1] != 0; ++arg)
+  {
+    std::string option(argv[arg]);
+    if(option == "-j" && arg + 1 < argc)
+      options.jobs = std::atoi(argv[++arg]);
+    else if(option == "-u")
+      options.ordered = false;
+    else if(option == "-b")
+      options.benchmark = true;
     else
-    {
-      std::cerr << eh.errors() << std::endl;
-      eh.reset();
-    } // if ...
+      break;
   } // for ...
 
+  if(argc - arg < 2)
+  {
+    std::cout << "Usage : " << argv[0] << " [-j jobs] [-u] [-b] xpath xmlfile ... " << std::endl;
+    std::cout << "  -j  number of threads, by default one for each hardware thread\n"
+              << "  -u  print each file's results as soon as it's done, not in order\n"
+              << "  -b  print nothing but how quickly the files were searched" << std::endl;
+    return 0;
+  } // if(argc - arg < 2)
+
+  Arabica::XPath::XPath<std::string> xpathParser;
+  Arabica::XPath::XPathExpressionPtr<std::string> xpath;
+  try {
+    //xpath = xpathParser.compile(argv[arg]);
+    xpath = xpathParser.compile_expr(argv[arg]);
+  }
+  catch(const std::runtime_error& error) {
+    std::cout << "XPath compilation error: " << error.what() << std::endl;
+    return 0;
+  }
+
+  std::vector<std::string> files(argv + arg + 1, argv + argc);
+  unsigned int jobs = options.jobs;
+  if(jobs == 0)
+    jobs = std::max(1u, std::thread::hardware_concurrency());
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  Grep grep(xpath, files, options);
+  grep.run(jobs);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  if(options.benchmark)
+    std::cout << files.size() << " files, " << grep.bytes() << " bytes, " << jobs << " threads, "
+              << seconds << "s: " << (seconds > 0 ? files.size() / seconds : 0) << " files/s, "
+              << (seconds > 0 ? grep.bytes() / (1024 * 1024) / seconds : 0) << " MB/s" << std::endl;
+
   return 0;
 } // main
 
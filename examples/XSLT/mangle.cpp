@@ -12,14 +12,20 @@ Arabica::DOM::Document<std::string> buildDOM(const std::string & xml);
 
 int main(int argc, const char* argv[])
 {
+  bool profile = (argc == 4) && (std::string(argv[1]) == "-profile");
+  if(profile)
+    ++argv, --argc;
 
   if(argc != 3)
   {
     std::cout << "mangle is an (in-development) XSLT processor\n" 
-              << argv[0] << " xmlfile xsltfile" << std::endl;
+              << argv[0] << " [-profile] xmlfile xsltfile\n"
+              << "  -profile  afterwards, report where the transformation spent its time" << std::endl;
     return 0;
   } // if ...
 
+  Arabica::XSLT::Profiler profiler;
+
   Arabica::XSLT::StylesheetCompiler<std::string> compiler;
   std::ostringstream errors;
   try 
@@ -33,6 +39,8 @@ int main(int argc, const char* argv[])
     } // if ...
 
     stylesheet->set_error_output(errors);
+    if(profile)
+      stylesheet->set_profiler(&profiler);
 
     Arabica::DOM::Document<std::string> document = buildDOM(argv[1]); 
     if(document == 0)
@@ -48,6 +56,8 @@ int main(int argc, const char* argv[])
   } // catch
 
   std::cerr << "\n\n" << errors.str() << std::endl;
+  if(profile)
+    profiler.report(std::cerr);
 
   return 0;
 } // main
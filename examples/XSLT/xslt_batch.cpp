@@ -0,0 +1,146 @@
+#ifdef _MSC_VER
+#pragma warning(disable : 4250 4244)
+#endif
+
+//////////////////////////////////////////////////
+//
+// Applies one stylesheet to many documents, on several threads.
+// Results go to an output directory, named after their inputs, or are
+// thrown away if no directory is given, which leaves a measure of how
+// fast the documents can be parsed and transformed.  Input file names
+// can be given on the command line, or read one a line from standard
+// input in place of a -.
+//
+//   xslt_batch [-j threads] [-q queue] [-o directory [-x extension]] xsltfile xmlfile ...
+//
+//////////////////////////////////////////////////
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+#include <XSLT/XSLT.hpp>
+#include <XSLT/BatchTransformer.hpp>
+
+namespace
+{
+  // A sink for every document, writing nowhere
+  class DiscardingSinkFactory : public Arabica::XSLT::SinkFactory<std::string>
+  {
+  public:
+    virtual Arabica::XSLT::Sink<std::string>* open(const std::string&, size_t)
+    {
+      return new NullSink();
+    } // open
+
+  private:
+    struct NullStream
+    {
+      NullStream() : stream_(0) { }
+      std::ostream stream_;
+    }; // struct NullStream
+
+    class NullSink : private NullStream, public Arabica::XSLT::StreamSink<std::string>
+    {
+    public:
+      NullSink() : NullStream(), Arabica::XSLT::StreamSink<std::string>(NullStream::stream_) { }
+    }; // class NullSink
+  }; // class DiscardingSinkFactory
+
+  void usage(const char* name)
+  {
+    std::cout << "xslt_batch applies an XSLT stylesheet to many documents at once\n"
+              << name << " [-j threads] [-q queue] [-o directory [-x extension]] xsltfile xmlfile ...\n"
+              << "  an xmlfile of - reads file names from standard input" << std::endl;
+  } // usage
+} // namespace
+
+int main(int argc, const char* argv[])
+{
+  unsigned int threads = 0;
+  size_t queue = 0;
+  std::string directory;
+  std::string extension;
+  bool output = false;
+
+  int arg = 1;
+  for( ; arg + 1 < argc && argv[arg][0] == '-' && argv[arg][1] != 0; arg += 2)
+  {
+    std::string option(argv[arg]);
+    if(option == "-j")
+      threads = std::atoi(argv[arg + 1]);
+    else if(option == "-q")
+      queue = std::atoi(argv[arg + 1]);
+    else if(option == "-o")
+    {
+      directory = argv[arg + 1];
+      output = true;
+    }
+    else if(option == "-x")
+      extension = argv[arg + 1];
+    else
+    {
+      usage(argv[0]);
+      return 0;
+    } // if ...
+  } // for ...
+
+  if(arg + 2 > argc)
+  {
+    usage(argv[0]);
+    return 0;
+  } // if ...
+
+  Arabica::XSLT::StylesheetCompiler<std::string> compiler;
+  Arabica::SAX::InputSource<std::string> source(argv[arg]);
+  std::auto_ptr<Arabica::XSLT::Stylesheet<std::string> > stylesheet = compiler.compile(source);
+  if(stylesheet.get() == 0)
+  {
+    std::cerr << "Couldn't compile stylesheet: " << compiler.error() << std::endl;
+    return -1;
+  } // if ...
+
+  std::vector<std::string> inputs;
+  for(++arg; arg < argc; ++arg)
+  {
+    std::string input(argv[arg]);
+    if(input != "-")
+    {
+      inputs.push_back(input);
+      continue;
+    } // if ...
+
+    std::string line;
+    while(std::getline(std::cin, line))
+      if(!line.empty())
+        inputs.push_back(line);
+  } // for ...
+
+  Arabica::XSLT::BatchTransformer<std::string> batch(*stylesheet);
+  batch.set_threads(threads);
+  batch.set_queue_size(queue);
+
+  Arabica::XSLT::BatchResults results;
+  if(output)
+  {
+    Arabica::XSLT::DirectorySinkFactory<std::string> sinks(directory, extension);
+    results = batch.transform(inputs.begin(), inputs.end(), sinks);
+  }
+  else
+  {
+    DiscardingSinkFactory sinks;
+    results = batch.transform(inputs.begin(), inputs.end(), sinks);
+  } // if ...
+
+  std::cout << results.documents() << " documents, " << results.failures() << " failed, "
+            << results.seconds() << "s, " << results.throughput() << " documents/s\n"
+            << "latency (ms): 50% " << results.percentile(0.5) * 1000
+            << ", 90% " << results.percentile(0.9) * 1000
+            << ", 99% " << results.percentile(0.99) * 1000
+            << ", max " << results.percentile(1) * 1000 << std::endl;
+
+  return (results.failures() == 0) ? 0 : 1;
+} // main
+
+// end of file
@@ -0,0 +1,486 @@
+#ifdef _MSC_VER
+#pragma warning(disable : 4250 4244)
+#endif
+
+//////////////////////////////////////////////////
+//
+// Times the XSLT conformance tests - compiling each stylesheet, parsing
+// its input and running the transformation, over and over - and counts
+// the memory allocated doing it.  Tests expected to fail, and those
+// which are meant to raise an error, are left out.  Suites are named
+// as they are for xslt_test, or every suite xslt_test runs is run.
+//
+// -scale repeats everything inside each input's document element that
+// many times, to see how transformations hold up as documents grow.
+// The scaled-up input is written out and parsed again, so any internal
+// DTD subset is lost.
+//
+// -o writes a line per test as CSV.  Given a file written by an earlier
+// run, -baseline lists the tests whose time has changed by more than 10%.
+//
+//   xslt_bench [-n iterations] [-scale n] [-d testsuite] [-o results.csv]
+//              [-baseline results.csv] [-v] [suite ...]
+//
+//////////////////////////////////////////////////
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <new>
+#include <cstdlib>
+#include <ctime>
+#include <chrono>
+
+#include <XSLT/XSLT.hpp>
+#include <DOM/io/Stream.hpp>
+
+namespace
+{
+  // every allocation made by the program goes through here
+  unsigned long allocations = 0;
+  unsigned long allocated = 0;
+} // namespace
+
+void* operator new(std::size_t size)
+{
+  ++allocations;
+  allocated += static_cast<unsigned long>(size);
+  void* p = std::malloc(size ? size : 1);
+  if(p == 0)
+    throw std::bad_alloc();
+  return p;
+} // operator new
+
+void* operator new[](std::size_t size)
+{
+  return operator new(size);
+} // operator new[]
+
+// GCC sees the free below as releasing what operator new returned, not
+// knowing that came from malloc too
+#if defined(__GNUC__) && (__GNUC__ >= 11)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* p) throw()
+{
+  std::free(p);
+} // operator delete
+
+void operator delete[](void* p) throw()
+{
+  std::free(p);
+} // operator delete[]
+
+void operator delete(void* p, std::size_t) throw()
+{
+  operator delete(p);
+} // operator delete
+
+void operator delete[](void* p, std::size_t) throw()
+{
+  operator delete(p);
+} // operator delete[]
+
+namespace
+{
+  typedef Arabica::DOM::Document<std::string> Document;
+  typedef Arabica::DOM::Node<std::string> Node;
+  typedef Arabica::XPath::NodeSet<std::string> NodeSet;
+  typedef std::chrono::steady_clock Clock;
+
+  // the suites xslt_test runs
+  const char* default_suites[] = { "attribvaltemplate", "axes", "boolean", "conditional",
+                                   "conflictres", "copy", "dflt", "expression", "extend",
+                                   "impincl", "lre", "match", "math",
+                                   "mdocs", "message", "modes", "namedtemplate",
+                                   "namespace", "node", "output", "position", "predicate",
+                                   "processorinfo", "reluri", "select", "sort", "string",
+                                   "variable", "ver", "whitespace",
+                                   "AVTs", "Attributes", "BVTs",
+                                   "Comment", "Completeness", "ConflictResolution", "Copying",
+                                   "Elements", "Errors", "Fallback", "ForEach",
+                                   "ForwardComp", "Import", "Keys", "Messages",
+                                   "Miscellaneous", "Modes", "NamedTemplates", "Namespace",
+                                   "Namespace-alias", "Namespace_XPath",
+                                   "ProcessingInstruction", "RTF", "Sorting",
+                                   "Stylesheet", "Template", "Text", "Valueof",
+                                   "Variables", "Whitespaces", "XSLTFunctions",
+                                   "attributes", "errors", "include", "processing-instruction",
+                                   "stylesheet", "text", "variables", 0 };
+
+  struct Test
+  {
+    std::string suite;
+    std::string name;
+    std::string xml;
+    std::string xslt;
+  }; // struct Test
+
+  struct Result
+  {
+    Result() :
+      compile(0), parse(0), transform(0), wall(0), cpu(0),
+      allocations(0), allocated(0), output(0), ok(false)
+    {
+    } // Result
+
+    // best of the iterations, in microseconds
+    double compile;
+    double parse;
+    double transform;
+    // all of the iterations, in milliseconds
+    double wall;
+    double cpu;
+    // one iteration
+    unsigned long allocations;
+    unsigned long allocated;
+    size_t output;
+    bool ok;
+    std::string error;
+  }; // struct Result
+
+  double since(Clock::time_point start)
+  {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+  } // since
+
+  std::string readFile(const std::string& filename)
+  {
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+  } // readFile
+
+  Document parse(const std::string& document, const std::string& systemId)
+  {
+    std::istringstream stream(document);
+    Arabica::SAX::InputSource<std::string> is(stream);
+    is.setSystemId(systemId);
+    Arabica::SAX2DOM::Parser<std::string> parser;
+    Arabica::SAX::CatchErrorHandler<std::string> eh;
+    parser.setErrorHandler(eh);
+    parser.parse(is);
+    if(eh.errorsReported())
+      return Document();
+    return parser.getDocument();
+  } // parse
+
+  std::string select(const char* xpath, const Node& node)
+  {
+    Arabica::XPath::XPath<std::string> compiler;
+    return compiler.evaluate_expr(xpath, node).asString();
+  } // select
+
+  NodeSet selectNodes(const std::string& xpath, const Node& node)
+  {
+    Arabica::XPath::XPath<std::string> compiler;
+    return compiler.evaluate_expr(xpath, node).asNodeSet();
+  } // selectNodes
+
+  Document load(const std::string& filename)
+  {
+    return parse(readFile(filename), filename);
+  } // load
+
+  // the tests which ought to run, from one catalog
+  void catalog(const std::string& testsuite, const std::string& filename,
+               const std::set<std::string>& suites, const std::set<std::string>& fails,
+               std::vector<Test>& tests)
+  {
+    Document c = load(testsuite + filename);
+    if(c == 0)
+    {
+      std::cerr << "Couldn't read " << testsuite << filename << std::endl;
+      return;
+    } // if ...
+
+    NodeSet cases = selectNodes("/test-suite/test-catalog/test-case[scenario/@operation = 'standard']", c);
+    for(size_t i = 0; i != cases.size(); ++i)
+    {
+      Test test;
+      test.suite = select("file-path", cases[i]);
+      test.name = select("@id", cases[i]);
+      if(suites.find(test.suite) == suites.end() ||
+         fails.find(test.name) != fails.end())
+        continue;
+
+      std::string path = testsuite + select("concat(../major-path, '/', file-path, '/')", cases[i]);
+      test.xml = path + select(".//input-file[@role='principal-data']", cases[i]);
+      test.xslt = path + select(".//input-file[@role='principal-stylesheet']", cases[i]);
+      tests.push_back(test);
+    } // for ...
+  } // catalog
+
+  std::set<std::string> expectedFails(const std::string& testsuite)
+  {
+    std::set<std::string> fails;
+    Document expected = load(testsuite + "arabica-expected-fails.xml");
+    if(expected == 0)
+      return fails;
+    NodeSet cases = selectNodes("/test-suite/test-case[@compiles = 'no' or @runs = 'no' or @skip = 'yes']", expected);
+    for(size_t i = 0; i != cases.size(); ++i)
+      fails.insert(select("@id", cases[i]));
+    return fails;
+  } // expectedFails
+
+  // the document, with the contents of its document element repeated
+  std::string scaled(const std::string& document, const std::string& systemId, int scale)
+  {
+    Document d = parse(document, systemId);
+    if(d == 0 || d.getDocumentElement() == 0)
+      return document;
+
+    Node root = d.getDocumentElement();
+    std::vector<Node> children;
+    for(Node c = root.getFirstChild(); c != 0; c = c.getNextSibling())
+      children.push_back(c);
+    for(int s = 1; s < scale; ++s)
+      for(size_t c = 0; c != children.size(); ++c)
+        root.appendChild(children[c].cloneNode(true));
+
+    std::ostringstream o;
+    o << d;
+    return o.str();
+  } // scaled
+
+  Result run(const Test& test, int iterations, int scale)
+  {
+    Result result;
+    try
+    {
+      std::string document = readFile(test.xml);
+      if(scale > 1)
+        document = scaled(document, test.xml, scale);
+
+      Clock::time_point wallStart = Clock::now();
+      std::clock_t cpuStart = std::clock();
+      for(int i = 0; i != iterations; ++i)
+      {
+        unsigned long allocationsBefore = allocations;
+        unsigned long allocatedBefore = allocated;
+
+        Clock::time_point start = Clock::now();
+        Arabica::XSLT::StylesheetCompiler<std::string> compiler;
+        Arabica::SAX::InputSource<std::string> source(test.xslt);
+        std::auto_ptr<Arabica::XSLT::Stylesheet<std::string> > stylesheet = compiler.compile(source);
+        double compile = since(start);
+        if(stylesheet.get() == 0)
+        {
+          result.error = compiler.error();
+          return result;
+        } // if ...
+
+        start = Clock::now();
+        Document input = parse(document, test.xml);
+        double parse = since(start);
+        if(input == 0)
+        {
+          result.error = "couldn't parse " + test.xml;
+          return result;
+        } // if ...
+        stylesheet->strip_whitespace(input);
+
+        std::ostringstream output;
+        std::ostringstream errors;
+        Arabica::XSLT::StreamSink<std::string> sink(output);
+        stylesheet->set_output(sink);
+        stylesheet->set_error_output(errors);
+        start = Clock::now();
+        stylesheet->execute(input);
+        double transform = since(start);
+
+        if(i == 0 || compile < result.compile)
+          result.compile = compile;
+        if(i == 0 || parse < result.parse)
+          result.parse = parse;
+        if(i == 0 || transform < result.transform)
+          result.transform = transform;
+        result.allocations = allocations - allocationsBefore;
+        result.allocated = allocated - allocatedBefore;
+        result.output = output.str().size();
+      } // for ...
+      result.wall = since(wallStart) / 1000;
+      result.cpu = (static_cast<double>(std::clock() - cpuStart) * 1000) / CLOCKS_PER_SEC;
+    }
+    catch(const std::exception& e)
+    {
+      result.error = e.what();
+      return result;
+    } // catch
+    result.ok = true;
+    return result;
+  } // run
+
+  const char* header = "suite,test,scale,iterations,compile_us,parse_us,transform_us,wall_ms,cpu_ms,allocations,allocated_bytes,output_bytes,status";
+
+  void write(std::ostream& csv, const Test& test, const Result& result, int scale, int iterations)
+  {
+    csv << test.suite << ',' << test.name << ',' << scale << ',' << iterations << ','
+        << result.compile << ',' << result.parse << ',' << result.transform << ','
+        << result.wall << ',' << result.cpu << ','
+        << result.allocations << ',' << result.allocated << ',' << result.output << ','
+        << (result.ok ? "ok" : "failed") << '\n';
+  } // write
+
+  // test name -> compile + parse + transform time, from an earlier run
+  std::map<std::string, double> readBaseline(const std::string& filename)
+  {
+    std::map<std::string, double> baseline;
+    std::ifstream in(filename.c_str());
+    std::string line;
+    std::getline(in, line);
+    while(std::getline(in, line))
+    {
+      std::vector<std::string> fields;
+      std::istringstream l(line);
+      std::string field;
+      while(std::getline(l, field, ','))
+        fields.push_back(field);
+      if(fields.size() < 13 || fields[12] != "ok")
+        continue;
+      baseline[fields[1]] = std::atof(fields[4].c_str()) + std::atof(fields[5].c_str()) + std::atof(fields[6].c_str());
+    } // while ...
+    return baseline;
+  } // readBaseline
+
+  void usage(const char* name)
+  {
+    std::cout << "xslt_bench times the XSLT conformance tests\n"
+              << name << " [-n iterations] [-scale n] [-d testsuite] [-o results.csv]\n"
+              << "           [-baseline results.csv] [-v] [suite ...]" << std::endl;
+  } // usage
+} // namespace
+
+int main(int argc, const char* argv[])
+{
+  int iterations = 5;
+  int scale = 1;
+  bool verbose = false;
+  std::string testsuite = "tests/XSLT/testsuite/TESTS/";
+  std::string results;
+  std::string baselineFile;
+  std::set<std::string> suites;
+
+  for(int i = 1; i < argc; ++i)
+  {
+    std::string arg(argv[i]);
+    if(arg == "-n" && i + 1 < argc)
+      iterations = std::atoi(argv[++i]);
+    else if(arg == "-scale" && i + 1 < argc)
+      scale = std::atoi(argv[++i]);
+    else if(arg == "-d" && i + 1 < argc)
+      testsuite = argv[++i];
+    else if(arg == "-o" && i + 1 < argc)
+      results = argv[++i];
+    else if(arg == "-baseline" && i + 1 < argc)
+      baselineFile = argv[++i];
+    else if(arg == "-v")
+      verbose = true;
+    else if(arg[0] != '-')
+      suites.insert(arg);
+    else
+    {
+      usage(argv[0]);
+      return 0;
+    } // if ...
+  } // for ...
+  if(iterations <= 0 || scale <= 0)
+  {
+    usage(argv[0]);
+    return 0;
+  } // if ...
+  if(!testsuite.empty() && testsuite[testsuite.length()-1] != '/')
+    testsuite += '/';
+  if(suites.empty())
+    for(const char** s = default_suites; *s != 0; ++s)
+      suites.insert(*s);
+
+  std::set<std::string> fails = expectedFails(testsuite);
+  std::vector<Test> tests;
+  catalog(testsuite, "catalog.xml", suites, fails, tests);
+  catalog(testsuite, "arabica-catalog.xml", suites, fails, tests);
+  if(tests.empty())
+  {
+    std::cerr << "No tests found in " << testsuite << std::endl;
+    return 1;
+  } // if ...
+
+  std::map<std::string, double> baseline;
+  if(!baselineFile.empty())
+    baseline = readBaseline(baselineFile);
+
+  std::ofstream csv;
+  if(!results.empty())
+  {
+    csv.open(results.c_str());
+    csv << header << '\n';
+  } // if ...
+
+  std::cout << tests.size() << " tests, " << iterations << " iterations";
+  if(scale > 1)
+    std::cout << ", inputs scaled " << scale << " times";
+  std::cout << std::endl;
+
+  Result total;
+  int failed = 0;
+  double before = 0;
+  double after = 0;
+  for(size_t t = 0; t != tests.size(); ++t)
+  {
+    Result result = run(tests[t], iterations, scale);
+    if(csv.is_open())
+      write(csv, tests[t], result, scale, iterations);
+    if(!result.ok)
+    {
+      ++failed;
+      if(verbose)
+        std::cout << "  " << tests[t].name << ": " << result.error << std::endl;
+      continue;
+    } // if ...
+
+    total.compile += result.compile;
+    total.parse += result.parse;
+    total.transform += result.transform;
+    total.wall += result.wall;
+    total.cpu += result.cpu;
+    total.allocations += result.allocations;
+    total.allocated += result.allocated;
+
+    if(verbose)
+      std::cout << "  " << tests[t].name << ": compile " << result.compile
+                << "us, parse " << result.parse
+                << "us, transform " << result.transform
+                << "us, " << result.allocations << " allocations" << std::endl;
+
+    std::map<std::string, double>::const_iterator b = baseline.find(tests[t].name);
+    if(b == baseline.end() || b->second <= 0)
+      continue;
+    double now = result.compile + result.parse + result.transform;
+    before += b->second;
+    after += now;
+    double ratio = now / b->second;
+    if(ratio > 1.1 || ratio < 0.9)
+      std::cout << "  " << tests[t].name << ": " << b->second << "us -> " << now << "us ("
+                << (ratio > 1 ? "+" : "") << static_cast<int>((ratio - 1) * 100) << "%)" << std::endl;
+  } // for ...
+
+  std::cout << "compile " << total.compile / 1000 << "ms, "
+            << "parse " << total.parse / 1000 << "ms, "
+            << "transform " << total.transform / 1000 << "ms (best of each)\n"
+            << "wall " << total.wall << "ms, cpu " << total.cpu << "ms, "
+            << total.allocations << " allocations of " << total.allocated << " bytes per iteration" << std::endl;
+  if(after > 0)
+    std::cout << "against baseline: " << before / 1000 << "ms -> " << after / 1000 << "ms" << std::endl;
+  if(failed)
+    std::cout << failed << " tests failed to run" << std::endl;
+
+  return 0;
+} // main
+
+// end of file
@@ -0,0 +1,50 @@
+#ifndef ARABICA_UTILS_SIMD_HPP
+#define ARABICA_UTILS_SIMD_HPP
+
+/**
+Which vector instructions the string kernels - the escapers in
+XML/escaper.hpp and the searches in text/string_kernels.hpp - may use.
+
+The choice is made when the code is compiled, not when it runs.
+ARABICA_SSE2 is defined whenever the compiler targets SSE2, which every
+x86-64 compiler does, and ARABICA_AVX2 when it targets AVX2 (-mavx2 or
+/arch:AVX2).  Define ARABICA_NO_SIMD to use the plain loops everywhere.
+**/
+
+#ifndef ARABICA_NO_SIMD
+#  if defined(__AVX2__)
+#    define ARABICA_AVX2
+#    include <immintrin.h>
+#  endif
+#  if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#    define ARABICA_SSE2
+#    include <emmintrin.h>
+#  endif
+#  if defined(_MSC_VER) && (defined(ARABICA_AVX2) || defined(ARABICA_SSE2))
+#    include <intrin.h>
+#  endif
+#endif
+
+namespace Arabica
+{
+namespace simd
+{
+
+#if defined(ARABICA_AVX2) || defined(ARABICA_SSE2)
+// the index of the lowest set bit of a movemask result, which mustn't be 0
+inline unsigned int first_set_bit(unsigned int mask)
+{
+#if defined(_MSC_VER)
+  unsigned long bit;
+  _BitScanForward(&bit, mask);
+  return bit;
+#else
+  return __builtin_ctz(mask);
+#endif
+} // first_set_bit
+#endif
+
+} // namespace simd
+} // namespace Arabica
+
+#endif // ARABICA_UTILS_SIMD_HPP
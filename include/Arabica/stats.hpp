@@ -0,0 +1,229 @@
+#ifndef ARABICA_UTILS_STATS_HPP
+#define ARABICA_UTILS_STATS_HPP
+
+/**
+Counters and timers on Arabica's hot paths - the parsers, the DOM, XPath
+and XSLT - for finding out where the time and memory goes.
+
+They're only compiled in if ARABICA_STATS is defined, either by hand or by
+configuring with ARABICA_STATS (CMake) or --enable-stats (autotools), and
+that needs C++11.  Otherwise the ARABICA_STATS_ hooks expand to nothing,
+and snapshot() is always empty.
+
+The figures are kept per thread.  snapshot() copies the calling thread's
+figures, and reset() sets them back to zero.  To see what one execution
+costs, whatever went before it on the thread, create a Scope before it and
+ask for its delta() afterwards.
+
+  Arabica::stats::Scope scope;
+  stylesheet->execute(document);
+  std::cerr << scope.delta();
+**/
+
+#include <SAX/ArabicaConfig.hpp>
+#include <ostream>
+
+#ifdef ARABICA_STATS
+#include <chrono>
+#endif
+
+namespace Arabica
+{
+namespace stats
+{
+
+enum Counter
+{
+  axis_walks,             // AxisEnumerators set off along an axis
+  axis_steps,             // nodes those AxisEnumerators stepped on to
+  nodeset_sorts,          // NodeSets put into document order
+  nodeset_sorted_nodes,   // nodes in those NodeSets
+  templates_applied,      // nodes templates were applied to
+  template_match_tests,   // match patterns tried against them
+  builtin_templates,      // nodes no template matched
+  dom_nodes_created,
+  dom_nodes_deleted,
+  pool_lookups,           // names looked up in a document's string pool
+  pool_strings,           // names that were new to it
+  counter_count
+}; // Counter
+
+enum Timer
+{
+  sax_parse,              // SAX parser parse()
+  dom_build,              // SAX2DOM::Parser parse()
+  xpath_evaluate,         // XPathExpression evaluation
+  xslt_execute,           // CompiledStylesheet execute()
+  nodeset_sort,           // NodeSet sort()
+  timer_count
+}; // Timer
+
+inline const char* name(Counter counter)
+{
+  static const char* const names[] = {
+    "axis_walks", "axis_steps", "nodeset_sorts", "nodeset_sorted_nodes",
+    "templates_applied", "template_match_tests", "builtin_templates",
+    "dom_nodes_created", "dom_nodes_deleted", "pool_lookups", "pool_strings"
+  };
+  return names[counter];
+} // name
+
+inline const char* name(Timer timer)
+{
+  static const char* const names[] = {
+    "sax_parse", "dom_build", "xpath_evaluate", "xslt_execute", "nodeset_sort"
+  };
+  return names[timer];
+} // name
+
+/**
+A copy of a thread's figures.  A timer's calls counts every call, but its
+time is only taken around the outermost of nested or recursive calls, so
+it's the time spent inside, not the sum of the calls' times.
+**/
+struct Snapshot
+{
+  unsigned long long counters[counter_count];
+  unsigned long long calls[timer_count];
+  unsigned long long nanoseconds[timer_count];
+
+  Snapshot()
+  {
+    for(int c = 0; c != counter_count; ++c)
+      counters[c] = 0;
+    for(int t = 0; t != timer_count; ++t)
+      calls[t] = nanoseconds[t] = 0;
+  } // Snapshot
+
+  unsigned long long operator[](Counter counter) const { return counters[counter]; }
+  double milliseconds(Timer timer) const { return nanoseconds[timer] / 1e6; }
+
+  Snapshot operator-(const Snapshot& rhs) const
+  {
+    Snapshot delta;
+    for(int c = 0; c != counter_count; ++c)
+      delta.counters[c] = counters[c] - rhs.counters[c];
+    for(int t = 0; t != timer_count; ++t)
+    {
+      delta.calls[t] = calls[t] - rhs.calls[t];
+      delta.nanoseconds[t] = nanoseconds[t] - rhs.nanoseconds[t];
+    } // for ...
+    return delta;
+  } // operator-
+}; // struct Snapshot
+
+#ifdef ARABICA_STATS
+inline bool enabled() { return true; }
+#else
+inline bool enabled() { return false; }
+#endif
+
+#ifdef ARABICA_STATS
+namespace impl
+{
+
+struct Figures : public Snapshot
+{
+  Figures() : Snapshot()
+  {
+    for(int t = 0; t != timer_count; ++t)
+      depth[t] = 0;
+  } // Figures
+
+  unsigned int depth[timer_count];
+}; // struct Figures
+
+inline Figures& figures()
+{
+  static thread_local Figures f;
+  return f;
+} // figures
+
+} // namespace impl
+
+inline Snapshot snapshot()
+{
+  return impl::figures();
+} // snapshot
+
+inline void reset()
+{
+  // leaves alone any timers which are running
+  static_cast<Snapshot&>(impl::figures()) = Snapshot();
+} // reset
+
+class Timing
+{
+public:
+  explicit Timing(Timer timer) :
+    timer_(timer),
+    outermost_(impl::figures().depth[timer]++ == 0)
+  {
+    if(outermost_)
+      start_ = std::chrono::steady_clock::now();
+  } // Timing
+
+  ~Timing()
+  {
+    impl::Figures& f = impl::figures();
+    --f.depth[timer_];
+    ++f.calls[timer_];
+    if(outermost_)
+      f.nanoseconds[timer_] += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count();
+  } // ~Timing
+
+private:
+  Timer timer_;
+  bool outermost_;
+  std::chrono::steady_clock::time_point start_;
+
+  Timing(const Timing&);
+  Timing& operator=(const Timing&);
+}; // class Timing
+
+#define ARABICA_STATS_COUNT(counter) (++::Arabica::stats::impl::figures().counters[::Arabica::stats::counter])
+#define ARABICA_STATS_ADD(counter, n) (::Arabica::stats::impl::figures().counters[::Arabica::stats::counter] += (n))
+#define ARABICA_STATS_TIME(timer) ::Arabica::stats::Timing arabica_stats_timing_##timer(::Arabica::stats::timer)
+#else
+inline Snapshot snapshot() { return Snapshot(); }
+inline void reset() { }
+
+#define ARABICA_STATS_COUNT(counter) ((void)0)
+#define ARABICA_STATS_ADD(counter, n) ((void)0)
+#define ARABICA_STATS_TIME(timer) ((void)0)
+#endif
+
+/**
+The figures for whatever the thread does while a Scope is alive.
+**/
+class Scope
+{
+public:
+  Scope() : start_(snapshot()) { }
+
+  Snapshot delta() const { return snapshot() - start_; }
+
+private:
+  Snapshot start_;
+}; // class Scope
+
+/**
+Writes the figures, one per line, leaving out those which are zero.
+**/
+template<class charT, class traitsT>
+std::basic_ostream<charT, traitsT>& operator<<(std::basic_ostream<charT, traitsT>& os, const Snapshot& snapshot)
+{
+  for(int c = 0; c != counter_count; ++c)
+    if(snapshot.counters[c] != 0)
+      os << name(static_cast<Counter>(c)) << ' ' << snapshot.counters[c] << '\n';
+  for(int t = 0; t != timer_count; ++t)
+    if(snapshot.calls[t] != 0)
+      os << name(static_cast<Timer>(t)) << ' ' << snapshot.calls[t] << " calls "
+         << snapshot.milliseconds(static_cast<Timer>(t)) << " ms\n";
+  return os;
+} // operator<<
+
+} // namespace stats
+} // namespace Arabica
+
+#endif // ARABICA_UTILS_STATS_HPP
@@ -1,26 +1,95 @@
 #ifndef ARABICA_DOM_DUALMODE_DUALMODE_HPP
 #define ARABICA_DOM_DUALMODE_DUALMODE_HPP
 
-#include <DOM/SAX2DOM/SAX2DOM.h>
+#include <DOM/SAX2DOM/SAX2DOM.hpp>
+#include <XML/XMLCharacterClasses.hpp>
 #include <boost/function.hpp>
+#include <algorithm>
 
 namespace Arabica
 {
 namespace DualMode
 {
-template<class stringT, 
+
+/**
+ * What becomes of an element once it has been completely parsed.
+ *
+ * KEEP leaves it where it is in the document.  DETACH takes it out of
+ * the document, but it lives for as long as the document does, so it
+ * can be held on to.  DISCARD takes it out and deletes it, and
+ * everything in it, straight away - nothing may refer to it once the
+ * handler has returned.
+ */
+enum Release { KEEP, DETACH, DISCARD };
+
+/**
+ * Builds a DOM, as SAX2DOM::Parser does, but offers each element to a
+ * handler as soon as its end tag is seen.
+ *
+ * The element end handler is called for every element, and the element
+ * stays in the document.  The element release handler says what should
+ * become of each element - whether it stays in the document, or is
+ * detached or discarded.  Either way, when a handler is called the
+ * element is complete and still part of the document, so everything
+ * above and before it can be reached, and it can be searched with XPath.
+ *
+ * A document which is a long sequence of records - log entries, feed
+ * items, database rows - can be worked through in the memory needed to
+ * hold one record by naming the record element.  Only records are then
+ * offered to the release handler, and each record is discarded unless
+ * the release handler says otherwise.  The whitespace between records is
+ * released along with them.
+ */
+template<class stringT,
          class string_adaptorT = Arabica::default_string_adaptor<stringT>,
          class SAX_parser = Arabica::SAX::XMLReader<stringT, string_adaptorT> >
 class Parser : public Arabica::SAX2DOM::Parser<stringT, string_adaptorT, SAX_parser>
 {
     typedef Arabica::SAX2DOM::Parser<stringT, string_adaptorT, SAX_parser> BaseT;
   public:
-    typedef boost::function2<void, Arabica::DOM::Node<stringT, string_adaptorT> &, Arabica::DOM::Node<stringT, string_adaptorT> &> ElementHandlerT;
+    typedef Arabica::DOM::Node<stringT, string_adaptorT> NodeT;
+    typedef boost::function2<void, NodeT&, NodeT&> ElementHandlerT;
+    typedef boost::function2<Release, NodeT&, NodeT&> ReleaseHandlerT;
+
+    Parser() :
+      records_(false)
+    {
+    } // Parser
 
+    /**
+     * func(parent, element) is called as each element ends.
+     */
     void setElementEndHandler(ElementHandlerT func)
     {
       elementEndFunc_ = func;
-    } // setElementEndHandler 
+    } // setElementEndHandler
+
+    /**
+     * func(parent, element) is called as each element ends, after the
+     * element end handler, and returns what should become of the element.
+     */
+    void setElementReleaseHandler(ReleaseHandlerT func)
+    {
+      releaseFunc_ = func;
+    } // setElementReleaseHandler
+
+    /**
+     * Elements named namespaceURI:localName are records.  Once a record
+     * element is set, only records go to the release handler, records
+     * are discarded if there's no release handler, and all other
+     * elements are kept.
+     */
+    void setRecordElement(const stringT& namespaceURI, const stringT& localName)
+    {
+      records_ = true;
+      recordNamespaceURI_ = namespaceURI;
+      recordLocalName_ = localName;
+    } // setRecordElement
+
+    void clearRecordElement()
+    {
+      records_ = false;
+    } // clearRecordElement
 
   protected:
     virtual void endElement(const stringT& namespaceURI, const stringT& localName,
@@ -29,16 +98,64 @@ class Parser : public Arabica::SAX2DOM::Parser<stringT, string_adaptorT, SAX_par
       if(BaseT::currentNode() == 0)
         return;
 
-      Arabica::DOM::Node<stringT, string_adaptorT> child(BaseT::currentNode());
+      NodeT child(BaseT::currentNode());
 
       BaseT::endElement(namespaceURI, localName, qName);
-      
+
+      NodeT parent(BaseT::currentNode());
       if(!!elementEndFunc_)
-        elementEndFunc_(BaseT::currentNode(), child);
+        elementEndFunc_(parent, child);
+
+      if(records_ && !(equals(localName, recordLocalName_) && equals(namespaceURI, recordNamespaceURI_)))
+        return;
+
+      Release release = records_ ? DISCARD : KEEP;
+      if(!!releaseFunc_)
+        release = releaseFunc_(parent, child);
+
+      // the handlers might have moved it themselves
+      if(release == KEEP || child.getParentNode() != parent)
+        return;
+
+      releaseWhitespace(parent, child);
+      if(release == DETACH)
+        parent.removeChild(child);
+      else
+        parent.purgeChild(child);
     } // endElement
 
   private:
+    void releaseWhitespace(NodeT& parent, const NodeT& child)
+    {
+      NodeT prev = child.getPreviousSibling();
+      while(prev != 0 && prev.getNodeType() == Arabica::DOM::Node_base::TEXT_NODE && isWhitespace(prev.getNodeValue()))
+      {
+        NodeT text = prev;
+        prev = prev.getPreviousSibling();
+        parent.purgeChild(text);
+      } // while ...
+    } // releaseWhitespace
+
+    // compared through the adaptor, not the string type's own operators
+    static bool equals(const stringT& lhs, const stringT& rhs)
+    {
+      return string_adaptorT::length(lhs) == string_adaptorT::length(rhs) &&
+             std::equal(string_adaptorT::begin(lhs), string_adaptorT::end(lhs), string_adaptorT::begin(rhs));
+    } // equals
+
+    static bool isWhitespace(const stringT& text)
+    {
+      for(typename string_adaptorT::const_iterator c = string_adaptorT::begin(text), ce = string_adaptorT::end(text); c != ce; ++c)
+        if(!Arabica::XML::is_space(*c))
+          return false;
+      return true;
+    } // isWhitespace
+
     ElementHandlerT elementEndFunc_;
+    ReleaseHandlerT releaseFunc_;
+    bool records_;
+    stringT recordNamespaceURI_;
+    stringT recordLocalName_;
 }; // class Parser
 
 } // namespace DualMode
@@ -2,9 +2,11 @@
 #define JEZUK_SAX2DOM_PARSER_H
 
 #include <SAX/XMLReader.hpp>
+#include <SAX/XMLFilter.hpp>
 #include <SAX/helpers/DefaultHandler.hpp>
 #include <SAX/helpers/AttributeTypes.hpp>
 #include <SAX/filter/TextCoalescer.hpp>
+#include <Arabica/stats.hpp>
 #include <DOM/Simple/DOMImplementation.hpp>
 #include <DOM/Simple/NotationImpl.hpp>
 #include <DOM/Simple/EntityImpl.hpp>
@@ -43,6 +45,7 @@ class Parser : protected Arabica::SAX::DefaultHandler<stringT, typename ParserTy
     typedef typename ParserTypes<stringT, T0, T1>::SAX_parser_type SAX_parser_type;
     typedef Arabica::SAX::XMLReaderInterface<stringT, string_adaptorT> XMLReaderInterfaceT;
     typedef Arabica::SAX::TextCoalescer<stringT, string_adaptorT> TextCoalescerT;
+    typedef Arabica::SAX::XMLFilter<stringT, string_adaptorT> XMLFilterT;
     typedef Arabica::SAX::Attributes<stringT, string_adaptorT> AttributesT;
     typedef Arabica::SAX::EntityResolver<stringT, string_adaptorT> EntityResolverT;
     typedef Arabica::SAX::ErrorHandler<stringT, string_adaptorT> ErrorHandlerT;
@@ -52,13 +55,21 @@ class Parser : protected Arabica::SAX::DefaultHandler<stringT, typename ParserTy
     typedef Arabica::SimpleDOM::EntityImpl<stringT, string_adaptorT> EntityT;
     typedef Arabica::SimpleDOM::NotationImpl<stringT, string_adaptorT> NotationT;
     typedef Arabica::SimpleDOM::ElementImpl<stringT, string_adaptorT> ElementT;
+    typedef Arabica::SimpleDOM::DocumentImpl<stringT, string_adaptorT> DocumentImplT;
+    typedef DOM::Element_impl<stringT, string_adaptorT> ElementImplT;
+    typedef DOM::Text_impl<stringT, string_adaptorT> TextImplT;
+    typedef Arabica::SimpleDOM::AttrNSImpl<stringT, string_adaptorT> AttrT;
     typedef typename ErrorHandlerT::SAXParseExceptionT SAXParseExceptionT;
 
   public:
     Parser() :
         documentType_(0),
         entityResolver_(0),
-        errorHandler_(0)
+        errorHandler_(0),
+        filter_(0),
+        trusted_(false),
+        documentImpl_(0),
+        text_(0)
     { 
       Arabica::SAX::FeatureNames<stringT, string_adaptorT> fNames;
       features_.insert(std::make_pair(fNames.namespaces, true));
@@ -72,6 +83,24 @@ class Parser : protected Arabica::SAX::DefaultHandler<stringT, typename ParserTy
     void setErrorHandler(ErrorHandlerT& handler) { errorHandler_ = &handler; }
     ErrorHandlerT* getErrorHandler() const { return errorHandler_; }
 
+    /**
+     * Events pass through filter on their way from the parser to the
+     * document being built.  The filter's parent is set on each parse.
+     */
+    void setFilter(XMLFilterT& filter) { filter_ = &filter; }
+    XMLFilterT* getFilter() const { return filter_; }
+
+    /**
+     * When trusted, the names the SAX parser reports are taken to be
+     * well-formed, as any conforming parser guarantees, so they aren't
+     * checked again as elements and attributes are created.  Elements
+     * of the same name share their names' storage, and text is joined up
+     * as it arrives rather than passing through a TextCoalescer.  The
+     * document built is the same either way.
+     */
+    void setTrusted(bool trusted) { trusted_ = trusted; }
+    bool getTrusted() const { return trusted_; }
+
     void setFeature(const stringT& name, bool value)
     {
       typename Features::iterator f = features_.find(name);
@@ -97,17 +126,24 @@ class Parser : protected Arabica::SAX::DefaultHandler<stringT, typename ParserTy
 
     bool parse(InputSourceT& source)
     {
+      ARABICA_STATS_TIME(dom_build);
       Arabica::SAX::PropertyNames<stringT, string_adaptorT> pNames;
       
       DOM::DOMImplementation<stringT, string_adaptorT> di = Arabica::SimpleDOM::DOMImplementation<stringT, string_adaptorT>::getDOMImplementation();
       document_ = di.createDocument(string_adaptorT::construct_from_utf8(""), string_adaptorT::construct_from_utf8(""), 0);
+      documentImpl_ = dynamic_cast<DocumentImplT*>(document_.underlying_impl());
       currentNode_ = document_;
+      text_ = 0;
       inCDATA_ = false;
       inDTD_ = false;
       inEntity_ = 0;
 
       SAX_parser_type base_parser;
-      TextCoalescerT parser(base_parser);
+      TextCoalescerT coalescer(base_parser);
+      XMLReaderInterfaceT& source_parser = trusted_ ? static_cast<XMLReaderInterfaceT&>(base_parser) : coalescer;
+      XMLReaderInterfaceT& parser = filter_ ? static_cast<XMLReaderInterfaceT&>(*filter_) : source_parser;
+      if(filter_)
+        filter_->setParent(source_parser);
       parser.setContentHandler(*this);
       parser.setErrorHandler(*this);
       if(entityResolver_)
@@ -132,6 +168,8 @@ class Parser : protected Arabica::SAX::DefaultHandler<stringT, typename ParserTy
           errorHandler_->fatalError(pe);
         } // if ...
       } // catch
+      elementPrototypes_.clear();
+      attributePrototypes_.clear();
 
       return (document_ != 0);
     } // loadDOM
@@ -144,6 +182,8 @@ class Parser : protected Arabica::SAX::DefaultHandler<stringT, typename ParserTy
     void reset()
     {
       currentNode_ = 0;
+      text_ = 0;
+      documentImpl_ = 0;
       document_ = 0;
     } // reset
 
@@ -173,6 +213,18 @@ class Parser : protected Arabica::SAX::DefaultHandler<stringT, typename ParserTy
 
     EntityResolverT* entityResolver_;
     ErrorHandlerT* errorHandler_;
+    XMLFilterT* filter_;
+
+    // trusted building
+    bool trusted_;
+    DocumentImplT* documentImpl_;
+    TextImplT* text_;
+    typedef std::pair<stringT, stringT> Name;
+    typedef std::map<Name, ElementImplT*> ElementPrototypes;
+    typedef std::map<Name, AttrT*> AttributePrototypes;
+    ElementPrototypes elementPrototypes_;
+    AttributePrototypes attributePrototypes_;
+
     Arabica::SAX::AttributeTypes<stringT, string_adaptorT> attributeTypes_;
 
   protected:
@@ -190,6 +242,7 @@ class Parser : protected Arabica::SAX::DefaultHandler<stringT, typename ParserTy
     virtual void endDocument()
     {
       currentNode_ = 0;
+      text_ = 0;
     } // endDocument
 
     virtual void startElement(const stringT& namespaceURI, 
@@ -200,8 +253,15 @@ class Parser : protected Arabica::SAX::DefaultHandler<stringT, typename ParserTy
       if(currentNode_ == 0)
         return;
 
+      text_ = 0;
       try 
       {
+        if(trusted_)
+        {
+          startTrustedElement(namespaceURI, qName, atts);
+          return;
+        } // if ...
+
         DOM::Element<stringT, string_adaptorT> elem = document_.createElementNS(namespaceURI, qName);
         currentNode_.appendChild(elem);
 
@@ -228,6 +288,48 @@ class Parser : protected Arabica::SAX::DefaultHandler<stringT, typename ParserTy
       } // catch
     } // startElement
 
+    void startTrustedElement(const stringT& namespaceURI, 
+                             const stringT& qName, 
+                             const AttributesT& atts)
+    {
+      ElementImplT* elem = createTrustedElement(namespaceURI, qName);
+      currentNode_.underlying_impl()->appendChild(elem);
+
+      ElementT* simple = static_cast<ElementT*>(elem);
+      for(int i = 0, ie = atts.getLength(); i != ie; ++i)
+      {
+        stringT attName = atts.getQName(i);
+        if(string_adaptorT::empty(attName))
+          attName = atts.getLocalName(i);
+        simple->setAttributeNS_like(attributePrototype(atts.getURI(i), attName), atts.getValue(i));
+      } // for ...
+
+      currentNode_ = elem;
+    } // startTrustedElement
+
+    // The first element or attribute made of each name is a prototype,
+    // kept out of the document, whose names the rest share.
+    ElementImplT* createTrustedElement(const stringT& namespaceURI, const stringT& qName)
+    {
+      Name name(namespaceURI, qName);
+      typename ElementPrototypes::const_iterator p = elementPrototypes_.find(name);
+      if(p == elementPrototypes_.end())
+        p = elementPrototypes_.insert(std::make_pair(name, documentImpl_->createElementNS_nocheck(namespaceURI, qName))).first;
+      return documentImpl_->createElementNS_like(p->second);
+    } // createTrustedElement
+
+    const AttrT* attributePrototype(const stringT& namespaceURI, const stringT& qName)
+    {
+      Name name(namespaceURI, qName);
+      typename AttributePrototypes::const_iterator p = attributePrototypes_.find(name);
+      if(p == attributePrototypes_.end())
+      {
+        AttrT* attr = static_cast<AttrT*>(documentImpl_->createAttributeNS_nocheck(namespaceURI, qName));
+        p = attributePrototypes_.insert(std::make_pair(name, attr)).first;
+      } // if ...
+      return p->second;
+    } // attributePrototype
+
     virtual void endElement(const stringT& /*namespaceURI*/, 
 			    const stringT& /*localName*/,
                             const stringT& /*qName*/)
@@ -235,6 +337,7 @@ class Parser : protected Arabica::SAX::DefaultHandler<stringT, typename ParserTy
       if(currentNode_ == 0)
         return;
 
+      text_ = 0;
       currentNode_ = currentNode_.getParentNode();
     } // endElement
 
@@ -243,6 +346,18 @@ class Parser : protected Arabica::SAX::DefaultHandler<stringT, typename ParserTy
       if(currentNode_ == 0)
         return;
 
+      if(trusted_)
+      {
+        if(text_ != 0)
+          text_->appendData(ch);
+        else
+        {
+          text_ = inCDATA_ ? documentImpl_->createCDATASection(ch) : documentImpl_->createTextNode(ch);
+          currentNode_.underlying_impl()->appendChild(text_);
+        } // if ...
+        return;
+      } // if ...
+
       if(!inCDATA_)
         currentNode_.appendChild(document_.createTextNode(ch));
       else
@@ -254,6 +369,7 @@ class Parser : protected Arabica::SAX::DefaultHandler<stringT, typename ParserTy
       if(currentNode_ == 0)
         return;
 
+      text_ = 0;
       currentNode_.appendChild(document_.createProcessingInstruction(target, data));
     } // processingInstruction
 
@@ -262,6 +378,7 @@ class Parser : protected Arabica::SAX::DefaultHandler<stringT, typename ParserTy
       if(currentNode_ == 0 || inDTD_ == true)
         return;
 
+      text_ = 0;
       currentNode_.appendChild(document_.createEntityReference(name));
     } // skippedEntity
 
@@ -309,6 +426,8 @@ class Parser : protected Arabica::SAX::DefaultHandler<stringT, typename ParserTy
       if(currentNode_ == 0)
         return;
 
+      text_ = 0;
+
       if(++inEntity_ == 1)
       {
         cachedCurrent_ = currentNode_;
@@ -320,6 +439,7 @@ class Parser : protected Arabica::SAX::DefaultHandler<stringT, typename ParserTy
 
     virtual void endEntity(const stringT& name)
     {
+      text_ = 0;
       if(--inEntity_ == 0)
         currentNode_ = cachedCurrent_;
 
@@ -340,11 +460,13 @@ class Parser : protected Arabica::SAX::DefaultHandler<stringT, typename ParserTy
 
     virtual void startCDATA()
     {
+      text_ = 0;
       inCDATA_ = true;
     } // startCDATA
 
     virtual void endCDATA()
     {
+      text_ = 0;
       inCDATA_ = false;
     } // endCDATA
 
@@ -353,6 +475,7 @@ class Parser : protected Arabica::SAX::DefaultHandler<stringT, typename ParserTy
       if(currentNode_ == 0)
         return;
 
+      text_ = 0;
       currentNode_.appendChild(document_.createComment(text));
     } // comment
 
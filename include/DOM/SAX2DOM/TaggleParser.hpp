@@ -0,0 +1,279 @@
+#ifndef ARABICA_SAX2DOM_TAGGLE_PARSER_HPP
+#define ARABICA_SAX2DOM_TAGGLE_PARSER_HPP
+
+#include <map>
+#include <Taggle/Taggle.hpp>
+#include <SAX/ErrorHandler.hpp>
+#include <SAX/SAXParseException.hpp>
+#include <DOM/Simple/DOMImplementation.hpp>
+#include <DOM/Document.hpp>
+#include <DOM/DOMException.hpp>
+#include <DOM/SAX2DOM/DocumentTypeImpl.hpp>
+
+namespace Arabica
+{
+namespace SAX2DOM
+{
+
+/**
+Builds a DOM from HTML.  The result is the same as that of a
+SAX2DOM::Parser driven by Taggle, but the tree is built straight from
+what Taggle has scanned - there are no SAX events in between, so no
+Attributes to fill in and no strings converted just to be handed on.
+Each element name is looked up in the document once, the first time its
+element type is seen, and shared by every element of that type after.
+
+Features are Taggle's.
+**/
+template<class stringT, class string_adaptorT = Arabica::default_string_adaptor<stringT> >
+class TaggleParser : private Arabica::SAX::TreeBuilder,
+                     private Arabica::SAX::ErrorHandler<stringT, string_adaptorT>
+{
+    typedef Arabica::SAX::Taggle<stringT, string_adaptorT> TaggleT;
+    typedef Arabica::SAX::InputSource<stringT, string_adaptorT> InputSourceT;
+    typedef Arabica::SAX::EntityResolver<stringT, string_adaptorT> EntityResolverT;
+    typedef Arabica::SAX::ErrorHandler<stringT, string_adaptorT> ErrorHandlerT;
+    typedef typename ErrorHandlerT::SAXParseExceptionT SAXParseExceptionT;
+    typedef Arabica::SAX::AttributesImpl<std::string> AttributesT;
+    typedef Arabica::SAX::ElementType ElementTypeT;
+    typedef Arabica::SimpleDOM::DocumentImpl<stringT, string_adaptorT> DocumentImplT;
+    typedef DOM::Node_impl<stringT, string_adaptorT> NodeImplT;
+    typedef DOM::Element_impl<stringT, string_adaptorT> ElementImplT;
+    typedef DOM::Text_impl<stringT, string_adaptorT> TextImplT;
+
+  public:
+    TaggleParser() :
+        documentImpl_(0),
+        documentType_(0),
+        current_(0),
+        text_(0),
+        inCDATA_(false),
+        errorHandler_(0)
+    {
+    } // TaggleParser
+
+    void setEntityResolver(EntityResolverT& resolver) { taggle_.setEntityResolver(resolver); }
+    EntityResolverT* getEntityResolver() const { return taggle_.getEntityResolver(); }
+
+    void setErrorHandler(ErrorHandlerT& handler) { errorHandler_ = &handler; }
+    ErrorHandlerT* getErrorHandler() const { return errorHandler_; }
+
+    void setFeature(const stringT& name, bool value) { taggle_.setFeature(name, value); }
+    bool getFeature(const stringT& name) const { return taggle_.getFeature(name); }
+
+    bool parse(const stringT& systemId)
+    {
+      InputSourceT is(systemId);
+      return parse(is);
+    } // parse
+
+    bool parse(InputSourceT& source)
+    {
+      DOM::DOMImplementation<stringT, string_adaptorT> di = Arabica::SimpleDOM::DOMImplementation<stringT, string_adaptorT>::getDOMImplementation();
+      document_ = di.createDocument(string_adaptorT::construct_from_utf8(""), string_adaptorT::construct_from_utf8(""), 0);
+      documentImpl_ = dynamic_cast<DocumentImplT*>(document_.underlying_impl());
+      documentType_ = 0;
+      current_ = documentImpl_;
+      text_ = 0;
+      inCDATA_ = false;
+      // a parse which threw leaves the elements of its document behind
+      prototypes_.clear();
+
+      taggle_.setErrorHandler(*this);
+      try
+      {
+        taggle_.parse(source, *this);
+      }
+      catch(const DOM::DOMException& de)
+      {
+        reset();
+
+        if(errorHandler_)
+        {
+          SAXParseExceptionT pe(de.what());
+          errorHandler_->fatalError(pe);
+        } // if ...
+      } // catch
+      prototypes_.clear();
+
+      return (document_ != 0);
+    } // parse
+
+    DOM::Document<stringT, string_adaptorT> getDocument() const
+    {
+      return document_;
+    } // getDocument
+
+    void reset()
+    {
+      current_ = 0;
+      text_ = 0;
+      documentImpl_ = 0;
+      document_ = 0;
+    } // reset
+
+  private:
+    // no implementations
+    TaggleParser(const TaggleParser&);
+    bool operator==(const TaggleParser&) const;
+    TaggleParser& operator=(const TaggleParser&);
+
+    static stringT S(const std::string& s)
+    {
+      return string_adaptorT::construct_from_utf8(s.c_str(), static_cast<int>(s.length()));
+    } // S
+
+    // the first element made of each type, whose names the rest share
+    typedef std::map<const ElementTypeT*, ElementImplT*> Prototypes;
+
+    ElementImplT* createElement(const ElementTypeT& type, const std::string& namespaceURI)
+    {
+      typename Prototypes::const_iterator p = prototypes_.find(&type);
+      if(p != prototypes_.end())
+        return documentImpl_->createElementNS_like(p->second);
+
+      ElementImplT* elem = documentImpl_->createElementNS_nocheck(S(namespaceURI), S(type.name()));
+      prototypes_.insert(std::make_pair(&type, elem));
+      return elem;
+    } // createElement
+
+    void append(NodeImplT* node)
+    {
+      text_ = 0;
+      current_->appendChild(node);
+    } // append
+
+    ///////////////////////////////////////////////////////////
+    // TreeBuilder
+    virtual void startDocument()
+    {
+    } // startDocument
+
+    virtual void endDocument()
+    {
+      current_ = 0;
+    } // endDocument
+
+    virtual void doctype(const std::string& name, const std::string& publicId, const std::string& systemId)
+    {
+      if(current_ == 0 || documentType_ != 0)
+        return;
+
+      documentType_ = new DocumentType<stringT, string_adaptorT>(S(name), S(publicId), S(systemId));
+      document_.insertBefore(documentType_, 0);
+      documentType_->setReadOnly(true);
+    } // doctype
+
+    virtual void startElement(const ElementTypeT& type, const std::string& namespaceURI, const AttributesT& atts)
+    {
+      if(current_ == 0)
+        return;
+
+      ElementImplT* elem = createElement(type, namespaceURI);
+      append(elem);
+
+      for(int i = 0, ie = atts.getLength(); i != ie; ++i)
+      {
+        const std::string& qName = atts.getQName(i);
+        elem->setAttributeNS(S(atts.getURI(i)),
+                             S(qName.empty() ? atts.getLocalName(i) : qName),
+                             S(atts.getValue(i)));
+      } // for ...
+
+      current_ = elem;
+    } // startElement
+
+    virtual void endElement()
+    {
+      if(current_ == 0)
+        return;
+
+      text_ = 0;
+      current_ = current_->getParentNode();
+    } // endElement
+
+    virtual void characters(const std::string& text)
+    {
+      if(current_ == 0)
+        return;
+
+      // Taggle can split text, so join it up here
+      if(text_ != 0)
+      {
+        text_->appendData(S(text));
+        return;
+      } // if ...
+
+      TextImplT* node = inCDATA_ ? documentImpl_->createCDATASection(S(text))
+                                 : documentImpl_->createTextNode(S(text));
+      append(node);
+      text_ = node;
+    } // characters
+
+    virtual void startCDATA()
+    {
+      text_ = 0;
+      inCDATA_ = true;
+    } // startCDATA
+
+    virtual void endCDATA()
+    {
+      text_ = 0;
+      inCDATA_ = false;
+    } // endCDATA
+
+    virtual void comment(const std::string& text)
+    {
+      if(current_ == 0)
+        return;
+
+      append(documentImpl_->createComment(S(text)));
+    } // comment
+
+    virtual void processingInstruction(const std::string& target, const std::string& data)
+    {
+      if(current_ == 0)
+        return;
+
+      append(documentImpl_->createProcessingInstruction_nocheck(S(target), S(data)));
+    } // processingInstruction
+
+    ////////////////////////////////////////////////////
+    // ErrorHandler
+    virtual void warning(const SAXParseExceptionT& e)
+    {
+      if(errorHandler_)
+        errorHandler_->warning(e);
+    } // warning
+
+    virtual void error(const SAXParseExceptionT& e)
+    {
+      if(errorHandler_)
+        errorHandler_->error(e);
+      reset();
+    } // error
+
+    virtual void fatalError(const SAXParseExceptionT& e)
+    {
+      if(errorHandler_)
+        errorHandler_->fatalError(e);
+      reset();
+    } // fatalError
+
+    // instance variables
+    TaggleT taggle_;
+    DOM::Document<stringT, string_adaptorT> document_;
+    DocumentImplT* documentImpl_;
+    DocumentType<stringT, string_adaptorT>* documentType_;
+    NodeImplT* current_;
+    TextImplT* text_;
+    bool inCDATA_;
+    Prototypes prototypes_;
+
+    ErrorHandlerT* errorHandler_;
+}; // class TaggleParser
+
+} // namespace SAX2DOM
+} // namespace Arabica
+
+#endif
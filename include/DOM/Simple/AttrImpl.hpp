@@ -45,6 +45,19 @@ class AttrImpl : public DOM::Attr_impl<stringT, string_adaptorT>,
       setNodeValue(value);
     } // AttrImpl
 
+  protected:
+    // an attribute with the same, already pooled, name as names
+    AttrImpl(DocumentImpl<stringT, string_adaptorT>* ownerDoc, const AttrImpl& names) : 
+        DOMAttr_implT(),
+        NodeImplWithChildren<stringT, string_adaptorT>(ownerDoc),
+        name_(names.name_),
+        ownerElement_(0),
+        specified_(true),
+        valueCalculated_(false)
+    {
+    } // AttrImpl
+
+  public:
     virtual ~AttrImpl() { }
 
     ///////////////////////////////////////////////////
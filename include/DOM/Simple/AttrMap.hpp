@@ -115,6 +115,15 @@ class AttrMap : public NamedNodeMapImpl<stringT, string_adaptorT>
       NamedNodeMapImplT::setNamedItemNS(a);
     } // setAttributeNS
 
+    // as setAttributeNS, with the names of prototype, which belongs to the same document
+    void setAttributeNS_like(const AttrNSImplT* prototype, const stringT& value)
+    {
+      AttrNSImplT* a = new AttrNSImplT(NamedNodeMapImplT::ownerDoc_, *prototype);
+      a->setValue(value);
+      a->setOwnerElement(ownerElement_);
+      NamedNodeMapImplT::setNamedItemNS(a);
+    } // setAttributeNS_like
+
     void removeAttributeNS(const stringT& namespaceURI, const stringT& localName)    
     {
       removeNamedItemNS(namespaceURI, localName);
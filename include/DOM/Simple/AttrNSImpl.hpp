@@ -53,6 +53,17 @@ class AttrNSImpl : public AttrImpl<stringT, string_adaptorT>
       namespaceURI_ = AttrImplT::ownerDoc_->stringPool(mappedURI.second);
     } // AttrImpl
 
+    // An attribute with the same names as names, which belongs to ownerDoc.
+    // They've already been checked and pooled, so there's nothing to look up.
+    AttrNSImpl(DocumentImpl<stringT, string_adaptorT>* ownerDoc, const AttrNSImpl& names) :
+        AttrImplT(ownerDoc, names),
+        namespaceURI_(names.namespaceURI_),
+        prefix_(names.prefix_),
+        localName_(names.localName_),
+        hasNamespaceURI_(names.hasNamespaceURI_)
+    {
+    } // AttrNSImpl
+
     virtual ~AttrNSImpl() { }
 
     ///////////////////////////////////////////////////////
@@ -347,6 +347,22 @@ class DocumentImpl : public DOM::Document_impl<stringT, string_adaptorT>,
       return n;
     } // createElementNS
 
+    // An element with the same namespace URI and qualified name as
+    // prototype.  When prototype belongs to this document, its names are
+    // shared rather than looked up again, which is worth having when a
+    // builder makes many elements of the same few names.
+    DOMElement_implT* createElementNS_like(const DOMElement_implT* prototype) const
+    {
+      const ElementNSImpl<stringT, string_adaptorT>* names = dynamic_cast<const ElementNSImpl<stringT, string_adaptorT>*>(prototype);
+      if((names == 0) || (names->getOwnerDoc() != this))
+        return createElementNS_nocheck(prototype->getNamespaceURI(), prototype->getNodeName());
+
+      ElementNSImpl<stringT, string_adaptorT>* n =
+        new ElementNSImpl<stringT, string_adaptorT>(const_cast<DocumentImpl*>(this), *names);
+      orphaned(n);
+      return n;
+    } // createElementNS_like
+
     virtual DOMAttr_implT* createAttributeNS(const stringT& namespaceURI, const stringT& qualifiedName) const
     {
       this->checkName(qualifiedName);
@@ -482,6 +498,8 @@ class DocumentImpl : public DOM::Document_impl<stringT, string_adaptorT>,
     void purge(NodeImplT* node)
     {
       orphans_.erase(node);
+      if(!idNodes_.empty())
+        forgetElementIds(node);
       delete node;
     } // purge
 
@@ -506,12 +524,31 @@ class DocumentImpl : public DOM::Document_impl<stringT, string_adaptorT>,
 
     stringT const* stringPool(const stringT& str) const
     {
-      return &(*stringPool_.insert(str).first);
+      std::pair<typename std::set<stringT>::iterator, bool> pooled = stringPool_.insert(str);
+      ARABICA_STATS_COUNT(pool_lookups);
+      if(pooled.second)
+        ARABICA_STATS_COUNT(pool_strings);
+      return &(*pooled.first);
     } // stringPool
 
     const stringT& empty_string() const { return empty_; }
 
   private:
+    // ids belonging to elements in a subtree that's about to be deleted
+    void forgetElementIds(NodeImplT* node)
+    {
+      for(typename std::set<AttrImplT*>::iterator i = idNodes_.begin(); i != idNodes_.end(); )
+      {
+        DOMNode_implT* n = (*i)->getOwnerElement();
+        while(n != 0 && n != node)
+          n = n->getParentNode();
+        if(n != 0)
+          idNodes_.erase(i++);
+        else
+          ++i;
+      } // for ...
+    } // forgetElementIds
+
     void checkChildType(DOMNode_implT* child)
     {
       typename DOM::Node_base::Type type = child->getNodeType();
@@ -36,6 +36,18 @@ class ElementImpl : public DOM::Element_impl<stringT, string_adaptorT>,
       attributes_.setOwnerElement(this);
     } // ElementImpl
 
+  protected:
+    // an element with the same, already pooled, tag name as names
+    ElementImpl(DocumentImplT* ownerDoc, const ElementImpl& names) :
+        DOMElement_implT(),
+        NodeT(ownerDoc),
+        attributes_(ownerDoc),
+        tagName_(names.tagName_)
+    {
+      attributes_.setOwnerElement(this);
+    } // ElementImpl
+
+  public:
     virtual ~ElementImpl()
     {
     } // ~ElementImpl
@@ -95,6 +107,14 @@ class ElementImpl : public DOM::Element_impl<stringT, string_adaptorT>,
       attributes_.setAttributeNS(namespaceURI, qualifiedName, value);
     } // setAttributeNS
 
+    // An attribute with the same names as prototype, which belongs to the
+    // same document.  Its names have been checked already, so they aren't
+    // checked or looked up again.
+    void setAttributeNS_like(const AttrNSImpl<stringT, string_adaptorT>* prototype, const stringT& value)
+    {
+      attributes_.setAttributeNS_like(prototype, value);
+    } // setAttributeNS_like
+
     virtual void removeAttributeNS(const stringT& namespaceURI, const stringT& localName)
     {
       attributes_.removeAttributeNS(namespaceURI, localName);
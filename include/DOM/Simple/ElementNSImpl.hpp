@@ -46,6 +46,17 @@ class ElementNSImpl : public ElementImpl<stringT, string_adaptorT>
       namespaceURI_ = ElementImplT::ownerDoc_->stringPool(mappedURI.second);
     } // ElementImpl
 
+    // An element with the same names as names, which belongs to ownerDoc.
+    // They've already been checked and pooled, so there's nothing to look up.
+    ElementNSImpl(DocumentImpl<stringT, string_adaptorT>* ownerDoc, const ElementNSImpl& names) :
+        ElementImplT(ownerDoc, names),
+        namespaceURI_(names.namespaceURI_),
+        prefix_(names.prefix_),
+        localName_(names.localName_),
+        hasNamespaceURI_(names.hasNamespaceURI_)
+    {
+    } // ElementNSImpl
+
     virtual ~ElementNSImpl() { }
 
     ///////////////////////////////////////////////////////
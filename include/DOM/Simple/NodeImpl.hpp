@@ -10,6 +10,7 @@
 #include <DOM/Events/EventListener.hpp>
 #include <DOM/DOMException.hpp>
 #include <XML/XMLCharacterClasses.hpp>
+#include <Arabica/stats.hpp>
 #include <deque>
 #include <algorithm>
 #include <map>
@@ -42,11 +43,13 @@ class NodeImpl : virtual public DOM::Node_impl<stringT, string_adaptorT>
       readOnly_(false)
     {
         //std::cout << std::endl << "born " << this << std::endl;
+        ARABICA_STATS_COUNT(dom_nodes_created);
     } // NodeImpl
 
     virtual ~NodeImpl()
     {
         //std::cout << std::endl << "die  " << this << std::endl;
+        ARABICA_STATS_COUNT(dom_nodes_deleted);
     }
 
     ///////////////////////////////////////////////////////
@@ -160,6 +163,7 @@ class NodeImpl : virtual public DOM::Node_impl<stringT, string_adaptorT>
     } // setParentNode
 
     NodeImplT* getFirst() { return dynamic_cast<NodeImplT*>(getFirstChild()); }
+    NodeImplT* getParent() const { return parentNode_; }
 
     NodeImplT* getPrev() { return prevSibling_; }
 
@@ -294,14 +298,23 @@ class NodeImplWithChildren : public NodeImpl<stringT, string_adaptorT>,
     typedef DOM::NodeList_impl<stringT, string_adaptorT> DOMNodeList_implT;
 
     NodeImplWithChildren(DocumentImplT* ownerDoc) :
-      NodeImplT(ownerDoc)
+      NodeImplT(ownerDoc),
+      first_(0),
+      last_(0),
+      length_(0),
+      cursor_(0),
+      cursorIndex_(0)
     {
     } // NodeImplWithChildren
 
     virtual ~NodeImplWithChildren()
     {
-      for(typename NodeListT::iterator i = nodes_.begin(); i != nodes_.end(); ++i)
-        delete (*i);
+      for(NodeImplT* child = first_; child != 0; )
+      {
+        NodeImplT* next = child->getNext();
+        delete child;
+        child = next;
+      } // for ...
     } // ~NodeImpl
 
     ///////////////////////////////////////////////////////
@@ -324,16 +337,12 @@ class NodeImplWithChildren : public NodeImpl<stringT, string_adaptorT>,
 
     virtual DOMNode_implT* getFirstChild() const
     {
-      if(nodes_.size())
-        return nodes_[0];
-      return 0;
+      return first_;
     } // getFirstChild
 
     virtual DOMNode_implT* getLastChild() const
     {
-      if(nodes_.size())
-        return *nodes_.rbegin();
-      return 0;
+      return last_;
     } // getLastChild
 
     virtual DOMNode_implT* insertBefore(DOMNode_implT* newChild, DOMNode_implT* refChild)
@@ -365,22 +374,46 @@ class NodeImplWithChildren : public NodeImpl<stringT, string_adaptorT>,
 
     virtual bool hasChildNodes() const
     {
-      return nodes_.size() != 0;
+      return first_ != 0;
     } // hasChildNodes
 
     ///////////////////////////////////////////////////////
     // NodeList methods
+    // The children are only a linked list, so item walks to index from
+    // whichever is nearest of the first child, the last child, or the
+    // last item asked for.  Walking through the list in order, either
+    // way, is one step per item.
     virtual DOMNode_implT* item(unsigned int index) const
     {
-      if(index >= nodes_.size())
+      if(index >= length_)
         return 0;
 
-      return nodes_[index];
+      NodeImplT* node = first_;
+      unsigned int at = 0;
+      if(length_ - 1 - index < index)
+      {
+        node = last_;
+        at = length_ - 1;
+      } // if ...
+      if(cursor_ != 0 && distance(cursorIndex_, index) < distance(at, index))
+      {
+        node = cursor_;
+        at = cursorIndex_;
+      } // if ...
+
+      for( ; at < index; ++at)
+        node = node->getNext();
+      for( ; at > index; --at)
+        node = node->getPrev();
+
+      cursor_ = node;
+      cursorIndex_ = index;
+      return node;
     } // item
 
     virtual unsigned int getLength() const
     {
-      return static_cast<unsigned int>(nodes_.size());
+      return length_;
     } // getLength
 
     /////////////////////////////////////////////////////////////
@@ -397,28 +430,35 @@ class NodeImplWithChildren : public NodeImpl<stringT, string_adaptorT>,
         return newChild;
       } // if ...
 
+      if(refChild)
+        checkIsChild(refChild);
       checkCanAdd(newChild);
+      if(newChild == refChild)
+        return newChild;
       removeIfRequired(newChild);
       if(refChild)
       {
-        nodes_.insert(findChild(refChild), newChild);
-
         NodeImplT* prev = refChild->getPrev();
         if(prev != 0)
           prev->setNext(newChild);
+        else
+          first_ = newChild;
         newChild->setPrev(prev);
         newChild->setNext(refChild);
         refChild->setPrev(newChild);
       }
       else
       {
-        if(!nodes_.empty())
-        {
-          (*nodes_.rbegin())->setNext(newChild);
-          newChild->setPrev(*nodes_.rbegin());
-        } //
-        nodes_.push_back(newChild);
+        if(last_ != 0)
+          last_->setNext(newChild);
+        else
+          first_ = newChild;
+        newChild->setPrev(last_);
+        newChild->setNext(0);
+        last_ = newChild;
       }
+      ++length_;
+      cursor_ = 0;
 
       newChild->setParentNode(this);
 
@@ -440,10 +480,11 @@ class NodeImplWithChildren : public NodeImpl<stringT, string_adaptorT>,
         return oldChild;
       } // if ...
 
+      checkIsChild(oldChild);
       checkCanAdd(newChild);
+      if(newChild == oldChild)
+        return oldChild;
       removeIfRequired(newChild);
-      typename std::deque<NodeImplT*>::iterator result = findChild(oldChild);
-      *result = newChild;
       newChild->setParentNode(this);
 
       NodeImplT* prev = oldChild->getPrev();
@@ -452,8 +493,13 @@ class NodeImplWithChildren : public NodeImpl<stringT, string_adaptorT>,
       newChild->setNext(next);
       if(prev != 0)
         prev->setNext(newChild);
+      else
+        first_ = newChild;
       if(next != 0)
         next->setPrev(newChild);
+      else
+        last_ = newChild;
+      cursor_ = 0;
 
       oldChild->setParentNode(0);
       oldChild->setPrev(0);
@@ -468,14 +514,20 @@ class NodeImplWithChildren : public NodeImpl<stringT, string_adaptorT>,
     {
       NodeImplT::throwIfReadOnly();
 
-      nodes_.erase(findChild(oldChild));
+      checkIsChild(oldChild);
 
       NodeImplT* prev = oldChild->getPrev();
       NodeImplT* next = oldChild->getNext();
       if(prev != 0)
         prev->setNext(next);
+      else
+        first_ = next;
       if(next != 0)
         next->setPrev(prev);
+      else
+        last_ = prev;
+      --length_;
+      cursor_ = 0;
 
       oldChild->setParentNode(0);
       oldChild->setPrev(0);
@@ -498,15 +550,16 @@ class NodeImplWithChildren : public NodeImpl<stringT, string_adaptorT>,
     } // do_purgeChild
 
   private:
-    typedef std::deque<NodeImplT*> NodeListT;
-
-    typename NodeListT::iterator findChild(NodeImplT* refChild)
+    void checkIsChild(NodeImplT* refChild) const
     {
-      typename NodeListT::iterator result = std::find(nodes_.begin(), nodes_.end(), refChild);
-      if(result == nodes_.end())
+      if(refChild == 0 || refChild->getParent() != this)
         throw DOM::DOMException(DOM::DOMException::NOT_FOUND_ERR);
-      return result;
-    } // findChild
+    } // checkIsChild
+
+    static unsigned int distance(unsigned int from, unsigned int to)
+    {
+      return from < to ? to - from : from - to;
+    } // distance
 
     void removeIfRequired(NodeImplT* newNode) const
     {
@@ -548,7 +601,11 @@ class NodeImplWithChildren : public NodeImpl<stringT, string_adaptorT>,
         NodeImplT::ownerDoc_->markChanged();
     } // markChanged
 
-    NodeListT nodes_;
+    NodeImplT* first_;
+    NodeImplT* last_;
+    unsigned int length_;
+    mutable NodeImplT* cursor_;
+    mutable unsigned int cursorIndex_;
 }; // class NodeImplWithChildren
 
 } // namespace DOM
@@ -173,7 +173,7 @@ int prefix_mapper(std::basic_ostream<charT, traitsT>& stream,
   {
     //DOM::Node<stringT, string_adaptorT> attr = attrs.getNamedItem(*a);
     const DOM::Node<stringT, string_adaptorT> attr = attrNodes[a];
-    if(attr.getNodeName().empty() ||
+    if(string_adaptorT::empty(attr.getNodeName()) ||
        isXmlns<stringT, string_adaptorT, charT>(attr.getNodeName()) ||
        isXmlns<stringT, string_adaptorT, charT>(attr.getPrefix()))
       continue;
@@ -182,9 +182,9 @@ int prefix_mapper(std::basic_ostream<charT, traitsT>& stream,
     stream  << UnicodeT::EQUALS_SIGN
             << UnicodeT::QUOTATION_MARK;
     stringT value = attr.getNodeValue();
-    std::for_each(string_adaptorT::begin(value), 
-                  string_adaptorT::end(value), 
-                  Arabica::XML::attribute_escaper<charT, traitsT>(stream));
+    Arabica::XML::escape_attribute(stream,
+                                   string_adaptorT::begin(value),
+                                   string_adaptorT::end(value));
     stream << UnicodeT::QUOTATION_MARK;
   }
 
@@ -201,9 +201,9 @@ int prefix_mapper(std::basic_ostream<charT, traitsT>& stream,
     if(!(string_adaptorT::empty(i->second)))
       stream << UnicodeT::COLON << i->second;
     stream << UnicodeT::EQUALS_SIGN << UnicodeT::QUOTATION_MARK;
-    std::for_each(string_adaptorT::begin(i->first), 
-                  string_adaptorT::end(i->first), 
-                  Arabica::XML::attribute_escaper<charT, traitsT>(stream));
+    Arabica::XML::escape_attribute(stream,
+                                   string_adaptorT::begin(i->first),
+                                   string_adaptorT::end(i->first));
     stream << UnicodeT::QUOTATION_MARK;
   } // for ...
 
@@ -311,7 +311,7 @@ void streamCDATA(std::basic_ostream<charT, traitsT>& stream, const DOM::Node<str
     do
     {
       breakAt += 2;
-      stream << string_adaptorT::substr(value, start, breakAt);
+      stream << string_adaptorT::substr(value, start, breakAt - start);
       StreamImpl::endCDATA(stream);
       start = breakAt;
       StreamImpl::startCDATA(stream);
@@ -367,9 +367,9 @@ operator<<(std::basic_ostream<charT, traitsT>& stream,
   case DOM::Node_base::TEXT_NODE:
     {
       stringT value = node.getNodeValue();
-      std::for_each(string_adaptorT::begin(value), 
-                    string_adaptorT::end(value), 
-                    Arabica::XML::text_escaper<charT, traitsT>(stream));
+      Arabica::XML::escape_text(stream,
+                                string_adaptorT::begin(value),
+                                string_adaptorT::end(value));
     }
     break;
   case DOM::Node_base::ENTITY_REFERENCE_NODE:
@@ -0,0 +1,537 @@
+#ifndef ARABICA_DOM_IO_WRITER_HPP
+#define ARABICA_DOM_IO_WRITER_HPP
+///////////////////////////////////////////////////////////////////////
+//
+// DOM/io/Writer.hpp
+//
+// Writes DOM::Nodes out as XML, like the operator<< in DOM/io/Stream.hpp
+// but quicker.  Output is gathered in a buffer and handed to the stream
+// a block at a time, characters are escaped a run at a time, and the
+// namespaces in scope are kept on a single stack for the whole of the
+// write rather than in a map per element.
+//
+// e.g.
+//  Arabica::DOM::Writer<std::string> writer(std::cout, Arabica::DOM::Writer<std::string>::pretty);
+//  writer.write(doc);
+//
+// With the sort_attributes option, and writing a document or its root
+// element, the output is the same as operator<<'s.  Unlike operator<<,
+// the Writer undeclares the default namespace for an element in no
+// namespace, never writes a namespaced attribute without a prefix, and
+// writing an element out of the middle of a document only declares the
+// namespaces it uses.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include <ostream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <DOM/Node.hpp>
+#include <DOM/NamedNodeMap.hpp>
+#include <text/UnicodeCharacters.hpp>
+#include <XML/XMLCharacterClasses.hpp>
+#include <XML/escaper.hpp>
+
+namespace Arabica
+{
+namespace DOM
+{
+
+template<class stringT, class string_adaptorT = Arabica::default_string_adaptor<stringT> >
+class Writer
+{
+public:
+  typedef typename string_adaptorT::value_type charT;
+  typedef std::char_traits<charT> traitsT;
+  typedef std::basic_ostream<charT, traitsT> ostreamT;
+  typedef DOM::Node<stringT, string_adaptorT> NodeT;
+
+  enum Options
+  {
+    compact = 0,            // exactly what's in the DOM
+    pretty = 1,             // elements which only contain elements are indented, two spaces a level
+    sort_attributes = 2,    // attributes by namespace URI then local name, rather than in document order
+    no_declaration = 4      // leave out <?xml version="1.0"?> when writing a Document
+  }; // Options
+
+  Writer(ostreamT& stream, int options = compact) :
+    stream_(stream),
+    options_(options),
+    used_(0),
+    depth_(0),
+    autoPrefix_(0),
+    xml_(string_adaptorT::construct_from_utf8("xml")),
+    xmlns_(string_adaptorT::construct_from_utf8("xmlns")),
+    xml_uri_(string_adaptorT::construct_from_utf8("http://www.w3.org/XML/1998/namespace"))
+  {
+  } // Writer
+
+  void write(const NodeT& node)
+  {
+    autoPrefix_ = 0;
+    writeNode(node);
+    flush();
+  } // write
+
+private:
+  typedef Arabica::text::Unicode<charT> UnicodeT;
+  typedef typename string_adaptorT::const_iterator const_iterator;
+
+  struct Binding
+  {
+    Binding(const stringT& p, const stringT& u) : prefix(p), uri(u) { }
+
+    stringT prefix;
+    stringT uri;
+  }; // struct Binding
+
+  static bool uri_order(const Binding* lhs, const Binding* rhs)
+  {
+    return lhs->uri < rhs->uri;
+  } // uri_order
+
+  static bool name_order(const NodeT& lhs, const NodeT& rhs)
+  {
+    const stringT& lhsURI = lhs.getNamespaceURI();
+    const stringT& rhsURI = rhs.getNamespaceURI();
+    if(lhsURI == rhsURI)
+      return lhs.getLocalName() < rhs.getLocalName();
+    return lhsURI < rhsURI;
+  } // name_order
+
+  //////////////////////////////////////
+  void writeNode(const NodeT& node)
+  {
+    switch(node.getNodeType())
+    {
+    case DOM::Node_base::DOCUMENT_NODE:
+      writeDocument(node);
+      break;
+    case DOM::Node_base::DOCUMENT_FRAGMENT_NODE:
+      for(NodeT c = node.getFirstChild(); c != 0; c = c.getNextSibling())
+        writeNode(c);
+      break;
+    case DOM::Node_base::ELEMENT_NODE:
+      writeElement(node);
+      break;
+    case DOM::Node_base::TEXT_NODE:
+      writeEscaped(node.getNodeValue(), false);
+      break;
+    case DOM::Node_base::ENTITY_REFERENCE_NODE:
+      put(UnicodeT::AMPERSAND);
+      put(node.getNodeName());
+      put(UnicodeT::SEMI_COLON);
+      break;
+    case DOM::Node_base::CDATA_SECTION_NODE:
+      writeCDATA(node.getNodeValue());
+      break;
+    case DOM::Node_base::PROCESSING_INSTRUCTION_NODE:
+      put(UnicodeT::LESS_THAN_SIGN);
+      put(UnicodeT::QUESTION_MARK);
+      put(node.getNodeName());
+      put(UnicodeT::SPACE);
+      put(node.getNodeValue());
+      put(UnicodeT::QUESTION_MARK);
+      put(UnicodeT::GREATER_THAN_SIGN);
+      break;
+    case DOM::Node_base::COMMENT_NODE:
+      put("<!--");
+      put(node.getNodeValue());
+      put("-->");
+      break;
+    default:
+      break;
+    } // switch
+  } // writeNode
+
+  void writeDocument(const NodeT& document)
+  {
+    if(!(options_ & no_declaration))
+    {
+      put("<?xml version=\"1.0\"?>");
+      put(UnicodeT::LINE_FEED);
+    } // if ...
+
+    for(NodeT c = document.getFirstChild(); c != 0; c = c.getNextSibling())
+    {
+      writeNode(c);
+      if(options_ & pretty)
+        put(UnicodeT::LINE_FEED);
+    } // for ...
+  } // writeDocument
+
+  void writeElement(const NodeT& element)
+  {
+    scopes_.push_back(bindings_.size());
+
+    put(UnicodeT::LESS_THAN_SIGN);
+    size_t binding = writeName(element, false);
+    writeAttributes(element);
+    writeDeclarations();
+
+    if(!element.hasChildNodes())
+    {
+      put(UnicodeT::SLASH);
+      put(UnicodeT::GREATER_THAN_SIGN);
+    }
+    else
+    {
+      put(UnicodeT::GREATER_THAN_SIGN);
+
+      bool indent = (options_ & pretty) && onlyElements(element);
+      ++depth_;
+      for(NodeT c = element.getFirstChild(); c != 0; c = c.getNextSibling())
+      {
+        if(indent)
+        {
+          if(c.getNodeType() == DOM::Node_base::TEXT_NODE)
+            continue;
+          newline();
+        } // if ...
+        writeNode(c);
+      } // for ...
+      --depth_;
+      if(indent)
+        newline();
+
+      // an attribute may since have bound another prefix to the element's
+      // namespace, so the end tag uses whatever the start tag did
+      put(UnicodeT::LESS_THAN_SIGN);
+      put(UnicodeT::SLASH);
+      if(binding == noBinding)
+        put(element.getNodeName());
+      else
+      {
+        if(!string_adaptorT::empty(bindings_[binding].prefix))
+        {
+          put(bindings_[binding].prefix);
+          put(UnicodeT::COLON);
+        } // if ...
+        put(element.getLocalName());
+      } // if ...
+      put(UnicodeT::GREATER_THAN_SIGN);
+    } // if ...
+
+    bindings_.resize(scopes_.back(), Binding(stringT(), stringT()));
+    scopes_.pop_back();
+  } // writeElement
+
+  void writeAttributes(const NodeT& element)
+  {
+    const DOM::NamedNodeMap<stringT, string_adaptorT> attrs = element.getAttributes();
+    unsigned int count = attrs.getLength();
+    if(count == 0)
+      return;
+
+    attrs_.clear();
+    for(unsigned int a = 0; a != count; ++a)
+    {
+      NodeT attr = attrs.item(a);
+      const stringT& name = attr.getNodeName();
+      if(string_adaptorT::empty(name) || isXmlns(name) || isXmlns(attr.getPrefix()))
+        continue;
+      attrs_.push_back(attr);
+    } // for ...
+    if(options_ & sort_attributes)
+      std::stable_sort(attrs_.begin(), attrs_.end(), name_order);
+
+    for(typename std::vector<NodeT>::const_iterator a = attrs_.begin(), ae = attrs_.end(); a != ae; ++a)
+    {
+      put(UnicodeT::SPACE);
+      writeName(*a, true);
+      put(UnicodeT::EQUALS_SIGN);
+      put(UnicodeT::QUOTATION_MARK);
+      writeEscaped(a->getNodeValue(), true);
+      put(UnicodeT::QUOTATION_MARK);
+    } // for ...
+    attrs_.clear();
+  } // writeAttributes
+
+  void writeDeclarations()
+  {
+    // sorts pointers, as the element's end tag needs its binding to
+    // stay where it is
+    declarations_.clear();
+    for(size_t b = scopes_.back(); b != bindings_.size(); ++b)
+      declarations_.push_back(&bindings_[b]);
+    if(options_ & sort_attributes)
+      std::sort(declarations_.begin(), declarations_.end(), uri_order);
+
+    for(typename std::vector<const Binding*>::const_iterator d = declarations_.begin(), de = declarations_.end(); d != de; ++d)
+    {
+      const Binding* b = *d;
+      put(" xmlns");
+      if(!string_adaptorT::empty(b->prefix))
+      {
+        put(UnicodeT::COLON);
+        put(b->prefix);
+      } // if ...
+      put(UnicodeT::EQUALS_SIGN);
+      put(UnicodeT::QUOTATION_MARK);
+      writeEscaped(b->uri, true);
+      put(UnicodeT::QUOTATION_MARK);
+    } // for ...
+  } // writeDeclarations
+
+  // writes node's qualified name, declaring its namespace if it isn't
+  // already in scope, and returns the binding it used
+  size_t writeName(const NodeT& node, bool isAttribute)
+  {
+    const stringT& namespaceURI = node.getNamespaceURI();
+    if(string_adaptorT::empty(namespaceURI))
+    {
+      if(!isAttribute)
+      {
+        const Binding* def = lookupPrefix(stringT());
+        if((def != 0) && !string_adaptorT::empty(def->uri))
+          bindings_.push_back(Binding(stringT(), stringT()));
+      } // if ...
+      put(node.getNodeName());
+      return noBinding;
+    } // if ...
+
+    if(isAttribute && (namespaceURI == xml_uri_))
+    {
+      // always in scope, never declared
+      put(xml_);
+      put(UnicodeT::COLON);
+      put(node.getLocalName());
+      return noBinding;
+    } // if ...
+
+    size_t binding = lookupURI(namespaceURI, isAttribute);
+    if(binding == noBinding)
+    {
+      // an attribute mustn't take a prefix the element might be using
+      stringT prefix = node.getPrefix();
+      if(isAttribute && (string_adaptorT::empty(prefix) || (lookupPrefix(prefix) != 0)))
+        prefix = autoPrefix();
+      bindings_.push_back(Binding(prefix, namespaceURI));
+      binding = bindings_.size() - 1;
+    } // if ...
+
+    if(!string_adaptorT::empty(bindings_[binding].prefix))
+    {
+      put(bindings_[binding].prefix);
+      put(UnicodeT::COLON);
+    } // if ...
+    put(node.getLocalName());
+    return binding;
+  } // writeName
+
+  // the innermost binding of namespaceURI whose prefix isn't hidden by
+  // an inner binding - elements use the default namespace if they can,
+  // attributes can't use it at all
+  size_t lookupURI(const stringT& namespaceURI, bool needPrefix) const
+  {
+    if(!needPrefix)
+    {
+      const Binding* def = lookupPrefix(stringT());
+      if((def != 0) && (def->uri == namespaceURI))
+        return def - &bindings_[0];
+    } // if ...
+
+    for(size_t b = bindings_.size(); b != 0; --b)
+    {
+      const Binding& binding = bindings_[b-1];
+      if(!(binding.uri == namespaceURI))
+        continue;
+      if(needPrefix && string_adaptorT::empty(binding.prefix))
+        continue;
+      if(lookupPrefix(binding.prefix) == &binding)
+        return b-1;
+    } // for ...
+    return noBinding;
+  } // lookupURI
+
+  const Binding* lookupPrefix(const stringT& prefix) const
+  {
+    for(size_t b = bindings_.size(); b != 0; --b)
+      if(bindings_[b-1].prefix == prefix)
+        return &bindings_[b-1];
+    return 0;
+  } // lookupPrefix
+
+  stringT autoPrefix()
+  {
+    stringT prefix;
+    do
+    {
+      std::ostringstream os;
+      os << 'a' << autoPrefix_++;
+      prefix = string_adaptorT::construct_from_utf8(os.str().c_str());
+    }
+    while(lookupPrefix(prefix) != 0);
+    return prefix;
+  } // autoPrefix
+
+  bool isXmlns(const stringT& name) const
+  {
+    return name == xmlns_;
+  } // isXmlns
+
+  static bool isWhitespace(const stringT& text)
+  {
+    for(const_iterator c = string_adaptorT::begin(text), ce = string_adaptorT::end(text); c != ce; ++c)
+      if(!Arabica::XML::is_space(*c))
+        return false;
+    return true;
+  } // isWhitespace
+
+  // true if element's children are elements, comments and processing
+  // instructions, give or take some whitespace, so can be laid out
+  static bool onlyElements(const NodeT& element)
+  {
+    bool any = false;
+    for(NodeT c = element.getFirstChild(); c != 0; c = c.getNextSibling())
+      switch(c.getNodeType())
+      {
+      case DOM::Node_base::ELEMENT_NODE:
+      case DOM::Node_base::COMMENT_NODE:
+      case DOM::Node_base::PROCESSING_INSTRUCTION_NODE:
+        any = true;
+        break;
+      case DOM::Node_base::TEXT_NODE:
+        if(!isWhitespace(c.getNodeValue()))
+          return false;
+        break;
+      default:
+        return false;
+      } // switch
+    return any;
+  } // onlyElements
+
+  void newline()
+  {
+    put(UnicodeT::LINE_FEED);
+    for(int d = 0; d != depth_; ++d)
+    {
+      put(UnicodeT::SPACE);
+      put(UnicodeT::SPACE);
+    } // for ...
+  } // newline
+
+  //////////////////////////////////////
+  // escaping - copies the runs of characters which don't need escaping
+  // straight into the buffer
+  void writeEscaped(const stringT& text, bool attribute)
+  {
+    if(string_adaptorT::empty(text))
+      return;
+    const charT* c = &*string_adaptorT::begin(text);
+    const charT* const ce = c + (string_adaptorT::end(text) - string_adaptorT::begin(text));
+    while(c != ce)
+    {
+      const charT* run = c;
+      c = attribute ? XML::find_attribute_escape(c, ce) : XML::find_text_escape(c, ce);
+      put(run, c);
+      if(c == ce)
+        break;
+
+      if(*c == UnicodeT::LESS_THAN_SIGN)
+        put("&lt;");
+      else if(*c == UnicodeT::GREATER_THAN_SIGN)
+        put("&gt;");
+      else if(*c == UnicodeT::AMPERSAND)
+        put("&amp;");
+      else if(*c == UnicodeT::QUOTATION_MARK)
+        put("&quot;");
+      else if(*c == UnicodeT::HORIZONTAL_TABULATION)
+        put("&#x9;");
+      else if(*c == UnicodeT::LINE_FEED)
+        put("&#xA;");
+      else if(*c == UnicodeT::CARRIAGE_RETURN)
+        put("&#xD;");
+      else
+        put(*c);
+      ++c;
+    } // while ...
+  } // writeEscaped
+
+  void writeCDATA(const stringT& text)
+  {
+    // ]]> can't appear in a CDATA section, so is split across two
+    put("<![CDATA[");
+    const_iterator c = string_adaptorT::begin(text), ce = string_adaptorT::end(text);
+    const_iterator run = c;
+    for( ; c != ce; ++c)
+      if((*c == UnicodeT::GREATER_THAN_SIGN) &&
+         (c - run >= 2) &&
+         (*(c-1) == UnicodeT::RIGHT_SQUARE_BRACKET) &&
+         (*(c-2) == UnicodeT::RIGHT_SQUARE_BRACKET))
+      {
+        put(run, c);
+        put("]]><![CDATA[");
+        run = c;
+      } // if ...
+    put(run, ce);
+    put("]]>");
+  } // writeCDATA
+
+  //////////////////////////////////////
+  // the buffer
+  void put(charT c)
+  {
+    if(used_ == bufferSize)
+      flush();
+    buffer_[used_++] = c;
+  } // put
+
+  template<class iteratorT>
+  void put(iteratorT begin, iteratorT end)
+  {
+    while(begin != end)
+    {
+      if(used_ == bufferSize)
+        flush();
+      size_t count = std::min<size_t>(bufferSize - used_, end - begin);
+      std::copy(begin, begin + count, buffer_ + used_);
+      used_ += count;
+      begin += count;
+    } // while ...
+  } // put
+
+  void put(const stringT& str)
+  {
+    put(string_adaptorT::begin(str), string_adaptorT::end(str));
+  } // put
+
+  // markup - ASCII only
+  void put(const char* markup)
+  {
+    while(*markup)
+      put(static_cast<charT>(*markup++));
+  } // put
+
+  void flush()
+  {
+    stream_.write(buffer_, used_);
+    used_ = 0;
+  } // flush
+
+  enum { bufferSize = 4096 };
+  static const size_t noBinding = static_cast<size_t>(-1);
+
+  ostreamT& stream_;
+  int options_;
+  charT buffer_[bufferSize];
+  size_t used_;
+  int depth_;
+  unsigned int autoPrefix_;
+  std::vector<Binding> bindings_;
+  std::vector<size_t> scopes_;
+  std::vector<NodeT> attrs_;
+  std::vector<const Binding*> declarations_;
+  const stringT xml_;
+  const stringT xmlns_;
+  const stringT xml_uri_;
+
+  Writer(const Writer&);
+  Writer& operator=(const Writer&);
+}; // class Writer
+
+} // namespace DOM
+} // namespace Arabica
+
+#endif
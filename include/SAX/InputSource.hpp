@@ -6,6 +6,7 @@
 
 #include <iosfwd>
 #include <string>
+#include <cstddef>
 
 #include <SAX/ArabicaConfig.hpp>
 #include <SAX/IStreamHandle.hpp>
@@ -63,6 +64,8 @@ public:
    */
   InputSource() : 
     byteStream_(),
+    bytes_(0),
+    byteCount_(0),
     publicId_(),
     systemId_(),
     encoding_()
@@ -84,12 +87,16 @@ public:
    */
   InputSource(const string_type& systemId) : 
     byteStream_(),
+    bytes_(0),
+    byteCount_(0),
     publicId_(),
     systemId_(systemId), 
     encoding_()
     { }
   InputSource(const InputSource& rhs) :
     byteStream_(rhs.byteStream_),
+    bytes_(rhs.bytes_),
+    byteCount_(rhs.byteCount_),
     publicId_(rhs.publicId_),
     systemId_(rhs.systemId_),
     encoding_(rhs.encoding_)
@@ -113,6 +120,8 @@ public:
    */
   InputSource(std::istream& byteStream) :
       byteStream_(byteStream),
+      bytes_(0),
+      byteCount_(0),
       publicId_(),
       systemId_(),
       encoding_()
@@ -138,6 +147,8 @@ public:
    */
   InputSource(std::auto_ptr<std::istream> byteStream) :
       byteStream_(byteStream),
+      bytes_(0),
+      byteCount_(0),
       publicId_(),
       systemId_(),
       encoding_()
@@ -145,6 +156,8 @@ public:
   
   InputSource(std::auto_ptr<std::iostream> byteStream) :
       byteStream_(byteStream),
+      bytes_(0),
+      byteCount_(0),
       publicId_(),
       systemId_(),
       encoding_()
@@ -156,6 +169,8 @@ public:
   InputSource& operator=(const InputSource& rhs)
   {
     byteStream_ = rhs.byteStream_;
+    bytes_ = rhs.bytes_;
+    byteCount_ = rhs.byteCount_;
     publicId_ = rhs.publicId_;
     systemId_ = rhs.systemId_;
     encoding_ = rhs.encoding_;
@@ -297,6 +312,44 @@ public:
   {
     return byteStream_;
   }
+
+  /**
+   * Set a block of memory holding the document.
+   *
+   * <p>The SAX parser will read from the memory in preference to
+   * a byte stream or opening a URI connection itself.  Parsers
+   * which can work directly on a contiguous buffer do so without
+   * any copying, others are given a stream reading from it.</p>
+   *
+   * @param bytes The start of the document.  The InputSource does
+   *              not take a copy, so the memory must remain valid
+   *              for as long as the InputSource is in use.
+   * @param byteCount The length of the document in bytes.
+   * @see #getBytes
+   * @see #getByteCount
+   */
+  void setBytes(const char* bytes, size_t byteCount)
+  {
+    bytes_ = bytes;
+    byteCount_ = byteCount;
+  } // setBytes
+
+  /**
+   * Get the block of memory holding the document.
+   *
+   * @return The start of the document, or null if none was supplied.
+   * @see #setBytes
+   */
+  const char* getBytes() const { return bytes_; }
+
+  /**
+   * Get the length of the block of memory holding the document.
+   *
+   * @return The length in bytes, or 0 if none was supplied.
+   * @see #setBytes
+   */
+  size_t getByteCount() const { return byteCount_; }
+
   /** 
    * Set the character encoding, if known.
    *
@@ -323,6 +376,8 @@ public:
   ///////////////////////////////////////////////////////////
 private:
   IStreamHandle byteStream_;
+  const char* bytes_;
+  size_t byteCount_;
 	string_type publicId_;
 	string_type systemId_;
 	string_type encoding_;
@@ -0,0 +1,905 @@
+#ifndef ARABICA_SAX_STREAMING_XPATH_FILTER_HPP
+#define ARABICA_SAX_STREAMING_XPATH_FILTER_HPP
+
+#include <SAX/ArabicaConfig.hpp>
+#include <SAX/helpers/XMLFilterImpl.hpp>
+#include <SAX/SAXException.hpp>
+#include <SAX/SAXNotSupportedException.hpp>
+#include <Arabica/StringAdaptor.hpp>
+#include <XPath/impl/xpath_number.hpp>
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+
+namespace Arabica
+{
+namespace SAX
+{
+
+/**
+  Told about each node a StreamingXPathFilter matches, as soon as it is
+  found.
+ */
+template<class string_type, class string_adaptor = Arabica::default_string_adaptor<string_type> >
+class StreamingXPathHandler
+{
+public:
+  typedef Attributes<string_type, string_adaptor> AttributesT;
+
+  virtual ~StreamingXPathHandler() { }
+
+  /**
+    An element matches.  This is called as it starts, before the filter
+    passes its startElement on.
+   */
+  virtual void element(const string_type& /* namespaceURI */, const string_type& /* localName */,
+                       const string_type& /* qName */, const AttributesT& /* atts */) { }
+
+  /**
+    An attribute matches.
+   */
+  virtual void attribute(const string_type& /* namespaceURI */, const string_type& /* localName */,
+                         const string_type& /* qName */, const string_type& /* value */) { }
+
+  /**
+    A text node matches.  Its text is given whole, however the parser
+    split it up.
+   */
+  virtual void text(const string_type& /* text */) { }
+}; // class StreamingXPathHandler
+
+/**
+  Matches a forward-only subset of XPath against a document as it is
+  parsed, so no tree need be built to find things in it.
+
+  The expression may be a location path, absolute or relative - either
+  way, it's taken from the document root - or a union of them.  Steps may
+  use the child, descendant and attribute axes, and the // and @
+  abbreviations.  Node tests may be names, prefix:*, * or text().
+  Element steps may have predicates made of positions - [2], or
+  position() compared with a number - and tests on the element's
+  attributes - [@type] or [@type='x'] or [@n > 3] - combined with and,
+  or, not() and brackets.  Positions can't be used with the descendant
+  axis, as that would mean looking ahead.  Anything outside all that is
+  rejected by setExpression.
+
+  Each match is reported to the StreamingXPathHandler, and the filter's
+  own ContentHandler is passed only what has been matched - each matched
+  element with all of its content, and matched text - so a Writer or
+  SAX2DOM behind the filter sees just those parts of the document.  The
+  prefix mappings in scope where a matched element starts are passed on
+  with it, wherever they were declared.  The filter keeps nothing but a
+  little state for each open element, so the memory it needs goes with
+  the depth of the document, not its size.
+ */
+template<class string_type, class string_adaptor = Arabica::default_string_adaptor<string_type> >
+class StreamingXPathFilter : public XMLFilterImpl<string_type, string_adaptor>
+{
+  typedef XMLFilterImpl<string_type, string_adaptor> XMLFilterT;
+public:
+  typedef XMLReaderInterface<string_type, string_adaptor> XMLReaderT;
+  typedef Attributes<string_type, string_adaptor> AttributesT;
+  typedef StreamingXPathHandler<string_type, string_adaptor> StreamingXPathHandlerT;
+
+  StreamingXPathFilter() :
+    XMLFilterT(),
+    handler_(0),
+    counters_(0),
+    depth_(0),
+    forwarding_(0),
+    matches_(0)
+  {
+  } // StreamingXPathFilter
+
+  StreamingXPathFilter(XMLReaderT& parent) :
+    XMLFilterT(parent),
+    handler_(0),
+    counters_(0),
+    depth_(0),
+    forwarding_(0),
+    matches_(0)
+  {
+  } // StreamingXPathFilter
+
+  virtual ~StreamingXPathFilter() { }
+
+  /**
+    Binds a prefix for use in the expression.  Do this before
+    setExpression.
+   */
+  void declareNamespace(const string_type& prefix, const string_type& namespaceURI)
+  {
+    namespaces_[string_adaptor::asStdString(prefix)] = namespaceURI;
+  } // declareNamespace
+
+  /**
+    Compiles the expression to match.
+
+    @exception SAXNotSupportedException if the expression is XPath, but
+               not part of the subset that can be matched while streaming
+    @exception SAXException if the expression isn't XPath
+   */
+  void setExpression(const string_type& xpath)
+  {
+    steps_.clear();
+    conditions_.clear();
+    initial_.clear();
+    counters_ = 0;
+
+    expr_ = string_adaptor::asStdString(xpath);
+    pos_ = 0;
+    parseUnion();
+    skipSpace();
+    if(pos_ != expr_.length())
+      syntaxError();
+  } // setExpression
+
+  void setMatchHandler(StreamingXPathHandlerT& handler) { handler_ = &handler; }
+  StreamingXPathHandlerT* getMatchHandler() const { return handler_; }
+
+  /**
+    How many nodes have been matched in the document being parsed, or
+    the last one.
+   */
+  unsigned long matches() const { return matches_; }
+
+  /////////////////////////////////////////////////
+  // ContentHandler
+  virtual void startDocument()
+  {
+    depth_ = 0;
+    forwarding_ = 0;
+    matches_ = 0;
+    text_ = string_adaptor::empty_string();
+    pendingPrefixes_.clear();
+    replayedPrefixes_.clear();
+
+    Frame& root = pushFrame();
+    for(std::vector<int>::const_iterator s = initial_.begin(), se = initial_.end(); s != se; ++s)
+      addState(root, *s);
+
+    XMLFilterT::startDocument();
+  } // startDocument
+
+  virtual void endDocument()
+  {
+    flushText();
+    depth_ = 0;
+    XMLFilterT::endDocument();
+  } // endDocument
+
+  virtual void startPrefixMapping(const string_type& prefix, const string_type& uri)
+  {
+    if(forwarding_)
+      XMLFilterT::startPrefixMapping(prefix, uri);
+    else
+      pendingPrefixes_.push_back(std::make_pair(prefix, uri));
+  } // startPrefixMapping
+
+  // the matched element's own mappings were replayed, and are ended with it
+  virtual void endPrefixMapping(const string_type& prefix)
+  {
+    if(forwarding_)
+      XMLFilterT::endPrefixMapping(prefix);
+  } // endPrefixMapping
+
+  virtual void startElement(const string_type& namespaceURI, const string_type& localName,
+                            const string_type& qName, const AttributesT& atts)
+  {
+    flushText();
+
+    Frame& frame = pushFrame();
+    Frame& context = frames_[depth_ - 2];
+
+    bool matched = false;
+    for(std::vector<int>::const_iterator s = context.states.begin(), se = context.states.end(); s != se; ++s)
+    {
+      const Step& step = steps_[*s];
+      if(step.descendant)
+        addState(frame, *s);
+      if(step.kind != ElementStep)
+        continue;
+      if(!matchesElement(step, namespaceURI, localName, qName) ||
+         !matchesPredicates(step, context, atts))
+        continue;
+
+      if(step.last)
+        matched = true;
+      else
+        addState(frame, *s + 1);
+    } // for ...
+
+    if(matched)
+    {
+      ++matches_;
+      if(handler_)
+        handler_->element(namespaceURI, localName, qName, atts);
+    } // if ...
+    if(frame.attributes)
+      matchAttributes(frame, atts);
+
+    frame.prefixes.swap(pendingPrefixes_);
+    pendingPrefixes_.clear();
+    if(forwarding_ == 0 && matched)
+      replayPrefixes();
+
+    if(forwarding_ || matched)
+    {
+      ++forwarding_;
+      frame.forwarded = true;
+      XMLFilterT::startElement(namespaceURI, localName, qName, atts);
+    } // if ...
+  } // startElement
+
+  virtual void endElement(const string_type& namespaceURI, const string_type& localName,
+                          const string_type& qName)
+  {
+    flushText();
+
+    bool forwarded = frames_[depth_ - 1].forwarded;
+    --depth_;
+    if(forwarded)
+    {
+      --forwarding_;
+      XMLFilterT::endElement(namespaceURI, localName, qName);
+      if(forwarding_ == 0)
+        endReplayedPrefixes();
+    } // if ...
+  } // endElement
+
+  virtual void characters(const string_type& ch)
+  {
+    if(frames_[depth_ - 1].text)
+      string_adaptor::append(text_, ch);
+    if(forwarding_ || frames_[depth_ - 1].text)
+      XMLFilterT::characters(ch);
+  } // characters
+
+  virtual void ignorableWhitespace(const string_type& ch)
+  {
+    if(frames_[depth_ - 1].text)
+      string_adaptor::append(text_, ch);
+    if(forwarding_ || frames_[depth_ - 1].text)
+      XMLFilterT::ignorableWhitespace(ch);
+  } // ignorableWhitespace
+
+  virtual void processingInstruction(const string_type& target, const string_type& data)
+  {
+    flushText();
+    if(forwarding_)
+      XMLFilterT::processingInstruction(target, data);
+  } // processingInstruction
+
+  virtual void skippedEntity(const string_type& name)
+  {
+    if(forwarding_)
+      XMLFilterT::skippedEntity(name);
+  } // skippedEntity
+
+  /////////////////////////////////////////////////
+  // LexicalHandler
+  virtual void startCDATA()
+  {
+    if(forwarding_)
+      XMLFilterT::startCDATA();
+  } // startCDATA
+
+  virtual void endCDATA()
+  {
+    if(forwarding_)
+      XMLFilterT::endCDATA();
+  } // endCDATA
+
+  virtual void comment(const string_type& text)
+  {
+    flushText();
+    if(forwarding_)
+      XMLFilterT::comment(text);
+  } // comment
+
+private:
+  enum StepKind { ElementStep, AttributeStep, TextStep };
+  enum NameTestKind { QualifiedName, AnyNameInNamespace, AnyName };
+  enum Operator { Equals, NotEquals, LessThan, LessThanEquals, GreaterThan, GreaterThanEquals };
+
+  struct Step
+  {
+    Step() : kind(ElementStep), test(AnyName), descendant(false), last(false), positional(false), counterBase(0) { }
+
+    StepKind kind;
+    NameTestKind test;
+    string_type namespaceURI;
+    string_type localName;
+    string_type qName;
+    bool descendant;
+    bool last;
+    bool positional;
+    std::vector<int> predicates;  // indexes into conditions_
+    int counterBase;              // predicate i counts positions in counters[counterBase + i]
+  }; // struct Step
+
+  struct Condition
+  {
+    enum Kind { Position, HasAttribute, AttributeCompare, And, Or, Not };
+
+    Condition() : kind(Position), op(Equals), number(0), numeric(true), left(-1), right(-1) { }
+
+    Kind kind;
+    Operator op;
+    double number;
+    string_type literal;
+    bool numeric;          // compare with number rather than literal
+    string_type namespaceURI;
+    string_type localName;
+    string_type qName;
+    int left;
+    int right;
+  }; // struct Condition
+
+  typedef std::vector<std::pair<string_type, string_type> > Prefixes;
+
+  // what's known about an open element
+  struct Frame
+  {
+    Frame() : text(false), attributes(false), forwarded(false) { }
+
+    std::vector<int> states;    // steps to try against the element's children
+    std::vector<int> counters;  // positions of the children, per predicate
+    Prefixes prefixes;          // mappings declared on the element
+    bool text;                  // the element's text is matched
+    bool attributes;            // some of the element's attributes might be
+    bool forwarded;
+  }; // struct Frame
+
+  Frame& pushFrame()
+  {
+    if(depth_ == frames_.size())
+      frames_.push_back(Frame());
+    Frame& frame = frames_[depth_++];
+    frame.states.clear();
+    frame.counters.assign(counters_, 0);
+    frame.prefixes.clear();
+    frame.text = false;
+    frame.attributes = false;
+    frame.forwarded = false;
+    return frame;
+  } // pushFrame
+
+  void addState(Frame& frame, int s)
+  {
+    for(std::vector<int>::const_iterator i = frame.states.begin(), ie = frame.states.end(); i != ie; ++i)
+      if(*i == s)
+        return;
+    frame.states.push_back(s);
+    if(steps_[s].kind == TextStep)
+      frame.text = true;
+    if(steps_[s].kind == AttributeStep)
+      frame.attributes = true;
+  } // addState
+
+  // A Writer only declares the prefixes it's told about, so a match has
+  // every mapping in scope replayed before it - the innermost for each
+  // prefix - not just those declared on the matched element.
+  void replayPrefixes()
+  {
+    replayedPrefixes_.clear();
+    for(size_t d = depth_; d != 0; --d)
+    {
+      const Prefixes& declared = frames_[d - 1].prefixes;
+      for(typename Prefixes::const_iterator p = declared.begin(), pe = declared.end(); p != pe; ++p)
+        if(!isReplayed(p->first))
+        {
+          replayedPrefixes_.push_back(*p);
+          XMLFilterT::startPrefixMapping(p->first, p->second);
+        } // if ...
+    } // for ...
+  } // replayPrefixes
+
+  bool isReplayed(const string_type& prefix) const
+  {
+    for(typename Prefixes::const_iterator p = replayedPrefixes_.begin(), pe = replayedPrefixes_.end(); p != pe; ++p)
+      if(p->first == prefix)
+        return true;
+    return false;
+  } // isReplayed
+
+  void endReplayedPrefixes()
+  {
+    for(typename Prefixes::const_iterator p = replayedPrefixes_.begin(), pe = replayedPrefixes_.end(); p != pe; ++p)
+      XMLFilterT::endPrefixMapping(p->first);
+    replayedPrefixes_.clear();
+  } // endReplayedPrefixes
+
+  void flushText()
+  {
+    if(string_adaptor::empty(text_))
+      return;
+    ++matches_;
+    if(handler_)
+      handler_->text(text_);
+    text_ = string_adaptor::empty_string();
+  } // flushText
+
+  static bool matchesName(NameTestKind test,
+                          const string_type& testURI, const string_type& testLocalName, const string_type& testQName,
+                          const string_type& namespaceURI, const string_type& localName, const string_type& qName)
+  {
+    if(test == AnyName)
+      return true;
+    if(string_adaptor::empty(localName))  // no namespace processing
+      return (test == QualifiedName) && (testQName == qName);
+    if(!(testURI == namespaceURI))
+      return false;
+    return (test == AnyNameInNamespace) || (testLocalName == localName);
+  } // matchesName
+
+  bool matchesElement(const Step& step, const string_type& namespaceURI, const string_type& localName, const string_type& qName) const
+  {
+    return matchesName(step.test, step.namespaceURI, step.localName, step.qName, namespaceURI, localName, qName);
+  } // matchesElement
+
+  bool matchesPredicates(const Step& step, Frame& context, const AttributesT& atts) const
+  {
+    for(size_t p = 0; p != step.predicates.size(); ++p)
+    {
+      int position = ++context.counters[step.counterBase + p];
+      if(!evaluate(step.predicates[p], position, atts))
+        return false;
+    } // for ...
+    return true;
+  } // matchesPredicates
+
+  void matchAttributes(const Frame& frame, const AttributesT& atts)
+  {
+    for(int a = 0, ae = atts.getLength(); a != ae; ++a)
+      for(std::vector<int>::const_iterator s = frame.states.begin(), se = frame.states.end(); s != se; ++s)
+      {
+        const Step& step = steps_[*s];
+        if(step.kind != AttributeStep ||
+           !matchesName(step.test, step.namespaceURI, step.localName, step.qName,
+                        atts.getURI(a), atts.getLocalName(a), atts.getQName(a)))
+          continue;
+
+        ++matches_;
+        if(handler_)
+          handler_->attribute(atts.getURI(a), atts.getLocalName(a), atts.getQName(a), atts.getValue(a));
+        break;
+      } // for ...
+  } // matchAttributes
+
+  bool evaluate(int c, int position, const AttributesT& atts) const
+  {
+    const Condition& condition = conditions_[c];
+    switch(condition.kind)
+    {
+      case Condition::Position:
+        return compare(condition.op, position, condition.number);
+      case Condition::HasAttribute:
+        return findAttribute(condition, atts) != -1;
+      case Condition::AttributeCompare:
+        {
+          int a = findAttribute(condition, atts);
+          if(a == -1)
+            return false;
+          const string_type& value = atts.getValue(a);
+          if(!condition.numeric && (condition.op == Equals || condition.op == NotEquals))
+            return (value == condition.literal) == (condition.op == Equals);
+          double rhs = condition.numeric ? condition.number : toNumber(condition.literal);
+          return compare(condition.op, toNumber(value), rhs);
+        }
+      case Condition::And:
+        return evaluate(condition.left, position, atts) && evaluate(condition.right, position, atts);
+      case Condition::Or:
+        return evaluate(condition.left, position, atts) || evaluate(condition.right, position, atts);
+      case Condition::Not:
+        return !evaluate(condition.left, position, atts);
+    } // switch
+    return false;
+  } // evaluate
+
+  static int findAttribute(const Condition& condition, const AttributesT& atts)
+  {
+    for(int a = 0, ae = atts.getLength(); a != ae; ++a)
+      if(matchesName(QualifiedName, condition.namespaceURI, condition.localName, condition.qName,
+                     atts.getURI(a), atts.getLocalName(a), atts.getQName(a)))
+        return a;
+    return -1;
+  } // findAttribute
+
+  static bool compare(Operator op, double lhs, double rhs)
+  {
+    switch(op)
+    {
+      case Equals: return lhs == rhs;
+      case NotEquals: return lhs != rhs;
+      case LessThan: return lhs < rhs;
+      case LessThanEquals: return lhs <= rhs;
+      case GreaterThan: return lhs > rhs;
+      case GreaterThanEquals: return lhs >= rhs;
+    } // switch
+    return false;
+  } // compare
+
+  // XPath's number(), which is stricter than strtod
+  static double toNumber(const string_type& s)
+  {
+    return XPath::impl::parseNumber(string_adaptor::begin(s), string_adaptor::end(s));
+  } // toNumber
+
+  ///////////////////////////////////////////////////////
+  // the expression
+  void parseUnion()
+  {
+    parsePath();
+    while(skip("|"))
+      parsePath();
+  } // parseUnion
+
+  void parsePath()
+  {
+    bool descendant = false;
+    if(skip("//"))
+      descendant = true;
+    else if(skip("/") && atEnd())
+      unsupported("the root node");
+
+    initial_.push_back(static_cast<int>(steps_.size()));
+    for(;;)
+    {
+      parseStep(descendant);
+      if(skip("//"))
+        descendant = true;
+      else if(skip("/"))
+        descendant = false;
+      else
+        break;
+      if(steps_.back().kind != ElementStep)
+        unsupported("steps after attributes or text");
+    } // for ...
+    steps_.back().last = true;
+  } // parsePath
+
+  void parseStep(bool descendant)
+  {
+    Step step;
+    step.descendant = descendant;
+
+    skipSpace();
+    if(skip("@") || skip("attribute::"))
+      step.kind = AttributeStep;
+    else if(skip("descendant::"))
+    {
+      if(descendant)
+        unsupported("// followed by the descendant axis");
+      step.descendant = true;
+      step.positional = true;  // positions would be counted among descendants
+    }
+    else if(skip("child::"))
+      ;
+    else if(lookingAt(".") || lookingAt("..") || (peekName() && lookingAtAxis()))
+      unsupported("that axis");
+
+    skipSpace();
+    if(step.kind == ElementStep && skip("text()"))
+      step.kind = TextStep;
+    else
+      parseNameTest(step.test, step.namespaceURI, step.localName, step.qName);
+
+    while(skip("["))
+    {
+      if(step.kind != ElementStep)
+        unsupported("predicates on attributes or text");
+      bool usesPosition = false;
+      step.predicates.push_back(parseOr(usesPosition));
+      if(usesPosition && step.positional)
+        unsupported("positions on the descendant axis");
+      if(!skip("]"))
+        syntaxError();
+    } // while ...
+    step.counterBase = counters_;
+    counters_ += static_cast<int>(step.predicates.size());
+
+    steps_.push_back(step);
+  } // parseStep
+
+  void parseNameTest(NameTestKind& test, string_type& namespaceURI, string_type& localName, string_type& qName)
+  {
+    skipSpace();
+    if(skip("*"))
+    {
+      test = AnyName;
+      return;
+    } // if ...
+
+    std::string name = parseNCName();
+    std::string prefix;
+    if(lookingAt(":") && !lookingAt("::"))
+    {
+      ++pos_;
+      prefix = name;
+      if(skip("*"))
+      {
+        test = AnyNameInNamespace;
+        namespaceURI = resolve(prefix);
+        return;
+      } // if ...
+      name = parseNCName();
+    } // if ...
+    if(lookingAt("("))
+      unsupported(name + "()");
+
+    test = QualifiedName;
+    if(!prefix.empty())
+      namespaceURI = resolve(prefix);
+    localName = string_adaptor::construct_from_utf8(name.c_str());
+    qName = string_adaptor::construct_from_utf8((prefix.empty() ? name : prefix + ":" + name).c_str());
+  } // parseNameTest
+
+  int parseOr(bool& usesPosition)
+  {
+    int left = parseAnd(usesPosition);
+    while(skipWord("or"))
+      left = addCondition(Condition::Or, left, parseAnd(usesPosition));
+    return left;
+  } // parseOr
+
+  int parseAnd(bool& usesPosition)
+  {
+    int left = parsePrimary(usesPosition);
+    while(skipWord("and"))
+      left = addCondition(Condition::And, left, parsePrimary(usesPosition));
+    return left;
+  } // parseAnd
+
+  int parsePrimary(bool& usesPosition)
+  {
+    skipSpace();
+    if(skip("("))
+    {
+      int inner = parseOr(usesPosition);
+      if(!skip(")"))
+        syntaxError();
+      return inner;
+    } // if ...
+    if(skipFunction("not"))
+    {
+      int inner = addCondition(Condition::Not, parseOr(usesPosition), -1);
+      if(!skip(")"))
+        syntaxError();
+      return inner;
+    } // if ...
+
+    Condition condition;
+    if(lookingAtNumber())
+    {
+      condition.kind = Condition::Position;
+      condition.op = Equals;
+      condition.number = parseNumber();
+      usesPosition = true;
+    }
+    else if(skipFunction("position") && skip(")"))
+    {
+      condition.kind = Condition::Position;
+      condition.op = parseOperator();
+      skipSpace();
+      if(!lookingAtNumber())
+        unsupported("position() compared with anything but a number");
+      condition.number = parseNumber();
+      usesPosition = true;
+    }
+    else if(skip("@") || skip("attribute::"))
+    {
+      NameTestKind test;
+      parseNameTest(test, condition.namespaceURI, condition.localName, condition.qName);
+      if(test != QualifiedName)
+        unsupported("wildcard attribute tests in predicates");
+      condition.kind = Condition::HasAttribute;
+      skipSpace();
+      if(lookingAtOperator())
+      {
+        condition.kind = Condition::AttributeCompare;
+        condition.op = parseOperator();
+        skipSpace();
+        if(lookingAtNumber())
+          condition.number = parseNumber();
+        else
+        {
+          condition.numeric = false;
+          condition.literal = string_adaptor::construct_from_utf8(parseLiteral().c_str());
+        } // if ...
+      } // if ...
+    }
+    else if(lookingAt("last()"))
+      unsupported("last()");
+    else if(pos_ == expr_.length() || lookingAt("]"))
+      syntaxError();
+    else
+      unsupported("that predicate");
+
+    conditions_.push_back(condition);
+    return static_cast<int>(conditions_.size()) - 1;
+  } // parsePrimary
+
+  int addCondition(typename Condition::Kind kind, int left, int right)
+  {
+    Condition condition;
+    condition.kind = kind;
+    condition.left = left;
+    condition.right = right;
+    conditions_.push_back(condition);
+    return static_cast<int>(conditions_.size()) - 1;
+  } // addCondition
+
+  bool lookingAtOperator() const
+  {
+    return lookingAt("=") || lookingAt("!=") || lookingAt("<") || lookingAt(">");
+  } // lookingAtOperator
+
+  Operator parseOperator()
+  {
+    skipSpace();
+    if(skip("!=")) return NotEquals;
+    if(skip("<=")) return LessThanEquals;
+    if(skip(">=")) return GreaterThanEquals;
+    if(skip("=")) return Equals;
+    if(skip("<")) return LessThan;
+    if(skip(">")) return GreaterThan;
+    syntaxError();
+    return Equals;
+  } // parseOperator
+
+  bool lookingAtNumber() const
+  {
+    return pos_ < expr_.length() &&
+           (isDigit(expr_[pos_]) || (expr_[pos_] == '.' && pos_ + 1 < expr_.length() && isDigit(expr_[pos_ + 1])));
+  } // lookingAtNumber
+
+  double parseNumber()
+  {
+    size_t start = pos_;
+    while(pos_ < expr_.length() && (isDigit(expr_[pos_]) || expr_[pos_] == '.'))
+      ++pos_;
+    double number = XPath::impl::parseNumber(expr_.begin() + start, expr_.begin() + pos_);
+    if(number != number)
+      syntaxError();
+    return number;
+  } // parseNumber
+
+  std::string parseLiteral()
+  {
+    if(pos_ == expr_.length() || (expr_[pos_] != '\'' && expr_[pos_] != '"'))
+      syntaxError();
+    char quote = expr_[pos_++];
+    size_t end = expr_.find(quote, pos_);
+    if(end == std::string::npos)
+      syntaxError();
+    std::string literal = expr_.substr(pos_, end - pos_);
+    pos_ = end + 1;
+    return literal;
+  } // parseLiteral
+
+  std::string parseNCName()
+  {
+    size_t start = pos_;
+    if(!peekName())
+      syntaxError();
+    while(pos_ < expr_.length() && isNameChar(expr_[pos_]))
+      ++pos_;
+    return expr_.substr(start, pos_ - start);
+  } // parseNCName
+
+  string_type resolve(const std::string& prefix) const
+  {
+    typename Namespaces::const_iterator ns = namespaces_.find(prefix);
+    if(ns == namespaces_.end())
+      throw SAXException("Undeclared namespace prefix " + prefix + " in " + expr_);
+    return ns->second;
+  } // resolve
+
+  bool peekName() const
+  {
+    return pos_ < expr_.length() && isNameStart(expr_[pos_]);
+  } // peekName
+
+  bool lookingAtAxis() const
+  {
+    size_t p = pos_;
+    while(p < expr_.length() && isNameChar(expr_[p]))
+      ++p;
+    return expr_.compare(p, 2, "::") == 0;
+  } // lookingAtAxis
+
+  bool lookingAt(const char* s) const
+  {
+    return expr_.compare(pos_, std::char_traits<char>::length(s), s) == 0;
+  } // lookingAt
+
+  bool skip(const char* s)
+  {
+    skipSpace();
+    if(!lookingAt(s))
+      return false;
+    pos_ += std::char_traits<char>::length(s);
+    return true;
+  } // skip
+
+  bool skipWord(const char* word)
+  {
+    skipSpace();
+    size_t length = std::char_traits<char>::length(word);
+    if(!lookingAt(word) || (pos_ + length < expr_.length() && isNameChar(expr_[pos_ + length])))
+      return false;
+    pos_ += length;
+    return true;
+  } // skipWord
+
+  // name, then (, with whitespace allowed between them
+  bool skipFunction(const char* name)
+  {
+    size_t start = pos_;
+    if(skipWord(name) && skip("("))
+      return true;
+    pos_ = start;
+    return false;
+  } // skipFunction
+
+  void skipSpace()
+  {
+    while(pos_ < expr_.length() && (expr_[pos_] == ' ' || expr_[pos_] == '\t' || expr_[pos_] == '\r' || expr_[pos_] == '\n'))
+      ++pos_;
+  } // skipSpace
+
+  bool atEnd()
+  {
+    skipSpace();
+    return pos_ == expr_.length() || expr_[pos_] == '|';
+  } // atEnd
+
+  static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+  static bool isNameStart(char c)
+  {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || (static_cast<unsigned char>(c) >= 0x80);
+  } // isNameStart
+  static bool isNameChar(char c)
+  {
+    return isNameStart(c) || isDigit(c) || c == '-' || c == '.';
+  } // isNameChar
+
+  void syntaxError() const
+  {
+    throw SAXException("Bad XPath expression " + expr_);
+  } // syntaxError
+
+  void unsupported(const std::string& what) const
+  {
+    throw SAXNotSupportedException("Streaming XPath can't match " + what + " in " + expr_);
+  } // unsupported
+
+  typedef std::map<std::string, string_type> Namespaces;
+
+  StreamingXPathHandlerT* handler_;
+  Namespaces namespaces_;
+
+  // the compiled expression
+  std::vector<Step> steps_;
+  std::vector<Condition> conditions_;
+  std::vector<int> initial_;  // the first step of each path
+  int counters_;              // predicates, over all steps
+  std::string expr_;
+  size_t pos_;
+
+  // the state of the parse
+  std::vector<Frame> frames_;
+  size_t depth_;
+  int forwarding_;            // open elements inside a matched element
+  string_type text_;
+  Prefixes pendingPrefixes_;  // declared on the element about to start
+  Prefixes replayedPrefixes_; // passed on before the matched element
+  unsigned long matches_;
+}; // class StreamingXPathFilter
+
+} // namespace SAX
+} // namespace Arabica
+
+#endif
@@ -288,7 +288,7 @@ void Writer<string_type, string_adaptor>::writeAttributes(const AttributesT& att
              << UnicodeT::EQUALS_SIGN
              << UnicodeT::QUOTATION_MARK;
     string_type value = atts.getValue(i); 
-    std::for_each(value.begin(), value.end(), attribute_escaperT(*stream_));
+    Arabica::XML::escape_attribute(*stream_, value.begin(), value.end());
     *stream_ << UnicodeT::QUOTATION_MARK;
   }
 } // writeAttributes
@@ -347,7 +347,7 @@ void Writer<string_type, string_adaptor>::characters(const string_type& ch)
 {
   startElementClose();
   if(!inCDATA_)
-    std::for_each(ch.begin(), ch.end(), text_escaperT(*stream_));
+    Arabica::XML::escape_text(*stream_, ch.begin(), ch.end());
   else
     *stream_ << ch;
 
@@ -7,8 +7,9 @@
 #include <SAX/ArabicaConfig.hpp>
 #include <SAX/Attributes.hpp>
 #include <stdexcept>
-#include <deque>
+#include <vector>
 #include <sstream>
+#include <cstddef>
 
 namespace Arabica
 {
@@ -35,6 +36,13 @@ namespace SAX
  * AttributeListImpl AttributeListImpl}
  * class.</p>
  *
+ * <p>Attributes are held contiguously.  Once an element has more than
+ * a handful of attributes, name lookups go through a small hash index.
+ * The index is kept up to date as the list is modified, reusing its
+ * storage, never by a lookup, so a list that is only read can be shared
+ * between threads.  The findAttribute and valueOf methods give access to
+ * the stored strings without copying them.</p>
+ *
  * @since SAX 2.0
  * @author Jez Higgins, 
  *         <a href="mailto:jez@jezuk.co.uk">jez@jezuk.co.uk</a>
@@ -93,6 +101,7 @@ public:
   AttributesImpl& operator=(const AttributesT& rhs) 
   {
     setAttributes(rhs);
+    return *this;
   } // operator=
 
   bool operator==(const AttributesImpl& rhs) const
@@ -206,10 +215,7 @@ public:
    */
   virtual int getIndex(const string_type& uri, const string_type& localName) const
   {
-    typename AttrList::const_iterator a = std::find_if(attributes_.begin(), attributes_.end(), AttributeNamed(uri, localName));
-    if(a != attributes_.end())
-      return static_cast<int>(std::distance(attributes_.begin(), a));
-    return -1;
+    return indexOf(uri, localName);
   } // getIndex
 
   /**
@@ -221,13 +227,7 @@ public:
    */
   virtual int getIndex(const string_type& qName) const
   {
-	  size_t max = attributes_.size();
-	  for(size_t i = 0; i < max; ++i)
-    {
-	    if(attributes_[i].qName_ == qName)
-		    return static_cast<int>(i);
-    }
-    return -1;
+    return indexOf(qName);
   } // getIndex
 
   /**
@@ -242,10 +242,8 @@ public:
    */
   virtual string_type getType(const string_type& uri, const string_type& localName) const
   {
-    typename AttrList::const_iterator a = std::find_if(attributes_.begin(), attributes_.end(), AttributeNamed(uri, localName));
-    if(a != attributes_.end())
-      return a->type_;
-	  return emptyString_;
+    const Attr* a = findAttribute(uri, localName);
+    return a ? a->type_ : emptyString_;
   } // getType
 
   /**
@@ -258,13 +256,8 @@ public:
    */
   virtual string_type getType(const string_type& qName) const
   {
-	  size_t max = attributes_.size();
-	  for(size_t i = 0; i < max; ++i) 
-    {
-	    if(attributes_[i].qName_ == qName) 
-		    return attributes_[i].type_;
-    } // for ...
-    return emptyString_;
+    const Attr* a = findAttribute(qName);
+    return a ? a->type_ : emptyString_;
   } // getType
 
   /**
@@ -279,11 +272,8 @@ public:
    */
   virtual string_type getValue(const string_type& uri, const string_type& localName) const
   {
-    typename AttrList::const_iterator a = std::find_if(attributes_.begin(), attributes_.end(), AttributeNamed(uri, localName));
-    if(a != attributes_.end())
-        return a->value_;
-	  return emptyString_;
-  } // getType
+    return valueOf(uri, localName);
+  } // getValue
 
   /**
    * Look up an attribute's value by qualified (prefixed) name.
@@ -295,15 +285,85 @@ public:
    */
   virtual string_type getValue(const string_type& qName) const
   {
-	  size_t max = attributes_.size();
-	  for(size_t i = 0; i < max; ++i) 
-    {
-	    if(attributes_[i].qName_ == qName) 
-		    return attributes_[i].value_;
-    } // for ...
-    return emptyString_;
+    return valueOf(qName);
   } // getValue
 
+  ////////////////////////////////////////////////////////////////////
+  // Non-copying accessors.
+  /**
+   * Return an attribute by index.
+   *
+   * @param index The attribute's index (zero-based).
+   * @return The stored attribute.
+   * @exception std::out_of_range When the
+   *            supplied index does not point to an attribute
+   *            in the list.
+   */
+  const Attr& getAttribute(unsigned int index) const
+  {
+    if(index >= attributes_.size())
+      badIndex(index);
+    return attributes_[index];
+  } // getAttribute
+
+  /**
+   * Look up an attribute by Namespace-qualified name.
+   *
+   * @param uri The Namespace URI, or the empty string for a name
+   *        with no explicit Namespace URI.
+   * @param localName The local name.
+   * @return The stored attribute, or 0 if none matches.  The pointer
+   *         is invalidated by any modification of the list.
+   */
+  const Attr* findAttribute(const string_type& uri, const string_type& localName) const
+  {
+    int index = indexOf(uri, localName);
+    return (index != -1) ? &attributes_[index] : 0;
+  } // findAttribute
+
+  /**
+   * Look up an attribute by qualified (prefixed) name.
+   *
+   * @param qName The qualified name.
+   * @return The stored attribute, or 0 if none matches.  The pointer
+   *         is invalidated by any modification of the list.
+   */
+  const Attr* findAttribute(const string_type& qName) const
+  {
+    int index = indexOf(qName);
+    return (index != -1) ? &attributes_[index] : 0;
+  } // findAttribute
+
+  /**
+   * Look up an attribute's value by Namespace-qualified name, 
+   * without copying it.
+   *
+   * @param uri The Namespace URI, or the empty string for a name
+   *        with no explicit Namespace URI.
+   * @param localName The local name.
+   * @return The attribute's value, or an empty string if there is no
+   *         matching attribute.
+   */
+  const string_type& valueOf(const string_type& uri, const string_type& localName) const
+  {
+    const Attr* a = findAttribute(uri, localName);
+    return a ? a->value_ : emptyString_;
+  } // valueOf
+
+  /**
+   * Look up an attribute's value by qualified (prefixed) name, 
+   * without copying it.
+   *
+   * @param qName The qualified name.
+   * @return The attribute's value, or an empty string if there is no
+   *         matching attribute.
+   */
+  const string_type& valueOf(const string_type& qName) const
+  {
+    const Attr* a = findAttribute(qName);
+    return a ? a->value_ : emptyString_;
+  } // valueOf
+
   ////////////////////////////////////////////////////////////////////
   // Manipulators.
   /**
@@ -311,7 +371,9 @@ public:
    */
   void clear()
   {
-	  attributes_.erase(attributes_.begin(), attributes_.end());
+	  attributes_.clear();
+    qNameIndex_.clear();
+    nameIndex_.clear();
   } // clear
 
   /**
@@ -327,12 +389,14 @@ public:
 	  clear();
 	  
     int max = atts.getLength();
+    attributes_.reserve(max);
 	  for(int i = 0; i < max; ++i) 
       attributes_.push_back(Attr(atts.getURI(i),
                           atts.getLocalName(i),
                           atts.getQName(i),
                           atts.getType(i),
                           atts.getValue(i)));
+    reindex();
   } // setAttributes
 
   /**
@@ -359,11 +423,13 @@ public:
                     const string_type& value)
   {
     attributes_.push_back(Attr(uri, localName, qName, type, value));
+    indexLast();
   } // addAttribute
 
   void addAttribute(const Attr& attr)
   {
     attributes_.push_back(attr);
+    indexLast();
   } // addAttribute
 
   /**
@@ -385,14 +451,15 @@ public:
 	 	                         const string_type& type, 
                              const string_type& value)
   {
-    typename AttrList::iterator a = std::find_if(attributes_.begin(), attributes_.end(), AttributeNamed(uri, localName));
-    if(a != attributes_.end())
+    int index = indexOf(uri, localName);
+    if(index != -1)
     {
-      a->value_ = value;
+      attributes_[index].value_ = value;
       return;
     } // if ...
 
     attributes_.push_back(Attr(uri, localName, qName, type, value));
+    indexLast();
   } // addOrReplaceAttribute
 
   /**
@@ -431,6 +498,7 @@ public:
 	    a.qName_ = qName;
 	    a.type_ = type;
 	    a.value_ = value;
+      reindex();
     } 
     else 
 	    badIndex(index);
@@ -447,7 +515,10 @@ public:
   void removeAttribute(unsigned int index)
   {
 	  if(index < attributes_.size()) 
+    {
       attributes_.erase(attributes_.begin() + index);
+      reindex();
+    }
     else 
 	    badIndex(index);
   } // removeAttribute
@@ -465,7 +536,10 @@ public:
   void setURI(unsigned int index, const string_type& uri)
   {
 	  if(index < attributes_.size())
+    {
       attributes_[index].uri_ = uri;
+      reindex();
+    }
 	  else 
 	    badIndex(index);
   } // setURI
@@ -483,7 +557,10 @@ public:
   void setLocalName(unsigned int index, const string_type& localName)
   {
 	  if(index < attributes_.size())
+    {
       attributes_[index].localName_ = localName;
+      reindex();
+    }
 	  else 
 	    badIndex(index);
   } // setLocalName
@@ -500,8 +577,11 @@ public:
    */
   void setQName(unsigned int index, const string_type& qName)
   {
-	  if(index >= 0 && index < attributes_.size()) 
+	  if(index < attributes_.size()) 
+    {
       attributes_[index].qName_ = qName;
+      reindex();
+    }
 	  else 
 	    badIndex(index);
   } // setQName
@@ -517,7 +597,7 @@ public:
    */
   void setType(unsigned int index, const string_type& type)
   {
-    if(index >= 0 && index < attributes_.size()) 
+    if(index < attributes_.size()) 
       attributes_[index].type_ = type;
     else 
       badIndex(index);
@@ -544,7 +624,7 @@ private:
   ////////////////////////////////////////////////////////////////////
   // Internal methods.
   ////////////////////////////////////////////////////////////////////
-  void badIndex(unsigned int index)
+  void badIndex(unsigned int index) const
   {
     // sort out
     std::stringstream msg;
@@ -552,30 +632,103 @@ private:
     throw std::out_of_range(msg.str());
   }
 
-  class AttributeNamed
+  // below this many attributes a straight scan beats hashing
+  enum { IndexThreshold = 8 };
+
+  int indexOf(const string_type& qName) const
   {
-  public:
-    AttributeNamed(const string_type& uri, const string_type& localName) :
-        uri_(uri), localName_(localName) { }
-    AttributeNamed(const AttributeNamed& rhs) :
-        uri_(rhs.uri_), localName_(rhs.localName_) { }
-    ~AttributeNamed() { }
+    if(attributes_.size() <= IndexThreshold)
+    {
+      for(size_t i = 0, max = attributes_.size(); i != max; ++i)
+        if(attributes_[i].qName_ == qName)
+          return static_cast<int>(i);
+      return -1;
+    } // if ...
 
-    bool operator()(const Attr& attr) const
+    size_t mask = qNameIndex_.size() - 1;
+    for(size_t slot = hashOf(qName) & mask; qNameIndex_[slot] != -1; slot = (slot + 1) & mask)
+      if(attributes_[qNameIndex_[slot]].qName_ == qName)
+        return qNameIndex_[slot];
+    return -1;
+  } // indexOf
+
+  int indexOf(const string_type& uri, const string_type& localName) const
+  {
+    if(attributes_.size() <= IndexThreshold)
     {
-      return (attr.uri_ == uri_) && (attr.localName_ == localName_);
-    } // operator()
+      for(size_t i = 0, max = attributes_.size(); i != max; ++i)
+        if((attributes_[i].localName_ == localName) && (attributes_[i].uri_ == uri))
+          return static_cast<int>(i);
+      return -1;
+    } // if ...
 
-  private:
-    const string_type& uri_;
-    const string_type& localName_;
+    size_t mask = nameIndex_.size() - 1;
+    for(size_t slot = hashOf(localName, hashOf(uri)) & mask; nameIndex_[slot] != -1; slot = (slot + 1) & mask)
+    {
+      const Attr& a = attributes_[nameIndex_[slot]];
+      if((a.localName_ == localName) && (a.uri_ == uri))
+        return nameIndex_[slot];
+    } // for ...
+    return -1;
+  } // indexOf
+
+  // open addressing, linear probing, load factor at most 1/2
+  // entries are inserted in list order, so the first of any
+  // duplicate names is the one found
+  // there's an index only above IndexThreshold attributes
+  void reindex()
+  {
+    qNameIndex_.clear();
+    nameIndex_.clear();
+    if(attributes_.size() <= IndexThreshold)
+      return;
 
-    AttributeNamed& operator=(const AttributeNamed&);
-    bool operator==(const AttributeNamed&) const;
-  }; // class AttributeNamed
+    size_t slots = 32;
+    while(slots < attributes_.size() * 2)
+      slots <<= 1;
+    qNameIndex_.assign(slots, -1);
+    nameIndex_.assign(slots, -1);
+    for(size_t i = 0, max = attributes_.size(); i != max; ++i)
+      index(i);
+  } // reindex
+
+  // the attribute just added to the end
+  void indexLast()
+  {
+    if(qNameIndex_.size() < attributes_.size() * 2)
+      reindex();
+    else
+      index(attributes_.size() - 1);
+  } // indexLast
 
-  typedef typename std::deque<Attr> AttrList;
+  void index(size_t i)
+  {
+    size_t mask = qNameIndex_.size() - 1;
+    const Attr& a = attributes_[i];
+    size_t slot = hashOf(a.qName_) & mask;
+    while(qNameIndex_[slot] != -1)
+      slot = (slot + 1) & mask;
+    qNameIndex_[slot] = static_cast<int>(i);
+
+    slot = hashOf(a.localName_, hashOf(a.uri_)) & mask;
+    while(nameIndex_[slot] != -1)
+      slot = (slot + 1) & mask;
+    nameIndex_[slot] = static_cast<int>(i);
+  } // index
+
+  // FNV-1a
+  static size_t hashOf(const string_type& str, size_t hash = 2166136261u)
+  {
+    for(typename string_adaptor::const_iterator c = string_adaptor::begin(str), ce = string_adaptor::end(str); c != ce; ++c)
+      hash = (hash ^ static_cast<size_t>(*c)) * 16777619u;
+    return hash;
+  } // hashOf
+
+  typedef typename std::vector<Attr> AttrList;
   AttrList attributes_;
+
+  std::vector<int> qNameIndex_;
+  std::vector<int> nameIndex_;
   
   string_type emptyString_;
 }; // class AttributesImpl
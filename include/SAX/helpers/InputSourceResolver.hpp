@@ -5,6 +5,7 @@
 #include <iosfwd>
 #include <map>
 #include <SAX/InputSource.hpp>
+#include <io/mapped_file.hpp>
 
 namespace Arabica
 {
@@ -18,7 +19,9 @@ public:
   InputSourceResolver(const SAX::InputSource<stringT, stringAdaptorT>& inputSource,
                       const stringAdaptorT& /*SA*/) :
     deleteStream_(false),
-    byteStream_(0)
+    byteStream_(0),
+    bytes_(inputSource.getBytes()),
+    byteCount_(inputSource.getByteCount())
   {
     open(stringAdaptorT::asStdString(inputSource.getPublicId()),
          stringAdaptorT::asStdString(inputSource.getSystemId()),
@@ -28,6 +31,13 @@ public:
 
   std::istream* resolve() const { return byteStream_; }
 
+  // When the document is a contiguous block of memory - a byte range
+  // set on the InputSource, or a local file which has been memory
+  // mapped - bytes() gives it directly.  resolve() is then a stream
+  // reading from the same memory, for parsers that want one.
+  const char* bytes() const { return bytes_; }
+  size_t byteCount() const { return byteCount_; }
+
   typedef std::istream* (*URIResolver)(const std::string& url);
   static bool registerResolver(const std::string& method, URIResolver resolver);
   static bool unRegisterResolver(const std::string& method);
@@ -41,10 +51,14 @@ private:
   // instance variables
   bool deleteStream_;
   std::istream* byteStream_;
+  const char* bytes_;
+  size_t byteCount_;
+  io::mapped_file mapping_;
 
   void open(const std::string& publicId, 
             const std::string& systemId,
             std::istream* byteStream);
+  bool openMapped(const std::string& path);
 
   // class variables
   static URIResolver findResolver(std::string method);
@@ -4,6 +4,7 @@
 #include <SAX/ArabicaConfig.hpp>
 #include <map>
 #include <vector>
+#include <algorithm>
 #include <functional>
 #include <XML/QName.hpp>
 #include <SAX/SAXException.hpp>
@@ -73,6 +74,12 @@ struct NamespaceConstants
  * prefix/URI mapping is repeated for each context (for example), this
  * class will be somewhat less efficient.</p>
  *
+ * <p>Declarations are held on a single stack, and each prefix has a
+ * slot recording its binding currently in force, so pushing and popping
+ * a context costs nothing beyond the declarations it makes.  Each 
+ * distinct set of bindings is given a version number, and the results
+ * of processName are cached against the name and that version.</p>
+ *
  * @since SAX 2.0
  * @author Jez Higgins, 
  *         <a href="mailto:jez@jezuk.co.uk">jez@jezuk.co.uk</a>
@@ -98,9 +105,15 @@ class NamespaceSupport
      */
     void reset()
     {
+      bindings_.clear();
       contexts_.clear();
-      contexts_.push_back(Context());
-      contexts_.back().insert(std::make_pair(nsc_.xml, nsc_.xml_uri));
+      declarations_.clear();
+      elementNames_.clear();
+      attributeNames_.clear();
+      version_ = lastVersion_ = 0;
+
+      contexts_.push_back(Context(0, version_));
+      bind(nsc_.xml, nsc_.xml_uri);
     } // reset
 
     ////////////////////////////////////////////////////////////////////
@@ -122,7 +135,7 @@ class NamespaceSupport
      */
     void pushContext()
     {
-      contexts_.push_back(Context());
+      contexts_.push_back(Context(declarations_.size(), version_));
     } // pushContext
     
     /**
@@ -140,6 +153,14 @@ class NamespaceSupport
      */
     void popContext()
     {
+      const Context& context = contexts_.back();
+      for(size_t d = declarations_.size(); d != context.first_; --d)
+      {
+        const Declaration& decl = declarations_[d-1];
+        decl.slot_->second = decl.shadowed_;
+      } // for ...
+      declarations_.erase(declarations_.begin() + context.first_, declarations_.end());
+      version_ = context.version_;
       contexts_.pop_back();
     } // popContext
 
@@ -178,7 +199,7 @@ class NamespaceSupport
       if((prefix == nsc_.xml) || (prefix == nsc_.xmlns))
         return false;
 
-      contexts_.back().insert(std::make_pair(prefix, uri));
+      bind(prefix, uri);
       return true;
     } // declarePrefix
 
@@ -211,7 +232,7 @@ class NamespaceSupport
     {
     public:
       URIMapper(const NamespaceSupport* ns) : ns_(ns) { }
-      string_type operator()(const string_type& prefix) const { return ns_->getURI(prefix); }
+      const string_type& operator()(const string_type& prefix) const { return ns_->lookupURI(prefix); }
     private:
       const NamespaceSupport* const ns_;
     }; // class URIMapper
@@ -219,9 +240,22 @@ class NamespaceSupport
   public:
     XML::QualifiedName<string_type, string_adaptor> processName(const string_type& rawName, bool isAttribute) const
     {
+      nameCacheT& cache = isAttribute ? attributeNames_ : elementNames_;
+      typename nameCacheT::iterator cached = cache.find(rawName);
+      if((cached != cache.end()) && (cached->second.version_ == version_))
+        return cached->second.name_;
+
       try 
       {
-        return XML::QualifiedName<string_type, string_adaptor>::parseQName(rawName, isAttribute, URIMapper(this));
+        XML::QualifiedName<string_type, string_adaptor> name = 
+            XML::QualifiedName<string_type, string_adaptor>::parseQName(rawName, isAttribute, URIMapper(this));
+
+        if(cached != cache.end())
+          cached->second = ProcessedName(version_, name);
+        else if(cache.size() < maxCachedNames)
+          cache.insert(std::make_pair(rawName, ProcessedName(version_, name)));
+
+        return name;
       } // try
       catch(const std::runtime_error& ex)
       {
@@ -243,14 +277,7 @@ class NamespaceSupport
      */
     string_type getURI(const string_type& prefix) const
     {
-      for(typename contextListT::const_reverse_iterator i = contexts_.rbegin(); i != contexts_.rend(); ++i)
-      {
-        typename stringMapT::const_iterator u = i->find(prefix);
-        if(u != i->end())
-          return u->second;
-      } // for ...
-
-      return string_type();
+      return lookupURI(prefix);
     } // getURI
 
     /**
@@ -274,11 +301,11 @@ class NamespaceSupport
      */
     string_type getPrefix(const string_type& uri) const
     {
-      for(typename contextListT::const_reverse_iterator i = contexts_.rbegin(); i != contexts_.rend(); ++i)
+      for(size_t d = declarations_.size(); d != 0; --d)
       {
-        for(typename stringMapT::const_iterator u = i->begin(); u != i->end(); ++u)
-          if(u->second == uri)
-            return u->first;
+        const Declaration& decl = declarations_[d-1];
+        if(inForce(d-1) && (decl.uri_ == uri))
+          return decl.slot_->first;
       } // for ...
 
       return string_type();
@@ -301,11 +328,11 @@ class NamespaceSupport
     {
       stringListT prefixes;
 
-      for(typename contextListT::const_reverse_iterator i = contexts_.rbegin(); i != contexts_.rend(); ++i)
+      for(size_t d = declarations_.size(); d != 0; --d)
       {
-        for(typename stringMapT::const_iterator u = i->begin(); u != i->end(); ++u)
-          if(!string_adaptor::empty(u->first))
-            prefixes.push_back(u->first);
+        const string_type& prefix = declarations_[d-1].slot_->first;
+        if(inForce(d-1) && !string_adaptor::empty(prefix))
+          prefixes.push_back(prefix);
       } // for ...
        
       return prefixes;
@@ -336,11 +363,11 @@ class NamespaceSupport
     {
       stringListT prefixes;
 
-      for(typename contextListT::const_reverse_iterator i = contexts_.rbegin(); i != contexts_.rend(); ++i)
+      for(size_t d = declarations_.size(); d != 0; --d)
       {
-        for(typename stringMapT::const_iterator u = i->begin(); u != i->end(); ++u)
-          if(u->second == uri)
-            prefixes.push_back(u->first);
+        const Declaration& decl = declarations_[d-1];
+        if(inForce(d-1) && (decl.uri_ == uri))
+          prefixes.push_back(decl.slot_->first);
       } // for ...
 
       return prefixes;
@@ -362,19 +389,78 @@ class NamespaceSupport
     {
       stringListT prefixes;
 
-      for(typename stringMapT::const_iterator u = contexts_.back().begin(); u != contexts_.back().end(); ++u)
-        prefixes.push_back(u->first);
+      for(size_t d = contexts_.back().first_; d != declarations_.size(); ++d)
+        prefixes.push_back(declarations_[d].slot_->first);
+      std::sort(prefixes.begin(), prefixes.end());
        
       return prefixes;
     } // getDeclaredPrefixes
 
   private:
-    typedef typename std::multimap<string_type, string_type> stringMapT;
-    typedef stringMapT Context;
-    typedef typename std::vector<Context> contextListT;
+    static const size_t noBinding = static_cast<size_t>(-1);
+    static const size_t maxCachedNames = 1024;
+
+    // prefix -> index of the declaration currently in force
+    typedef typename std::map<string_type, size_t> bindingMapT;
+
+    struct Declaration
+    {
+      Declaration(typename bindingMapT::iterator slot, const string_type& uri, size_t shadowed) :
+        slot_(slot), uri_(uri), shadowed_(shadowed) { }
+
+      typename bindingMapT::iterator slot_;
+      string_type uri_;
+      size_t shadowed_;
+    }; // struct Declaration
+
+    struct Context
+    {
+      Context(size_t first, unsigned long version) : first_(first), version_(version) { }
+
+      size_t first_;
+      unsigned long version_;
+    }; // struct Context
+
+    struct ProcessedName
+    {
+      ProcessedName(unsigned long version, const XML::QualifiedName<string_type, string_adaptor>& name) :
+        version_(version), name_(name) { }
+
+      unsigned long version_;
+      XML::QualifiedName<string_type, string_adaptor> name_;
+    }; // struct ProcessedName
+    typedef typename std::map<string_type, ProcessedName> nameCacheT;
+
+    void bind(const string_type& prefix, const string_type& uri)
+    {
+      typename bindingMapT::iterator slot = bindings_.insert(std::make_pair(prefix, noBinding)).first;
+      declarations_.push_back(Declaration(slot, uri, slot->second));
+      slot->second = declarations_.size() - 1;
+      version_ = ++lastVersion_;
+    } // bind
+
+    const string_type& lookupURI(const string_type& prefix) const
+    {
+      typename bindingMapT::const_iterator slot = bindings_.find(prefix);
+      if((slot == bindings_.end()) || (slot->second == noBinding))
+        return string_adaptor::empty_string();
+      return declarations_[slot->second].uri_;
+    } // lookupURI
+
+    bool inForce(size_t d) const
+    {
+      return declarations_[d].slot_->second == d;
+    } // inForce
 
     // member variables
-    contextListT contexts_;
+    bindingMapT bindings_;
+    std::vector<Declaration> declarations_;
+    std::vector<Context> contexts_;
+    unsigned long version_;
+    unsigned long lastVersion_;
+
+    mutable nameCacheT elementNames_;
+    mutable nameCacheT attributeNames_;
 
     const NamespaceConstants<string_type, string_adaptor> nsc_;
 
@@ -384,6 +470,11 @@ class NamespaceSupport
     bool operator==(const NamespaceSupport&) const;
 }; // class NamespaceSupport
 
+template<class string_type, class string_adaptor>
+const size_t NamespaceSupport<string_type, string_adaptor>::noBinding;
+template<class string_type, class string_adaptor>
+const size_t NamespaceSupport<string_type, string_adaptor>::maxCachedNames;
+
 } // namespace SAX
 } // namespace Arabica
 
@@ -2,53 +2,187 @@
 #define ARABICA_GARDEN_H
 
 #include <SAX/ArabicaConfig.hpp>
-#include <boost/version.hpp>
-#if BOOST_VERSION >= 103800
-#define BOOST_SPIRIT_USE_OLD_NAMESPACE 1
-#include <boost/spirit/include/classic_core.hpp>
-#include <boost/spirit/include/classic_chset.hpp>
-#else
-#include <boost/spirit/core.hpp>
-#include <boost/spirit/utility/chset.hpp>
-#endif
-#include <boost/bind.hpp>
 #include <vector>
 #include <string>
-#include <stack>
 #include <map>
+#include <cstring>
+#include <sstream>
+#include <istream>
+#include <typeinfo>
 #include <SAX/XMLReader.hpp>
+#include <Arabica/stats.hpp>
+#include <SAX/Locator.hpp>
 #include <SAX/SAXParseException.hpp>
 #include <SAX/SAXNotRecognizedException.hpp>
+#include <SAX/SAXNotSupportedException.hpp>
 #include <SAX/helpers/InputSourceResolver.hpp>
 #include <SAX/helpers/AttributesImpl.hpp>
+#include <SAX/helpers/AttributeDefaults.hpp>
+#include <SAX/helpers/NamespaceSupport.hpp>
+#include <SAX/helpers/FeatureNames.hpp>
+#include <SAX/helpers/PropertyNames.hpp>
+#include <SAX/ext/LexicalHandler.hpp>
+#include <SAX/ext/DeclHandler.hpp>
 #include <Arabica/StringAdaptor.hpp>
 #include <Arabica/getparam.hpp>
 
-namespace Arabica 
+namespace Arabica
+{
+namespace SAX
+{
+
+namespace garden_impl
 {
-namespace SAX 
+
+// byte classes for the scanner - anything at or above 0x80 is part of
+// a UTF-8 sequence and is accepted as a name character
+struct CharClasses
+{
+  enum { Space = 1, NameStart = 2, Name = 4 };
+
+  CharClasses()
+  {
+    for(int c = 0; c != 256; ++c)
+    {
+      unsigned char k = 0;
+      if(c == ' ' || c == '\t' || c == '\n' || c == '\r')
+        k |= Space;
+      if((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':' || c >= 0x80)
+        k |= NameStart | Name;
+      if((c >= '0' && c <= '9') || c == '.' || c == '-')
+        k |= Name;
+      table_[c] = k;
+    } // for ...
+  } // CharClasses
+
+  bool isSpace(char c) const { return (table_[static_cast<unsigned char>(c)] & Space) != 0; }
+  bool isNameStart(char c) const { return (table_[static_cast<unsigned char>(c)] & NameStart) != 0; }
+  bool isName(char c) const { return (table_[static_cast<unsigned char>(c)] & Name) != 0; }
+
+  static const CharClasses& instance()
+  {
+    static const CharClasses classes;
+    return classes;
+  } // instance
+
+private:
+  unsigned char table_[256];
+}; // struct CharClasses
+
+// Returns the end of the run of complete, well-formed UTF-8 sequences
+// starting at p.  bad is set if the run stopped at a malformed sequence
+// rather than at a sequence cut short by the end of the input.
+inline const char* validUTF8(const char* p, const char* e, bool& bad)
 {
+  const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+  const unsigned char* ue = reinterpret_cast<const unsigned char*>(e);
+  while(u != ue)
+  {
+    if(*u < 0x80)
+    {
+      ++u;
+      continue;
+    } // if ...
+
+    unsigned char c = *u;
+    int trail;
+    unsigned char lo = 0x80, hi = 0xBF;
+    if(c >= 0xC2 && c <= 0xDF)
+      trail = 1;
+    else if(c >= 0xE0 && c <= 0xEF)
+    {
+      trail = 2;
+      if(c == 0xE0) lo = 0xA0;
+      if(c == 0xED) hi = 0x9F;
+    }
+    else if(c >= 0xF0 && c <= 0xF4)
+    {
+      trail = 3;
+      if(c == 0xF0) lo = 0x90;
+      if(c == 0xF4) hi = 0x8F;
+    }
+    else
+    {
+      bad = true;
+      break;
+    } // if ...
+
+    if(ue - u <= trail)
+    {
+      for(const unsigned char* t = u + 1; t != ue; ++t)
+        if(*t < 0x80 || *t > 0xBF || (t == u + 1 && (*t < lo || *t > hi)))
+          bad = true;
+      break;
+    } // if ...
+    if(u[1] < lo || u[1] > hi ||
+       (trail > 1 && (u[2] < 0x80 || u[2] > 0xBF)) ||
+       (trail > 2 && (u[3] < 0x80 || u[3] > 0xBF)))
+    {
+      bad = true;
+      break;
+    } // if ...
+    u += trail + 1;
+  } // while ...
+  return reinterpret_cast<const char*>(u);
+} // validUTF8
 
-template<class string_type, 
+struct ParseError
+{
+  ParseError(const std::string& message) : message_(message) { }
+  std::string message_;
+}; // struct ParseError
+
+} // namespace garden_impl
+
+/**
+ * Garden is Arabica's own XML parser.  It has no dependencies beyond
+ * the standard library.
+ *
+ * <p>Input is read from the resolved stream in chunks and scanned in
+ * place - character data, attribute values, comments, CDATA sections
+ * and processing instructions are located with memchr, so the clean
+ * runs between delimiters are copied in bulk.  The document is never
+ * held in memory as a whole.</p>
+ *
+ * <p>The input may be UTF-8 (or its ASCII subset), UTF-16, told apart
+ * by its byte order mark or first character, or ISO-8859-1 if the XML
+ * declaration says so.  The internal DTD subset is read for entity,
+ * attribute-list, element and notation declarations.  The external DTD
+ * subset and external parameter entities are never loaded.  External
+ * general entities are reported with skippedEntity, unless the
+ * external-general-entities feature is on, when they are resolved through
+ * the EntityResolver, read and expanded in place.</p>
+ */
+template<class string_type,
          class T0 = Arabica::nil_t,
          class T1 = Arabica::nil_t>
-class Garden : 
-    public SAX::XMLReaderInterface<string_type, 
-				   typename Arabica::get_string_adaptor<string_type, T0, T1>::type>
+class Garden :
+    public SAX::XMLReaderInterface<string_type,
+                                   typename Arabica::get_string_adaptor<string_type, T0, T1>::type>,
+    public SAX::Locator<string_type, typename Arabica::get_string_adaptor<string_type, T0, T1>::type>
 {
 public:
-  typedef SAX::XMLReaderInterface<string_type, 
-				  typename Arabica::get_string_adaptor<string_type, T0, T1>::type> XMLReaderT;
+  typedef SAX::XMLReaderInterface<string_type,
+                                  typename Arabica::get_string_adaptor<string_type, T0, T1>::type> XMLReaderT;
   typedef typename XMLReaderT::string_adaptor string_adaptor;
+  typedef string_adaptor SA;
   typedef EntityResolver<string_type, string_adaptor> EntityResolverT;
   typedef DTDHandler<string_type, string_adaptor> DTDHandlerT;
   typedef ContentHandler<string_type, string_adaptor> ContentHandlerT;
   typedef InputSource<string_type, string_adaptor> InputSourceT;
   typedef AttributesImpl<string_type, string_adaptor> AttributesImplT;
+  typedef AttributeType<string_type, string_adaptor> AttributeTypeT;
   typedef ErrorHandler<string_type, string_adaptor> ErrorHandlerT;
   typedef DeclHandler<string_type, string_adaptor> declHandlerT;
   typedef LexicalHandler<string_type, string_adaptor> lexicalHandlerT;
+  typedef NamespaceSupport<string_type, string_adaptor> namespaceSupportT;
+  typedef SAXParseException<string_type, string_adaptor> SAXParseExceptionT;
+  typedef XML::QualifiedName<string_type, string_adaptor> qualifiedNameT;
   typedef typename XMLReaderT::PropertyBase PropertyBaseT;
+  typedef typename XMLReaderT::template Property<lexicalHandlerT*> getLexicalHandlerT;
+  typedef typename XMLReaderT::template Property<lexicalHandlerT&> setLexicalHandlerT;
+  typedef typename XMLReaderT::template Property<declHandlerT*> getDeclHandlerT;
+  typedef typename XMLReaderT::template Property<declHandlerT&> setDeclHandlerT;
 
   Garden();
 
@@ -63,55 +197,127 @@ public:
   virtual ContentHandlerT* getContentHandler() const { return contentHandler_; }
   virtual void setErrorHandler(ErrorHandlerT& handler) { errorHandler_ = &handler; }
   virtual ErrorHandlerT* getErrorHandler() const { return errorHandler_; }
-  virtual void setDeclHandler(declHandlerT& handler) { throw SAXNotSupportedException("decl-handler"); }
-  virtual declHandlerT* getDeclHandler() const { throw SAXNotSupportedException("decl-handler"); }
-  virtual void setLexicalHandler(lexicalHandlerT& handler) { throw SAXNotSupportedException("lexical-handler"); }
-  virtual lexicalHandlerT* getLexicalHandler() const { throw SAXNotSupportedException("lexical-handler"); }
+  virtual void setDeclHandler(declHandlerT& handler) { declHandler_ = &handler; }
+  virtual declHandlerT* getDeclHandler() const { return declHandler_; }
+  virtual void setLexicalHandler(lexicalHandlerT& handler) { lexicalHandler_ = &handler; }
+  virtual lexicalHandlerT* getLexicalHandler() const { return lexicalHandler_; }
 
   virtual void parse(InputSourceT& input);
 
+  //////////////////////////////////////////////////
+  // Locator
+  virtual string_type getPublicId() const { return publicId_; }
+  virtual string_type getSystemId() const { return systemId_; }
+  virtual size_t getLineNumber() const;
+  virtual size_t getColumnNumber() const;
+
+protected:
   virtual std::auto_ptr<PropertyBaseT> doGetProperty(const string_type& name);
   virtual void doSetProperty(const string_type& name, std::auto_ptr<PropertyBaseT> value);
 
 private:
+  typedef garden_impl::ParseError ParseError;
+
+  // input
+  bool fill(size_t want);
+  bool more() { return fill(end_ - pos_ + 1); }
+  int peek() { return ((pos_ != end_) || more()) ? static_cast<unsigned char>(data_[pos_]) : -1; }
+  bool lookingAt(const char* literal, size_t length);
+  void expect(char c);
+  bool skipSpaces();
+  void requireSpaces();
+  size_t runLength(const char* run, size_t length, bool delimited) const;
+  void countLines(size_t upTo) const;
+  void switchEncoding(int encoding);
+  void decode();
+  void pushEntity(const std::string& name, const std::string& text, bool external);
+  void popEntity();
+  void countExpansion(size_t length);
+  void loadExternalEntity(const std::string& publicId, const std::string& systemId, std::string& text);
+
+  // text
+  void append(std::string& out, const char* s, size_t length);
+  void appendAttribute(std::string& out, const char* s, size_t length);
+  static size_t encodeCodePoint(char* out, unsigned long cp);
+  static void appendCodePoint(std::string& out, unsigned long cp);
+  void flushText();
+  string_type str(const std::string& s) const { return SA::construct_from_utf8(s.data(), static_cast<int>(s.size())); }
+
+  // grammar
+  void parseDocument();
+  void parseXMLDecl();
+  void parseMisc(bool prolog);
+  void parseContent();
+  void scanText();
+  bool parseStartTag();
+  void parseEndTag();
+  void parseComment();
+  void parsePI();
+  void parseCDATA();
+  void parseDoctype();
+  void parseEntityDecl();
+  void parseAttlistDecl();
+  void parseElementDecl();
+  void parseNotationDecl();
+  void parseExternalId(std::string& publicId, std::string& systemId, bool systemOptional);
+  void scanName(std::string& name);
+  void scanLiteral(std::string& value);
+  void scanAttValue(std::string& value);
+  void scanEntityValue(std::string& value);
+  void parseReference(std::string& out, bool inAttribute);
+  unsigned long parseCharRef();
+  void expandInAttribute(const std::string& text, std::string& out, int level);
+  void scanUntil(const char* terminator, size_t length, std::string& out);
+
+  // events
+  void reportStartElement(bool empty);
+  void reportEndElement();
+  void applyDefaults();
+  qualifiedNameT processName(const string_type& qName, bool isAttribute);
   void reportError(const std::string& message, bool fatal = false);
+  void checkNotParsing(const string_type& type, const string_type& name) const;
 
-  typedef typename string_adaptor::value_type char_t;
-  typedef std::vector<char_t> vector_t;
-  typedef typename vector_t::iterator iterator_t;
-  typedef boost::spirit::scanner<iterator_t> scanner_t;
-  typedef boost::spirit::rule<scanner_t> rule_t;
-
-  void openElement(iterator_t s, iterator_t e);
-  void closeElement(iterator_t s, iterator_t e);
-  void closeEmptyElement(iterator_t s, iterator_t e);
-  void endElementName(iterator_t s, iterator_t e);
-  void endElement(iterator_t s, iterator_t e);
-  void attributeName(iterator_t s, iterator_t e);
-  void attributeValue(iterator_t s, iterator_t e);
-  void elementContent(iterator_t s, iterator_t e);
-  void piTarget(iterator_t s, iterator_t e);
-  void piData(iterator_t s, iterator_t e);
-  void piEnd(iterator_t s, iterator_t e);
-  void entityRef(iterator_t s, iterator_t e);
-  void decimalCharacterRef(iterator_t s, iterator_t e);
-  void hexCharacterRef(iterator_t s, iterator_t e);
-  void characterRef(iterator_t s, iterator_t e, int base);
-
-  // Start grammar definition
-  rule_t prolog, element, Misc, Reference,
-                CDSect, CDStart, CData, CDEnd, 
-                PI, PITarget, PIData,
-                doctypedecl, XMLDecl, SDDecl, VersionInfo, EncodingDecl,
-                VersionNum, Eq, EmptyElemTag, STag, content, ETag, Attribute,
-                AttValue, CharData, Comment, 
-                CharRef, EntityRef, EncName, document_,
-                Name, Comment1, Spaces;
-
-  string_type str(iterator_t s, iterator_t e, int trim = 0)
-  {
-    return string_adaptor::construct(s, e-trim);
-  } // str
+  struct AttributeDecl
+  {
+    std::string name_;
+    bool cdata_;
+    bool hasDefault_;
+    std::string value_;
+  }; // struct AttributeDecl
+  typedef std::vector<AttributeDecl> AttributeDeclList;
+
+  struct ExternalEntity
+  {
+    std::string publicId_;
+    std::string systemId_;
+    bool unparsed_;
+  }; // struct ExternalEntity
+
+  struct SavedInput
+  {
+    std::istream* stream_;
+    std::vector<char> buffer_;
+    const char* data_;
+    size_t pos_;
+    size_t end_;
+    size_t filled_;
+    bool eof_;
+    bool bad_;
+    int encoding_;
+    std::vector<char> raw_;
+    size_t rawEnd_;
+    size_t depth_;
+    std::string name_;
+    bool external_;
+  }; // struct SavedInput
+
+  enum { Unknown, UTF8, Latin1, UTF16LE, UTF16BE };
+  enum { ChunkSize = 16 * 1024 };
+  enum { MaxEntityDepth = 64 };
+  // text expanded from entities may be MaxAmplification times the size of
+  // the document read so far, once there is more than ExpansionThreshold
+  enum { MaxAmplification = 100 };
+  enum { ExpansionThreshold = 8 * 1024 * 1024 };
 
   //////////////////////////////
   // member variables
@@ -119,141 +325,150 @@ private:
   DTDHandlerT* dtdHandler_;
   ContentHandlerT* contentHandler_;
   ErrorHandlerT* errorHandler_;
+  declHandlerT* declHandler_;
+  lexicalHandlerT* lexicalHandler_;
+  namespaceSupportT nsSupport_;
+
+  string_type publicId_;
+  string_type systemId_;
+  bool parsing_;
 
-  std::stack<string_type> elements_;
+  // features
+  bool namespaces_;
+  bool prefixes_;
+  bool externalResolving_;
+
+  // input state
+  std::istream* stream_;
+  std::vector<char> buffer_;
+  const char* data_;
+  size_t pos_;
+  size_t end_;
+  size_t filled_;
+  bool eof_;
+  bool bad_;
+  int encoding_;
+  std::vector<char> raw_;
+  size_t rawEnd_;
+  std::vector<SavedInput> inputs_;
+  size_t expanded_;
+  size_t base_;
+  size_t markup_;
+  mutable size_t counted_;
+  mutable size_t line_;
+  mutable size_t lineStart_;
+
+  // document state
+  std::string text_;
+  std::string name_;
+  std::string refName_;
+  std::string scratch_;
+  std::vector<std::string> attNames_;
+  std::vector<std::string> attValues_;
+  size_t attCount_;
+  std::vector<std::string> elements_;
+  size_t depth_;
+  std::vector<bool> contextPushed_;
   AttributesImplT attrs_;
-  typedef typename AttributesImplT::Attr Attr;
-  Attr currentAttr_;
-  string_type piTarget_;
-  string_type piData_;
-  string_type entityRef_;
-  std::map<string_type, string_type> declaredEntities_;
-  std::map<char, int> conversion_;
-}; // parser
+  bool externalSubset_;
+  std::map<std::string, std::string> entities_;
+  std::map<std::string, ExternalEntity> externalEntities_;
+  std::map<std::string, AttributeDeclList> attributeDecls_;
+
+  const garden_impl::CharClasses& classes_;
+  const SAX::FeatureNames<string_type, string_adaptor> features_;
+  const SAX::PropertyNames<string_type, string_adaptor> properties_;
+  const SAX::NamespaceConstants<string_type, string_adaptor> nsc_;
+  const SAX::AttributeDefaults<string_type, string_adaptor> attrDefaults_;
+  string_type emptyString_;
+}; // class Garden
 
 template<class string_type, class T0, class T1>
 Garden<string_type, T0, T1>::Garden() :
   entityResolver_(0),
   dtdHandler_(0),
   contentHandler_(0),
-  errorHandler_(0)
-{
-  // define the parsing rules
-  typedef boost::spirit::chset<char_t> chset_t;
-  typedef boost::spirit::chlit<char_t> chlit_t;
-
-  // characters
-  chset_t Char("\x9\xA\xD\x20-\xFF");
-  chset_t SpaceChar("\x20\x9\xD\xA");
-  Spaces = +(SpaceChar);
-  chset_t Letter("\x41-\x5A\x61-\x7A\xC0-\xD6\xD8-\xF6\xF8-\xFF");
-  chset_t Digit("0-9");
-  chlit_t Extender('\xB7');
-  chset_t NameChar = Letter | Digit | chset_t("._:-") | Extender;
-  Name = (Letter | '_' | ':') >> *(NameChar);
-
-  document_ = prolog >> element >> *Misc;
-
-  chset_t CharDataChar (boost::spirit::anychar_p - (chset_t('<') | chset_t('&')));
-  CharData = (*(CharDataChar - boost::spirit::str_p("]]>")))[boost::bind(&Garden<string_type, T0, T1>::elementContent, this, _1, _2)];
-
-  // Section 2.5 - Comments
-  Comment =        boost::spirit::str_p("<!--") >> Comment1 >> boost::spirit::str_p("-->");
-  Comment1 = *((Char - boost::spirit::ch_p('-')) | (boost::spirit::ch_p('-') >> (Char - boost::spirit::ch_p('-'))));
- 
-  // Section 2.6 - Processing Instructions
-  PI = boost::spirit::str_p("<?") >> (PITarget)[boost::bind(&Garden<string_type, T0, T1>::piTarget, this, _1, _2)] >> !Spaces >> (PIData)[boost::bind(&Garden<string_type, T0, T1>::piData, this, _1, _2)] >> (boost::spirit::str_p("?>"))[boost::bind(&Garden<string_type, T0, T1>::piEnd, this, _1, _2)];
-  PITarget = Name - boost::spirit::as_lower_d[boost::spirit::str_p("xml")];
-  PIData = !(!Spaces >> (*(Char - boost::spirit::str_p("?>"))));
-
-  // Section 2.7 - CDATA
-  CDSect  = CDStart >> (CData)[boost::bind(&Garden<string_type, T0, T1>::elementContent, this, _1, _2)] >> CDEnd;
-  CDStart = boost::spirit::str_p("<![CDATA[");
-  CData   = *(Char - boost::spirit::str_p("]]>"));
-  CDEnd   = boost::spirit::str_p("]]>");
-
-  // bits before the root elemenet
-  prolog = !XMLDecl >> *Misc >> !(doctypedecl >> *Misc);
-  XMLDecl = boost::spirit::str_p("<?xml") >> VersionInfo >> !EncodingDecl >> !SDDecl >> !Spaces >> boost::spirit::str_p("?>");
-  VersionInfo = Spaces >> boost::spirit::str_p("version") >> Eq >> (boost::spirit::ch_p('\'') >> VersionNum >>'\''
-                          | boost::spirit::ch_p('"') >> VersionNum >> '"');
-  chset_t VersionNumCh("A-Za-z0-9_.:-");
-  VersionNum =    +(VersionNumCh);
-  doctypedecl =    boost::spirit::str_p("<!DOCTYPE") >> *(Char - (chset_t('[') | '>')) >> !('[' >> *(Char - ']') >> ']') >> '>';
-  SDDecl =            Spaces >> boost::spirit::str_p("standalone") >> Eq >> ((boost::spirit::ch_p('\'') >> (boost::spirit::str_p("yes") | boost::spirit::str_p("no")) >> '\'')
-                          | (boost::spirit::ch_p('"') >> (boost::spirit::str_p("yes") | boost::spirit::str_p("no")) >> '"'));
-
-  // odd bits
-  Eq =                !Spaces >> '=' >> !Spaces;
-  Misc =            Comment | Spaces | PI;
-
-  // Elements
-  element = STag >> (EmptyElemTag | (boost::spirit::str_p(">"))[boost::bind(&Garden<string_type, T0, T1>::closeElement, this, _1, _2)] >> content >> ETag);
-  STag = '<' >> (Name)[boost::bind(&Garden<string_type, T0, T1>::openElement, this, _1, _2)] >> *(Spaces >> Attribute) >> !Spaces;
-  Attribute = (Name)[boost::bind(&Garden<string_type, T0, T1>::attributeName, this, _1, _2)] >> Eq >> AttValue;
-  EmptyElemTag = (boost::spirit::str_p("/>"))[boost::bind(&Garden<string_type, T0, T1>::closeEmptyElement, this, _1, _2)];
-  ETag = (boost::spirit::str_p("</") >> (Name)[boost::bind(&Garden<string_type, T0, T1>::endElementName, this, _1, _2)] >> !Spaces >> '>')[boost::bind(&Garden<string_type, T0, T1>::endElement, this, _1, _2)];
-  
-  AttValue =   '"' >> (*((boost::spirit::anychar_p - (chset_t('<') | '&' | '"')) | Reference))[boost::bind(&Garden<string_type, T0, T1>::attributeValue, this, _1, _2)] >> '"'
-            | '\'' >> (*((boost::spirit::anychar_p - (chset_t('<') | '&' | '\'')) | Reference))[boost::bind(&Garden<string_type, T0, T1>::attributeValue, this, _1, _2)] >> '\'';
-  
-  content =        !CharData >> *((element | Reference | CDSect | Comment | PI) >> !CharData);
-
-  // Section 4.1 - Character and entity references
-  CharRef = boost::spirit::str_p("&#") >> (+boost::spirit::digit_p >> ';')[boost::bind(&Garden<string_type, T0, T1>::decimalCharacterRef, this, _1, _2)] |
-            boost::spirit::str_p("&#x") >> (+boost::spirit::xdigit_p >> ';')[boost::bind(&Garden<string_type, T0, T1>::hexCharacterRef, this, _1, _2)];
-  Reference = EntityRef | CharRef;
-  EntityRef = '&' >> (Name >> boost::spirit::ch_p(';'))[boost::bind(&Garden<string_type, T0, T1>::entityRef, this, _1, _2)];
-
-  EncodingDecl =    Spaces >> boost::spirit::str_p("encoding") >> Eq >> (boost::spirit::ch_p('"') >> EncName >> '"' |
-                          boost::spirit::ch_p('\'') >> EncName >> '\'');
-  chset_t EncNameCh = VersionNumCh - chset_t(':');
-  EncName =        boost::spirit::alpha_p >> *(EncNameCh);
-
-
-  /////////////////
-  declaredEntities_.insert(std::make_pair<string_type, string_type>(string_adaptor::construct("lt"), string_adaptor::construct("<")));
-  declaredEntities_.insert(std::make_pair<string_type, string_type>(string_adaptor::construct("gt"), string_adaptor::construct(">")));
-  declaredEntities_.insert(std::make_pair<string_type, string_type>(string_adaptor::construct("amp"), string_adaptor::construct("&")));
-  declaredEntities_.insert(std::make_pair<string_type, string_type>(string_adaptor::construct("apos"), string_adaptor::construct("'")));
-  declaredEntities_.insert(std::make_pair<string_type, string_type>(string_adaptor::construct("quot"), string_adaptor::construct("\"")));
-
-  conversion_.insert(std::make_pair('0', 0));
-  conversion_.insert(std::make_pair('1', 1));
-  conversion_.insert(std::make_pair('2', 2));
-  conversion_.insert(std::make_pair('3', 3));
-  conversion_.insert(std::make_pair('4', 4));
-  conversion_.insert(std::make_pair('5', 5));
-  conversion_.insert(std::make_pair('6', 6));
-  conversion_.insert(std::make_pair('7', 7));
-  conversion_.insert(std::make_pair('8', 8));
-  conversion_.insert(std::make_pair('9', 9));
-  conversion_.insert(std::make_pair('a', 10));
-  conversion_.insert(std::make_pair('b', 11));
-  conversion_.insert(std::make_pair('c', 12));
-  conversion_.insert(std::make_pair('d', 13));
-  conversion_.insert(std::make_pair('e', 14));
-  conversion_.insert(std::make_pair('f', 15));
-  conversion_.insert(std::make_pair('A', 10));
-  conversion_.insert(std::make_pair('B', 11));
-  conversion_.insert(std::make_pair('C', 12));
-  conversion_.insert(std::make_pair('D', 13));
-  conversion_.insert(std::make_pair('E', 14));
-  conversion_.insert(std::make_pair('F', 15));
-} // XMLparser
+  errorHandler_(0),
+  declHandler_(0),
+  lexicalHandler_(0),
+  parsing_(false),
+  namespaces_(true),
+  prefixes_(true),
+  externalResolving_(false),
+  stream_(0),
+  data_(0),
+  pos_(0),
+  end_(0),
+  filled_(0),
+  eof_(true),
+  bad_(false),
+  encoding_(UTF8),
+  rawEnd_(0),
+  expanded_(0),
+  base_(0),
+  markup_(0),
+  counted_(0),
+  line_(1),
+  lineStart_(0),
+  attCount_(0),
+  depth_(0),
+  externalSubset_(false),
+  classes_(garden_impl::CharClasses::instance())
+{
+} // Garden
 
 //////////////////////////////////////
 // features
 template<class string_type, class T0, class T1>
 bool Garden<string_type, T0, T1>::getFeature(const string_type& name) const
 {
-  throw SAXNotRecognizedException(string_adaptor::asStdString(name));
+  if(name == features_.namespaces)
+    return namespaces_;
+
+  if(name == features_.namespace_prefixes)
+    return prefixes_;
+
+  if(name == features_.external_general || name == features_.external_parameter)
+    return externalResolving_;
+
+  if(name == features_.validation)
+    return false;
+
+  throw SAXNotRecognizedException(std::string("Feature not recognized ") + SA::asStdString(name));
 } // getFeature
 
 template<class string_type, class T0, class T1>
 void Garden<string_type, T0, T1>::setFeature(const string_type& name, bool value)
 {
-  throw SAXNotRecognizedException(string_adaptor::asStdString(name));
+  if(name == features_.namespaces)
+  {
+    checkNotParsing(SA::construct_from_utf8("feature"), name);
+    namespaces_ = value;
+    if(!namespaces_ && !prefixes_)
+      prefixes_ = true;
+    return;
+  } // namespaces
+
+  if(name == features_.namespace_prefixes)
+  {
+    checkNotParsing(SA::construct_from_utf8("feature"), name);
+    prefixes_ = value;
+    if(prefixes_ && !namespaces_)
+      namespaces_ = true;
+    return;
+  } // namespace prefixes
+
+  if(name == features_.external_general || name == features_.external_parameter)
+  {
+    checkNotParsing(SA::construct_from_utf8("feature"), name);
+    externalResolving_ = value;
+    return;
+  } // external entity resolution
+
+  if(name == features_.validation)
+    throw SAXNotSupportedException(std::string("Feature not supported ") + SA::asStdString(name));
+
+  throw SAXNotRecognizedException(std::string("Feature not recognized ") + SA::asStdString(name));
 } // setFeature
 
 ///////////////////////////////////////
@@ -261,202 +476,1666 @@ void Garden<string_type, T0, T1>::setFeature(const string_type& name, bool value
 template<class string_type, class T0, class T1>
 std::auto_ptr<typename Garden<string_type, T0, T1>::PropertyBaseT> Garden<string_type, T0, T1>::doGetProperty(const string_type& name)
 {
-  throw SAXNotRecognizedException(string_adaptor::asStdString(name));
+  if(name == properties_.lexicalHandler)
+    return std::auto_ptr<PropertyBaseT>(new getLexicalHandlerT(lexicalHandler_));
+  if(name == properties_.declHandler)
+    return std::auto_ptr<PropertyBaseT>(new getDeclHandlerT(declHandler_));
+
+  throw SAXNotRecognizedException(std::string("Property not recognized ") + SA::asStdString(name));
 } // doGetProperty
 
 template<class string_type, class T0, class T1>
 void Garden<string_type, T0, T1>::doSetProperty(const string_type& name, std::auto_ptr<PropertyBaseT> value)
 {
-  throw SAXNotRecognizedException(string_adaptor::asStdString(name));
+  if(name == properties_.lexicalHandler)
+  {
+    setLexicalHandlerT* prop = dynamic_cast<setLexicalHandlerT*>(value.get());
+    if(!prop)
+      throw std::bad_cast();
+    lexicalHandler_ = &(prop->get());
+    return;
+  } // if ...
+
+  if(name == properties_.declHandler)
+  {
+    setDeclHandlerT* prop = dynamic_cast<setDeclHandlerT*>(value.get());
+    if(!prop)
+      throw std::bad_cast();
+    declHandler_ = &(prop->get());
+    return;
+  } // if ...
+
+  throw SAXNotRecognizedException(std::string("Property not recognized ") + SA::asStdString(name));
 } // doSetProperty
 
+//////////////////////////////////////////
+// Locator
+template<class string_type, class T0, class T1>
+size_t Garden<string_type, T0, T1>::getLineNumber() const
+{
+  if(inputs_.empty())
+    countLines(pos_);
+  return line_;
+} // getLineNumber
+
+template<class string_type, class T0, class T1>
+size_t Garden<string_type, T0, T1>::getColumnNumber() const
+{
+  if(!inputs_.empty())
+    return 0;
+  countLines(pos_);
+  return base_ + pos_ - lineStart_;
+} // getColumnNumber
+
 //////////////////////////////////////////
 // parse
 template<class string_type, class T0, class T1>
 void Garden<string_type, T0, T1>::parse(InputSourceT& input)
 {
+  ARABICA_STATS_TIME(sax_parse);
+  publicId_ = input.getPublicId();
+  systemId_ = input.getSystemId();
+
+  if(contentHandler_)
+    contentHandler_->setDocumentLocator(*this);
+
+  parsing_ = true;
+
+  if(contentHandler_)
+    contentHandler_->startDocument();
+
   InputSourceResolver is(input, string_adaptor());
   if(is.resolve() == 0)
-  {
     reportError("Could not resolve XML document", true);
-		return;
-  } // if(is.resolver() == 0)
+  else
+  {
+    stream_ = is.resolve();
+    pos_ = end_ = filled_ = base_ = markup_ = counted_ = lineStart_ = 0;
+    line_ = 1;
+    eof_ = bad_ = false;
+    if(is.bytes() != 0)
+    {
+      // a document already in memory is scanned where it lies
+      data_ = is.bytes();
+      end_ = filled_ = is.byteCount();
+      eof_ = true;
+    }
+    else
+    {
+      buffer_.resize(ChunkSize);
+      data_ = &buffer_[0];
+    } // if ...
+    encoding_ = Unknown;
+    raw_.resize(ChunkSize);
+    rawEnd_ = 0;
+    inputs_.clear();
+    expanded_ = 0;
+    text_.clear();
+    depth_ = 0;
+    contextPushed_.clear();
+    externalSubset_ = false;
+    entities_.clear();
+    externalEntities_.clear();
+    attributeDecls_.clear();
+    nsSupport_.reset();
 
-  // Turn of white space skipping on the stream
-  is.resolve()->unsetf(std::ios::skipws);
+    bool ok = true;
+    std::string message;
+    try
+    {
+      parseDocument();
+    } // try
+    catch(const ParseError& e)
+    {
+      ok = false;
+      message = e.message_;
+      if(inputs_.empty() && pos_ == end_ && filled_ != end_)
+        message = bad_ ? "not well-formed (invalid token)" : "partial character";
+    } // catch
 
-  vector_t data(std::istream_iterator<char_t>(*is.resolve()), std::istream_iterator<char_t>());
+    if(!ok)
+    {
+      // characters read before the error are still reported, and the
+      // error itself is located at the start of the offending markup
+      // where that is still in the buffer
+      if(inputs_.empty() && depth_ != 0)
+        flushText();
+      if(inputs_.empty() && markup_ >= base_ && markup_ >= counted_ && markup_ <= base_ + pos_)
+        pos_ = markup_ - base_;
+      reportError(message, true);
+    } // if ...
 
-  iterator_t first = data.begin();
-  iterator_t last = data.end();
-  scanner_t scanner(first, last);
-  typedef typename boost::spirit::parser_result<rule_t, scanner_t>::type result_t;
+    // the input is about to go away, so the locator is brought up to date
+    countLines(pos_);
+    stream_ = 0;
+    data_ = 0;
+    inputs_.clear();
+  } // if ...
 
-  if(contentHandler_)
-    contentHandler_->startDocument();
-  result_t r = document_.parse(scanner);
   if(contentHandler_)
     contentHandler_->endDocument();
 
-  if(!(r && first == last))
+  parsing_ = false;
+} // parse
+
+//////////////////////////////////////////
+// input
+template<class string_type, class T0, class T1>
+bool Garden<string_type, T0, T1>::fill(size_t want)
+{
+  while(end_ - pos_ < want)
   {
-    std::cout << string_adaptor::asStdString(input.getSystemId()) << " Fails Parsing\n" << std::endl;
-    for (int i = 0; i < 50; ++i)
+    // a malformed or truncated character reads as the end of the input,
+    // and is reported as such by parse
+    if(eof_ || bad_)
+      return false;
+
+    if(pos_ != 0)
     {
-        std::cout << *first++;
-    }
-    std::cout << std::endl;
+      countLines(pos_);
+      std::memmove(&buffer_[0], &buffer_[0] + pos_, filled_ - pos_);
+      base_ += pos_;
+      end_ -= pos_;
+      filled_ -= pos_;
+      pos_ = 0;
+    } // if ...
+    if(filled_ == buffer_.size())
+      buffer_.resize(buffer_.size() * 2);
+
+    if(encoding_ == UTF8 || encoding_ == Unknown)
+    {
+      // bytes past end_ are read but not yet known to be good UTF-8
+      stream_->read(&buffer_[0] + filled_, static_cast<std::streamsize>(buffer_.size() - filled_));
+      size_t got = static_cast<size_t>(stream_->gcount());
+      filled_ += got;
+      if(got == 0 || !stream_->good())
+        eof_ = true;
+      data_ = &buffer_[0];
+      end_ = (encoding_ == UTF8) ? (garden_impl::validUTF8(data_ + end_, data_ + filled_, bad_) - data_) : filled_;
+      continue;
+    } // if ...
+
+    stream_->read(&raw_[rawEnd_], static_cast<std::streamsize>(raw_.size() - rawEnd_));
+    size_t got = static_cast<size_t>(stream_->gcount());
+    rawEnd_ += got;
+    if(got == 0 || !stream_->good())
+      eof_ = true;
+    decode();
+    if(eof_ && rawEnd_ != 0)
+      throw ParseError("partial character");
+    filled_ = end_;
+  } // while ...
+  return true;
+} // fill
+
+// Bytes not yet scanned were read before the encoding was known, so
+// they go back through the decoder, which writes to the start of the
+// scan buffer.
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::switchEncoding(int encoding)
+{
+  if(encoding == UTF8)
+  {
+    encoding_ = UTF8;
+    bad_ = false;
+    end_ = garden_impl::validUTF8(data_ + pos_, data_ + filled_, bad_) - data_;
+    return;
   } // if ...
-} // parse
 
+  size_t unread = filled_ - pos_;
+  if(raw_.size() < unread)
+    raw_.resize(unread);
+  if(unread != 0)
+    std::memcpy(&raw_[0], data_ + pos_, unread);
+  rawEnd_ = unread;
+  countLines(pos_);
+  base_ += pos_;
+  pos_ = end_ = 0;
+  bad_ = false;
+  encoding_ = encoding;
+  decode();
+  filled_ = end_;
+} // switchEncoding
+
+// Transcode the raw bytes to UTF-8 on the end of the scan buffer.  An
+// incomplete character at the end of the raw bytes waits for more input.
 template<class string_type, class T0, class T1>
-void Garden<string_type, T0, T1>::openElement(iterator_t s, iterator_t e)
+void Garden<string_type, T0, T1>::decode()
 {
-  elements_.push(str(s, e));
-  attrs_.clear();
-} // openElement
+  if(buffer_.size() - end_ < rawEnd_ * 2)
+    buffer_.resize(end_ + rawEnd_ * 2);
+
+  const unsigned char* raw = reinterpret_cast<const unsigned char*>(raw_.empty() ? 0 : &raw_[0]);
+  char* out = buffer_.empty() ? 0 : &buffer_[0];
+  size_t i = 0;
+  while(i != rawEnd_)
+  {
+    unsigned long cp;
+    if(encoding_ == Latin1)
+      cp = raw[i++];
+    else
+    {
+      if(rawEnd_ - i < 2)
+        break;
+      cp = (encoding_ == UTF16LE) ? (raw[i] | (raw[i+1] << 8)) : ((raw[i] << 8) | raw[i+1]);
+      if(cp >= 0xDC00 && cp <= 0xDFFF)
+        throw ParseError("not well-formed (invalid token) - unpaired surrogate");
+      if(cp >= 0xD800 && cp <= 0xDBFF)
+      {
+        if(rawEnd_ - i < 4)
+          break;
+        unsigned long low = (encoding_ == UTF16LE) ? (raw[i+2] | (raw[i+3] << 8)) : ((raw[i+2] << 8) | raw[i+3]);
+        if(low < 0xDC00 || low > 0xDFFF)
+          throw ParseError("not well-formed (invalid token) - unpaired surrogate");
+        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+        i += 2;
+      } // if ...
+      i += 2;
+    } // if ...
+
+    if(cp < 0x80)
+      out[end_++] = static_cast<char>(cp);
+    else
+      end_ += encodeCodePoint(out + end_, cp);
+  } // while ...
+
+  if(i != rawEnd_)
+    std::memmove(&raw_[0], &raw_[i], rawEnd_ - i);
+  rawEnd_ -= i;
+  data_ = out;
+} // decode
 
 template<class string_type, class T0, class T1>
-void Garden<string_type, T0, T1>::closeElement(iterator_t s, iterator_t e)
+bool Garden<string_type, T0, T1>::lookingAt(const char* literal, size_t length)
 {
-  if(contentHandler_)
-    contentHandler_->startElement(string_adaptor::empty_string(), elements_.top(), string_adaptor::empty_string(), attrs_);
-} // closeElement
+  return fill(length) && (std::memcmp(data_ + pos_, literal, length) == 0);
+} // lookingAt
 
 template<class string_type, class T0, class T1>
-void Garden<string_type, T0, T1>::closeEmptyElement(iterator_t s, iterator_t e)
+void Garden<string_type, T0, T1>::expect(char c)
 {
-  if(contentHandler_)
+  if(peek() != static_cast<unsigned char>(c))
+    throw ParseError(std::string("not well-formed (invalid token) - expected '") + c + "'");
+  ++pos_;
+} // expect
+
+template<class string_type, class T0, class T1>
+bool Garden<string_type, T0, T1>::skipSpaces()
+{
+  bool skipped = false;
+  for(;;)
+  {
+    while(pos_ != end_ && classes_.isSpace(data_[pos_]))
+    {
+      ++pos_;
+      skipped = true;
+    } // while ...
+    if(pos_ != end_ || !more())
+      return skipped;
+  } // for ...
+} // skipSpaces
+
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::requireSpaces()
+{
+  if(!skipSpaces())
+    throw ParseError("not well-formed (invalid token) - expected whitespace");
+} // requireSpaces
+
+// A run which stops at the end of the buffer rather than at a delimiter
+// leaves a trailing CR behind, so a CR LF pair split across two reads
+// is still seen as a pair.
+template<class string_type, class T0, class T1>
+size_t Garden<string_type, T0, T1>::runLength(const char* run, size_t length, bool delimited) const
+{
+  if(!delimited && !eof_ && length != 0 && run[length-1] == '\r')
+    return length - 1;
+  return length;
+} // runLength
+
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::countLines(size_t upTo) const
+{
+  if(!inputs_.empty() || data_ == 0 || base_ + upTo <= counted_)
+    return;
+
+  const char* b = data_;
+  const char* p = b + (counted_ - base_);
+  const char* e = b + upTo;
+  while(p != e)
+  {
+    const char* nl = static_cast<const char*>(std::memchr(p, '\n', e - p));
+    if(nl == 0)
+      break;
+    ++line_;
+    lineStart_ = base_ + (nl - b) + 1;
+    p = nl + 1;
+  } // while ...
+  counted_ = base_ + upTo;
+} // countLines
+
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::pushEntity(const std::string& name, const std::string& text, bool external)
+{
+  if(inputs_.size() == MaxEntityDepth)
+    throw ParseError("entity references nested too deeply");
+  for(size_t i = 0; i != inputs_.size(); ++i)
+    if(inputs_[i].name_ == name)
+      throw ParseError("recursive entity reference " + name);
+  countExpansion(text.size());
+
+  countLines(pos_);
+  inputs_.push_back(SavedInput());
+  SavedInput& saved = inputs_.back();
+  saved.stream_ = stream_;
+  saved.buffer_.swap(buffer_);
+  saved.data_ = data_;
+  saved.pos_ = pos_;
+  saved.end_ = end_;
+  saved.filled_ = filled_;
+  saved.bad_ = bad_;
+  saved.eof_ = eof_;
+  saved.encoding_ = encoding_;
+  saved.raw_.swap(raw_);
+  saved.rawEnd_ = rawEnd_;
+  saved.depth_ = depth_;
+  saved.name_ = name;
+  saved.external_ = external;
+
+  buffer_.assign(text.begin(), text.end());
+  data_ = buffer_.empty() ? 0 : &buffer_[0];
+  stream_ = 0;
+  pos_ = 0;
+  end_ = filled_ = buffer_.size();
+  bad_ = false;
+  eof_ = true;
+  encoding_ = UTF8;
+  rawEnd_ = 0;
+
+  if(external && lexicalHandler_)
+    lexicalHandler_->startEntity(str(name));
+} // pushEntity
+
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::popEntity()
+{
+  SavedInput& saved = inputs_.back();
+  if(saved.depth_ != depth_)
+    throw ParseError("entity " + saved.name_ + " is not well-balanced");
+  if(saved.external_ && lexicalHandler_)
+  {
+    flushText();
+    lexicalHandler_->endEntity(str(saved.name_));
+  } // if ...
+
+  stream_ = saved.stream_;
+  buffer_.swap(saved.buffer_);
+  data_ = saved.data_;
+  pos_ = saved.pos_;
+  end_ = saved.end_;
+  filled_ = saved.filled_;
+  bad_ = saved.bad_;
+  eof_ = saved.eof_;
+  encoding_ = saved.encoding_;
+  raw_.swap(saved.raw_);
+  rawEnd_ = saved.rawEnd_;
+  inputs_.pop_back();
+} // popEntity
+
+// Neither the depth limit nor the check for recursion stops a billion
+// laughs - ten entities, each referring ten times to the one before,
+// expand a few hundred bytes into gigabytes.  As in expat, the expanded
+// text is measured against the document read so far.
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::countExpansion(size_t length)
+{
+  expanded_ += length;
+  if(expanded_ <= ExpansionThreshold)
+    return;
+  const size_t read = base_ + (inputs_.empty() ? filled_ : inputs_.front().filled_);
+  if(expanded_ / MaxAmplification > read)
+    throw ParseError("entity expansion exceeds the limit - possible billion laughs attack");
+} // countExpansion
+
+// External parsed entities are small, so they are read whole and then
+// scanned like an internal entity.
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::loadExternalEntity(const std::string& publicId, const std::string& systemId, std::string& text)
+{
+  string_type pubId = str(publicId);
+  string_type sysId = str(systemId);
+
+  InputSourceT source;
+  if(entityResolver_)
+    source = entityResolver_->resolveEntity(pubId, sysId);
+  if(SA::empty(source.getPublicId()) && SA::empty(source.getSystemId()))
+  {
+    source.setPublicId(pubId);
+    source.setSystemId(sysId);
+  } // if ...
+
+  InputSourceResolver is(source, string_adaptor());
+  if(is.resolve() == 0)
+    throw ParseError("error in processing external entity reference");
+
+  text.clear();
+  if(is.bytes() != 0)
+    text.assign(is.bytes(), is.byteCount());
+  else
+  {
+    char chunk[4096];
+    while(is.resolve()->read(chunk, sizeof(chunk)) || is.resolve()->gcount())
+      text.append(chunk, static_cast<size_t>(is.resolve()->gcount()));
+  } // if ...
+
+  if(text.compare(0, 3, "\xEF\xBB\xBF") == 0)
+    text.erase(0, 3);
+  if(text.compare(0, 5, "<?xml") != 0 || text.size() < 6 || !classes_.isSpace(text[5]))
+    return;
+
+  // drop the text declaration, transcoding if it asks for ISO-8859-1
+  std::string::size_type close = text.find("?>");
+  if(close == std::string::npos)
+    throw ParseError("unclosed token");
+  std::string decl(text, 0, close);
+  text.erase(0, close + 2);
+  for(std::string::iterator c = decl.begin(); c != decl.end(); ++c)
+    if(*c >= 'A' && *c <= 'Z')
+      *c = *c - 'A' + 'a';
+  if(decl.find("8859-1") == std::string::npos && decl.find("latin1") == std::string::npos)
+    return;
+
+  std::string utf8;
+  for(std::string::const_iterator c = text.begin(); c != text.end(); ++c)
+    appendCodePoint(utf8, static_cast<unsigned char>(*c));
+  text.swap(utf8);
+} // loadExternalEntity
+
+//////////////////////////////////////////
+// text
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::append(std::string& out, const char* s, size_t length)
+{
+  const char* cr = static_cast<const char*>(std::memchr(s, '\r', length));
+  if(cr == 0)
+  {
+    out.append(s, length);
+    return;
+  } // if ...
+
+  // line-end normalisation
+  for(const char* e = s + length; s != e; s = cr)
+  {
+    cr = static_cast<const char*>(std::memchr(s, '\r', e - s));
+    if(cr == 0)
+    {
+      out.append(s, e - s);
+      return;
+    } // if ...
+    out.append(s, cr - s);
+    out += '\n';
+    if(++cr != e && *cr == '\n')
+      ++cr;
+  } // for ...
+} // append
+
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::appendAttribute(std::string& out, const char* s, size_t length)
+{
+  size_t from = out.size();
+  append(out, s, length);
+  for(std::string::iterator c = out.begin() + from, ce = out.end(); c != ce; ++c)
+    if(*c == '\n' || *c == '\t')
+      *c = ' ';
+} // appendAttribute
+
+template<class string_type, class T0, class T1>
+size_t Garden<string_type, T0, T1>::encodeCodePoint(char* out, unsigned long cp)
+{
+  if(cp < 0x80)
+  {
+    out[0] = static_cast<char>(cp);
+    return 1;
+  } // if ...
+  if(cp < 0x800)
+  {
+    out[0] = static_cast<char>(0xC0 | (cp >> 6));
+    out[1] = static_cast<char>(0x80 | (cp & 0x3F));
+    return 2;
+  } // if ...
+  if(cp < 0x10000)
   {
-    contentHandler_->startElement(string_adaptor::empty_string(), elements_.top(), string_adaptor::empty_string(), attrs_);
-    contentHandler_->endElement(string_adaptor::empty_string(), elements_.top(), string_adaptor::empty_string());
-    elements_.pop();
+    out[0] = static_cast<char>(0xE0 | (cp >> 12));
+    out[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out[2] = static_cast<char>(0x80 | (cp & 0x3F));
+    return 3;
   } // if ...
-} // closeEmptyElement
+  out[0] = static_cast<char>(0xF0 | (cp >> 18));
+  out[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+  out[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+  out[3] = static_cast<char>(0x80 | (cp & 0x3F));
+  return 4;
+} // encodeCodePoint
 
 template<class string_type, class T0, class T1>
-void Garden<string_type, T0, T1>::endElementName(iterator_t s, iterator_t e)
+void Garden<string_type, T0, T1>::appendCodePoint(std::string& out, unsigned long cp)
 {
-  string_type name = str(s, e);
-  if(name != elements_.top())
-    reportError("Expect end element " + string_adaptor::asStdString(elements_.top()), true);
-} // endElementName
+  char utf8[4];
+  out.append(utf8, encodeCodePoint(utf8, cp));
+} // appendCodePoint
 
 template<class string_type, class T0, class T1>
-void Garden<string_type, T0, T1>::endElement(iterator_t s, iterator_t e)
+void Garden<string_type, T0, T1>::flushText()
 {
+  if(text_.empty())
+    return;
   if(contentHandler_)
-    contentHandler_->endElement(string_adaptor::empty_string(), elements_.top(), string_adaptor::empty_string());
-  elements_.pop();
-} // endElement
+    contentHandler_->characters(str(text_));
+  text_.clear();
+} // flushText
 
+//////////////////////////////////////////
+// grammar
 template<class string_type, class T0, class T1>
-void Garden<string_type, T0, T1>::attributeName(iterator_t s, iterator_t e)
+void Garden<string_type, T0, T1>::parseDocument()
 {
-  currentAttr_ = typename AttributesImplT::Attr();
-  currentAttr_.localName_ = str(s, e);
-} // attributeName
+  fill(4);
+  if(lookingAt("\xEF\xBB\xBF", 3))
+  {
+    pos_ += 3;
+    switchEncoding(UTF8);
+  }
+  else if(lookingAt("\xFF\xFE", 2))
+  {
+    pos_ += 2;
+    switchEncoding(UTF16LE);
+  }
+  else if(lookingAt("\xFE\xFF", 2))
+  {
+    pos_ += 2;
+    switchEncoding(UTF16BE);
+  }
+  else if(lookingAt("<\0", 2))
+    switchEncoding(UTF16LE);
+  else if(lookingAt("\0<", 2))
+    switchEncoding(UTF16BE);
+  else
+    switchEncoding(UTF8);
+
+  if(lookingAt("<?xml", 5) && fill(6) && classes_.isSpace(data_[pos_+5]))
+    parseXMLDecl();
+
+  parseMisc(true);
+  if(peek() != '<')
+    throw ParseError(peek() == -1 ? "no element found" : "syntax error");
+  parseContent();
+  parseMisc(false);
+  if(peek() != -1)
+    throw ParseError("junk after document element");
+  if(filled_ != end_)
+    throw ParseError("not well-formed (invalid token)");
+} // parseDocument
 
 template<class string_type, class T0, class T1>
-void Garden<string_type, T0, T1>::attributeValue(iterator_t s, iterator_t e)
+void Garden<string_type, T0, T1>::parseXMLDecl()
 {
-  currentAttr_.value_ = str(s, e);
-  currentAttr_.type_ = AttributeType<string_type, string_adaptor>::CDATA;
-  attrs_.addAttribute(currentAttr_);
-} // attributeValue
+  pos_ += 5;
+  bool first = true;
+  bool latin1 = false;
+  for(;;)
+  {
+    bool spaced = skipSpaces();
+    if(lookingAt("?>", 2))
+    {
+      pos_ += 2;
+      break;
+    } // if ...
+    if(!spaced)
+      throw ParseError("XML declaration not well-formed");
+
+    scanName(name_);
+    skipSpaces();
+    expect('=');
+    skipSpaces();
+    scanLiteral(scratch_);
+
+    if(first && name_ != "version")
+      throw ParseError("XML declaration not well-formed");
+    first = false;
+
+    if(name_ == "encoding")
+    {
+      std::string enc;
+      for(std::string::const_iterator c = scratch_.begin(); c != scratch_.end(); ++c)
+        enc += static_cast<char>((*c >= 'A' && *c <= 'Z') ? (*c - 'A' + 'a') : *c);
+      if(encoding_ != UTF8)
+        continue; // the byte order mark or the declaration itself said UTF-16
+      if(enc == "iso-8859-1" || enc == "latin1" || enc == "iso_8859-1" || enc == "iso8859-1")
+        latin1 = true;
+      else if(enc != "utf-8" && enc != "utf8" && enc != "us-ascii" && enc != "ascii")
+        throw ParseError("unknown encoding " + scratch_);
+    } // if ...
+  } // for ...
+
+  if(latin1)
+    switchEncoding(Latin1);
+} // parseXMLDecl
 
 template<class string_type, class T0, class T1>
-void Garden<string_type, T0, T1>::elementContent(iterator_t s, iterator_t e)
+void Garden<string_type, T0, T1>::parseMisc(bool prolog)
 {
-  if(contentHandler_ && (s != e))
-    contentHandler_->characters(str(s, e));
-} // Garden<string_type, T0, T1>::elementContent
-  
-// processing instructions
+  bool seenDoctype = false;
+  for(;;)
+  {
+    skipSpaces();
+    int c = peek();
+    if(c == -1)
+      return;
+    markup_ = base_ + pos_;
+    if(c != '<')
+      throw ParseError(prolog ? "syntax error" : "junk after document element");
+
+    if(lookingAt("<!--", 4))
+      parseComment();
+    else if(lookingAt("<?", 2))
+      parsePI();
+    else if(prolog && !seenDoctype && lookingAt("<!DOCTYPE", 9))
+    {
+      parseDoctype();
+      seenDoctype = true;
+    }
+    else if(prolog)
+      return;
+    else
+      throw ParseError("junk after document element");
+  } // for ...
+} // parseMisc
+
 template<class string_type, class T0, class T1>
-void Garden<string_type, T0, T1>::piTarget(iterator_t s, iterator_t e)
+void Garden<string_type, T0, T1>::parseContent()
 {
-  piTarget_ = str(s, e);
-  piData_ = string_adaptor::empty_string();
-} // piTarget
+  do
+  {
+    scanText();
+
+    if(!fill(2))
+    {
+      if(inputs_.empty())
+        throw ParseError((pos_ == end_) ? "no element found" : "unclosed token");
+      popEntity();
+      continue;
+    } // if ...
+
+    markup_ = base_ + pos_;
+    switch(data_[pos_+1])
+    {
+      case '/':
+        flushText();
+        parseEndTag();
+        break;
+      case '?':
+        flushText();
+        parsePI();
+        break;
+      case '!':
+        flushText();
+        if(lookingAt("<!--", 4))
+          parseComment();
+        else if(lookingAt("<![CDATA[", 9))
+          parseCDATA();
+        else
+          throw ParseError("not well-formed (invalid token)");
+        break;
+      default:
+        flushText();
+        parseStartTag();
+        break;
+    } // switch
+  }
+  while(depth_ != 0);
+} // parseContent
 
 template<class string_type, class T0, class T1>
-void Garden<string_type, T0, T1>::piData(iterator_t s, iterator_t e)
+void Garden<string_type, T0, T1>::scanText()
 {
-  piData_ = str(s, e);
-} // piData
+  for(;;)
+  {
+    if(pos_ == end_ && !more())
+      return;
+
+    const char* s = data_ + pos_;
+    size_t n = end_ - pos_;
+    const char* lt = static_cast<const char*>(std::memchr(s, '<', n));
+    size_t run = lt ? (lt - s) : n;
+    const char* amp = static_cast<const char*>(std::memchr(s, '&', run));
+    if(amp)
+      run = amp - s;
+    run = runLength(s, run, lt || amp);
+
+    if(run != 0)
+    {
+      if(depth_ == 0)
+        throw ParseError("not well-formed (invalid token) - text outside the document element");
+      append(text_, s, run);
+      pos_ += run;
+    } // if ...
+
+    if(amp)
+      parseReference(text_, false);
+    else if(lt)
+      return;
+    else if(!more())
+      return;
+  } // for ...
+} // scanText
 
 template<class string_type, class T0, class T1>
-void Garden<string_type, T0, T1>::piEnd(iterator_t s, iterator_t e)
+bool Garden<string_type, T0, T1>::parseStartTag()
 {
-  if(contentHandler_)
-    contentHandler_->processingInstruction(piTarget_, piData_);
-} // piEnd
+  ++pos_;
+  scanName(name_);
+
+  attCount_ = 0;
+  bool empty = false;
+  for(;;)
+  {
+    bool spaced = skipSpaces();
+    int c = peek();
+    if(c == '>')
+    {
+      ++pos_;
+      break;
+    } // if ...
+    if(c == '/')
+    {
+      ++pos_;
+      expect('>');
+      empty = true;
+      break;
+    } // if ...
+    if(!spaced)
+      throw ParseError("not well-formed (invalid token)");
+
+    if(attCount_ == attNames_.size())
+    {
+      attNames_.push_back(std::string());
+      attValues_.push_back(std::string());
+    } // if ...
+    std::string& attName = attNames_[attCount_];
+    scanName(attName);
+    skipSpaces();
+    expect('=');
+    skipSpaces();
+    scanAttValue(attValues_[attCount_]);
+
+    for(size_t a = 0; a != attCount_; ++a)
+      if(attNames_[a] == attName)
+        throw ParseError("duplicate attribute " + attName);
+    ++attCount_;
+  } // for ...
+
+  reportStartElement(empty);
+  return !empty;
+} // parseStartTag
 
-//entity refs
 template<class string_type, class T0, class T1>
-void Garden<string_type, T0, T1>::entityRef(iterator_t s, iterator_t e)
+void Garden<string_type, T0, T1>::parseEndTag()
 {
+  pos_ += 2;
+  scanName(name_);
+  skipSpaces();
+  expect('>');
+
+  if(depth_ == 0 || elements_[depth_-1] != name_)
+    throw ParseError("mismatched tag");
+  reportEndElement();
+} // parseEndTag
+
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::parseComment()
+{
+  pos_ += 4;
+  scratch_.clear();
+  scanUntil("--", 2, scratch_);
+  expect('>');
+
+  if(lexicalHandler_)
+    lexicalHandler_->comment(str(scratch_));
+} // parseComment
+
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::parsePI()
+{
+  pos_ += 2;
+  scanName(name_);
+  if(name_.size() == 3 &&
+     (name_[0] == 'x' || name_[0] == 'X') &&
+     (name_[1] == 'm' || name_[1] == 'M') &&
+     (name_[2] == 'l' || name_[2] == 'L'))
+    throw ParseError("XML or text declaration not at start of entity");
+
+  scratch_.clear();
+  if(lookingAt("?>", 2))
+    pos_ += 2;
+  else
+  {
+    requireSpaces();
+    scanUntil("?>", 2, scratch_);
+  } // if ...
+
   if(contentHandler_)
+    contentHandler_->processingInstruction(str(name_), str(scratch_));
+} // parsePI
+
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::parseCDATA()
+{
+  pos_ += 9;
+  if(lexicalHandler_)
+    lexicalHandler_->startCDATA();
+  scanUntil("]]>", 3, text_);
+  flushText();
+  if(lexicalHandler_)
+    lexicalHandler_->endCDATA();
+} // parseCDATA
+
+// Copy everything up to the terminator into out, and step over the
+// terminator.  Only the terminator's first character is searched for.
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::scanUntil(const char* terminator, size_t length, std::string& out)
+{
+  for(;;)
+  {
+    if(pos_ == end_ && !more())
+      throw ParseError("unclosed token");
+
+    const char* s = data_ + pos_;
+    const char* hit = static_cast<const char*>(std::memchr(s, terminator[0], end_ - pos_));
+    size_t run = runLength(s, hit ? (hit - s) : (end_ - pos_), hit != 0);
+    append(out, s, run);
+    pos_ += run;
+    if(!hit)
+    {
+      if(!more())
+        throw ParseError("unclosed token");
+      continue;
+    } // if ...
+
+    if(!fill(length))
+      throw ParseError("unclosed token");
+    if(std::memcmp(data_ + pos_, terminator, length) == 0)
+    {
+      pos_ += length;
+      return;
+    } // if ...
+    out += data_[pos_++];
+  } // for ...
+} // scanUntil
+
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::parseDoctype()
+{
+  pos_ += 9;
+  requireSpaces();
+  scanName(name_);
+  std::string name(name_);
+
+  std::string publicId, systemId;
+  if(skipSpaces())
+    parseExternalId(publicId, systemId, true);
+  externalSubset_ = !systemId.empty();
+
+  if(lexicalHandler_)
+    lexicalHandler_->startDTD(str(name), str(publicId), str(systemId));
+
+  skipSpaces();
+  if(peek() == '[')
+  {
+    ++pos_;
+    for(;;)
+    {
+      skipSpaces();
+      int c = peek();
+      if(c == -1)
+        throw ParseError("unclosed token");
+      if(c == ']')
+      {
+        ++pos_;
+        break;
+      } // if ...
+      if(c == '%')
+      {
+        // parameter entities are not expanded
+        ++pos_;
+        scanName(name_);
+        expect(';');
+        externalSubset_ = true;
+        continue;
+      } // if ...
+
+      if(lookingAt("<!--", 4))
+        parseComment();
+      else if(lookingAt("<?", 2))
+        parsePI();
+      else if(lookingAt("<!ENTITY", 8))
+        parseEntityDecl();
+      else if(lookingAt("<!ATTLIST", 9))
+        parseAttlistDecl();
+      else if(lookingAt("<!ELEMENT", 9))
+        parseElementDecl();
+      else if(lookingAt("<!NOTATION", 10))
+        parseNotationDecl();
+      else
+        throw ParseError("syntax error in internal subset");
+    } // for ...
+    skipSpaces();
+  } // if ...
+  expect('>');
+
+  if(lexicalHandler_)
+    lexicalHandler_->endDTD();
+} // parseDoctype
+
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::parseExternalId(std::string& publicId, std::string& systemId, bool systemOptional)
+{
+  if(lookingAt("SYSTEM", 6))
+  {
+    pos_ += 6;
+    requireSpaces();
+    scanLiteral(systemId);
+  }
+  else if(lookingAt("PUBLIC", 6))
+  {
+    pos_ += 6;
+    requireSpaces();
+    scanLiteral(publicId);
+    bool spaced = skipSpaces();
+    int c = peek();
+    if(c == '"' || c == '\'')
+    {
+      if(!spaced)
+        throw ParseError("syntax error - expected whitespace");
+      scanLiteral(systemId);
+    }
+    else if(!systemOptional)
+      throw ParseError("syntax error - expected system literal");
+  } // if ...
+} // parseExternalId
+
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::parseEntityDecl()
+{
+  pos_ += 8;
+  requireSpaces();
+  bool parameter = false;
+  if(peek() == '%')
+  {
+    ++pos_;
+    requireSpaces();
+    parameter = true;
+  } // if ...
+  scanName(name_);
+  std::string name(name_);
+  requireSpaces();
+
+  std::string value, publicId, systemId, notation;
+  bool internal = (peek() == '"' || peek() == '\'');
+  if(internal)
+    scanEntityValue(value);
+  else
+  {
+    parseExternalId(publicId, systemId, false);
+    if(systemId.empty())
+      throw ParseError("syntax error in entity declaration");
+    if(skipSpaces() && !parameter && lookingAt("NDATA", 5))
+    {
+      pos_ += 5;
+      requireSpaces();
+      scanName(notation);
+    } // if ...
+  } // if ...
+  skipSpaces();
+  expect('>');
+
+  if(!parameter)
+  {
+    if(entities_.find(name) != entities_.end() || externalEntities_.find(name) != externalEntities_.end())
+      return; // only the first declaration counts
+
+    if(internal)
+      entities_.insert(std::make_pair(name, value));
+    else
+    {
+      ExternalEntity& external = externalEntities_[name];
+      external.publicId_ = publicId;
+      external.systemId_ = systemId;
+      external.unparsed_ = !notation.empty();
+    } // if ...
+  } // if ...
+
+  if(internal)
+  {
+    if(declHandler_)
+      declHandler_->internalEntityDecl(str(parameter ? ("%" + name) : name), str(value));
+  }
+  else if(notation.empty())
+  {
+    if(declHandler_)
+      declHandler_->externalEntityDecl(str(parameter ? ("%" + name) : name), str(publicId), str(systemId));
+  }
+  else if(dtdHandler_)
+    dtdHandler_->unparsedEntityDecl(str(name), str(publicId), str(systemId), str(notation));
+} // parseEntityDecl
+
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::parseAttlistDecl()
+{
+  pos_ += 9;
+  requireSpaces();
+  scanName(name_);
+  std::string elementName(name_);
+  AttributeDeclList& decls = attributeDecls_[elementName];
+
+  for(;;)
+  {
+    bool spaced = skipSpaces();
+    if(peek() == '>')
+    {
+      ++pos_;
+      return;
+    } // if ...
+    if(!spaced)
+      throw ParseError("syntax error in attribute list declaration");
+
+    AttributeDecl decl;
+    scanName(decl.name_);
+    requireSpaces();
+
+    std::string type;
+    if(peek() != '(')
+    {
+      scanName(type);
+      if(type == "NOTATION")
+        requireSpaces();
+    } // if ...
+    if(peek() == '(')
+    {
+      for(int c = peek(); c != ')'; c = peek())
+      {
+        if(c == -1)
+          throw ParseError("unclosed token");
+        if(!classes_.isSpace(static_cast<char>(c)))
+          type += static_cast<char>(c);
+        ++pos_;
+      } // for ...
+      type += data_[pos_++];
+    } // if ...
+    requireSpaces();
+
+    const string_type* valueDefault = &attrDefaults_.implied;
+    decl.hasDefault_ = true;
+    if(peek() == '#')
+    {
+      ++pos_;
+      scanName(name_);
+      if(name_ == "REQUIRED")
+      {
+        valueDefault = &attrDefaults_.required;
+        decl.hasDefault_ = false;
+      }
+      else if(name_ == "IMPLIED")
+        decl.hasDefault_ = false;
+      else if(name_ == "FIXED")
+      {
+        valueDefault = &attrDefaults_.fixed;
+        requireSpaces();
+      }
+      else
+        throw ParseError("syntax error in attribute list declaration");
+    } // if ...
+    if(decl.hasDefault_)
+      scanAttValue(decl.value_);
+    decl.cdata_ = (type == "CDATA");
+
+    bool declared = false;
+    for(typename AttributeDeclList::const_iterator d = decls.begin(); d != decls.end(); ++d)
+      declared = declared || (d->name_ == decl.name_);
+    if(declared)
+      continue;
+    decls.push_back(decl);
+
+    if(declHandler_)
+      declHandler_->attributeDecl(str(elementName),
+                                  str(decl.name_),
+                                  str(type),
+                                  *valueDefault,
+                                  str(decl.value_));
+  } // for ...
+} // parseAttlistDecl
+
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::parseElementDecl()
+{
+  pos_ += 9;
+  requireSpaces();
+  scanName(name_);
+  std::string name(name_);
+  requireSpaces();
+
+  std::string model;
+  for(int c = peek(); c != '>'; c = peek())
+  {
+    if(c == -1)
+      throw ParseError("unclosed token");
+    if(!classes_.isSpace(static_cast<char>(c)))
+      model += static_cast<char>(c);
+    ++pos_;
+  } // for ...
+  ++pos_;
+
+  if(declHandler_)
+    declHandler_->elementDecl(str(name), str(model));
+} // parseElementDecl
+
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::parseNotationDecl()
+{
+  pos_ += 10;
+  requireSpaces();
+  scanName(name_);
+  std::string name(name_);
+  requireSpaces();
+
+  std::string publicId, systemId;
+  parseExternalId(publicId, systemId, true);
+  skipSpaces();
+  expect('>');
+
+  if(dtdHandler_)
+    dtdHandler_->notationDecl(str(name), str(publicId), str(systemId));
+} // parseNotationDecl
+
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::scanName(std::string& name)
+{
+  name.clear();
+  int c = peek();
+  if(c == -1 || !classes_.isNameStart(static_cast<char>(c)))
+    throw ParseError("not well-formed (invalid token)");
+
+  for(;;)
+  {
+    size_t start = pos_;
+    while(pos_ != end_ && classes_.isName(data_[pos_]))
+      ++pos_;
+    name.append(data_ + start, pos_ - start);
+    if(pos_ != end_ || !more())
+      break;
+  } // for ...
+} // scanName
+
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::scanLiteral(std::string& value)
+{
+  int quote = peek();
+  if(quote != '"' && quote != '\'')
+    throw ParseError("not well-formed (invalid token) - expected quoted literal");
+  ++pos_;
+
+  value.clear();
+  for(;;)
+  {
+    if(pos_ == end_ && !more())
+      throw ParseError("unclosed token");
+    const char* s = data_ + pos_;
+    const char* q = static_cast<const char*>(std::memchr(s, quote, end_ - pos_));
+    size_t run = q ? (q - s) : (end_ - pos_);
+    append(value, s, run);
+    pos_ += run;
+    if(q)
+    {
+      ++pos_;
+      return;
+    } // if ...
+  } // for ...
+} // scanLiteral
+
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::scanAttValue(std::string& value)
+{
+  int quote = peek();
+  if(quote != '"' && quote != '\'')
+    throw ParseError("not well-formed (invalid token) - expected quoted value");
+  ++pos_;
+
+  value.clear();
+  for(;;)
+  {
+    if(pos_ == end_ && !more())
+      throw ParseError("unclosed token");
+
+    const char* s = data_ + pos_;
+    size_t n = end_ - pos_;
+    const char* q = static_cast<const char*>(std::memchr(s, quote, n));
+    size_t run = q ? (q - s) : n;
+    const char* amp = static_cast<const char*>(std::memchr(s, '&', run));
+    if(amp)
+      run = amp - s;
+    if(std::memchr(s, '<', run))
+      throw ParseError("not well-formed (invalid token) - '<' in attribute value");
+    run = runLength(s, run, q || amp);
+
+    appendAttribute(value, s, run);
+    pos_ += run;
+
+    if(amp)
+      parseReference(value, true);
+    else if(q)
+    {
+      ++pos_;
+      return;
+    } // if ...
+    else if(!more())
+      throw ParseError("unclosed token");
+  } // for ...
+} // scanAttValue
+
+// Character references are replaced when the entity is declared,
+// general entity references are left for expansion where the entity
+// is used.
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::scanEntityValue(std::string& value)
+{
+  int quote = peek();
+  ++pos_;
+
+  value.clear();
+  for(;;)
   {
-    string_type name(str(s, e, 1));
+    if(pos_ == end_ && !more())
+      throw ParseError("unclosed token");
+
+    const char* s = data_ + pos_;
+    size_t n = end_ - pos_;
+    const char* q = static_cast<const char*>(std::memchr(s, quote, n));
+    size_t run = q ? (q - s) : n;
+    const char* amp = static_cast<const char*>(std::memchr(s, '&', run));
+    if(amp)
+      run = amp - s;
+    run = runLength(s, run, q || amp);
 
-    typedef typename std::map<string_type, string_type>::iterator entity_iterator;
+    append(value, s, run);
+    pos_ += run;
 
-    entity_iterator ent = declaredEntities_.find(name);
-    if(ent != declaredEntities_.end())
-    { 
-      contentHandler_->characters((*ent).second);
+    if(amp)
+    {
+      if(!fill(2))
+        throw ParseError("unclosed token");
+      if(data_[pos_+1] == '#')
+        appendCodePoint(value, parseCharRef());
+      else
+      {
+        ++pos_;
+        scanName(refName_);
+        expect(';');
+        value += '&';
+        value += refName_;
+        value += ';';
+      } // if ...
+    }
+    else if(q)
+    {
+      ++pos_;
       return;
-    } 
+    } // if ...
+    else if(!more())
+      throw ParseError("unclosed token");
+  } // for ...
+} // scanEntityValue
+
+template<class string_type, class T0, class T1>
+unsigned long Garden<string_type, T0, T1>::parseCharRef()
+{
+  pos_ += 2;
+  int base = 10;
+  if(peek() == 'x')
+  {
+    base = 16;
+    ++pos_;
+  } // if ...
+
+  unsigned long cp = 0;
+  int digits = 0;
+  for(int c = peek(); c != ';'; c = peek())
+  {
+    int v;
+    if(c >= '0' && c <= '9')
+      v = c - '0';
+    else if(base == 16 && c >= 'a' && c <= 'f')
+      v = c - 'a' + 10;
+    else if(base == 16 && c >= 'A' && c <= 'F')
+      v = c - 'A' + 10;
     else
+      throw ParseError("not well-formed (invalid token) in character reference");
+    cp = cp * base + v;
+    if(cp > 0x10FFFF)
+      throw ParseError("reference to invalid character number");
+    ++digits;
+    ++pos_;
+  } // for ...
+  ++pos_;
+
+  if(digits == 0 ||
+     (cp < 0x20 && cp != 0x9 && cp != 0xA && cp != 0xD) ||
+     (cp >= 0xD800 && cp <= 0xDFFF) ||
+     cp == 0xFFFE || cp == 0xFFFF)
+    throw ParseError("reference to invalid character number");
+  return cp;
+} // parseCharRef
+
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::parseReference(std::string& out, bool inAttribute)
+{
+  if(!fill(2))
+    throw ParseError("unclosed token");
+  if(data_[pos_+1] == '#')
+  {
+    appendCodePoint(out, parseCharRef());
+    return;
+  } // if ...
+
+  ++pos_;
+  scanName(refName_);
+  expect(';');
+
+  if(refName_.size() <= 4)
+  {
+    char c = 0;
+    if(refName_ == "lt") c = '<';
+    else if(refName_ == "gt") c = '>';
+    else if(refName_ == "amp") c = '&';
+    else if(refName_ == "quot") c = '"';
+    else if(refName_ == "apos") c = '\'';
+    if(c)
+    {
+      out += c;
+      return;
+    } // if ...
+  } // if ...
+
+  std::map<std::string, std::string>::const_iterator entity = entities_.find(refName_);
+  if(entity == entities_.end())
+  {
+    typename std::map<std::string, ExternalEntity>::const_iterator external = externalEntities_.find(refName_);
+    if(external != externalEntities_.end())
     {
-      reportError("Undeclared entity " + string_adaptor::asStdString(name));
+      if(external->second.unparsed_)
+        throw ParseError("reference to binary entity " + refName_);
+      if(inAttribute)
+        throw ParseError("reference to external entity in attribute " + refName_);
+      flushText();
+      if(!externalResolving_)
+      {
+        if(contentHandler_)
+          contentHandler_->skippedEntity(str(refName_));
+        return;
+      } // if ...
+
+      std::string text;
+      loadExternalEntity(external->second.publicId_, external->second.systemId_, text);
+      bool bad = false;
+      if(garden_impl::validUTF8(text.data(), text.data() + text.size(), bad) != text.data() + text.size())
+        throw ParseError("not well-formed (invalid token) in external entity " + refName_);
+      pushEntity(external->first, text, true);
       return;
     } // if ...
 
-    contentHandler_->skippedEntity(name);
-  } // if ... 
-} // entityRef
-  
+    if(inAttribute || !externalSubset_)
+      throw ParseError("undefined entity " + refName_);
+    if(contentHandler_)
+    {
+      flushText();
+      contentHandler_->skippedEntity(str(refName_));
+    } // if ...
+    return;
+  } // if ...
+
+  const std::string& text = entity->second;
+  if(inAttribute)
+  {
+    countExpansion(text.size());
+    expandInAttribute(text, out, 1);
+    return;
+  } // if ...
+
+  if(text.find_first_of("<&") == std::string::npos)
+  {
+    countExpansion(text.size());
+    out += text;
+  }
+  else
+    pushEntity(entity->first, text, false);
+} // parseReference
+
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::expandInAttribute(const std::string& text, std::string& out, int level)
+{
+  if(level > MaxEntityDepth)
+    throw ParseError("recursive entity reference");
+
+  for(std::string::size_type i = 0; i != text.size(); ++i)
+  {
+    char c = text[i];
+    if(c == '<')
+      throw ParseError("not well-formed (invalid token) - '<' in attribute value");
+    if(c != '&')
+    {
+      out += (c == '\n' || c == '\t' || c == '\r') ? ' ' : c;
+      continue;
+    } // if ...
+
+    std::string::size_type semi = text.find(';', i);
+    if(semi == std::string::npos)
+      throw ParseError("not well-formed (invalid token) in entity reference");
+    std::string ref(text, i + 1, semi - i - 1);
+    i = semi;
+
+    if(!ref.empty() && ref[0] == '#')
+    {
+      // only possible where the declaration escaped the ampersand
+      unsigned long cp = (ref.size() > 1 && ref[1] == 'x') ?
+                           std::strtoul(ref.c_str() + 2, 0, 16) :
+                           std::strtoul(ref.c_str() + 1, 0, 10);
+      appendCodePoint(out, cp);
+    }
+    else if(ref == "lt") out += '<';
+    else if(ref == "gt") out += '>';
+    else if(ref == "amp") out += '&';
+    else if(ref == "quot") out += '"';
+    else if(ref == "apos") out += '\'';
+    else
+    {
+      std::map<std::string, std::string>::const_iterator entity = entities_.find(ref);
+      if(entity == entities_.end())
+        throw ParseError("undefined entity " + ref);
+      countExpansion(entity->second.size());
+      expandInAttribute(entity->second, out, level + 1);
+    } // if ...
+  } // for ...
+} // expandInAttribute
+
+//////////////////////////////////////////
+// events
 template<class string_type, class T0, class T1>
-void Garden<string_type, T0, T1>::decimalCharacterRef(iterator_t s, iterator_t e)
+void Garden<string_type, T0, T1>::applyDefaults()
 {
-  characterRef(s, e, 10);
-} // decimalCharacterRef
+  typename std::map<std::string, AttributeDeclList>::const_iterator decls = attributeDecls_.find(name_);
+  if(decls == attributeDecls_.end())
+    return;
+
+  for(typename AttributeDeclList::const_iterator d = decls->second.begin(); d != decls->second.end(); ++d)
+  {
+    size_t a = 0;
+    while(a != attCount_ && attNames_[a] != d->name_)
+      ++a;
+
+    if(a != attCount_)
+    {
+      if(d->cdata_)
+        continue;
+      // tokenised types have their whitespace collapsed
+      std::string& value = attValues_[a];
+      std::string collapsed;
+      for(std::string::const_iterator c = value.begin(); c != value.end(); ++c)
+        if(*c != ' ' || (!collapsed.empty() && *(collapsed.end()-1) != ' '))
+          collapsed += *c;
+      if(!collapsed.empty() && *(collapsed.end()-1) == ' ')
+        collapsed.erase(collapsed.size() - 1);
+      value.swap(collapsed);
+    }
+    else if(d->hasDefault_)
+    {
+      if(attCount_ == attNames_.size())
+      {
+        attNames_.push_back(std::string());
+        attValues_.push_back(std::string());
+      } // if ...
+      attNames_[attCount_] = d->name_;
+      attValues_[attCount_] = d->value_;
+      ++attCount_;
+    } // if ...
+  } // for ...
+} // applyDefaults
 
 template<class string_type, class T0, class T1>
-void Garden<string_type, T0, T1>::hexCharacterRef(iterator_t s, iterator_t e)
+void Garden<string_type, T0, T1>::reportStartElement(bool empty)
 {
-  characterRef(s, e, 16);
-} // hexCharacterRef
+  if(!attributeDecls_.empty())
+    applyDefaults();
+
+  if(depth_ == elements_.size())
+    elements_.push_back(name_);
+  else
+    elements_[depth_] = name_;
+  ++depth_;
+
+  attrs_.clear();
+  string_type qName = str(name_);
+
+  if(!namespaces_)
+  {
+    for(size_t a = 0; a != attCount_; ++a)
+      attrs_.addAttribute(emptyString_, emptyString_, str(attNames_[a]), AttributeTypeT::CDATA, str(attValues_[a]));
+    contextPushed_.push_back(false);
+    if(contentHandler_)
+      contentHandler_->startElement(emptyString_, emptyString_, qName, attrs_);
+    if(empty)
+      reportEndElement();
+    return;
+  } // if ...
+
+  bool pushedContext = false;
+  for(size_t a = 0; a != attCount_; ++a)
+  {
+    const std::string& attName = attNames_[a];
+    if(attName.compare(0, 5, "xmlns") != 0 || (attName.size() > 5 && attName[5] != ':'))
+      continue;
+
+    if(!pushedContext)
+    {
+      nsSupport_.pushContext();
+      pushedContext = true;
+    } // if ...
+
+    string_type prefix = (attName.size() > 5) ? SA::construct_from_utf8(attName.data() + 6, static_cast<int>(attName.size() - 6)) : emptyString_;
+    string_type value = str(attValues_[a]);
+    if(!nsSupport_.declarePrefix(prefix, value))
+      reportError(std::string("Illegal Namespace prefix ") + SA::asStdString(prefix));
+    if(contentHandler_)
+      contentHandler_->startPrefixMapping(prefix, value);
+    if(prefixes_)
+      attrs_.addAttribute(emptyString_, emptyString_, str(attName), AttributeTypeT::CDATA, value);
+  } // for ...
+  contextPushed_.push_back(pushedContext);
+
+  for(size_t a = 0; a != attCount_; ++a)
+  {
+    const std::string& attName = attNames_[a];
+    if(attName.compare(0, 5, "xmlns") == 0 && (attName.size() == 5 || attName[5] == ':'))
+      continue;
+
+    qualifiedNameT name = processName(str(attName), true);
+    attrs_.addAttribute(name.namespaceUri(), name.localName(), name.rawName(), AttributeTypeT::CDATA, str(attValues_[a]));
+  } // for ...
+
+  qualifiedNameT name = processName(qName, false);
+  if(contentHandler_)
+    contentHandler_->startElement(name.namespaceUri(), name.localName(), name.rawName(), attrs_);
+
+  if(empty)
+    reportEndElement();
+} // reportStartElement
 
 template<class string_type, class T0, class T1>
-void Garden<string_type, T0, T1>::characterRef(iterator_t s, iterator_t e, int base)
+void Garden<string_type, T0, T1>::reportEndElement()
 {
-  if(!contentHandler_)
+  --depth_;
+  bool pushedContext = contextPushed_.back();
+  contextPushed_.pop_back();
+
+  string_type qName = str(elements_[depth_]);
+  if(!namespaces_)
+  {
+    if(contentHandler_)
+      contentHandler_->endElement(emptyString_, emptyString_, qName);
+    return;
+  } // if ...
+
+  qualifiedNameT name = processName(qName, false);
+  if(contentHandler_)
+    contentHandler_->endElement(name.namespaceUri(), name.localName(), name.rawName());
+
+  if(!pushedContext)
     return;
 
-  int val = 0;
-  char next = *s;
-  while(++s != e)
+  if(contentHandler_)
   {
-    val *= base;
-    val += conversion_[next];
-    next = *s;
-  } 
+    typename namespaceSupportT::stringListT prefixes = nsSupport_.getDeclaredPrefixes();
+    for(size_t i = 0, end = prefixes.size(); i < end; ++i)
+      contentHandler_->endPrefixMapping(prefixes[i]);
+  } // if ...
+  nsSupport_.popContext();
+} // reportEndElement
 
-  contentHandler_->characters(string_adaptor::construct("?"));//string_type(1, val));
-} // characterRef
+template<class string_type, class T0, class T1>
+typename Garden<string_type, T0, T1>::qualifiedNameT Garden<string_type, T0, T1>::processName(const string_type& qName, bool isAttribute)
+{
+  qualifiedNameT p = nsSupport_.processName(qName, isAttribute);
+  if(!p.has_namespaceUri() && p.has_prefix())
+    reportError(std::string("Undeclared prefix ") + SA::asStdString(qName));
+  return p;
+} // processName
 
-///////////////////////////////  
+template<class string_type, class T0, class T1>
+void Garden<string_type, T0, T1>::checkNotParsing(const string_type& type, const string_type& name) const
+{
+  if(parsing_)
+  {
+    std::ostringstream os;
+    os << "Can't change " << SA::asStdString(type) << " " << SA::asStdString(name) << " while parsing";
+    throw SAX::SAXNotSupportedException(os.str());
+  } // if(parsing_)
+} // checkNotParsing
+
+///////////////////////////////
 template<class string_type, class T0, class T1>
 void Garden<string_type, T0, T1>::reportError(const std::string& message, bool fatal)
 {
   if(!errorHandler_)
     return;
-  
-  SAX::SAXParseException<string_type> e(message);
+
+  SAXParseExceptionT e(message, publicId_, systemId_, getLineNumber(), getColumnNumber());
 
   if(fatal)
     errorHandler_->fatalError(e);
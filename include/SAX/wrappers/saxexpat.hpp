@@ -6,9 +6,11 @@
 
 #include <SAX/ArabicaConfig.hpp>
 #include <SAX/XMLReader.hpp>
+#include <Arabica/stats.hpp>
 #include <expat.h>
 
 #include <sstream>
+#include <climits>
 #include <SAX/InputSource.hpp>
 #include <SAX/ContentHandler.hpp>
 #include <SAX/SAXParseException.hpp>
@@ -463,6 +465,7 @@ bool expat_wrapper<string_type, T0, T1>::getFeature(const string_type& name) con
 template<class string_type, class T0, class T1>
 void expat_wrapper<string_type, T0, T1>::parse(inputSourceT& source)
 {
+  ARABICA_STATS_TIME(sax_parse);
   setCallbacks();
 
   publicId_ = source.getPublicId();
@@ -498,6 +501,27 @@ bool expat_wrapper<string_type, T0, T1>::do_parse(inputSourceT& source, XML_Pars
     return false;
   } // if(is.resolver() == 0)
 
+  if(is.bytes() != 0)
+  {
+    // the document is already in memory, so hand it straight to expat,
+    // which parses in place rather than copying into its own buffer
+    const char* bytes = is.bytes();
+    size_t remaining = is.byteCount();
+    do
+    {
+      int len = (remaining > INT_MAX) ? INT_MAX : static_cast<int>(remaining);
+      remaining -= len;
+      if(XML_Parse(parser, bytes, len, remaining == 0) == 0)
+      {
+        reportError(XML_ErrorString(XML_GetErrorCode(parser_)), true);
+        return false;
+      } // if ...
+      bytes += len;
+    }
+    while(remaining != 0);
+    return true;
+  } // if ...
+
   const int BUFF_SIZE = 10*1024;
   while(!is.resolve()->eof())
   {
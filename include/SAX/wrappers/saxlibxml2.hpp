@@ -6,6 +6,7 @@
 
 #include <SAX/ArabicaConfig.hpp>
 #include <SAX/XMLReader.hpp>
+#include <Arabica/stats.hpp>
 #include <SAX/SAXParseException.hpp>
 #include <SAX/InputSource.hpp>
 #include <SAX/SAXNotSupportedException.hpp>
@@ -14,6 +15,7 @@
 
 #include <string>
 #include <cstdarg>
+#include <climits>
 #include <typeinfo>
 
 #include <SAX/helpers/FeatureNames.hpp>
@@ -464,6 +466,7 @@ size_t libxml2_wrapper<string_type, T0, T1>::getColumnNumber() const
 template<class string_type, class T0, class T1>
 void libxml2_wrapper<string_type, T0, T1>::parse(inputSourceT& source)
 {
+  ARABICA_STATS_TIME(sax_parse);
   if(contentHandler_)
     contentHandler_->setDocumentLocator(*this);
 
@@ -473,12 +476,29 @@ void libxml2_wrapper<string_type, T0, T1>::parse(inputSourceT& source)
 
   parsing_ = true;
 
-	while(!is.resolve()->eof())
- 	{
-		char buffer[4096];
-		is.resolve()->read(buffer, sizeof(buffer));
-		xmlParseChunk(context_, buffer, (int)is.resolve()->gcount(), is.resolve()->eof());
-	} // while(!in.eof())
+  if(is.bytes() != 0)
+  {
+    // already in memory - pass it over in large chunks
+    const char* bytes = is.bytes();
+    size_t remaining = is.byteCount();
+    do
+    {
+      int len = (remaining > INT_MAX) ? INT_MAX : static_cast<int>(remaining);
+      remaining -= len;
+      xmlParseChunk(context_, bytes, len, remaining == 0);
+      bytes += len;
+    }
+    while(remaining != 0);
+  }
+  else
+  {
+    while(!is.resolve()->eof())
+    {
+      char buffer[4096];
+      is.resolve()->read(buffer, sizeof(buffer));
+      xmlParseChunk(context_, buffer, (int)is.resolve()->gcount(), is.resolve()->eof());
+    } // while(!in.eof())
+  } // if ...
 
   xmlCtxtResetPush(context_, 0, 0, 0, 0);
 
@@ -6,6 +6,7 @@
 
 #include <SAX/ArabicaConfig.hpp>
 #include <SAX/XMLReader.hpp>
+#include <Arabica/stats.hpp>
 #include <SAX/InputSource.hpp>
 #include <SAX/SAXParseException.hpp>
 #include <SAX/SAXNotRecognizedException.hpp>
@@ -1058,6 +1059,7 @@ void msxml2_wrapper<string_type, T0, T1>::setErrorHandler(errorHandlerT& handler
 template<class string_type, class T0, class T1>
 void msxml2_wrapper<string_type, T0, T1>::parse(inputSourceT& source)
 {
+  ARABICA_STATS_TIME(sax_parse);
   if(source.getByteStream() == 0)
   {
     std::wstring wSysId(string_adaptor::asStdWString(source.getSystemId()));
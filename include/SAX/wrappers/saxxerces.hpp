@@ -51,6 +51,7 @@ std::ostream& operator<<(std::ostream& o, const std::type_info& ti)
 #include <SAX/wrappers/XercesPropertyNames.hpp>
 #include <SAX/wrappers/XercesFeatureNames.hpp>
 #include <Arabica/getparam.hpp>
+#include <Arabica/stats.hpp>
 
 // Xerces Includes
 #include <xercesc/util/PlatformUtils.hpp>
@@ -1073,6 +1074,7 @@ void xerces_wrapper<string_type, T0, T1>::doSetProperty(const string_type& name,
 template<class string_type, class T0, class T1>
 void xerces_wrapper<string_type, T0, T1>::parse(InputSourceT& source)
 {
+  ARABICA_STATS_TIME(sax_parse);
   // if no stream is open, let Xerces deal with it
   if(source.getByteStream() == 0)
     xerces_->parse(XSA::asStdString(source.getSystemId()).c_str());
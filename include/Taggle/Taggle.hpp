@@ -5,6 +5,7 @@
 #include "impl/ElementType.hpp"
 #include "impl/Element.hpp"
 #include "impl/Schema.hpp"
+#include "impl/TreeBuilder.hpp"
 #include "impl/html/HTMLModels.hpp"
 #include "impl/html/HTMLScanner.hpp"
 #include "impl/html/HTMLSchema.hpp"
@@ -66,7 +66,7 @@ public:
      Convenience method.
      @return the element type name
   */
-  std::string name() const;
+  const std::string& name() const;
 
 
   /**
@@ -74,14 +74,14 @@ public:
      Convenience method.
      @return The element type namespace name
   */
-  std::string namespaceName() const;
+  const std::string& namespaceName() const;
 
   /**
      Return the local name of the element's type.
      Convenience method.
      @return The element type local name
   */
-  std::string localName() const;
+  const std::string& localName() const;
 
   /**
      Return the content model vector of the element's type.
@@ -200,9 +200,9 @@ public:
   } // next()
   void setNext(const Element& next) { next_ = next; }
 
-  std::string name() const { return type_->name(); }
-  std::string namespaceName() const { return type_->namespaceName(); }
-  std::string localName() const { return type_->localName(); }
+  const std::string& name() const { return type_->name(); }
+  const std::string& namespaceName() const { return type_->namespaceName(); }
+  const std::string& localName() const { return type_->localName(); }
   int model() const { return type_->model(); }
   int memberOf() const { return type_->memberOf(); }
   int flags() const { return type_->flags(); }
@@ -335,9 +335,9 @@ void Element::setNext(const Element& next)
   impl_->setNext(next);
 } // setNext
 
-std::string Element::name() const { return impl_->name(); }
-std::string Element::namespaceName() const { return impl_->namespaceName(); }
-std::string Element::localName() const { return impl_->localName(); }
+const std::string& Element::name() const { return impl_->name(); }
+const std::string& Element::namespaceName() const { return impl_->namespaceName(); }
+const std::string& Element::localName() const { return impl_->localName(); }
 
 int Element::model() const { return impl_->model(); }
 int Element::memberOf() const { return impl_->memberOf(); }
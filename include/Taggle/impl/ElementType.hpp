@@ -132,19 +132,19 @@ public:
 	Returns the name of this element type.
 	@return The name of the element type
 	*/
-	std::string name() const { return name_; }
+	const std::string& name() const { return name_; }
 
 	/**
 	Returns the namespace name of this element type.
 	@return The namespace name of the element type
 	*/
-	std::string namespaceName() const { return namespace_; }
+	const std::string& namespaceName() const { return namespace_; }
 
 	/**
 	Returns the local name of this element type.
 	@return The local name of the element type
 	*/
-	std::string localName() const { return localName_; }
+	const std::string& localName() const { return localName_; }
 
 	/**
 	Returns the content models of this element type.
@@ -0,0 +1,150 @@
+#ifndef ARABICA_SAX_TAGGLE_ELEMENTTYPETABLE_HPP
+#define ARABICA_SAX_TAGGLE_ELEMENTTYPETABLE_HPP
+
+#include <string>
+#include <vector>
+#include "ElementType.hpp"
+
+namespace Arabica
+{
+namespace SAX
+{
+
+/**
+The element types of a schema, by name, ignoring ASCII case.
+
+An open addressing hash table with linear probing.  The hash and the
+comparison both fold case as they go, so a lookup never builds a
+lower-cased copy of the name it's given.  The table owns the
+ElementTypes put into it.
+**/
+class ElementTypeTable
+{
+public:
+  ElementTypeTable() :
+      slots_(16),
+      count_(0)
+  {
+  } // ElementTypeTable
+
+  ~ElementTypeTable()
+  {
+    for(std::vector<Slot>::iterator s = slots_.begin(), se = slots_.end(); s != se; ++s)
+      delete s->type;
+  } // ~ElementTypeTable
+
+  /**
+  Add type under name, replacing and deleting any type already there.
+  **/
+  void insert(const std::string& name, ElementType* type)
+  {
+    if((count_ + 1) * 2 > slots_.size())
+      grow();
+
+    Slot& slot = probe(name.data(), name.length());
+    if(slot.type != 0)
+      delete slot.type;
+    else
+    {
+      slot.name = lower_case(name);
+      ++count_;
+    } // if ...
+    slot.type = type;
+  } // insert
+
+  /**
+  The type named name, or 0 if there isn't one.
+  **/
+  ElementType* find(const std::string& name) const
+  {
+    return find(name.data(), name.length());
+  } // find
+
+  ElementType* find(const char* name, size_t length) const
+  {
+    return const_cast<ElementTypeTable*>(this)->probe(name, length).type;
+  } // find
+
+  size_t size() const { return count_; }
+
+private:
+  struct Slot
+  {
+    Slot() : type(0) { }
+
+    std::string name;     // lower case
+    ElementType* type;    // 0 if the slot is empty
+  }; // struct Slot
+
+  // the slot holding name, or the empty slot where it would go
+  Slot& probe(const char* name, size_t length)
+  {
+    size_t mask = slots_.size() - 1;
+    for(size_t s = hash(name, length) & mask; ; s = (s + 1) & mask)
+    {
+      Slot& slot = slots_[s];
+      if((slot.type == 0) || equals(slot.name, name, length))
+        return slot;
+    } // for ...
+  } // probe
+
+  void grow()
+  {
+    std::vector<Slot> old(slots_.size() * 2);
+    old.swap(slots_);
+    for(std::vector<Slot>::iterator s = old.begin(), se = old.end(); s != se; ++s)
+      if(s->type != 0)
+      {
+        Slot& slot = probe(s->name.data(), s->name.length());
+        slot.name.swap(s->name);
+        slot.type = s->type;
+        s->type = 0;
+      } // if ...
+  } // grow
+
+  static char fold(char c)
+  {
+    return ((c >= 'A') && (c <= 'Z')) ? static_cast<char>(c + ('a' - 'A')) : c;
+  } // fold
+
+  // FNV-1a
+  static size_t hash(const char* name, size_t length)
+  {
+    unsigned long h = 2166136261UL;
+    for(size_t i = 0; i != length; ++i)
+    {
+      h ^= static_cast<unsigned char>(fold(name[i]));
+      h *= 16777619UL;
+    } // for ...
+    return static_cast<size_t>(h);
+  } // hash
+
+  static bool equals(const std::string& lower, const char* name, size_t length)
+  {
+    if(lower.length() != length)
+      return false;
+    for(size_t i = 0; i != length; ++i)
+      if(lower[i] != fold(name[i]))
+        return false;
+    return true;
+  } // equals
+
+  static std::string lower_case(const std::string& name)
+  {
+    std::string lower(name);
+    for(std::string::iterator c = lower.begin(), ce = lower.end(); c != ce; ++c)
+      *c = fold(*c);
+    return lower;
+  } // lower_case
+
+  std::vector<Slot> slots_;
+  size_t count_;
+
+  ElementTypeTable(const ElementTypeTable&);
+  ElementTypeTable& operator=(const ElementTypeTable&);
+}; // class ElementTypeTable
+
+} // namespace SAX
+} // namespace Arabica
+
+#endif
@@ -0,0 +1,166 @@
+#ifndef ARABICA_SAX_TAGGLE_ENTITYTRIE_HPP
+#define ARABICA_SAX_TAGGLE_ENTITYTRIE_HPP
+
+#include <string>
+#include <vector>
+
+namespace Arabica
+{
+namespace SAX
+{
+
+/**
+The character entities of a schema, as a trie of their names.
+
+A reference can be resolved a character at a time as it is scanned -
+start at root(), follow each character with next(), and look at value()
+once the name ends - so the name never needs to be copied out of the
+text it's in.  Values are full Unicode code points.
+**/
+class EntityTrie
+{
+public:
+  typedef int Cursor;
+
+  /**
+  Where no entity name goes.  next() stays here once it gets here.
+  **/
+  enum { Nowhere = -1 };
+
+  EntityTrie() :
+      nodes_(1)
+  {
+    for(int c = 0; c != RootFanOut; ++c)
+      root_[c] = Nowhere;
+  } // EntityTrie
+
+  /**
+  Add or replace an entity.
+  **/
+  void insert(const std::string& name, int value)
+  {
+    Cursor cursor = root();
+    for(std::string::const_iterator c = name.begin(), ce = name.end(); c != ce; ++c)
+    {
+      Cursor child = next(cursor, *c);
+      if(child == Nowhere)
+        child = addChild(cursor, *c);
+      cursor = child;
+    } // for ...
+    nodes_[cursor].value = value;
+  } // insert
+
+  Cursor root() const { return 0; }
+
+  /**
+  The node reached by following ch from cursor.
+  **/
+  Cursor next(Cursor cursor, char ch) const
+  {
+    if(cursor == Nowhere)
+      return Nowhere;
+    if(cursor == 0)
+    {
+      unsigned char c = static_cast<unsigned char>(ch);
+      return (c < RootFanOut) ? root_[c] : Nowhere;
+    } // if ...
+
+    for(Cursor child = nodes_[cursor].firstChild; child != Nowhere; child = nodes_[child].nextSibling)
+      if(nodes_[child].ch == ch)
+        return child;
+    return Nowhere;
+  } // next
+
+  /**
+  The value of the entity whose name ends at cursor, or 0 if no name ends there.
+  **/
+  int value(Cursor cursor) const
+  {
+    return (cursor == Nowhere) ? 0 : nodes_[cursor].value;
+  } // value
+
+  /**
+  The value of the entity called name, or 0 if there isn't one.
+  **/
+  int find(const char* name, size_t length) const
+  {
+    Cursor cursor = root();
+    for(size_t i = 0; (i != length) && (cursor != Nowhere); ++i)
+      cursor = next(cursor, name[i]);
+    return value(cursor);
+  } // find
+
+  int find(const std::string& name) const
+  {
+    return find(name.data(), name.length());
+  } // find
+
+  /**
+  Appends a code point to a UTF-8 string.
+  **/
+  static void appendUTF8(std::string& out, int cp)
+  {
+    if(cp < 0x80)
+      out += static_cast<char>(cp);
+    else if(cp < 0x800)
+    {
+      out += static_cast<char>(0xC0 | (cp >> 6));
+      out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else if(cp < 0x10000)
+    {
+      out += static_cast<char>(0xE0 | (cp >> 12));
+      out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else
+    {
+      out += static_cast<char>(0xF0 | (cp >> 18));
+      out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+      out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (cp & 0x3F));
+    } // if ...
+  } // appendUTF8
+
+private:
+  // The root's children are indexed directly, since every lookup
+  // starts there and it has the most of them.  Below the root, a node's
+  // children are a linked list, kept short by the shape of entity names.
+  enum { RootFanOut = 128 };
+
+  struct Node
+  {
+    Node() : ch(0), value(0), firstChild(Nowhere), nextSibling(Nowhere) { }
+
+    char ch;
+    int value;
+    Cursor firstChild;
+    Cursor nextSibling;
+  }; // struct Node
+
+  Cursor addChild(Cursor parent, char ch)
+  {
+    Cursor child = static_cast<Cursor>(nodes_.size());
+    nodes_.push_back(Node());
+    nodes_[child].ch = ch;
+    if(parent == 0)
+    {
+      unsigned char c = static_cast<unsigned char>(ch);
+      if(c < RootFanOut)
+        root_[c] = child;
+      // a name can't start with anything else, so the node is unreachable
+      return child;
+    } // if ...
+    nodes_[child].nextSibling = nodes_[parent].firstChild;
+    nodes_[parent].firstChild = child;
+    return child;
+  } // addChild
+
+  std::vector<Node> nodes_;
+  Cursor root_[RootFanOut];
+}; // class EntityTrie
+
+} // namespace SAX
+} // namespace Arabica
+
+#endif
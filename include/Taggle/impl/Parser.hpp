@@ -4,6 +4,8 @@
 
 #include <map>
 #include <vector>
+#include <algorithm>
+#include <cctype>
 #include <SAX/helpers/DefaultHandler.hpp>
 #include <SAX/XMLReader.hpp>
 #include <SAX/helpers/InputSourceResolver.hpp>
@@ -11,6 +13,8 @@
 #include <XML/XMLCharacterClasses.hpp>
 #include <io/uri.hpp>
 #include "ScanHandler.hpp"
+#include "EntityTrie.hpp"
+#include "TreeBuilder.hpp"
 
 namespace Arabica
 {
@@ -261,6 +265,7 @@ private:
   Element saved_;
   Element pcdata_;
   int entity_;
+  TreeBuilder* builder_;
 
   // Feature flags.  
   bool namespaces;
@@ -297,6 +302,7 @@ public:
     saved_(Element::Null),
     pcdata_(Element::Null),
     entity_(0),
+    builder_(0),
     namespaces(DEFAULT_NAMESPACES),
     ignoreBogons(DEFAULT_IGNORE_BOGONS),
     bogonsEmpty(DEFAULT_BOGONS_EMPTY),
@@ -549,6 +555,14 @@ public:
       return;
     } // if(is.resolver() == 0)
 
+    if(builder_ != 0)
+    {
+      builder_->startDocument();
+      scanner_->resetDocumentLocator(string_adaptor::asStdString(input.getPublicId()), string_adaptor::asStdString(input.getSystemId()));
+      scanner_->scan(*is.resolve(), *this);
+      return;
+    } // if ...
+
     contentHandler_->startDocument();
     scanner_->resetDocumentLocator(string_adaptor::asStdString(input.getPublicId()), string_adaptor::asStdString(input.getSystemId()));
 
@@ -561,6 +575,28 @@ public:
     scanner_->scan(*is.resolve(), *this);
   } // parse
 
+  /**
+  Parses input into builder, instead of reporting it to the
+  ContentHandler and LexicalHandler.  Nothing is converted to string_type
+  on the way - element types and attributes go to the builder just as
+  the parser holds them.  The ErrorHandler and EntityResolver are used
+  as usual.
+  **/
+  void parse(InputSourceT& input, TreeBuilder& builder)
+  {
+    builder_ = &builder;
+    try
+    {
+      parse(input);
+    }
+    catch(...)
+    {
+      builder_ = 0;
+      throw;
+    } // catch
+    builder_ = 0;
+  } // parse
+
 private:
   // Sets up instance variables that haven't been set by setFeature
   void setup() 
@@ -632,53 +668,50 @@ private:
 
   // Expand entity references in attribute values selectively.
   // Currently we expand a reference iff it is properly terminated
-  // with a semicolon.
-  std::string expandEntities(std::string src) 
+  // with a semicolon.  Names are followed through the schema's entity
+  // trie as they are scanned, and nothing is copied unless the value
+  // has a reference in it.
+  std::string expandEntities(const std::string& src) 
   {
-    size_t refStart = std::string::npos;
-    std::string dst;
-    for(std::string::const_iterator i = src.begin(), ie = src.end(); i != ie; ++i)
+    std::string::size_type amp = src.find('&');
+    if(amp == std::string::npos)
+      return src;
+
+    const EntityTrie& entities = schema_->entities();
+    std::string dst(src, 0, amp);
+    std::string::const_iterator i = src.begin() + amp, ie = src.end();
+    while(i != ie)
     {
-      char ch = *i;
-      dst.push_back(ch);
-      if(ch == '&' && refStart == std::string::npos)
-      {
-        // start of a ref excluding &
-        refStart = dst.length();
-      }
-      else if(refStart == std::string::npos) 
+      if(*i != '&')
       {
-        // not in a ref
-      }
-      else if(Arabica::XML::is_letter_or_digit(ch) || ch == '#') 
-      {
-        // valid entity char
-      }
-      else if(ch == ';') 
-      {
-        // properly terminated ref
-        int ent = lookupEntity(dst.substr(refStart, dst.size() - refStart - 1));
-        if(ent > 0xFFFF) 
-        {
-          ent -= 0x10000;
-          dst[refStart - 1] = (char)((ent>>10) + 0xD800);
-          dst[refStart] = (char)((ent&0x3FF) + 0xDC00);
-          dst.erase(refStart + 1);
-        }
-        else if(ent != 0) 
-        {
-          dst[refStart - 1] = (char)ent;
-          dst.erase(refStart);  
-        }
-        refStart = std::string::npos;
-      }
-      else 
+        dst.push_back(*i++);
+        continue;
+      } // if ...
+
+      std::string::const_iterator name = i + 1;
+      std::string::const_iterator n = name;
+      EntityTrie::Cursor cursor = entities.root();
+      while((n != ie) && (Arabica::XML::is_letter_or_digit(*n) || *n == '#'))
+        cursor = entities.next(cursor, *n++);
+
+      if((n == ie) || (*n != ';'))
       {
         // improperly terminated ref
-        refStart = std::string::npos;
+        dst.append(i, n);
+        i = n;
+        continue;
       } // if ...
-    } // for ...
-    return std::string(dst, 0, dst.size());
+
+      // properly terminated ref
+      int ent = ((name != n) && (*name == '#')) ? characterReference(name, n) : entities.value(cursor);
+      ++n;
+      if((ent != 0) && !((ent >= 0xD800) && (ent <= 0xDFFF)))
+        EntityTrie::appendUTF8(dst, ent);
+      else
+        dst.append(i, n);
+      i = n;
+    } // while ...
+    return dst;
   } // expandEntities
 
   virtual void entity(const std::string& buff) 
@@ -690,21 +723,44 @@ private:
   // deferring to the schema for named ones.
   int lookupEntity(const std::string& buff) 
   {
-    int result = 0;
     if(buff.length() < 1) 
-      return result;
+      return 0;
 
     if(buff[0] == '#') 
-    {
-      const char* b = buff.c_str();
-      char* end;
-      if(buff.length() > 1 && (buff[1] == 'x' || buff[1] == 'X')) 
-        return strtol(b + 2, &end, 16);
-      return strtol(b + 1, &end, 10);
-    }
+      return characterReference(buff.begin(), buff.end());
     return schema_->getEntity(buff);
   } // lookupEntity
 
+  // The value of #nnn or #xhhh, or 0 if it isn't a Unicode character.
+  // Like strtol, stops at the first character which isn't a digit.
+  static int characterReference(std::string::const_iterator i, std::string::const_iterator ie)
+  {
+    int base = 10;
+    if((++i != ie) && (*i == 'x' || *i == 'X'))
+    {
+      base = 16;
+      ++i;
+    } // if ...
+
+    long value = 0;
+    for( ; i != ie; ++i)
+    {
+      int digit;
+      if(*i >= '0' && *i <= '9')
+        digit = *i - '0';
+      else if(base == 16 && *i >= 'a' && *i <= 'f')
+        digit = *i - 'a' + 10;
+      else if(base == 16 && *i >= 'A' && *i <= 'F')
+        digit = *i - 'A' + 10;
+      else
+        break;
+      value = (value * base) + digit;
+      if(value > 0x10FFFF)
+        return 0;
+    } // for ...
+    return static_cast<int>(value);
+  } // characterReference
+
   virtual void eof(const std::string& /*buff*/) 
   {
     if(virginStack) 
@@ -713,6 +769,11 @@ private:
     {
       pop();
     }
+    if(builder_ != 0)
+    {
+      builder_->endDocument();
+      return;
+    } // if ...
     if(schema_->getURI() != "")
       contentHandler_->endPrefixMapping(S(schema_->getPrefix()));
     contentHandler_->endDocument();
@@ -750,9 +811,9 @@ private:
       } // if ...
       if(!realTag) 
       {
-        contentHandler_->characters(S("</"));
-        contentHandler_->characters(S(buff));
-        contentHandler_->characters(S(">"));
+        reportCharacters("</");
+        reportCharacters(buff);
+        reportCharacters(">");
         scanner_->startCDATA();
         return true;
       } // if ...
@@ -826,6 +887,12 @@ private:
   {
     if(stack_ == Element::Null) 
       return;    // empty stack
+    if(builder_ != 0)
+    {
+      builder_->endElement();
+      stack_ = stack_.next();
+      return;
+    } // if ...
     std::string name = stack_.name();
     std::string localName = stack_.localName();
     std::string namespaceName = stack_.namespaceName();
@@ -865,13 +932,37 @@ private:
 
   // Push element onto stack
   void push(Element e) 
+  {
+    e.clean();
+    if(builder_ != 0)
+      buildElement(e);
+    else
+      reportElement(e);
+
+    e.setNext(stack_);
+    stack_ = e;
+    virginStack = false;
+    if(CDATAElements && (stack_.flags() & Schema::F_CDATA) != 0) 
+      scanner_->startCDATA();
+  } // push 
+
+  // Hand e to the TreeBuilder
+  void buildElement(const Element& e)
+  {
+    static const std::string none;
+    if(virginStack && (lower_case(namespaces ? e.localName() : none) == lower_case(doctypeName_))) 
+      entityResolver_->resolveEntity(S(doctypePublicId_), S(doctypeSystemId_));
+    builder_->startElement(e.type(), namespaces ? e.namespaceName() : none, e.atts());
+  } // buildElement
+
+  // Report e to the ContentHandler
+  void reportElement(const Element& e)
   {
     std::string name = e.name();
     std::string localName = e.localName();
     std::string namespaceName = e.namespaceName();
     std::string prefix = prefixOf(name);
 
-    e.clean();
     if(!namespaces) 
       namespaceName = localName = "";
     if(virginStack && (lower_case(localName) == lower_case(doctypeName_))) 
@@ -895,13 +986,7 @@ private:
                         S(e.atts().getValue(i)));
     } // for ...
     contentHandler_->startElement(S(namespaceName), S(localName), S(name), atts);
-
-    e.setNext(stack_);
-    stack_ = e;
-    virginStack = false;
-    if(CDATAElements && (stack_.flags() & Schema::F_CDATA) != 0) 
-      scanner_->startCDATA();
-  } // push 
+  } // reportElement
 
   // Get the prefix from a QName
   std::string prefixOf(std::string name) 
@@ -969,8 +1054,13 @@ private:
     if(name != "") 
     {
       publicid = cleanPublicid(publicid);
-      lexicalHandler_->startDTD(S(name), S(publicid), S(systemid));
-      lexicalHandler_->endDTD();
+      if(builder_ != 0)
+        builder_->doctype(name, publicid, systemid);
+      else
+      {
+        lexicalHandler_->startDTD(S(name), S(publicid), S(systemid));
+        lexicalHandler_->endDTD();
+      } // if ...
       doctypeName_ = name;
       doctypePublicId_ = publicid;
       if(dynamic_cast<LocatorT*>(scanner_))
@@ -990,7 +1080,7 @@ private:
     char s = in[0];
     char e = in[length - 1];
     if(s == e && (s == '\'' || s == '"')) 
-      return in.substr(1, length - 1);
+      return in.substr(1, length - 2);
     return in;
   } // trimquotes
 
@@ -1032,7 +1122,7 @@ private:
       {
         if(Arabica::XML::is_space(c)) 
         {
-          splits.push_back(v.substr(s, e));
+          splits.push_back(v.substr(s, e - s));
 				  s = std::string::npos;
 				}
         else if(s == std::string::npos && c != ' ') 
@@ -1042,7 +1132,7 @@ private:
       }
       lastc = c;
     } // for ...
-    splits.push_back(v.substr(s, e));
+    splits.push_back(v.substr(s, e - s));
 
     return splits;
   } // split
@@ -1101,6 +1191,13 @@ private:
   virtual void cdsect(const std::string& buff) 
   {
     // std::cerr << "cdsect(\"" << buff.substr(offset, length) << "\", " << offset << ", " << length << ")" << std::endl;
+    if(builder_ != 0)
+    {
+      builder_->startCDATA();
+      pcdata(buff);
+      builder_->endCDATA();
+      return;
+    } // if ...
     lexicalHandler_->startCDATA();
     pcdata(buff);
     lexicalHandler_->endCDATA();
@@ -1119,16 +1216,24 @@ private:
     } // for ...
     if(allWhite && !stack_.canContain(pcdata_)) 
     {
-      if(ignorableWhitespace) 
+      if(ignorableWhitespace && (builder_ == 0)) 
         contentHandler_->ignorableWhitespace(S(buff));
     }
     else 
     {
       rectify(pcdata_);
-      contentHandler_->characters(S(buff));
+      reportCharacters(buff);
     } // if ...
   } // pcdata
 
+  void reportCharacters(const std::string& text)
+  {
+    if(builder_ != 0)
+      builder_->characters(text);
+    else
+      contentHandler_->characters(S(text));
+  } // reportCharacters
+
   virtual void pitarget(const std::string& buff) 
   {
     // std::cerr << "pitarget(\"" << buff.substr(offset, length) << "\", " << offset << ", " << length << ")" << std::endl;
@@ -1154,8 +1259,11 @@ private:
     size_t length = buff.length();
     if((length > 0) && (buff[length - 1] == '?')) 
       length--;  // remove trailing ?
-    contentHandler_->processingInstruction(S(piTarget_),
-                                           S(buff.substr(0, length)));
+    if(builder_ != 0)
+      builder_->processingInstruction(piTarget_, buff.substr(0, length));
+    else
+      contentHandler_->processingInstruction(S(piTarget_),
+                                             S(buff.substr(0, length)));
     piTarget_ = "";
   } // pi
 
@@ -1186,7 +1294,10 @@ private:
   virtual void cmnt(const std::string& buff) 
   {
     // std::cerr << "cmnt(\"" << buff.substr(offset, length) << "\", " << offset << ", " << length << ")" << std::endl;
-    lexicalHandler_->comment(S(buff));
+    if(builder_ != 0)
+      builder_->comment(buff);
+    else
+      lexicalHandler_->comment(S(buff));
   } // cmnt
 
   // Rectify the stack, pushing and popping as needed
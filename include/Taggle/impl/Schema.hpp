@@ -7,6 +7,7 @@ namespace SAX
 {
 
 class ElementType;
+class EntityTrie;
 
 /**
 Abstract class representing a TSSL schema.
@@ -32,6 +33,7 @@ public:
 
   virtual ElementType& getElementType(const std::string& name) = 0;
   virtual int getEntity(const std::string& name) const = 0;
+  virtual const EntityTrie& entities() const = 0;
   virtual const std::string& getURI() const = 0;
 	virtual const std::string& getPrefix() const = 0;
 
@@ -1,11 +1,10 @@
 #ifndef ARABICA_SAX_TAGGLE_SCHEMAIMPL_HPP
 #define ARABICA_SAX_TAGGLE_SCHEMAIMPL_HPP
 
-#include <map>
 #include <string>
-#include <algorithm>
-#include <cctype>
 #include "ElementType.hpp"
+#include "ElementTypeTable.hpp"
+#include "EntityTrie.hpp"
 #include "Schema.hpp"
 
 namespace Arabica
@@ -22,18 +21,21 @@ Based on code from John Cowan's super TagSoup package
 class SchemaImpl : public Schema
 {
 private:
-  std::map<std::string, char> entities_;
-  std::map<std::string, ElementType*> elementTypes_;
+  EntityTrie entities_;
+  ElementTypeTable elementTypes_;
 
 	std::string URI_;
 	std::string prefix_;
 	ElementType* root_;
 
 public:
+  SchemaImpl() : 
+    root_(0)
+  {
+  } // SchemaImpl
+
   virtual ~SchemaImpl()
   {
-    for(std::map<std::string, ElementType*>::iterator i = elementTypes_.begin(), ie = elementTypes_.end(); i != ie; ++i)
-      delete i->second;
   } // ~SchemaImpl
 
 	/**
@@ -46,10 +48,9 @@ public:
 	void elementType(const std::string& name, int model, int memberOf, int flags) 
   {
 		ElementType* e = new ElementType(name, model, memberOf, flags, *this);
-    std::string lname = lower_case(name);
-		elementTypes_[lname] = e;
+		elementTypes_.insert(name, e);
 		if(memberOf == M_ROOT)
-      root_ = elementTypes_[lname];
+      root_ = e;
 	} // elementType
 
 	/**
@@ -106,7 +107,7 @@ public:
 	**/
 	void entity(const std::string& name, int value) 
   {
-		entities_[name] = value;
+		entities_.insert(name, value);
 	} // entity
 
 	/**
@@ -116,10 +117,10 @@ public:
 	**/
 	ElementType& getElementType(const std::string& name)
   {
-    std::map<std::string, ElementType*>::iterator elemType = elementTypes_.find(lower_case(name));
-    if(elemType == elementTypes_.end())
+    ElementType* elemType = elementTypes_.find(name);
+    if(elemType == 0)
       return ElementType::Null;
-    return *elemType->second;
+    return *elemType;
 	} // getElementType
 
 	/**
@@ -129,12 +130,17 @@ public:
 	**/
 	int getEntity(const std::string& name) const
   {
-    std::map<std::string, char>::const_iterator ent = entities_.find(name);
-    if(ent == entities_.end())
-      return 0;
-		return ent->second;
+    return entities_.find(name);
 	} // getEntity
 
+	/**
+	The entities, for resolving references as they are scanned.
+	**/
+	const EntityTrie& entities() const
+  {
+    return entities_;
+	} // entities
+
 	/**
 	Return the URI (namespace name) of this schema.
 	**/
@@ -166,14 +172,6 @@ public:
   {
 		prefix_ = prefix;
 	} // setPrefix
-
-private:
-  static std::string lower_case(const std::string& str) 
-  {
-    std::string lower;
-    std::transform(str.begin(), str.end(), std::back_inserter(lower), (int(*)(int))std::tolower);
-    return lower;
-  } // lower_case
 }; // class Schema
 
 } // namespace SAX
@@ -0,0 +1,68 @@
+#ifndef ARABICA_SAX_TAGGLE_TREEBUILDER_HPP
+#define ARABICA_SAX_TAGGLE_TREEBUILDER_HPP
+
+#include <string>
+#include <SAX/helpers/AttributesImpl.hpp>
+#include "ElementType.hpp"
+
+namespace Arabica
+{
+namespace SAX
+{
+
+/**
+Receives the document Taggle makes of its input when a tree is wanted
+rather than SAX events.
+
+Element names arrive as the ElementType they were scanned as, which
+stays the same object for the whole parse, so a builder can key anything
+it works out about a name - converted strings, pooled names - on the
+type.  Attributes are handed over as Taggle holds them, by reference,
+and are only good for the duration of the call.
+
+@see Taggle::parse(InputSource&, TreeBuilder&)
+**/
+class TreeBuilder
+{
+protected:
+  ~TreeBuilder() { }
+
+public:
+  virtual void startDocument() = 0;
+  virtual void endDocument() = 0;
+
+  /**
+  The document has a DOCTYPE declaration.
+  **/
+  virtual void doctype(const std::string& name, const std::string& publicId, const std::string& systemId) = 0;
+
+  /**
+  An element starts.  namespaceURI is the type's namespace name, or
+  empty if namespace processing is switched off.
+  **/
+  virtual void startElement(const ElementType& type, const std::string& namespaceURI, const AttributesImpl<std::string>& atts) = 0;
+
+  /**
+  The most recently started element ends.
+  **/
+  virtual void endElement() = 0;
+
+  /**
+  Text, which may arrive in more than one piece.
+  **/
+  virtual void characters(const std::string& text) = 0;
+
+  /**
+  Bracket the text of a CDATA section.
+  **/
+  virtual void startCDATA() = 0;
+  virtual void endCDATA() = 0;
+
+  virtual void comment(const std::string& text) = 0;
+  virtual void processingInstruction(const std::string& target, const std::string& data) = 0;
+}; // class TreeBuilder
+
+} // namespace SAX
+} // namespace Arabica
+
+#endif
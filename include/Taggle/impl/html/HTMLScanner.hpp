@@ -6,6 +6,7 @@
 #include <SAX/Locator.hpp>
 #include <XML/XMLCharacterClasses.hpp>
 #include "../Scanner.hpp"
+#include "../EntityTrie.hpp"
 
 namespace Arabica
 {
@@ -349,22 +350,11 @@ public:
                 // Control becomes space
                 ent = 0x20;
               }
-              else if (ent >= 0xD800 && ent <= 0xDFFF) 
+              if (ent < 0xD800 || ent > 0xDFFF) 
               {
-                // Surrogates get dropped
-                ent = 0;
-              }
-              else if (ent <= 0xFFFF) 
-              {
-                // BMP character
-                save(ent, h);
-              }
-              else 
-              {
-                // Astral converted to two surrogates
-                ent -= 0x10000;
-                save((ent>>10) + 0xD800, h);
-                save((ent&0x3FF) + 0xDC00, h);
+                // Surrogates get dropped, everything else is
+                // written as UTF-8
+                saveCodePoint(ent, h);
               }
               if (ch != ';') 
               {
@@ -518,6 +508,20 @@ private:
     outputBuffer_ += static_cast<char>(ch);
   } // save
 
+  // saves all of a character's UTF-8 bytes into the same buffer-full
+  void saveCodePoint(int ch, ScanHandler& h)
+  {
+    if (ch < 0x80) 
+    {
+      save(ch, h);
+      return;
+    }
+    std::string utf8;
+    EntityTrie::appendUTF8(utf8, ch);
+    save(utf8[0], h);
+    outputBuffer_.append(utf8, 1, std::string::npos);
+  } // saveCodePoint
+
   static std::string nicechar(int in) 
   {
     if (in == '\n') 
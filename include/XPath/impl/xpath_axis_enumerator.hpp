@@ -4,6 +4,7 @@
 #include <DOM/Node.hpp>
 #include <DOM/Document.hpp>
 #include <DOM/NamedNodeMap.hpp>
+#include <Arabica/stats.hpp>
 #include "xpath_namespace_node.hpp"
 #include "xpath_object.hpp"
 
@@ -48,21 +49,34 @@ class AxisEnumerator
 
   struct NamedAxis { Axis name; CreateAxisPtr creator; };
   static const NamedAxis AxisLookupTable[];
+  static const NamedAxis ReverseAxisLookupTable[];
 
 public:
   AxisEnumerator(const DOM::Node<string_type, string_adaptor>& context, Axis axis) :
       walker_(0),
       node_(0)
   { 
-    for(const NamedAxis* ax = AxisLookupTable; ax->creator != 0; ++ax)
-      if(axis == ax->name)
-        walker_ = ax->creator(context);
+    create(AxisLookupTable, context, axis);
+  } // AxisEnumerator
 
-    if(!walker_)
-      throw std::runtime_error("Unknown Axis specifier");
-    grab();
+  // Walks the axis from the opposite end, if reversed is true - for
+  // finding the last node without visiting all the others.  Only the
+  // axes for which reversible() is true can be walked backwards.
+  AxisEnumerator(const DOM::Node<string_type, string_adaptor>& context, Axis axis, bool reversed) :
+      walker_(0),
+      node_(0)
+  { 
+    create(reversed ? ReverseAxisLookupTable : AxisLookupTable, context, axis);
   } // AxisEnumerator
 
+  static bool reversible(Axis axis)
+  {
+    for(const NamedAxis* ax = ReverseAxisLookupTable; ax->creator != 0; ++ax)
+      if(axis == ax->name)
+        return true;
+    return false;
+  } // reversible
+
   AxisEnumerator(const AxisEnumerator& rhs) :
     walker_(rhs.walker_->clone())
   {
@@ -91,9 +105,22 @@ public:
   AxisEnumerator operator++(int) { AxisEnumerator copy(*this); advance(); return copy; }
 
 private:
+  void create(const NamedAxis* table, const DOM::Node<string_type, string_adaptor>& context, Axis axis)
+  {
+    for(const NamedAxis* ax = table; ax->creator != 0; ++ax)
+      if(axis == ax->name)
+        walker_ = ax->creator(context);
+
+    if(!walker_)
+      throw std::runtime_error("Unknown Axis specifier");
+    ARABICA_STATS_COUNT(axis_walks);
+    grab();
+  } // create
+
   void advance() 
   {
     walker_->advance();
+    ARABICA_STATS_COUNT(axis_steps);
     grab();
   } // advance
   void grab()
@@ -185,6 +212,19 @@ protected:
     return prev;
   } // findPreviousSibling
 
+  // a run of adjacent text nodes is one text node to XPath, represented
+  // by the first of them
+  static RawNodeT firstOfRun(const RawNodeT node)
+  {
+    if((node == 0) || !nodeIsText(node))
+      return node;
+
+    RawNodeT first = node;
+    while((first->getPreviousSibling() != 0) && nodeIsText(first->getPreviousSibling()))
+      first = first->getPreviousSibling();
+    return first;
+  } // firstOfRun
+
 private:
   static bool nodeIsText(const RawNodeT node)
   {
@@ -665,6 +705,94 @@ private:
   PrecedingSiblingAxisWalker(const PrecedingSiblingAxisWalker& rhs) : BaseT(rhs) { }
 }; // class PrecedingSiblingAxisWalker
 
+template<class string_type, class string_adaptor>
+class ReverseChildAxisWalker : public AxisWalker<string_type, string_adaptor>
+{
+  typedef AxisWalker<string_type, string_adaptor> BaseT;
+public:
+  typedef DOM::Node_impl<string_type, string_adaptor>* RawNodeT;
+
+  ReverseChildAxisWalker(const RawNodeT context) : BaseT(false)
+  {
+    if(context != 0)
+      BaseT::set(BaseT::firstOfRun(context->getLastChild()));
+  } // ReverseChildAxisWalker
+
+  virtual void advance()
+  {
+    if(BaseT::get() != 0)
+      BaseT::set(BaseT::findPreviousSibling(BaseT::get()));
+  } // advance
+  virtual BaseT* clone() const { return new ReverseChildAxisWalker(*this); }
+
+private:
+  ReverseChildAxisWalker(const ReverseChildAxisWalker& rhs) : BaseT(rhs) { }
+}; // class ReverseChildAxisWalker
+
+template<class string_type, class string_adaptor>
+class ReverseFollowingSiblingAxisWalker : public AxisWalker<string_type, string_adaptor>
+{
+  typedef AxisWalker<string_type, string_adaptor> BaseT;
+public:
+  typedef DOM::Node_impl<string_type, string_adaptor>* RawNodeT;
+
+  // from the parent's last child back to the context's next sibling
+  ReverseFollowingSiblingAxisWalker(const RawNodeT context) : BaseT(false),
+      stop_(0)
+  {
+    if(context == 0)
+      return;
+    stop_ = BaseT::findNextSibling(context);
+    if((stop_ != 0) && (context->getParentNode() != 0))
+      BaseT::set(BaseT::firstOfRun(context->getParentNode()->getLastChild()));
+  } // ReverseFollowingSiblingAxisWalker
+
+  virtual void advance()
+  {
+    if(BaseT::get() == stop_)
+      BaseT::end();
+    else if(BaseT::get() != 0)
+      BaseT::set(BaseT::findPreviousSibling(BaseT::get()));
+  } // advance
+  virtual BaseT* clone() const { return new ReverseFollowingSiblingAxisWalker(*this); }
+
+private:
+  ReverseFollowingSiblingAxisWalker(const ReverseFollowingSiblingAxisWalker& rhs) : BaseT(rhs), stop_(rhs.stop_) { }
+  RawNodeT stop_;
+}; // class ReverseFollowingSiblingAxisWalker
+
+template<class string_type, class string_adaptor>
+class ReversePrecedingSiblingAxisWalker : public AxisWalker<string_type, string_adaptor>
+{
+  typedef AxisWalker<string_type, string_adaptor> BaseT;
+public:
+  typedef DOM::Node_impl<string_type, string_adaptor>* RawNodeT;
+
+  // from the parent's first child up to the context's previous sibling
+  ReversePrecedingSiblingAxisWalker(const RawNodeT context) : BaseT(true),
+      stop_(0)
+  {
+    if(context == 0)
+      return;
+    stop_ = BaseT::findPreviousSibling(context);
+    if((stop_ != 0) && (context->getParentNode() != 0))
+      BaseT::set(context->getParentNode()->getFirstChild());
+  } // ReversePrecedingSiblingAxisWalker
+
+  virtual void advance()
+  {
+    if(BaseT::get() == stop_)
+      BaseT::end();
+    else if(BaseT::get() != 0)
+      BaseT::set(BaseT::findNextSibling(BaseT::get()));
+  } // advance
+  virtual BaseT* clone() const { return new ReversePrecedingSiblingAxisWalker(*this); }
+
+private:
+  ReversePrecedingSiblingAxisWalker(const ReversePrecedingSiblingAxisWalker& rhs) : BaseT(rhs), stop_(rhs.stop_) { }
+  RawNodeT stop_;
+}; // class ReversePrecedingSiblingAxisWalker
+
 template<class string_type, class string_adaptor>
 class SelfAxisWalker : public AxisWalker<string_type, string_adaptor>
 {
@@ -711,6 +839,16 @@ AxisEnumerator<string_type, string_adaptor>::AxisLookupTable[] =
   { static_cast<Axis>(0), 0 } 
 };
 
+template<class string_type, class string_adaptor>
+const typename AxisEnumerator<string_type, string_adaptor>::NamedAxis 
+AxisEnumerator<string_type, string_adaptor>::ReverseAxisLookupTable[] = 
+{ 
+  { CHILD,              impl::CreateAxis<impl::ReverseChildAxisWalker<string_type, string_adaptor>, string_type> },
+  { FOLLOWING_SIBLING,  impl::CreateAxis<impl::ReverseFollowingSiblingAxisWalker<string_type, string_adaptor>, string_type> },
+  { PRECEDING_SIBLING,  impl::CreateAxis<impl::ReversePrecedingSiblingAxisWalker<string_type, string_adaptor>, string_type> },
+  { static_cast<Axis>(0), 0 } 
+};
+
 } // namespace XPath
 } // namespace Arabica
 
@@ -1,6 +1,9 @@
 #ifndef ARABICA_XPATH_COMPILE_CONTEXT_HPP
 #define ARABICA_XPATH_COMPILE_CONTEXT_HPP
 
+#include <vector>
+#include "xpath_invariant.hpp"
+
 namespace Arabica
 {
 namespace XPath
@@ -14,6 +17,17 @@ template<class string_type, class string_adaptor> class VariableCompileTimeResol
 namespace impl
 {
 
+// One line of the plan XPath::explain describes
+template<class string_type>
+struct CompilationStep
+{
+  CompilationStep(unsigned int d, const string_type& e) : depth(d), expression(e) { }
+
+  unsigned int depth;
+  string_type expression;
+  string_type note;
+}; // struct CompilationStep
+
 template<class string_type, class string_adaptor>
 class CompilationContext : private NamespaceContext<string_type, string_adaptor>
 {
@@ -25,7 +39,12 @@ public:
       xpath_(xpathCompiler),
       namespaceContext_(namespaceContext),
       functionResolver_(functionResolver),
-      ctVariableResolver_(variableCompileTimeResolver)
+      ctVariableResolver_(variableCompileTimeResolver),
+      invariants_(0),
+      predicates_(0),
+      enclosing_(DEPENDS_ON_CONTEXT),
+      plan_(0),
+      depth_(0)
   { 
   } // CompilationContext
 
@@ -34,6 +53,48 @@ public:
   const FunctionResolver<string_type, string_adaptor>& functionResolver() const { return functionResolver_; }
   const VariableCompileTimeResolver<string_type, string_adaptor>& ctVariableResolver() const { return ctVariableResolver_; }
 
+  // how many operands have been wrapped in an InvariantExpression
+  void addInvariant() { ++invariants_; }
+  unsigned int invariants() const { return invariants_; }
+
+  // Predicates are evaluated once for each node they filter, so that's
+  // where it's worth hoisting out invariant subexpressions
+  void enterPredicate() { ++predicates_; }
+  void leavePredicate() { --predicates_; }
+  bool inPredicate() const { return predicates_ != 0; }
+
+  // What the subexpression being hoisted or folded as a whole depends on,
+  // while its insides are compiled - DEPENDS_ON_CONTEXT otherwise
+  Dependency enclosing() const { return enclosing_; }
+  Dependency setEnclosing(Dependency enclosing) { Dependency was = enclosing_; enclosing_ = enclosing; return was; }
+
+  // Records each subexpression as it's compiled, if there's a plan to 
+  // record into.  beginStep returns the step's index, for note.
+  void explainTo(std::vector<CompilationStep<string_type> >& plan) { plan_ = &plan; }
+  bool explaining() const { return plan_ != 0; }
+  size_t beginStep(const string_type& expression)
+  {
+    plan_->push_back(CompilationStep<string_type>(depth_++, expression));
+    return plan_->size() - 1;
+  } // beginStep
+  void endStep() { --depth_; }
+  size_t nextStep() const { return plan_ ? plan_->size() : 0; }
+  void note(size_t step, const char* note)
+  {
+    if(!plan_ || (step >= plan_->size()))
+      return;
+    string_type& n = (*plan_)[step].note;
+    if(!string_adaptor::empty(n))
+      string_adaptor::append(n, string_adaptor::construct_from_utf8(", "));
+    string_adaptor::append(n, string_adaptor::construct_from_utf8(note));
+  } // note
+  void note(size_t step, const char* note, const string_type& value)
+  {
+    this->note(step, note);
+    if(plan_ && (step < plan_->size()))
+      string_adaptor::append((*plan_)[step].note, value);
+  } // note
+
 private:
   virtual string_type namespaceURI(const string_type& prefix) const
   {
@@ -48,6 +109,11 @@ private:
   const NamespaceContext<string_type, string_adaptor>& namespaceContext_;
   const FunctionResolver<string_type, string_adaptor>& functionResolver_;
   const VariableCompileTimeResolver<string_type, string_adaptor>& ctVariableResolver_;
+  unsigned int invariants_;
+  unsigned int predicates_;
+  Dependency enclosing_;
+  std::vector<CompilationStep<string_type> >* plan_;
+  unsigned int depth_;
 
   CompilationContext(const CompilationContext&);
   CompilationContext& operator=(const CompilationContext&);
@@ -9,6 +9,11 @@ namespace Arabica
 {
 namespace XPath
 {
+
+namespace impl
+{
+  template<class string_type, class string_adaptor> class InvariantCache;
+} // namespace impl
  
 template<class string_type, class string_adaptor = default_string_adaptor<std::string> >
 class ExecutionContext
@@ -16,7 +21,8 @@ class ExecutionContext
 public:
   ExecutionContext() : 
       position_(-1), 
-      last_(-1)
+      last_(-1),
+      invariants_(0)
   { 
   } // ExecutionContext
 
@@ -24,7 +30,17 @@ public:
       current_(parent.current_),
       position_(-1), 
       last_(static_cast<int>(last)),
-      variableResolver_(parent.variableResolver_)
+      variableResolver_(parent.variableResolver_),
+      invariants_(parent.invariants_)
+  { 
+  } // ExecutionContext
+
+  ExecutionContext(impl::InvariantCache<string_type, string_adaptor>& invariants, const ExecutionContext<string_type, string_adaptor>& parent) : 
+      current_(parent.current_),
+      position_(parent.position_), 
+      last_(parent.last_),
+      variableResolver_(parent.variableResolver_),
+      invariants_(&invariants)
   { 
   } // ExecutionContext
 
@@ -40,11 +56,16 @@ public:
   void setVariableResolver(const VariableResolver<string_type, string_adaptor>& resolver) { variableResolver_.set(resolver); }
   void setVariableResolver(VariableResolverPtr<string_type,string_adaptor>& resolver) { variableResolver_.set(resolver); }
 
+  // values which can't change during one evaluation of an expression, 
+  // or 0 outside of one
+  impl::InvariantCache<string_type, string_adaptor>* invariants() const { return invariants_; }
+
 private:
   DOM::Node<string_type, string_adaptor> current_;
   int position_;
   int last_;
   impl::ResolverHolder<const VariableResolver<string_type, string_adaptor> > variableResolver_;
+  impl::InvariantCache<string_type, string_adaptor>* invariants_;
 
   ExecutionContext(const ExecutionContext&);
   ExecutionContext& operator=(const ExecutionContext&);
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <DOM/Node.hpp>
+#include <Arabica/stats.hpp>
 #include "xpath_object.hpp"
 #include "xpath_execution_context.hpp"
 
@@ -128,26 +129,31 @@ public:
 
   XPathValue<string_type, string_adaptor> evaluate(const DOM::Node<string_type, string_adaptor>& context) const
   {
+    ARABICA_STATS_TIME(xpath_evaluate);
     return ptr_->evaluate(context);
   } // evaluate
 
   bool evaluateAsBool(const DOM::Node<string_type, string_adaptor>& context) const
   {
+    ARABICA_STATS_TIME(xpath_evaluate);
     return ptr_->evaluateAsBool(context);
   } // evaluateAsBool
 
   double evaluateAsNumber(const DOM::Node<string_type, string_adaptor>& context) const
   {
+    ARABICA_STATS_TIME(xpath_evaluate);
     return ptr_->evaluateAsNumber(context);
   } // evaluateAsNumber
 
   string_type evaluateAsString(const DOM::Node<string_type, string_adaptor>& context) const
   {
+    ARABICA_STATS_TIME(xpath_evaluate);
     return ptr_->evaluateAsString(context);
   } // evaluateAsString
 
   NodeSet<string_type, string_adaptor> evaluateAsNodeSet(const DOM::Node<string_type, string_adaptor>& context) const
   { 
+    ARABICA_STATS_TIME(xpath_evaluate);
     return ptr_->evaluate(context).asNodeSet(); 
   } // evaluateAsNodeSet
 
@@ -155,30 +161,35 @@ public:
   XPathValue<string_type, string_adaptor> evaluate(const DOM::Node<string_type, string_adaptor>& context,
                                                    const ExecutionContext<string_type, string_adaptor>& executionContext) const
   {
+    ARABICA_STATS_TIME(xpath_evaluate);
     return ptr_->evaluate(context, executionContext);
   } // evaluate
 
   bool evaluateAsBool(const DOM::Node<string_type, string_adaptor>& context,
                       const ExecutionContext<string_type, string_adaptor>& executionContext) const
   {
+    ARABICA_STATS_TIME(xpath_evaluate);
     return ptr_->evaluateAsBool(context, executionContext);
   } // evaluateAsBool
 
   double evaluateAsNumber(const DOM::Node<string_type, string_adaptor>& context, 
                           const ExecutionContext<string_type, string_adaptor>& executionContext) const
   {
+    ARABICA_STATS_TIME(xpath_evaluate);
     return ptr_->evaluateAsNumber(context, executionContext);
   } // evaluateAsNumber
 
   string_type evaluateAsString(const DOM::Node<string_type, string_adaptor>& context, 
                                const ExecutionContext<string_type, string_adaptor>& executionContext) const
   {
+    ARABICA_STATS_TIME(xpath_evaluate);
     return ptr_->evaluateAsString(context, executionContext);
   } // evaluateAsString
 
   NodeSet<string_type, string_adaptor> evaluateAsNodeSet(const DOM::Node<string_type, string_adaptor>& context, 
                                                          const ExecutionContext<string_type, string_adaptor>& executionContext) const 
   { 
+    ARABICA_STATS_TIME(xpath_evaluate);
     return ptr_->evaluate(context, executionContext).asNodeSet(); 
   } // evaluateAsNodeSet
 
@@ -267,6 +278,9 @@ public:
     scanner.scan(this);
   } // scan
 
+  XPathExpression_impl<string_type, string_adaptor>* lhs() const { return lhs_; }
+  XPathExpression_impl<string_type, string_adaptor>* rhs() const { return rhs_; }
+
 protected:
   ~BinaryExpression() 
   { 
@@ -274,9 +288,6 @@ protected:
     delete rhs_;
   } // ~BinaryExpression
 
-  XPathExpression_impl<string_type, string_adaptor>* lhs() const { return lhs_; }
-  XPathExpression_impl<string_type, string_adaptor>* rhs() const { return rhs_; }
-
 private:
   XPathExpression_impl<string_type, string_adaptor>* lhs_;
   XPathExpression_impl<string_type, string_adaptor>* rhs_;
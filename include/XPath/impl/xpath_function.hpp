@@ -6,6 +6,7 @@
 #include <XML/XMLCharacterClasses.hpp>
 #include <text/UnicodeCharacters.hpp>
 #include <text/normalize_whitespace.hpp>
+#include <text/string_kernels.hpp>
 #include "xpath_value.hpp"
 #include "xpath_execution_context.hpp"
 
@@ -323,6 +324,24 @@ protected:
 ///////////////////////////////////////////////
 // string functions
 
+// the string adaptors keep a string's characters one after the other, so
+// the string functions can search them where they are with the loops in
+// text/string_kernels.hpp
+template<class string_type, class string_adaptor>
+struct StringChars
+{
+  typedef typename string_adaptor::value_type charT;
+
+  explicit StringChars(const string_type& str) :
+    begin(string_adaptor::empty(str) ? 0 : &*string_adaptor::begin(str)),
+    end(begin + string_adaptor::length(str))
+  {
+  } // StringChars
+
+  const charT* const begin;
+  const charT* const end;
+}; // struct StringChars
+
 // string string(object?)
 template<class string_type, class string_adaptor>
 class StringFn : public StringXPathFunction<string_type, string_adaptor>
@@ -376,17 +395,8 @@ protected:
     string_type value = baseT::argAsString(0, context, executionContext);
     string_type start = baseT::argAsString(1, context, executionContext);
 
-    if(string_adaptor::length(value) < string_adaptor::length(start))
-      return false;
-
-    typename string_adaptor::const_iterator i = string_adaptor::begin(value);
-    typename string_adaptor::const_iterator s = string_adaptor::begin(start);
-    typename string_adaptor::const_iterator e = string_adaptor::end(start);
-    for(; s != e; ++s, ++i)
-      if(*i != *s)
-        return false;
-
-    return true;
+    StringChars<string_type, string_adaptor> v(value), s(start);
+    return Arabica::text::starts_with(v.begin, v.end, s.begin, s.end);
   } // evaluate
 }; // StartsWithFn
 
@@ -402,8 +412,11 @@ protected:
   virtual bool doEvaluate(const DOM::Node<string_type, string_adaptor>& context,
                           const ExecutionContext<string_type, string_adaptor>& executionContext) const
   {
-    return string_adaptor::find(baseT::argAsString(0, context, executionContext),
-                                baseT::argAsString(1, context, executionContext)) != string_adaptor::npos();
+    string_type value = baseT::argAsString(0, context, executionContext);
+    string_type what = baseT::argAsString(1, context, executionContext);
+
+    StringChars<string_type, string_adaptor> v(value), w(what);
+    return (w.begin == w.end) || (Arabica::text::find_string(v.begin, v.end, w.begin, w.end) != v.end);
   } // evaluate
 }; // class ContainsFn
 
@@ -421,12 +434,14 @@ protected:
                                  const ExecutionContext<string_type, string_adaptor>& executionContext) const
   {
     string_type value = baseT::argAsString(0, context, executionContext);
-    size_t splitAt = string_adaptor::find(value, baseT::argAsString(1, context, executionContext));
+    string_type split = baseT::argAsString(1, context, executionContext);
 
-    if(splitAt == string_adaptor::npos())
+    StringChars<string_type, string_adaptor> v(value), s(split);
+    const typename string_adaptor::value_type* splitAt = Arabica::text::find_string(v.begin, v.end, s.begin, s.end);
+    if(splitAt == v.end)
       return string_adaptor::empty_string();
 
-    return string_adaptor::substr(value, 0, splitAt);
+    return string_adaptor::substr(value, 0, splitAt - v.begin);
   } // evaluate
 }; // class SubstringBeforeFn
 
@@ -445,12 +460,13 @@ protected:
   {
     string_type value = baseT::argAsString(0, context, executionContext);
     string_type split = baseT::argAsString(1, context, executionContext);
-    size_t splitAt = string_adaptor::find(value, split);
 
-    if((splitAt == string_adaptor::npos()) || ((splitAt + string_adaptor::length(split)) >= string_adaptor::length(value)))
+    StringChars<string_type, string_adaptor> v(value), s(split);
+    const typename string_adaptor::value_type* splitAt = Arabica::text::find_string(v.begin, v.end, s.begin, s.end);
+    if((splitAt == v.end) || (splitAt + (s.end - s.begin) == v.end))
       return string_adaptor::empty_string();
 
-    return string_adaptor::substr(value, splitAt + string_adaptor::length(split));
+    return string_adaptor::substr(value, (splitAt - v.begin) + (s.end - s.begin));
   } // evaluate
 }; // class SubstringAfterFn
 
@@ -538,19 +554,17 @@ protected:
     string_type from = baseT::argAsString(1, context, executionContext);
     string_type to = baseT::argAsString(2, context, executionContext);
 
-    typename string_adaptor::mutable_iterator p = string_adaptor::begin(str);
-    for(typename string_adaptor::mutable_iterator i = string_adaptor::begin(str), ie = string_adaptor::end(str); i != ie; ++i)
-    {
-      size_t r = string_adaptor::find(from, *i);
-      if(r == string_adaptor::npos())
-        ++p;
-      else if(r < string_adaptor::length(to))
-        *p++ = *(string_adaptor::begin(to) + r);
-    } // for ...
-    if(p != string_adaptor::end(str))
-      *p = 0;
-
-		return string_adaptor::construct(string_adaptor::begin(str), p);
+    if(string_adaptor::empty(str) || string_adaptor::empty(from))
+      return str;
+
+    // translated in place, then cut down to size if anything was removed
+    StringChars<string_type, string_adaptor> f(from), t(to);
+    typename string_adaptor::value_type* begin = &*string_adaptor::begin(str);
+    typename string_adaptor::value_type* end = begin + string_adaptor::length(str);
+    typename string_adaptor::value_type* last = Arabica::text::translate(begin, end, f.begin, f.end, t.begin, t.end);
+    if(last == end)
+      return str;
+    return string_adaptor::substr(str, 0, last - begin);
   } // evaluate
 }; // class TranslateFn
 
@@ -0,0 +1,324 @@
+#ifndef ARABICA_XPATHIC_XPATH_INVARIANT_HPP
+#define ARABICA_XPATHIC_XPATH_INVARIANT_HPP
+
+///////////////////////////////////////////////////////////////////////
+//
+// Some subexpressions have the same value wherever they are evaluated
+// during one evaluation of an expression - absolute location paths,
+// variable references, and anything built only from those and constants.
+// Wrapped in an InvariantExpression, they are evaluated once
+// and the value remembered in the InvariantCache of the enclosing
+// InvariantScope, so in
+//    //order[customer/@id = //vip/@id]
+// //vip/@id is found once rather than once per order.
+//
+// A node-set which is compared more than once is also indexed - its
+// distinct string values hashed, its number values sorted - so the
+// comparisons become lookups rather than loops over every pair of nodes.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <boost/shared_ptr.hpp>
+#include "xpath_object.hpp"
+#include "xpath_expression.hpp"
+
+namespace Arabica
+{
+namespace XPath
+{
+namespace impl
+{
+
+// What the value of an expression depends on, least to most.  Worked out
+// from the parse tree at compile time - see XPath::dependencyOf.
+enum Dependency
+{
+  DEPENDS_ON_NOTHING,     // a constant, folded as it is compiled
+  DEPENDS_ON_VARIABLES,   // the same throughout one evaluation
+  DEPENDS_ON_DOCUMENT,    // the same for every node in one document
+  DEPENDS_ON_CONTEXT      // evaluated afresh for each context node
+}; // Dependency
+
+template<class string_type, class string_adaptor>
+class NodeSetIndex
+{
+public:
+  explicit NodeSetIndex(const NodeSet<string_type, string_adaptor>& nodes) :
+      hasNaN_(false)
+  {
+    for(typename NodeSet<string_type, string_adaptor>::const_iterator n = nodes.begin(), ne = nodes.end(); n != ne; ++n)
+      strings_.insert(nodeStringValue<string_type, string_adaptor>(*n));
+
+    for(size_t s = 0; s != strings_.size(); ++s)
+    {
+      double number = stringAsNumber<string_type, string_adaptor>(strings_[s]);
+      if(isNaN(number))
+        hasNaN_ = true;
+      else
+        numbers_.push_back(number);
+    } // for ...
+    std::sort(numbers_.begin(), numbers_.end());
+    numbers_.erase(std::unique(numbers_.begin(), numbers_.end()), numbers_.end());
+  } // NodeSetIndex
+
+  bool empty() const { return strings_.empty(); }
+
+  // NaN if no node is a number
+  double minNumber() const { return numbers_.empty() ? NaN : numbers_.front(); }
+  double maxNumber() const { return numbers_.empty() ? NaN : numbers_.back(); }
+
+  // true if some node in the indexed set = other, by the rules of
+  // XPath 1.0 section 3.4
+  bool equals(const XPathValue<string_type, string_adaptor>& other) const
+  {
+    switch(other.type())
+    {
+    case NODE_SET:
+      {
+        const NodeSet<string_type, string_adaptor>& ns = other.asNodeSet();
+        for(typename NodeSet<string_type, string_adaptor>::const_iterator n = ns.begin(), ne = ns.end(); n != ne; ++n)
+          if(strings_.contains(nodeStringValue<string_type, string_adaptor>(*n)))
+            return true;
+        return false;
+      } // case NODE_SET
+    case BOOL:
+      return !empty() == other.asBool();
+    case STRING:
+      return strings_.contains(other.asString());
+    case NUMBER:
+      {
+        double number = other.asNumber();
+        return !isNaN(number) && std::binary_search(numbers_.begin(), numbers_.end(), number);
+      } // case NUMBER
+    default:
+      return false;
+    } // switch
+  } // equals
+
+  // true if some node in the indexed set != other
+  bool notEquals(const XPathValue<string_type, string_adaptor>& other) const
+  {
+    switch(other.type())
+    {
+    case NODE_SET:
+      {
+        const NodeSet<string_type, string_adaptor>& ns = other.asNodeSet();
+        if(empty() || ns.empty())
+          return false;
+        if(strings_.size() > 1)
+          return true;
+        for(typename NodeSet<string_type, string_adaptor>::const_iterator n = ns.begin(), ne = ns.end(); n != ne; ++n)
+          if(nodeStringValue<string_type, string_adaptor>(*n) != strings_[0])
+            return true;
+        return false;
+      } // case NODE_SET
+    case BOOL:
+      return !empty() != other.asBool();
+    case STRING:
+      return (strings_.size() > 1) || (!empty() && (strings_[0] != other.asString()));
+    case NUMBER:
+      // NaN isn't equal to anything, not even itself
+      return hasNaN_ ||
+             (numbers_.size() > 1) ||
+             (!numbers_.empty() && !(numbers_[0] == other.asNumber()));
+    default:
+      return false;
+    } // switch
+  } // notEquals
+
+private:
+  StringValueSet<string_type, string_adaptor> strings_;
+  std::vector<double> numbers_;
+  bool hasNaN_;
+}; // class NodeSetIndex
+
+template<class string_type, class string_adaptor>
+class InvariantCache
+{
+public:
+  class Entry
+  {
+  public:
+    Entry(const void* key,
+          const DOM::Node<string_type, string_adaptor>& root,
+          const XPathValue<string_type, string_adaptor>& value) :
+        key_(key),
+        root_(root),
+        value_(value),
+        uses_(0)
+    {
+    } // Entry
+
+    const XPathValue<string_type, string_adaptor>& value() const { return value_; }
+
+    // An index of the value if it is a node-set, built the second time
+    // it's asked for - a value which is only compared once is quicker to
+    // search than to index.  0 until then, or if the value isn't a node-set.
+    const NodeSetIndex<string_type, string_adaptor>* index()
+    {
+      if(index_)
+        return index_.get();
+      if((value_.type() != NODE_SET) || (uses_++ == 0))
+        return 0;
+      index_.reset(new NodeSetIndex<string_type, string_adaptor>(value_.asNodeSet()));
+      return index_.get();
+    } // index
+
+  private:
+    const void* key_;
+    DOM::Node<string_type, string_adaptor> root_;
+    XPathValue<string_type, string_adaptor> value_;
+    boost::shared_ptr<NodeSetIndex<string_type, string_adaptor> > index_;
+    unsigned int uses_;
+
+    friend class InvariantCache;
+  }; // class Entry
+
+  InvariantCache() { }
+
+  Entry* find(const void* key, const DOM::Node<string_type, string_adaptor>& root)
+  {
+    for(typename std::deque<Entry>::iterator e = entries_.begin(), ee = entries_.end(); e != ee; ++e)
+      if((e->key_ == key) && (e->root_ == root))
+        return &*e;
+    return 0;
+  } // find
+
+  Entry* insert(const void* key,
+                const DOM::Node<string_type, string_adaptor>& root,
+                const XPathValue<string_type, string_adaptor>& value)
+  {
+    entries_.push_back(Entry(key, root, value));
+    return &entries_.back();
+  } // insert
+
+private:
+  // a deque, so entries stay put as more are added
+  std::deque<Entry> entries_;
+
+  InvariantCache(const InvariantCache&);
+  InvariantCache& operator=(const InvariantCache&);
+  bool operator==(const InvariantCache&) const;
+}; // class InvariantCache
+
+template<class string_type, class string_adaptor>
+class InvariantExpression : public UnaryExpression<string_type, string_adaptor>
+{
+  typedef UnaryExpression<string_type, string_adaptor> baseT;
+public:
+  typedef typename InvariantCache<string_type, string_adaptor>::Entry Entry;
+
+  // absolute is true for a location path starting at the root, whose
+  // value depends on which document the context node is in
+  InvariantExpression(XPathExpression_impl<string_type, string_adaptor>* expr, bool absolute) :
+      baseT(expr),
+      absolute_(absolute)
+  {
+  } // InvariantExpression
+
+  virtual ValueType type() const { return baseT::expr()->type(); }
+
+  virtual XPathValue<string_type, string_adaptor> evaluate(const DOM::Node<string_type, string_adaptor>& context,
+                                                           const ExecutionContext<string_type, string_adaptor>& executionContext) const
+  {
+    Entry* e = entry(context, executionContext);
+    if(e == 0)
+      return baseT::expr()->evaluate(context, executionContext);
+    return e->value();
+  } // evaluate
+
+  // The cache entry for this expression, evaluating it on first use.
+  // 0 if evaluation isn't within an InvariantScope.
+  Entry* entry(const DOM::Node<string_type, string_adaptor>& context,
+               const ExecutionContext<string_type, string_adaptor>& executionContext) const
+  {
+    InvariantCache<string_type, string_adaptor>* cache = executionContext.invariants();
+    if(cache == 0)
+      return 0;
+
+    DOM::Node<string_type, string_adaptor> root;
+    if(absolute_)
+      root = documentOf(context);
+
+    Entry* e = cache->find(this, root);
+    if(e == 0)
+      e = cache->insert(this, root, baseT::expr()->evaluate(context, executionContext));
+    return e;
+  } // entry
+
+private:
+  static DOM::Node<string_type, string_adaptor> documentOf(const DOM::Node<string_type, string_adaptor>& context)
+  {
+    int type = context.getNodeType();
+    if((type == DOM::Node_base::DOCUMENT_NODE) ||
+       (type == DOM::Node_base::DOCUMENT_FRAGMENT_NODE))
+      return context;
+    return context.getOwnerDocument();
+  } // documentOf
+
+  bool absolute_;
+}; // class InvariantExpression
+
+// Wraps the root of a compiled expression which has InvariantExpressions
+// within it, giving each evaluation its own InvariantCache.
+template<class string_type, class string_adaptor>
+class InvariantScope : public UnaryExpression<string_type, string_adaptor>
+{
+  typedef UnaryExpression<string_type, string_adaptor> baseT;
+public:
+  InvariantScope(XPathExpression_impl<string_type, string_adaptor>* expr) :
+      baseT(expr)
+  {
+  } // InvariantScope
+
+  virtual ValueType type() const { return baseT::expr()->type(); }
+
+  virtual XPathValue<string_type, string_adaptor> evaluate(const DOM::Node<string_type, string_adaptor>& context,
+                                                           const ExecutionContext<string_type, string_adaptor>& executionContext) const
+  {
+    InvariantCache<string_type, string_adaptor> invariants;
+    ExecutionContext<string_type, string_adaptor> scope(invariants, executionContext);
+    return baseT::expr()->evaluate(context, scope);
+  } // evaluate
+
+  virtual bool evaluateAsBool(const DOM::Node<string_type, string_adaptor>& context,
+                              const ExecutionContext<string_type, string_adaptor>& executionContext) const
+  {
+    InvariantCache<string_type, string_adaptor> invariants;
+    ExecutionContext<string_type, string_adaptor> scope(invariants, executionContext);
+    return baseT::expr()->evaluateAsBool(context, scope);
+  } // evaluateAsBool
+
+  virtual double evaluateAsNumber(const DOM::Node<string_type, string_adaptor>& context,
+                                  const ExecutionContext<string_type, string_adaptor>& executionContext) const
+  {
+    InvariantCache<string_type, string_adaptor> invariants;
+    ExecutionContext<string_type, string_adaptor> scope(invariants, executionContext);
+    return baseT::expr()->evaluateAsNumber(context, scope);
+  } // evaluateAsNumber
+
+  virtual string_type evaluateAsString(const DOM::Node<string_type, string_adaptor>& context,
+                                       const ExecutionContext<string_type, string_adaptor>& executionContext) const
+  {
+    InvariantCache<string_type, string_adaptor> invariants;
+    ExecutionContext<string_type, string_adaptor> scope(invariants, executionContext);
+    return baseT::expr()->evaluateAsString(context, scope);
+  } // evaluateAsString
+
+  virtual NodeSet<string_type, string_adaptor> evaluateAsNodeSet(const DOM::Node<string_type, string_adaptor>& context,
+                                                                 const ExecutionContext<string_type, string_adaptor>& executionContext) const
+  {
+    InvariantCache<string_type, string_adaptor> invariants;
+    ExecutionContext<string_type, string_adaptor> scope(invariants, executionContext);
+    return baseT::expr()->evaluateAsNodeSet(context, scope);
+  } // evaluateAsNodeSet
+}; // class InvariantScope
+
+} // namespace impl
+} // namespace XPath
+} // namespace Arabica
+
+#endif
@@ -0,0 +1,386 @@
+#ifndef ARABICA_XPATHIC_XPATH_NUMBER_HPP
+#define ARABICA_XPATHIC_XPATH_NUMBER_HPP
+
+///////////////////////////////////////////////////////////////////////
+//
+// Conversion between strings and numbers, following XPath 1.0 sections
+// 4.2 (string) and 4.4 (number).
+//
+// parseNumber accepts exactly the XPath grammar - optional whitespace, an
+// optional minus sign, a Number, optional whitespace - and returns NaN for
+// anything else.  It makes no copy of its input, and never throws.
+//
+// formatNumber writes the shortest decimal string which reads back as the
+// same double, without an exponent, as the XPath string() function requires.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <limits>
+
+namespace Arabica
+{
+namespace XPath
+{
+namespace impl
+{
+
+// big enough for the longest number formatNumber can produce - the
+// smallest denormal has 323 zeros after the decimal point
+const size_t NumberBufferSize = 400;
+
+inline bool isNumberSpace(int c)
+{
+  return (c == 0x20) || (c == 0x09) || (c == 0x0D) || (c == 0x0A);
+} // isNumberSpace
+
+inline bool isNumberDigit(int c)
+{
+  return (c >= '0') && (c <= '9');
+} // isNumberDigit
+
+inline double powerOfTen(int exponent)
+{
+  // every one of these is exactly representable
+  static const double powers[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  return powers[exponent];
+} // powerOfTen
+
+// Builds a digits-and-exponent string and lets strtod do the correctly
+// rounded conversion.  There's no decimal point in the string, so the
+// current C locale doesn't matter.  Only reached for numbers with more
+// than 15 significant digits, or with a very large or very small magnitude.
+template<class const_iterator>
+double slowNumber(const_iterator i, const_iterator ie, int exponent)
+{
+  // 800 digits is more than enough to decide the rounding of any double -
+  // past that, the only thing that matters is whether anything is non-zero
+  const int MaxDigits = 800;
+  char buffer[MaxDigits + 32];
+  char* p = buffer;
+  int digits = 0;
+  bool sticky = false;
+  bool leading = true;
+
+  for(; i != ie; ++i)
+  {
+    int c = static_cast<int>(*i);
+    if(c == '.')
+      continue;
+    if(!isNumberDigit(c))
+      break;
+    if(leading && (c == '0'))
+      continue;
+    leading = false;
+    if(digits < MaxDigits)
+    {
+      *p++ = static_cast<char>(c);
+      ++digits;
+    }
+    else
+    {
+      ++exponent;
+      sticky = sticky || (c != '0');
+    } // if ...
+  } // for ...
+  if(sticky)
+  {
+    *p++ = '1';
+    --exponent;
+  } // if ...
+
+  std::sprintf(p, "e%d", exponent);
+  return std::strtod(buffer, 0);
+} // slowNumber
+
+template<class const_iterator>
+double parseNumber(const_iterator i, const_iterator ie)
+{
+  const double NaN = std::numeric_limits<double>::quiet_NaN();
+
+  while((i != ie) && isNumberSpace(static_cast<int>(*i)))
+    ++i;
+
+  bool negative = false;
+  if((i != ie) && (static_cast<int>(*i) == '-'))
+  {
+    negative = true;
+    ++i;
+  } // if ...
+  const_iterator number = i;
+
+  // accumulate up to 19 significant digits, which always fit in 64 bits,
+  // and scale by the exponent - a digit dropped beyond that sends us the
+  // slow way
+  unsigned long long mantissa = 0;
+  int significant = 0;
+  int exponent = 0;
+  bool dropped = false;
+  bool sawDigit = false;
+
+  for(; (i != ie) && isNumberDigit(static_cast<int>(*i)); ++i)
+  {
+    int d = static_cast<int>(*i) - '0';
+    sawDigit = true;
+    if(significant < 19)
+    {
+      if((mantissa != 0) || (d != 0))
+      {
+        mantissa = (mantissa * 10) + d;
+        ++significant;
+      } // if ...
+    }
+    else
+    {
+      ++exponent;
+      dropped = dropped || (d != 0);
+    } // if ...
+  } // for ...
+
+  if((i != ie) && (static_cast<int>(*i) == '.'))
+  {
+    for(++i; (i != ie) && isNumberDigit(static_cast<int>(*i)); ++i)
+    {
+      int d = static_cast<int>(*i) - '0';
+      sawDigit = true;
+      if(significant < 19)
+      {
+        if((mantissa != 0) || (d != 0))
+        {
+          mantissa = (mantissa * 10) + d;
+          ++significant;
+        } // if ...
+        --exponent;
+      }
+      else
+        dropped = dropped || (d != 0);
+    } // for ...
+  } // if ...
+
+  if(!sawDigit)
+    return NaN;
+
+  const_iterator numberEnd = i;
+  while((i != ie) && isNumberSpace(static_cast<int>(*i)))
+    ++i;
+  if(i != ie)
+    return NaN;
+
+  double value;
+  if(mantissa == 0)
+    value = 0.0;
+  else if(!dropped && (mantissa <= (1ULL << 53)) && (exponent >= -22) && (exponent <= 22))
+  {
+    // the mantissa and the power of ten are both exact, so a single
+    // multiply or divide gives the correctly rounded result
+    value = static_cast<double>(mantissa);
+    value = (exponent < 0) ? value / powerOfTen(-exponent) : value * powerOfTen(exponent);
+  }
+  else
+  {
+    int fractionDigits = 0;
+    bool inFraction = false;
+    for(const_iterator c = number; c != numberEnd; ++c)
+      if(static_cast<int>(*c) == '.')
+        inFraction = true;
+      else if(inFraction)
+        ++fractionDigits;
+    value = slowNumber(number, numberEnd, -fractionDigits);
+  } // if ...
+
+  return negative ? -value : value;
+} // parseNumber
+
+// digits x 10^exponent as a double, correctly rounded
+inline double decimalToDouble(const char* digits, int count, int exponent)
+{
+  if((count <= 15) && (exponent >= -22) && (exponent <= 22))
+  {
+    unsigned long long mantissa = 0;
+    for(int d = 0; d != count; ++d)
+      mantissa = (mantissa * 10) + (digits[d] - '0');
+    double value = static_cast<double>(mantissa);
+    return (exponent < 0) ? value / powerOfTen(-exponent) : value * powerOfTen(exponent);
+  } // if ...
+
+  char buffer[48];
+  std::sprintf(buffer, "%.*se%d", count, digits, exponent);
+  return std::strtod(buffer, 0);
+} // decimalToDouble
+
+inline char* writeInteger(unsigned long long n, char* p)
+{
+  char digits[20];
+  char* d = digits + sizeof(digits);
+  do
+  {
+    *--d = static_cast<char>('0' + (n % 10));
+    n /= 10;
+  } while(n != 0);
+  while(d != digits + sizeof(digits))
+    *p++ = *d++;
+  return p;
+} // writeInteger
+
+// Lays out digits, which are d.ddd x 10^exponent, in plain decimal.
+inline char* writeDecimal(const char* digits, int count, int exponent, char* p)
+{
+  int point = exponent + 1;
+  if(point <= 0)
+  {
+    *p++ = '0';
+    *p++ = '.';
+    for(int z = point; z < 0; ++z)
+      *p++ = '0';
+    for(int c = 0; c != count; ++c)
+      *p++ = digits[c];
+  }
+  else if(point >= count)
+  {
+    for(int c = 0; c != count; ++c)
+      *p++ = digits[c];
+    for(int z = count; z < point; ++z)
+      *p++ = '0';
+  }
+  else
+  {
+    for(int c = 0; c != point; ++c)
+      *p++ = digits[c];
+    *p++ = '.';
+    for(int c = point; c != count; ++c)
+      *p++ = digits[c];
+  } // if ...
+  return p;
+} // writeDecimal
+
+// Writes value into buffer, which must be at least NumberBufferSize long,
+// and returns the length written.  NaN and the infinities are spelled as
+// XPath spells them, and negative zero is written as 0.
+inline size_t formatNumber(double value, char* buffer)
+{
+  char* p = buffer;
+  if(value != value)
+  {
+    std::sprintf(buffer, "NaN");
+    return 3;
+  } // if ...
+  if(value == 0.0)
+  {
+    *p++ = '0';
+    *p = 0;
+    return 1;
+  } // if ...
+  if(value < 0)
+  {
+    *p++ = '-';
+    value = -value;
+  } // if ...
+  if(value == std::numeric_limits<double>::infinity())
+  {
+    std::sprintf(p, "Infinity");
+    return (p - buffer) + 8;
+  } // if ...
+
+  const double TwoToThe53 = 9007199254740992.0;
+
+  // integers up to 2^53 are exact, and by far the commonest case -
+  // positions, counts, sums
+  if((value <= TwoToThe53) && (value == std::floor(value)))
+  {
+    p = writeInteger(static_cast<unsigned long long>(value), p);
+    *p = 0;
+    return p - buffer;
+  } // if ...
+
+  // Next commonest are numbers with a few decimal places - prices,
+  // percentages.  If some m / 10^k reads back as value, then m and k
+  // are its shortest spelling when k is the smallest that works.
+  if((value >= 1e-7) && (value < 1e15))
+  {
+    double scale = 1.0;
+    for(int k = 1; k <= 22; ++k)
+    {
+      scale *= 10.0;
+      double scaled = std::floor((value * scale) + 0.5);
+      if(scaled > TwoToThe53)
+        break;
+      if(scaled / scale == value)
+      {
+        char digits[24];
+        char* d = writeInteger(static_cast<unsigned long long>(scaled), digits);
+        int count = static_cast<int>(d - digits);
+        p = writeDecimal(digits, count, count - 1 - k, p);
+        *p = 0;
+        return p - buffer;
+      } // if ...
+    } // for ...
+  } // if ...
+
+  // Any double can be told apart from its neighbours with 17 significant
+  // digits, most with fewer.  Format 17, then see if those cut to 15 or 16
+  // still read back exactly - rounded to nearest first, and if that
+  // rounded up, truncated too, since the 17 digits are themselves
+  // rounded.  The digits are pulled out of %e output, so the locale's
+  // decimal point doesn't matter.
+  char formatted[40];
+  std::sprintf(formatted, "%.16e", value);
+  char digits[24];
+  int count = 0;
+  const char* f = formatted;
+  for(; *f && (*f != 'e'); ++f)
+    if(isNumberDigit(*f))
+      digits[count++] = *f;
+  int exponent = std::atoi(f + 1);
+
+  for(int precision = 15; precision != 17; ++precision)
+  {
+    char rounded[24];
+    int roundedExponent = exponent;
+    std::memcpy(rounded, digits, precision);
+    bool roundedUp = (digits[precision] >= '5');
+    if(roundedUp)
+    {
+      int r = precision - 1;
+      while((r >= 0) && (rounded[r] == '9'))
+        rounded[r--] = '0';
+      if(r >= 0)
+        ++rounded[r];
+      else
+      {
+        rounded[0] = '1';
+        ++roundedExponent;
+      } // if ...
+    } // if ...
+
+    if(decimalToDouble(rounded, precision, roundedExponent - (precision - 1)) != value)
+    {
+      if(!roundedUp || (decimalToDouble(digits, precision, exponent - (precision - 1)) != value))
+        continue;
+      std::memcpy(rounded, digits, precision);
+      roundedExponent = exponent;
+    } // if ...
+
+    std::memcpy(digits, rounded, precision);
+    count = precision;
+    exponent = roundedExponent;
+    break;
+  } // for ...
+  while((count > 1) && (digits[count-1] == '0'))
+    --count;
+
+  p = writeDecimal(digits, count, exponent, p);
+  *p = 0;
+  return p - buffer;
+} // formatNumber
+
+} // namespace impl
+} // namespace XPath
+} // namespace Arabica
+
+#endif
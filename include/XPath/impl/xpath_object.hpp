@@ -3,6 +3,8 @@
 
 #include <string>
 #include <vector>
+#include <map>
+#include <algorithm>
 #include <utility>
 #include <DOM/Node.hpp>
 #include <DOM/Attr.hpp>
@@ -15,6 +17,7 @@
 #include <Arabica/StringAdaptor.hpp>
 #include <text/normalize_whitespace.hpp>
 #include "xpath_axis_enumerator.hpp"
+#include "xpath_number.hpp"
 
 namespace Arabica
 {
@@ -174,6 +177,109 @@ bool nodes_less_than(const DOM::Node<string_type, string_adaptor>& n1,
   return compareNodes(n1, n2) < 0; 
 } // nodes_less_than
 
+// node_child_position for many nodes at once.  The first time a
+// node's position is asked for, all its siblings are numbered, so
+// positions in a long list of children cost one walk along it between
+// them, rather than a walk each.
+template<class string_type, class string_adaptor>
+class child_positions
+{
+  typedef DOM::Node<string_type, string_adaptor> NodeT;
+public:
+  unsigned int operator()(const NodeT& node)
+  {
+    if(node.getNodeType() == NAMESPACE_NODE_TYPE)
+      return 0;
+
+    typename Positions::const_iterator p = positions_.find(node.underlying_impl());
+    if(p != positions_.end())
+      return p->second;
+
+    if(node.getNodeType() == DOM::Node_base::ATTRIBUTE_NODE)
+    {
+      NodeT owner = (static_cast<DOM::Attr<string_type, string_adaptor> >(node)).getOwnerElement();
+      if(owner == 0)
+        return 1;
+      DOM::NamedNodeMap<string_type, string_adaptor> attrs = owner.getAttributes();
+      for(unsigned int a = 0, ae = attrs.getLength(); a != ae; ++a)
+        positions_[attrs.item(a).underlying_impl()] = a+1;
+    }
+    else
+    {
+      NodeT parent = node.getParentNode();
+      if(parent == 0)
+        return 1000;
+      unsigned int pos = 1000;
+      for(NodeT c = parent.getFirstChild(); c != 0; c = c.getNextSibling(), pos += 1000)
+        positions_[c.underlying_impl()] = pos;
+    } // if ...
+
+    return positions_[node.underlying_impl()];
+  } // operator()
+
+private:
+  typedef std::map<const void*, unsigned int> Positions;
+  Positions positions_;
+}; // class child_positions
+
+template<class string_type, class string_adaptor>
+struct positioned_node
+{
+  DOM::Node<string_type, string_adaptor> node;
+  DOM::Node<string_type, string_adaptor> root;
+  std::vector<unsigned int> position;  // as node_position
+}; // struct positioned_node
+
+template<class string_type, class string_adaptor>
+bool positioned_less_than(const positioned_node<string_type, string_adaptor>* lhs,
+                          const positioned_node<string_type, string_adaptor>* rhs)
+{
+  if(lhs->root != rhs->root)
+    return compareNodes(lhs->node, rhs->node) < 0;
+
+  return std::lexicographical_compare(lhs->position.rbegin(), lhs->position.rend(),
+                                      rhs->position.rbegin(), rhs->position.rend());
+} // positioned_less_than
+
+// Sorts [begin, end) into document order.  Comparing two nodes means
+// walking from each to the root, and along its siblings, so for more
+// than a handful of nodes it's much quicker to find each node's
+// position once and sort on that.
+template<class string_type, class string_adaptor, class Iterator>
+void sort_nodes(Iterator begin, Iterator end)
+{
+  typedef DOM::Node<string_type, string_adaptor> NodeT;
+  typedef positioned_node<string_type, string_adaptor> PositionedT;
+
+  if(std::distance(begin, end) <= 8)
+  {
+    std::sort(begin, end, nodes_less_than<string_type, string_adaptor>);
+    return;
+  } // if ...
+
+  child_positions<string_type, string_adaptor> child_position;
+  std::vector<PositionedT> positioned(std::distance(begin, end));
+  std::vector<const PositionedT*> order;
+  order.reserve(positioned.size());
+  typename std::vector<PositionedT>::iterator p = positioned.begin();
+  for(Iterator i = begin; i != end; ++i, ++p)
+  {
+    p->node = *i;
+    NodeT n = *i;
+    do
+    {
+      p->position.push_back(child_position(n));
+      p->root = n;
+      n = node_parent_or_owner(n);
+    } while(n != 0);
+    order.push_back(&*p);
+  } // for ...
+
+  std::sort(order.begin(), order.end(), positioned_less_than<string_type, string_adaptor>);
+  for(typename std::vector<const PositionedT*>::const_iterator o = order.begin(); o != order.end(); ++o, ++begin)
+    *begin = (*o)->node;
+} // sort_nodes
+
 } // namespace impl
 
 ///////////////////////////////////////////////////////////
@@ -275,10 +381,13 @@ public:
     if(sorted_)
       return;
 
+    ARABICA_STATS_TIME(nodeset_sort);
+    ARABICA_STATS_COUNT(nodeset_sorts);
+    ARABICA_STATS_ADD(nodeset_sorted_nodes, nodes_.size());
     if(forward_)
-      std::sort(nodes_.begin(), nodes_.end(), impl::nodes_less_than<string_type, string_adaptor>);
+      impl::sort_nodes<string_type, string_adaptor>(nodes_.begin(), nodes_.end());
     else
-      std::sort(nodes_.rbegin(), nodes_.rend(), impl::nodes_less_than<string_type, string_adaptor>);
+      impl::sort_nodes<string_type, string_adaptor>(nodes_.rbegin(), nodes_.rend());
 
     nodes_.erase(std::unique(nodes_.begin(), nodes_.end()), nodes_.end());
     sorted_ = true;
@@ -419,19 +528,9 @@ inline double roundNumber(double value)
 template<class string_type, class string_adaptor>
 double stringAsNumber(const string_type& str)
 {
-  try {
-    static string_type PLUS = string_adaptor::construct_from_utf8("+");
-
-    string_type n_str = Arabica::text::normalize_whitespace<string_type, string_adaptor>(str);
-    // '+1.5' is not a number according to XPath spec, counter intuitive as that is
-    if(string_adaptor::find(n_str, PLUS) == 0)
-      return NaN;
-    
-    return boost::lexical_cast<double>(n_str);
-  } // try
-  catch(const boost::bad_lexical_cast&) {
-    return NaN;
-  } // catch
+  // '+1.5' is not a number according to XPath spec, counter intuitive as that is,
+  // and neither is '1e5' - parseNumber sticks to the spec's grammar
+  return parseNumber(string_adaptor::begin(str), string_adaptor::end(str));
 } // stringAsNumber
 
 template<class string_type, class string_adaptor>
@@ -450,15 +549,15 @@ string_type nodeStringValue(const DOM::Node<string_type, string_adaptor>& node)
   case DOM::Node_base::DOCUMENT_FRAGMENT_NODE:
   case DOM::Node_base::ELEMENT_NODE:
     {
-      std::basic_ostringstream<typename string_adaptor::value_type> os;
+      string_type value;
       AxisEnumerator<string_type, string_adaptor> ae(node, DESCENDANT);
       while(*ae != 0)
       {
         if(nodeIsText<string_type, string_adaptor>(*ae))
-          os << nodeStringValue(*ae);
+          string_adaptor::append(value, nodeStringValue<string_type, string_adaptor>(*ae));
         ++ae;
       } // while
-      return string_adaptor::construct(os.str().c_str());
+      return value;
     } // case
 
   case DOM::Node_base::ATTRIBUTE_NODE:
@@ -470,15 +569,12 @@ string_type nodeStringValue(const DOM::Node<string_type, string_adaptor>& node)
   case DOM::Node_base::TEXT_NODE:
   case DOM::Node_base::CDATA_SECTION_NODE:
     {
-      DOM::Node<string_type, string_adaptor> next = node.getNextSibling();
-      if((next == 0) ||
-	 !nodeIsText<string_type, string_adaptor>(next))
-	return node.getNodeValue();
-
-      std::basic_ostringstream<typename string_adaptor::value_type> os;
-      os << node.getNodeValue() 
-	 << nodeStringValue<string_type, string_adaptor>(next);
-      return string_adaptor::construct(os.str().c_str());
+      string_type value = node.getNodeValue();
+      for(DOM::Node<string_type, string_adaptor> next = node.getNextSibling();
+          (next != 0) && nodeIsText<string_type, string_adaptor>(next);
+          next = next.getNextSibling())
+        string_adaptor::append(value, next.getNodeValue());
+      return value;
     } // case
 
   default:
@@ -528,8 +624,78 @@ private:
   compareNodeWith& operator=(const compareNodeWith&);
 }; // class compareNodeWith
 
-template<class string_type, class string_adaptor, class predicate1, class predicate2>
-bool nodeSetsCompare(const XPathValue<string_type, string_adaptor>& lhs, const XPathValue<string_type, string_adaptor>& rhs)
+// The string values on one side of a node-set comparison, hashed so the 
+// other side can be probed against them.  Open addressing, linear probing, 
+// load factor at most 1/2.
+template<class string_type, class string_adaptor>
+class StringValueSet
+{
+public:
+  StringValueSet() { }
+
+  void insert(const string_type& value)
+  {
+    if((values_.size() + 1) * 2 > slots_.size())
+      rehash((slots_.size() != 0) ? slots_.size() * 2 : 32);
+
+    size_t mask = slots_.size() - 1;
+    size_t slot = hashOf(value) & mask;
+    for( ; slots_[slot] != -1; slot = (slot + 1) & mask)
+      if(values_[slots_[slot]] == value)
+        return;
+    slots_[slot] = static_cast<int>(values_.size());
+    values_.push_back(value);
+  } // insert
+
+  bool contains(const string_type& value) const
+  {
+    if(values_.empty())
+      return false;
+
+    size_t mask = slots_.size() - 1;
+    for(size_t slot = hashOf(value) & mask; slots_[slot] != -1; slot = (slot + 1) & mask)
+      if(values_[slots_[slot]] == value)
+        return true;
+    return false;
+  } // contains
+
+  // distinct values, in the order they were first inserted
+  size_t size() const { return values_.size(); }
+  bool empty() const { return values_.empty(); }
+  const string_type& operator[](size_t i) const { return values_[i]; }
+
+private:
+  void rehash(size_t slots)
+  {
+    slots_.assign(slots, -1);
+    size_t mask = slots - 1;
+    for(size_t i = 0, ie = values_.size(); i != ie; ++i)
+    {
+      size_t slot = hashOf(values_[i]) & mask;
+      while(slots_[slot] != -1)
+        slot = (slot + 1) & mask;
+      slots_[slot] = static_cast<int>(i);
+    } // for ...
+  } // rehash
+
+  // FNV-1a
+  static size_t hashOf(const string_type& str)
+  {
+    size_t hash = 2166136261u;
+    for(typename string_adaptor::const_iterator c = string_adaptor::begin(str), ce = string_adaptor::end(str); c != ce; ++c)
+      hash = (hash ^ static_cast<size_t>(*c)) * 16777619u;
+    return hash;
+  } // hashOf
+
+  std::vector<string_type> values_;
+  std::vector<int> slots_;
+}; // class StringValueSet
+
+// true if any node in lns has the same string value as any node in rns
+// - the smaller side is hashed, and the larger probed against it, so each 
+// string value is computed only once
+template<class string_type, class string_adaptor>
+bool nodeSetsEqual(const XPathValue<string_type, string_adaptor>& lhs, const XPathValue<string_type, string_adaptor>& rhs)
 {
   const NodeSet<string_type, string_adaptor>& lns = lhs.asNodeSet();
   const NodeSet<string_type, string_adaptor>& rns = rhs.asNodeSet();
@@ -537,43 +703,43 @@ bool nodeSetsCompare(const XPathValue<string_type, string_adaptor>& lhs, const X
   if((lns.size() == 0) || (rns.size() == 0))
     return false;
 
-  std::set<string_type> values;
-  typename NodeSet<string_type, string_adaptor>::const_iterator l = lns.begin();
-  string_type lvalue = nodeStringValue<string_type, string_adaptor>(*l);
+  const NodeSet<string_type, string_adaptor>& build = (lns.size() <= rns.size()) ? lns : rns;
+  const NodeSet<string_type, string_adaptor>& probe = (lns.size() <= rns.size()) ? rns : lns;
 
-  predicate1 p1;
-  for(typename NodeSet<string_type, string_adaptor>::const_iterator r = rns.begin(), rend = rns.end(); r != rend; ++r)
-  {
-    string_type rvalue = nodeStringValue<string_type, string_adaptor>(*r);
-    if(p1(lvalue, rvalue))
-      return true;
-    values.insert(rvalue);
-  } // for ...
+  StringValueSet<string_type, string_adaptor> values;
+  for(typename NodeSet<string_type, string_adaptor>::const_iterator b = build.begin(), be = build.end(); b != be; ++b)
+    values.insert(nodeStringValue<string_type, string_adaptor>(*b));
 
-  ++l;
-  predicate2 p2;
-  for(typename NodeSet<string_type, string_adaptor>::const_iterator lend = lns.end(); l != lend; ++l)
-    if(p2(values.find(nodeStringValue<string_type, string_adaptor>(*l)),  values.end()))
+  for(typename NodeSet<string_type, string_adaptor>::const_iterator p = probe.begin(), pe = probe.end(); p != pe; ++p)
+    if(values.contains(nodeStringValue<string_type, string_adaptor>(*p)))
       return true;
 
   return false;
 } // nodeSetsEqual
 
-template<class string_type, class string_adaptor>
-bool nodeSetsEqual(const XPathValue<string_type, string_adaptor>& lhs, const XPathValue<string_type, string_adaptor>& rhs)
-{
-  return nodeSetsCompare<string_type, string_adaptor, 
-                         std::equal_to<string_type>,
-                         std::not_equal_to<typename std::set<string_type>::const_iterator> >(lhs, rhs);
-}
-
+// true if any node in lns has a different string value to any node in rns,
+// which is to say unless every node in both has one and the same value
 template<class string_type, class string_adaptor>
 bool nodeSetsNotEqual(const XPathValue<string_type, string_adaptor>& lhs, const XPathValue<string_type, string_adaptor>& rhs)
 {
-  return nodeSetsCompare<string_type, string_adaptor, 
-                         std::not_equal_to<string_type>,
-                         std::equal_to<typename std::set<string_type>::const_iterator> >(lhs, rhs);
-}
+  const NodeSet<string_type, string_adaptor>& lns = lhs.asNodeSet();
+  const NodeSet<string_type, string_adaptor>& rns = rhs.asNodeSet();
+
+  if((lns.size() == 0) || (rns.size() == 0))
+    return false;
+
+  typename NodeSet<string_type, string_adaptor>::const_iterator l = lns.begin();
+  string_type first = nodeStringValue<string_type, string_adaptor>(*l);
+
+  for(typename NodeSet<string_type, string_adaptor>::const_iterator r = rns.begin(), re = rns.end(); r != re; ++r)
+    if(nodeStringValue<string_type, string_adaptor>(*r) != first)
+      return true;
+  for(++l; l != lns.end(); ++l)
+    if(nodeStringValue<string_type, string_adaptor>(*l) != first)
+      return true;
+
+  return false;
+} // nodeSetsNotEqual
 
 template<class string_type, class string_adaptor>
 bool nodeSetAndValueEqual(const XPathValue<string_type, string_adaptor>& lhs, const XPathValue<string_type, string_adaptor>& rhs)
@@ -633,16 +799,18 @@ bool nodeSetAndValueNotEqual(const XPathValue<string_type, string_adaptor>& lhs,
   } // switch
 } // nodeSetAndValueNotEqual
 
+// The smallest and largest number values in a node-set, ignoring nodes 
+// which aren't numbers.  NaN if there are none.
 template<class string_type, class string_adaptor> 
 double minValue(const NodeSet<string_type, string_adaptor>& ns)
 {
-  double v = nodeNumberValue<string_type, string_adaptor>(ns[0]);
+  double v = NaN;
   for(typename NodeSet<string_type, string_adaptor>::const_iterator i = ns.begin(), ie = ns.end(); i != ie; ++i)
   {
     double vt = nodeNumberValue<string_type, string_adaptor>(*i);
     if(isNaN(vt))
       continue;
-    if(!(vt > v)) // looks weird, but should account for infinity
+    if(isNaN(v) || (vt < v))
       v = vt;
   } // for ...
   return v;
@@ -651,18 +819,21 @@ double minValue(const NodeSet<string_type, string_adaptor>& ns)
 template<class string_type, class string_adaptor> 
 double maxValue(const NodeSet<string_type, string_adaptor>& ns)
 {
-  double v = nodeNumberValue<string_type, string_adaptor>(ns[0]);
+  double v = NaN;
   for(typename NodeSet<string_type, string_adaptor>::const_iterator i = ns.begin(), ie = ns.end(); i != ie; ++i)
   {
     double vt = nodeNumberValue<string_type, string_adaptor>(*i);
     if(isNaN(vt))
       continue;
-    if(!(vt < v))
+    if(isNaN(v) || (vt > v))
       v = vt;
   } // for ...
   return v;
 } // maxValue
 
+// Some l in lhs and r in rhs have l < r (or l <= r) exactly when the 
+// smallest l does against the largest r, so each side is reduced to one 
+// number rather than comparing every pair.
 template<class Op, class string_type, class string_adaptor>
 bool compareNodeSets(const XPathValue<string_type, string_adaptor>& lhs, const XPathValue<string_type, string_adaptor>& rhs)
 {
@@ -20,6 +20,7 @@
 #include "xpath_expression.hpp"
 #include "xpath_ast.hpp"
 #include "xpath_grammar.hpp"
+#include "xpath_invariant.hpp"
 #include "xpath_namespace_context.hpp"
 #include "xpath_function_resolver.hpp"
 #include "xpath_variable_resolver.hpp"
@@ -53,6 +54,7 @@ public:
 namespace impl
 {
   template<class string_type, class string_adaptor> class CompilationContext;
+  template<class string_type> struct CompilationStep;
 
   template<class string_type, class string_adaptor> class StepExpression;
 
@@ -111,6 +113,31 @@ public:
     return compile_expr(xpath).evaluate(context, executionContext);
   } // evaluate_expr
 
+  // Describes how xpath is compiled, one subexpression to a line, indented
+  // under the expression it's part of.  Constants folded at compile time,
+  // and subexpressions evaluated once rather than for every node a 
+  // predicate filters, are noted against each.
+  string_type explain(const string_type& xpath) const
+  {
+    std::vector<impl::CompilationStep<string_type> > plan;
+    do_compile(xpath, &XPath::parse_xpath_expr, expression_factory(), &plan);
+
+    string_type explanation;
+    for(typename std::vector<impl::CompilationStep<string_type> >::const_iterator s = plan.begin(), se = plan.end(); s != se; ++s)
+    {
+      for(unsigned int d = 0; d != s->depth; ++d)
+        string_adaptor::append(explanation, string_adaptor::construct_from_utf8("  "));
+      string_adaptor::append(explanation, s->expression);
+      if(!string_adaptor::empty(s->note))
+      {
+        string_adaptor::append(explanation, string_adaptor::construct_from_utf8(" : "));
+        string_adaptor::append(explanation, s->note);
+      } // if ...
+      string_adaptor::append(explanation, string_adaptor::construct_from_utf8("\n"));
+    } // for ...
+    return explanation;
+  } // explain
+
   void setNamespaceContext(const NamespaceContext<string_type, string_adaptor>& namespaceContext) { namespaceContext_.set(namespaceContext); }
   void setNamespaceContext(NamespaceContextPtr<string_type, string_adaptor> namespaceContext) { namespaceContext_.set(namespaceContext); }
   const NamespaceContext<string_type, string_adaptor>& getNamespaceContext() const { return namespaceContext_.get(); }
@@ -139,7 +166,8 @@ private:
 
   XPathExpression<string_type, string_adaptor> do_compile(const string_type& xpath,
                                                              parserFn parser,
-                                                             const std::map<int, compileFn>& factory) const
+                                                             const std::map<int, compileFn>& factory,
+                                                             std::vector<impl::CompilationStep<string_type> >* plan = 0) const
   {
     typename impl::types<string_adaptor>::tree_info_t ast;
     try {
@@ -151,12 +179,18 @@ private:
 								    getNamespaceContext(), 
 								    getFunctionResolver(),
 								    getVariableCompileTimeResolver());
+      if(plan)
+        context.explainTo(*plan);
 
       //XPath::dump(ast.trees.begin(), 0);
-      return XPathExpression<string_type, string_adaptor>(compile_with_factory(ast.trees.begin(),
-                                                                                  ast.trees.end(),
-                                                                                  context,
-                                                                                  factory));
+      XPathExpression_impl<string_type, string_adaptor>* expr = (&factory == &expression_factory()) ?
+                                                                  compile_expression(ast.trees.begin(), ast.trees.end(), context) :
+                                                                  compile_with_factory(ast.trees.begin(), ast.trees.end(), context, factory);
+      // compile_match needs its MatchExpressionWrapper at the root, and 
+      // its invariants are evaluated afresh each time
+      if((context.invariants() != 0) && (&factory != &match_factory()))
+        expr = new impl::InvariantScope<string_type, string_adaptor>(expr);
+      return XPathExpression<string_type, string_adaptor>(expr);
     } // try
     catch(const std::exception&)
     {
@@ -208,7 +242,13 @@ public:
                                                                           typename impl::types<string_adaptor>::node_iter_t const& ie,
                                                                           impl::CompilationContext<string_type, string_adaptor>& context)
   {
-    return compile_with_factory(i, ie, context, XPath::expression_factory());
+    if(!context.explaining())
+      return optimise(i, ie, context, 0);
+
+    size_t step = context.beginStep(describe(i));
+    XPathExpression_impl<string_type, string_adaptor>* expr = optimise(i, ie, context, step);
+    context.endStep();
+    return expr;
   } // compile_expression
 
   static XPathExpression_impl<string_type, string_adaptor>* compile_match(typename impl::types<string_adaptor>::node_iter_t const& i,
@@ -249,6 +289,14 @@ public:
   } // compile_with_factory
 
 private:
+  static XPathExpression_impl<string_type, string_adaptor>* optimise(typename impl::types<string_adaptor>::node_iter_t const& i, typename impl::types<string_adaptor>::node_iter_t const& ie, impl::CompilationContext<string_type, string_adaptor>& context, size_t step);
+  static XPathExpression_impl<string_type, string_adaptor>* fold(XPathExpression_impl<string_type, string_adaptor>* expr, impl::CompilationContext<string_type, string_adaptor>& context, size_t step);
+  static impl::Dependency dependencyOf(typename impl::types<string_adaptor>::node_iter_t const& i);
+  static impl::Dependency functionDependency(typename impl::types<string_adaptor>::node_iter_t const& i);
+  static string_type describe(typename impl::types<string_adaptor>::node_iter_t const& i);
+  static void writeSource(typename impl::types<string_adaptor>::node_iter_t const& i, string_type& source);
+  static bool isBinaryExpression(long id);
+
   static XPathExpression_impl<string_type, string_adaptor>* createAbsoluteLocationPath(typename impl::types<string_adaptor>::node_iter_t const& i, typename impl::types<string_adaptor>::node_iter_t const& ie, impl::CompilationContext<string_type, string_adaptor>& context);
   static XPathExpression_impl<string_type, string_adaptor>* createRelativeLocationPath(typename impl::types<string_adaptor>::node_iter_t const& i, typename impl::types<string_adaptor>::node_iter_t const& ie, impl::CompilationContext<string_type, string_adaptor>& context);
   static XPathExpression_impl<string_type, string_adaptor>* createFilteredPath(typename impl::types<string_adaptor>::node_iter_t const& i, typename impl::types<string_adaptor>::node_iter_t const& ie, impl::CompilationContext<string_type, string_adaptor>& context);
@@ -256,6 +304,7 @@ private:
   static XPathExpression_impl<string_type, string_adaptor>* createExpression(typename impl::types<string_adaptor>::node_iter_t const& i, typename impl::types<string_adaptor>::node_iter_t const& ie, impl::CompilationContext<string_type, string_adaptor>& context);
   static XPathExpression_impl<string_type, string_adaptor>* createFunction(typename impl::types<string_adaptor>::node_iter_t const& i, typename impl::types<string_adaptor>::node_iter_t const& ie, impl::CompilationContext<string_type, string_adaptor>& context);
   static XPathExpression_impl<string_type, string_adaptor>* createBinaryExpression(typename impl::types<string_adaptor>::node_iter_t const& i, typename impl::types<string_adaptor>::node_iter_t const& ie, impl::CompilationContext<string_type, string_adaptor>& context);
+  static XPathExpression_impl<string_type, string_adaptor>* hoistInvariant(XPathExpression_impl<string_type, string_adaptor>* expr, long id, impl::CompilationContext<string_type, string_adaptor>& context, size_t step);
   static XPathExpression_impl<string_type, string_adaptor>* createLiteral(typename impl::types<string_adaptor>::node_iter_t const& i, typename impl::types<string_adaptor>::node_iter_t const& ie, impl::CompilationContext<string_type, string_adaptor>& context);
   static XPathExpression_impl<string_type, string_adaptor>* createNumber(typename impl::types<string_adaptor>::node_iter_t const& i, typename impl::types<string_adaptor>::node_iter_t const& ie, impl::CompilationContext<string_type, string_adaptor>& context);
   static XPathExpression_impl<string_type, string_adaptor>* createVariable(typename impl::types<string_adaptor>::node_iter_t const& i, typename impl::types<string_adaptor>::node_iter_t const& ie, impl::CompilationContext<string_type, string_adaptor>& context);
@@ -617,6 +666,8 @@ template<class string_type, class string_adaptor>
 XPathExpression_impl<string_type, string_adaptor>* XPath<string_type, string_adaptor>::createBinaryExpression(typename impl::types<string_adaptor>::node_iter_t const& i, typename impl::types<string_adaptor>::node_iter_t const& /* ie */, impl::CompilationContext<string_type, string_adaptor>& context)
 {
   typename impl::types<string_adaptor>::node_iter_t c = i->children.begin();
+  long p1id = impl::getNodeId<string_adaptor>(c);
+  size_t p1step = context.nextStep();
   XPathExpression_impl<string_type, string_adaptor>* p1 = XPath<string_type, string_adaptor>::compile_expression(c, i->children.end(), context);
   ++c;
 
@@ -624,8 +675,25 @@ XPathExpression_impl<string_type, string_adaptor>* XPath<string_type, string_ada
   {
     long op = impl::getNodeId<string_adaptor>(c);
     ++c;
+    long p2id = impl::getNodeId<string_adaptor>(c);
+    size_t p2step = context.nextStep();
     XPathExpression_impl<string_type, string_adaptor>* p2 = XPath<string_type, string_adaptor>::compile_expression(c, i->children.end(), context);
 
+    switch(op)
+    {
+      case impl::EqualsOperator_id:
+      case impl::NotEqualsOperator_id:
+      case impl::LessThanOperator_id:
+      case impl::LessThanEqualsOperator_id:
+      case impl::GreaterThanOperator_id:
+      case impl::GreaterThanEqualsOperator_id:
+        p1 = hoistInvariant(p1, p1id, context, p1step);
+        p2 = hoistInvariant(p2, p2id, context, p2step);
+        break;
+    } // switch
+    p1id = op;
+    p1step = static_cast<size_t>(-1);  // the expression so far has no step of its own
+
     switch(op)
     {
       case impl::PlusOperator_id:
@@ -679,6 +747,363 @@ XPathExpression_impl<string_type, string_adaptor>* XPath<string_type, string_ada
   return p1;
 } // createBinaryExpression
 
+// Comparison operands in a predicate which don't depend on the context
+// node are evaluated once per evaluation of the whole expression, and 
+// indexed if compared more than once - see xpath_invariant.hpp.  optimise
+// has already hoisted everything but variable references.
+template<class string_type, class string_adaptor>
+XPathExpression_impl<string_type, string_adaptor>* XPath<string_type, string_adaptor>::hoistInvariant(XPathExpression_impl<string_type, string_adaptor>* expr, long id, impl::CompilationContext<string_type, string_adaptor>& context, size_t step)
+{
+  if(dynamic_cast<impl::InvariantExpression<string_type, string_adaptor>*>(expr) != 0)
+  {
+    if((expr->type() == NODE_SET) || (expr->type() == ANY))
+      context.note(step, "indexed when compared repeatedly");
+    return expr;
+  } // if ...
+  if(!context.inPredicate() || (context.enclosing() != impl::DEPENDS_ON_CONTEXT))
+    return expr;
+
+  switch(id)
+  {
+    case impl::AbsoluteLocationPath_id:
+    case impl::AbbreviatedAbsoluteLocationPath_id:
+    case impl::Slash_id:
+      context.addInvariant();
+      context.note(step, "evaluated once per document, indexed when compared repeatedly");
+      return new impl::InvariantExpression<string_type, string_adaptor>(expr, true);
+    case impl::VariableReference_id:
+      context.addInvariant();
+      context.note(step, "evaluated once, indexed when compared repeatedly");
+      return new impl::InvariantExpression<string_type, string_adaptor>(expr, false);
+  } // switch
+  return expr;
+} // hoistInvariant
+
+// Constant subexpressions are evaluated as they're compiled, and replaced
+// by their value.  Within a predicate, the largest subexpressions which 
+// don't depend on the context node are wrapped in an InvariantExpression,
+// so they're evaluated once rather than once for each node filtered.
+template<class string_type, class string_adaptor>
+XPathExpression_impl<string_type, string_adaptor>* XPath<string_type, string_adaptor>::optimise(typename impl::types<string_adaptor>::node_iter_t const& i, typename impl::types<string_adaptor>::node_iter_t const& ie, impl::CompilationContext<string_type, string_adaptor>& context, size_t step)
+{
+  switch(impl::getNodeId<string_adaptor>(i))
+  {
+    case impl::Literal_id:
+    case impl::Number_id:
+    case impl::Digits_id:
+    case impl::VariableReference_id:
+      // nothing to gain
+      return compile_with_factory(i, ie, context, expression_factory());
+  } // switch
+
+  impl::Dependency enclosing = context.enclosing();
+  if(enclosing == impl::DEPENDS_ON_NOTHING)
+    return compile_with_factory(i, ie, context, expression_factory());
+
+  impl::Dependency dependency = dependencyOf(i);
+  if((dependency == impl::DEPENDS_ON_CONTEXT) ||
+     ((enclosing != impl::DEPENDS_ON_CONTEXT) && (dependency != impl::DEPENDS_ON_NOTHING)))
+    return compile_with_factory(i, ie, context, expression_factory());
+
+  context.setEnclosing(dependency);
+  XPathExpression_impl<string_type, string_adaptor>* expr = compile_with_factory(i, ie, context, expression_factory());
+  context.setEnclosing(enclosing);
+
+  if(dependency == impl::DEPENDS_ON_NOTHING)
+    return fold(expr, context, step);
+  if(!context.inPredicate())
+    return expr;
+
+  bool absolute = (dependency == impl::DEPENDS_ON_DOCUMENT);
+  context.addInvariant();
+  context.note(step, absolute ? "evaluated once per document" : "evaluated once");
+  return new impl::InvariantExpression<string_type, string_adaptor>(expr, absolute);
+} // optimise
+
+template<class string_type, class string_adaptor>
+XPathExpression_impl<string_type, string_adaptor>* XPath<string_type, string_adaptor>::fold(XPathExpression_impl<string_type, string_adaptor>* expr, impl::CompilationContext<string_type, string_adaptor>& context, size_t step)
+{
+  XPathExpression_impl<string_type, string_adaptor>* value = 0;
+  string_type shown;
+  try {
+    XPathValue<string_type, string_adaptor> v = expr->evaluate(DOM::Node<string_type, string_adaptor>());
+    switch(v.type())
+    {
+      case BOOL:
+        value = new BoolValue<string_type, string_adaptor>(v.asBool());
+        shown = v.asString();
+        break;
+      case NUMBER:
+        value = new NumericValue<string_type, string_adaptor>(v.asNumber());
+        shown = v.asString();
+        break;
+      case STRING:
+        value = new StringValue<string_type, string_adaptor>(v.asString());
+        shown = string_adaptor::construct_from_utf8("'");
+        string_adaptor::append(shown, v.asString());
+        string_adaptor::append(shown, string_adaptor::construct_from_utf8("'"));
+        break;
+      default:
+        break;
+    } // switch
+  } // try
+  catch(...)
+  {
+    // leave it to fail, if it's going to, when it's evaluated
+  } // catch
+
+  if(value == 0)
+    return expr;
+  context.note(step, "constant, folded to ", shown);
+  delete expr;
+  return value;
+} // fold
+
+// What the value of the expression at i depends on, worked out from the
+// parse tree.  Anything not recognised depends on the context.
+template<class string_type, class string_adaptor>
+impl::Dependency XPath<string_type, string_adaptor>::dependencyOf(typename impl::types<string_adaptor>::node_iter_t const& i)
+{
+  switch(impl::getNodeId<string_adaptor>(i))
+  {
+    case impl::Literal_id:
+    case impl::Number_id:
+    case impl::Digits_id:
+      return impl::DEPENDS_ON_NOTHING;
+
+    case impl::VariableReference_id:
+      return impl::DEPENDS_ON_VARIABLES;
+
+    case impl::AbsoluteLocationPath_id:
+    case impl::AbbreviatedAbsoluteLocationPath_id:
+    case impl::Slash_id:
+      // predicates are evaluated against the nodes they filter, 
+      // so the whole path only depends on which document it's in
+      return impl::DEPENDS_ON_DOCUMENT;
+
+    case impl::FunctionCall_id:
+      return functionDependency(i);
+
+    case impl::PathExpr_id:
+    case impl::FilterExpr_id:
+      {
+        // as for absolute location paths, it's where the path starts from
+        typename impl::types<string_adaptor>::node_iter_t c = i->children.begin();
+        impl::skipWhitespace<string_adaptor>(c);
+        return dependencyOf(c);
+      } 
+
+    case impl::PrimaryExpr_id:
+    case impl::UnaryExpr_id:
+    case impl::UnionExpr_id:
+    case impl::OrExpr_id:
+    case impl::AndExpr_id:
+    case impl::EqualityExpr_id:
+    case impl::RelationalExpr_id:
+    case impl::AdditiveExpr_id:
+    case impl::MultiplicativeExpr_id:
+      {
+        impl::Dependency dependency = impl::DEPENDS_ON_NOTHING;
+        for(typename impl::types<string_adaptor>::node_iter_t c = i->children.begin(), ce = i->children.end(); 
+            (c != ce) && (dependency != impl::DEPENDS_ON_CONTEXT); ++c)
+          switch(impl::getNodeId<string_adaptor>(c))
+          {
+            case impl::S_id:
+            case impl::LeftBracket_id:
+            case impl::RightBracket_id:
+            case impl::MultiplyOperator_id:
+            case impl::PlusOperator_id:
+            case impl::MinusOperator_id:
+            case impl::ModOperator_id:
+            case impl::DivOperator_id:
+            case impl::EqualsOperator_id:
+            case impl::NotEqualsOperator_id:
+            case impl::LessThanOperator_id:
+            case impl::LessThanEqualsOperator_id:
+            case impl::GreaterThanOperator_id:
+            case impl::GreaterThanEqualsOperator_id:
+            case impl::OrOperator_id:
+            case impl::AndOperator_id:
+            case impl::UnionOperator_id:
+            case impl::UnaryMinusOperator_id:
+              break;
+            default:
+              dependency = std::max(dependency, dependencyOf(c));
+          } // switch
+        return dependency;
+      } 
+  } // switch
+
+  return impl::DEPENDS_ON_CONTEXT;
+} // dependencyOf
+
+// The core functions depend only on their arguments, except for those 
+// which default to the context node when called without any.  Anything 
+// else, including every extension function, is assumed to depend on 
+// the context.
+template<class string_type, class string_adaptor>
+impl::Dependency XPath<string_type, string_adaptor>::functionDependency(typename impl::types<string_adaptor>::node_iter_t const& i)
+{
+  static const char* const pure[] = { "boolean", "not", "true", "false",
+                                      "number", "sum", "floor", "ceiling", "round", "count",
+                                      "string", "concat", "starts-with", "contains", 
+                                      "substring-before", "substring-after", "substring", 
+                                      "string-length", "normalize-space", "translate",
+                                      "local-name", "namespace-uri", "name", 0 };
+  static const char* const contextDefault[] = { "number", "string", "string-length", "normalize-space",
+                                                "local-name", "namespace-uri", "name", 0 };
+
+  typename impl::types<string_adaptor>::node_iter_t c = i->children.begin();
+  if(impl::getNodeId<string_adaptor>(c) != impl::NCName_id)
+    return impl::DEPENDS_ON_CONTEXT;
+  std::string name = string_adaptor::asStdString(string_adaptor::construct(c->value.begin(), c->value.end()));
+
+  impl::Dependency dependency = impl::DEPENDS_ON_NOTHING;
+  bool noArgs = true;
+  for(++c; c != i->children.end(); ++c)
+    switch(impl::getNodeId<string_adaptor>(c))
+    {
+      case impl::S_id:
+      case impl::LeftBracket_id:
+      case impl::RightBracket_id:
+        break;
+      default:
+        noArgs = false;
+        dependency = std::max(dependency, dependencyOf(c));
+    } // switch
+
+  const char* const* f = pure;
+  while(*f && (name != *f))
+    ++f;
+  if(*f == 0)
+    return impl::DEPENDS_ON_CONTEXT;
+
+  if(noArgs)
+    for(f = contextDefault; *f; ++f)
+      if(name == *f)
+        return impl::DEPENDS_ON_CONTEXT;
+
+  return dependency;
+} // functionDependency
+
+template<class string_type, class string_adaptor>
+string_type XPath<string_type, string_adaptor>::describe(typename impl::types<string_adaptor>::node_iter_t const& i)
+{
+  string_type description = names()[impl::getNodeId<string_adaptor>(i)];
+  string_type source;
+  writeSource(i, source);
+  if(!string_adaptor::empty(source))
+  {
+    string_adaptor::append(description, string_adaptor::construct_from_utf8(" "));
+    string_adaptor::append(description, source);
+  } // if ...
+  return description;
+} // describe
+
+// Reassembles the text of an expression from its parse tree, which is
+// missing whitespace, quotes and commas
+template<class string_type, class string_adaptor>
+void XPath<string_type, string_adaptor>::writeSource(typename impl::types<string_adaptor>::node_iter_t const& i, string_type& source)
+{
+  typedef string_adaptor SA;
+  switch(impl::getNodeId<string_adaptor>(i))
+  {
+    case impl::S_id:
+      return;
+    case impl::Literal_id:
+      SA::append(source, SA::construct_from_utf8("'"));
+      SA::append(source, SA::construct(i->value.begin(), i->value.end()));
+      SA::append(source, SA::construct_from_utf8("'"));
+      return;
+    case impl::MultiplyOperator_id:
+    case impl::PlusOperator_id:
+    case impl::MinusOperator_id:
+    case impl::ModOperator_id:
+    case impl::DivOperator_id:
+    case impl::EqualsOperator_id:
+    case impl::NotEqualsOperator_id:
+    case impl::LessThanOperator_id:
+    case impl::LessThanEqualsOperator_id:
+    case impl::GreaterThanOperator_id:
+    case impl::GreaterThanEqualsOperator_id:
+    case impl::OrOperator_id:
+    case impl::AndOperator_id:
+    case impl::UnionOperator_id:
+      SA::append(source, SA::construct_from_utf8(" "));
+      SA::append(source, SA::construct(i->value.begin(), i->value.end()));
+      SA::append(source, SA::construct_from_utf8(" "));
+      return;
+    case impl::QName_id:
+      writeSource(i->children.begin(), source);
+      SA::append(source, SA::construct_from_utf8(":"));
+      writeSource(i->children.begin() + 1, source);
+      return;
+    case impl::FunctionCall_id:
+      {
+        bool first = true;
+        for(typename impl::types<string_adaptor>::node_iter_t c = i->children.begin(), ce = i->children.end(); c != ce; ++c)
+          switch(impl::getNodeId<string_adaptor>(c))
+          {
+            case impl::S_id:
+              break;
+            case impl::LeftBracket_id:
+            case impl::RightBracket_id:
+              first = true;
+              writeSource(c, source);
+              break;
+            default:
+              if(!first)
+                SA::append(source, SA::construct_from_utf8(", "));
+              first = false;
+              writeSource(c, source);
+          } // switch
+        return;
+      }
+  } // switch
+
+  if(i->children.empty())
+    SA::append(source, SA::construct(i->value.begin(), i->value.end()));
+
+  long id = impl::getNodeId<string_adaptor>(i);
+  bool operands = (id == impl::UnaryExpr_id) || isBinaryExpression(id);
+  long previous = impl::Slash_id;
+  for(typename impl::types<string_adaptor>::node_iter_t c = i->children.begin(), ce = i->children.end(); c != ce; ++c)
+  {
+    long cid = impl::getNodeId<string_adaptor>(c);
+    // the parser drops the slashes between steps, and the brackets 
+    // around subexpressions
+    if((id == impl::RelativeLocationPath_id) && 
+       (previous != impl::Slash_id) && (previous != impl::SlashSlash_id) &&
+       (cid != impl::Slash_id) && (cid != impl::SlashSlash_id))
+      SA::append(source, SA::construct_from_utf8("/"));
+    previous = cid;
+
+    bool bracket = operands && isBinaryExpression(cid);
+    if(bracket)
+      SA::append(source, SA::construct_from_utf8("("));
+    writeSource(c, source);
+    if(bracket)
+      SA::append(source, SA::construct_from_utf8(")"));
+  } // for ...
+} // writeSource
+
+template<class string_type, class string_adaptor>
+bool XPath<string_type, string_adaptor>::isBinaryExpression(long id)
+{
+  switch(id)
+  {
+    case impl::OrExpr_id:
+    case impl::AndExpr_id:
+    case impl::EqualityExpr_id:
+    case impl::RelationalExpr_id:
+    case impl::AdditiveExpr_id:
+    case impl::MultiplicativeExpr_id:
+    case impl::UnionExpr_id:
+      return true;
+  } // switch
+  return false;
+} // isBinaryExpression
+
 template<class string_type, class string_adaptor>
 XPathExpression_impl<string_type, string_adaptor>* XPath<string_type, string_adaptor>::createLiteral(typename impl::types<string_adaptor>::node_iter_t const& i, typename impl::types<string_adaptor>::node_iter_t const& /* ie */, impl::CompilationContext<string_type, string_adaptor>& /* context */)
 {
@@ -689,8 +1114,7 @@ XPathExpression_impl<string_type, string_adaptor>* XPath<string_type, string_ada
 template<class string_type, class string_adaptor>
 XPathExpression_impl<string_type, string_adaptor>* XPath<string_type, string_adaptor>::createNumber(typename impl::types<string_adaptor>::node_iter_t const& i, typename impl::types<string_adaptor>::node_iter_t const& /* ie */, impl::CompilationContext<string_type, string_adaptor>& /* context */)
 {
-  string_type str = string_adaptor::construct(i->value.begin(), i->value.end());
-  return new NumericValue<string_type, string_adaptor>(boost::lexical_cast<double>(str));
+  return new NumericValue<string_type, string_adaptor>(impl::parseNumber(i->value.begin(), i->value.end()));
 } // createNumber
 
 template<class string_type, class string_adaptor>
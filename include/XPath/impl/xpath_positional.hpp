@@ -0,0 +1,234 @@
+#ifndef ARABICA_XPATHIC_XPATH_POSITIONAL_HPP
+#define ARABICA_XPATHIC_XPATH_POSITIONAL_HPP
+
+///////////////////////////////////////////////////////////////////////
+//
+// A predicate which selects nodes by their position alone -
+//    item[1]   item[last()]   item[position() < 4]
+//    item[position() > 2 and position() <= 5]
+// - doesn't need evaluating for every node it filters.  They're spotted
+// as the step is compiled and wrapped in a PositionalPredicate, which
+// knows the window of positions it selects.  A step can then count its
+// way along the axis and stop as soon as it has passed the window, and
+// can find the last() node by walking a sibling axis from the far end.
+//
+// Evaluated as an ordinary expression, a PositionalPredicate is just the
+// predicate it wraps.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include "xpath_object.hpp"
+#include "xpath_expression.hpp"
+#include "xpath_value.hpp"
+#include "xpath_relational.hpp"
+#include "xpath_logical.hpp"
+#include "xpath_function_holder.hpp"
+
+namespace Arabica
+{
+namespace XPath
+{
+namespace impl
+{
+
+template<class string_type, class string_adaptor>
+class PositionalPredicate : public UnaryExpression<string_type, string_adaptor>
+{
+  typedef UnaryExpression<string_type, string_adaptor> baseT;
+public:
+  static const unsigned long Unbounded = ULONG_MAX;
+
+  virtual ValueType type() const { return baseT::expr()->type(); }
+
+  virtual XPathValue<string_type, string_adaptor> evaluate(const DOM::Node<string_type, string_adaptor>& context,
+                                                           const ExecutionContext<string_type, string_adaptor>& executionContext) const
+  {
+    return baseT::expr()->evaluate(context, executionContext);
+  } // evaluate
+
+  // true for [last()], in which case from() and to() are meaningless
+  bool selectsLast() const { return last_; }
+  // otherwise, the positions selected, inclusive - to() is Unbounded if
+  // there's no upper limit, and less than from() if nothing is selected
+  unsigned long from() const { return from_; }
+  unsigned long to() const { return to_; }
+
+  // the nodes this predicate keeps, nodes being in axis order
+  NodeSet<string_type, string_adaptor> select(const NodeSet<string_type, string_adaptor>& nodes) const
+  {
+    NodeSet<string_type, string_adaptor> results(nodes.forward());
+    if(last_)
+    {
+      if(!nodes.empty())
+        results.push_back(nodes[nodes.size() - 1]);
+      return results;
+    } // if ...
+
+    for(unsigned long position = from_; (position <= to_) && (position <= nodes.size()); ++position)
+      results.push_back(nodes[position - 1]);
+    return results;
+  } // select
+
+  // Returns predicate wrapped in a PositionalPredicate if it selects
+  // by position alone, otherwise returns it unchanged.
+  static XPathExpression_impl<string_type, string_adaptor>* classify(XPathExpression_impl<string_type, string_adaptor>* predicate)
+  {
+    if(isFunction(predicate, FN_LAST) || isPositionEqualsLast(predicate))
+      return new PositionalPredicate(predicate);
+
+    double from, to;
+    if(!window(predicate, from, to))
+      return predicate;
+    return new PositionalPredicate(predicate, from, to);
+  } // classify
+
+private:
+  typedef XPathExpression_impl<string_type, string_adaptor> Expression;
+  typedef BinaryExpression<string_type, string_adaptor> Binary;
+
+  // [last()] or [position() = last()]
+  PositionalPredicate(Expression* expr) :
+      baseT(expr),
+      last_(true),
+      from_(0),
+      to_(0)
+  {
+  } // PositionalPredicate
+
+  PositionalPredicate(Expression* expr, double from, double to) :
+      baseT(expr),
+      last_(false),
+      from_(1),
+      to_(0)
+  {
+    if(isNaN(from) || isNaN(to) || (from > to) || (to < 1) || (from >= Unbounded))
+      return;
+    from_ = static_cast<unsigned long>(std::max(from, 1.0));
+    to_ = (to >= Unbounded) ? Unbounded : static_cast<unsigned long>(to);
+  } // PositionalPredicate
+
+  // Works out the window of positions expr selects, as doubles so the
+  // infinities and NaN come out in the wash.  False if expr depends on
+  // anything but position.
+  static bool window(const Expression* expr, double& from, double& to)
+  {
+    // a number is position() = n only when it is the whole predicate
+    const NumericValue<string_type, string_adaptor>* number = dynamic_cast<const NumericValue<string_type, string_adaptor>*>(expr);
+    if(number != 0)
+    {
+      double n = number->asNumber();
+      from = to = (n == std::floor(n)) ? n : NaN;
+      return true;
+    } // if ...
+
+    return range(expr, from, to);
+  } // window
+
+  // position() compared with a number, or an and of such comparisons.  A
+  // number anywhere else is a boolean, so is left to ordinary evaluation.
+  static bool range(const Expression* expr, double& from, double& to)
+  {
+    const Binary* comparison = dynamic_cast<const Binary*>(expr);
+    if(comparison == 0)
+      return false;
+
+    if(dynamic_cast<const AndOperator<string_type, string_adaptor>*>(expr))
+    {
+      double lfrom, lto, rfrom, rto;
+      if(!range(comparison->lhs(), lfrom, lto) || !range(comparison->rhs(), rfrom, rto))
+        return false;
+      from = std::max(lfrom, rfrom);
+      to = std::min(lto, rto);
+      if(isNaN(lfrom) || isNaN(rfrom))
+        from = NaN;
+      return true;
+    } // if ...
+
+    // position() op n, or n op position() which is turned round
+    bool flipped = false;
+    const Expression* operand = comparison->rhs();
+    if(!isFunction(comparison->lhs(), FN_POSITION))
+    {
+      if(!isFunction(comparison->rhs(), FN_POSITION))
+        return false;
+      flipped = true;
+      operand = comparison->lhs();
+    } // if ...
+
+    const NumericValue<string_type, string_adaptor>* limit = dynamic_cast<const NumericValue<string_type, string_adaptor>*>(operand);
+    if(limit == 0)
+      return false;
+    double n = limit->asNumber();
+
+    from = 1;
+    to = Infinity;
+    if(dynamic_cast<const EqualsOperator<string_type, string_adaptor>*>(expr))
+      from = to = (n == std::floor(n)) ? n : NaN;
+    else if(isComparison<LessThanOperator<string_type, string_adaptor>,
+                         GreaterThanOperator<string_type, string_adaptor> >(expr, flipped))
+      to = std::ceil(n) - 1;
+    else if(isComparison<LessThanEqualsOperator<string_type, string_adaptor>,
+                         GreaterThanEqualsOperator<string_type, string_adaptor> >(expr, flipped))
+      to = std::floor(n);
+    else if(isComparison<GreaterThanOperator<string_type, string_adaptor>,
+                         LessThanOperator<string_type, string_adaptor> >(expr, flipped))
+      from = std::floor(n) + 1;
+    else if(isComparison<GreaterThanEqualsOperator<string_type, string_adaptor>,
+                         LessThanEqualsOperator<string_type, string_adaptor> >(expr, flipped))
+      from = std::ceil(n);
+    else
+      return false;
+
+    // NaN compares false with everything
+    if(isNaN(n))
+      from = NaN;
+    return true;
+  } // range
+
+  static bool isPositionEqualsLast(const Expression* expr)
+  {
+    if(dynamic_cast<const EqualsOperator<string_type, string_adaptor>*>(expr) == 0)
+      return false;
+    const Binary* equals = dynamic_cast<const Binary*>(expr);
+    return (isFunction(equals->lhs(), FN_POSITION) && isFunction(equals->rhs(), FN_LAST)) ||
+           (isFunction(equals->lhs(), FN_LAST) && isFunction(equals->rhs(), FN_POSITION));
+  } // isPositionEqualsLast
+
+  // true if expr is position() op n - or n reversed_op position(), when flipped
+  template<class op, class reversed_op>
+  static bool isComparison(const Expression* expr, bool flipped)
+  {
+    if(flipped)
+      return dynamic_cast<const reversed_op*>(expr) != 0;
+    return dynamic_cast<const op*>(expr) != 0;
+  } // isComparison
+
+  static bool isFunction(const Expression* expr, const string_type& name)
+  {
+    const FunctionHolder<string_type, string_adaptor>* fn = dynamic_cast<const FunctionHolder<string_type, string_adaptor>*>(expr);
+    return (fn != 0) && string_adaptor::empty(fn->namespace_uri()) && (fn->name() == name);
+  } // isFunction
+
+  bool last_;
+  unsigned long from_;
+  unsigned long to_;
+
+  static const string_type FN_POSITION;
+  static const string_type FN_LAST;
+}; // class PositionalPredicate
+
+template<class string_type, class string_adaptor>
+const unsigned long PositionalPredicate<string_type, string_adaptor>::Unbounded;
+template<class string_type, class string_adaptor>
+const string_type PositionalPredicate<string_type, string_adaptor>::FN_POSITION = string_adaptor::construct_from_utf8("position");
+template<class string_type, class string_adaptor>
+const string_type PositionalPredicate<string_type, string_adaptor>::FN_LAST = string_adaptor::construct_from_utf8("last");
+
+} // namespace impl
+} // namespace XPath
+} // namespace Arabica
+
+#endif
@@ -1,7 +1,9 @@
 #ifndef ARABICA_XPATHIC_XPATH_RELATIONAL_HPP
 #define ARABICA_XPATHIC_XPATH_RELATIONAL_HPP
 
+#include <functional>
 #include "xpath_value.hpp"
+#include "xpath_invariant.hpp"
 
 namespace Arabica
 {
@@ -10,118 +12,216 @@ namespace XPath
 namespace impl
 {
 
-template<class string_type, class string_adaptor>
-class EqualsOperator : public BinaryExpression<string_type, string_adaptor>
+// Evaluates both operands and compares them with Policy.  An operand which
+// is an InvariantExpression comes from the cache, along with an index of
+// its value once it's been compared often enough to be worth building.
+template<class string_type, class string_adaptor, class Policy>
+class ComparisonOperator : public BinaryExpression<string_type, string_adaptor>
 {
   typedef BinaryExpression<string_type, string_adaptor> baseT;
+  typedef InvariantExpression<string_type, string_adaptor> InvariantT;
+  typedef NodeSetIndex<string_type, string_adaptor> IndexT;
 public:
-  EqualsOperator(XPathExpression_impl<string_type, string_adaptor>* lhs,   
-                 XPathExpression_impl<string_type, string_adaptor>* rhs) :
-       BinaryExpression<string_type, string_adaptor>(lhs, rhs) { }
+  ComparisonOperator(XPathExpression_impl<string_type, string_adaptor>* lhs, 
+                     XPathExpression_impl<string_type, string_adaptor>* rhs) :
+      BinaryExpression<string_type, string_adaptor>(lhs, rhs),
+      lhsInvariant_(dynamic_cast<const InvariantT*>(lhs)),
+      rhsInvariant_(dynamic_cast<const InvariantT*>(rhs))
+  { 
+  } // ComparisonOperator
 
   virtual ValueType type() const { return BOOL; }
 
   virtual XPathValue<string_type, string_adaptor> evaluate(const DOM::Node<string_type, string_adaptor>& context, 
                                               const ExecutionContext<string_type, string_adaptor>& executionContext) const
   {
-    return BoolValue<string_type, string_adaptor>::createValue(areEqual<string_type, string_adaptor>(baseT::lhs()->evaluate(context, executionContext),
-                                           baseT::rhs()->evaluate(context, executionContext)));
+    return BoolValue<string_type, string_adaptor>::createValue(evaluateAsBool(context, executionContext));
   } // evaluate
+
+  virtual bool evaluateAsBool(const DOM::Node<string_type, string_adaptor>& context, 
+                              const ExecutionContext<string_type, string_adaptor>& executionContext) const
+  {
+    const IndexT* lindex = 0;
+    const IndexT* rindex = 0;
+    XPathValue<string_type, string_adaptor> lhs = operand(baseT::lhs(), lhsInvariant_, context, executionContext, lindex);
+    XPathValue<string_type, string_adaptor> rhs = operand(baseT::rhs(), rhsInvariant_, context, executionContext, rindex);
+
+    if((lindex != 0) || (rindex != 0))
+      return Policy::compare(lhs, lindex, rhs, rindex);
+    return Policy::compare(lhs, rhs);
+  } // evaluateAsBool
+
+private:
+  static XPathValue<string_type, string_adaptor> operand(const XPathExpression_impl<string_type, string_adaptor>* expr,
+                                                         const InvariantT* invariant,
+                                                         const DOM::Node<string_type, string_adaptor>& context, 
+                                                         const ExecutionContext<string_type, string_adaptor>& executionContext,
+                                                         const IndexT*& index)
+  {
+    if(invariant != 0)
+    {
+      typename InvariantT::Entry* entry = invariant->entry(context, executionContext);
+      if(entry != 0)
+      {
+        index = entry->index();
+        return entry->value();
+      } // if ...
+    } // if ...
+    return expr->evaluate(context, executionContext);
+  } // operand
+
+  const InvariantT* lhsInvariant_;
+  const InvariantT* rhsInvariant_;
+}; // class ComparisonOperator
+
+template<class string_type, class string_adaptor>
+struct EqualsPolicy
+{
+  static bool compare(const XPathValue<string_type, string_adaptor>& lhs, const XPathValue<string_type, string_adaptor>& rhs)
+  {
+    return areEqual<string_type, string_adaptor>(lhs, rhs);
+  } // compare
+
+  static bool compare(const XPathValue<string_type, string_adaptor>& lhs, const NodeSetIndex<string_type, string_adaptor>* lindex,
+                      const XPathValue<string_type, string_adaptor>& rhs, const NodeSetIndex<string_type, string_adaptor>* rindex)
+  {
+    return (lindex != 0) ? lindex->equals(rhs) : rindex->equals(lhs);
+  } // compare
+}; // struct EqualsPolicy
+
+template<class string_type, class string_adaptor>
+struct NotEqualsPolicy
+{
+  static bool compare(const XPathValue<string_type, string_adaptor>& lhs, const XPathValue<string_type, string_adaptor>& rhs)
+  {
+    return areNotEqual<string_type, string_adaptor>(lhs, rhs);
+  } // compare
+
+  static bool compare(const XPathValue<string_type, string_adaptor>& lhs, const NodeSetIndex<string_type, string_adaptor>* lindex,
+                      const XPathValue<string_type, string_adaptor>& rhs, const NodeSetIndex<string_type, string_adaptor>* rindex)
+  {
+    return (lindex != 0) ? lindex->notEquals(rhs) : rindex->notEquals(lhs);
+  } // compare
+}; // struct NotEqualsPolicy
+
+// lhs < rhs, or lhs <= rhs, when at least one side is an indexed node-set.
+// As in compareNodeSets, only the smallest number on the left and the 
+// largest on the right matter, and the index already knows those.
+template<class Op, class string_type, class string_adaptor>
+bool indexedLessThan(const XPathValue<string_type, string_adaptor>& lhs, const NodeSetIndex<string_type, string_adaptor>* lindex,
+                     const XPathValue<string_type, string_adaptor>& rhs, const NodeSetIndex<string_type, string_adaptor>* rindex)
+{
+  double l = (lindex != 0) ? lindex->minNumber() :
+             (lhs.type() == NODE_SET) ? minValue<string_type, string_adaptor>(lhs.asNodeSet()) :
+             lhs.asNumber();
+  double r = (rindex != 0) ? rindex->maxNumber() :
+             (rhs.type() == NODE_SET) ? maxValue<string_type, string_adaptor>(rhs.asNodeSet()) :
+             rhs.asNumber();
+  return Op()(l, r);
+} // indexedLessThan
+
+template<class string_type, class string_adaptor>
+struct LessThanPolicy
+{
+  static bool compare(const XPathValue<string_type, string_adaptor>& lhs, const XPathValue<string_type, string_adaptor>& rhs)
+  {
+    return isLessThan<string_type, string_adaptor>(lhs, rhs);
+  } // compare
+
+  static bool compare(const XPathValue<string_type, string_adaptor>& lhs, const NodeSetIndex<string_type, string_adaptor>* lindex,
+                      const XPathValue<string_type, string_adaptor>& rhs, const NodeSetIndex<string_type, string_adaptor>* rindex)
+  {
+    return indexedLessThan<std::less<double>, string_type, string_adaptor>(lhs, lindex, rhs, rindex);
+  } // compare
+}; // struct LessThanPolicy
+
+template<class string_type, class string_adaptor>
+struct LessThanEqualsPolicy
+{
+  static bool compare(const XPathValue<string_type, string_adaptor>& lhs, const XPathValue<string_type, string_adaptor>& rhs)
+  {
+    return isLessThanEquals<string_type, string_adaptor>(lhs, rhs);
+  } // compare
+
+  static bool compare(const XPathValue<string_type, string_adaptor>& lhs, const NodeSetIndex<string_type, string_adaptor>* lindex,
+                      const XPathValue<string_type, string_adaptor>& rhs, const NodeSetIndex<string_type, string_adaptor>* rindex)
+  {
+    return indexedLessThan<std::less_equal<double>, string_type, string_adaptor>(lhs, lindex, rhs, rindex);
+  } // compare
+}; // struct LessThanEqualsPolicy
+
+// a > b is b < a, and a >= b is b <= a
+template<class string_type, class string_adaptor, class LessPolicy>
+struct SwappedPolicy
+{
+  static bool compare(const XPathValue<string_type, string_adaptor>& lhs, const XPathValue<string_type, string_adaptor>& rhs)
+  {
+    return LessPolicy::compare(rhs, lhs);
+  } // compare
+
+  static bool compare(const XPathValue<string_type, string_adaptor>& lhs, const NodeSetIndex<string_type, string_adaptor>* lindex,
+                      const XPathValue<string_type, string_adaptor>& rhs, const NodeSetIndex<string_type, string_adaptor>* rindex)
+  {
+    return LessPolicy::compare(rhs, rindex, lhs, lindex);
+  } // compare
+}; // struct SwappedPolicy
+
+template<class string_type, class string_adaptor>
+class EqualsOperator : public ComparisonOperator<string_type, string_adaptor, EqualsPolicy<string_type, string_adaptor> >
+{
+public:
+  EqualsOperator(XPathExpression_impl<string_type, string_adaptor>* lhs,   
+                 XPathExpression_impl<string_type, string_adaptor>* rhs) :
+      ComparisonOperator<string_type, string_adaptor, EqualsPolicy<string_type, string_adaptor> >(lhs, rhs) { }
 }; // class EqualsOperator
 
 template<class string_type, class string_adaptor>
-class NotEqualsOperator : public BinaryExpression<string_type, string_adaptor>
+class NotEqualsOperator : public ComparisonOperator<string_type, string_adaptor, NotEqualsPolicy<string_type, string_adaptor> >
 {
-  typedef BinaryExpression<string_type, string_adaptor> baseT;
 public:
   NotEqualsOperator(XPathExpression_impl<string_type, string_adaptor>* lhs, 
                     XPathExpression_impl<string_type, string_adaptor>* rhs) :
-       BinaryExpression<string_type, string_adaptor>(lhs, rhs) { }
-
-  virtual ValueType type() const { return BOOL; }
-
-  virtual XPathValue<string_type, string_adaptor> evaluate(const DOM::Node<string_type, string_adaptor>& context, 
-                                              const ExecutionContext<string_type, string_adaptor>& executionContext) const
-  {
-    return BoolValue<string_type, string_adaptor>::createValue(areNotEqual<string_type, string_adaptor>(baseT::lhs()->evaluate(context, executionContext),
-                                            baseT::rhs()->evaluate(context, executionContext)));
-  } // evaluate
+      ComparisonOperator<string_type, string_adaptor, NotEqualsPolicy<string_type, string_adaptor> >(lhs, rhs) { }
 }; // class NotEqualsOperator
 
 template<class string_type, class string_adaptor>
-class LessThanOperator : public BinaryExpression<string_type, string_adaptor>
+class LessThanOperator : public ComparisonOperator<string_type, string_adaptor, LessThanPolicy<string_type, string_adaptor> >
 {
-  typedef BinaryExpression<string_type, string_adaptor> baseT;
 public:
   LessThanOperator(XPathExpression_impl<string_type, string_adaptor>* lhs, 
                    XPathExpression_impl<string_type, string_adaptor>* rhs) :
-      BinaryExpression<string_type, string_adaptor>(lhs, rhs) { }
-
-  virtual ValueType type() const { return BOOL; }
-
-  virtual XPathValue<string_type, string_adaptor> evaluate(const DOM::Node<string_type, string_adaptor>& context, 
-                                              const ExecutionContext<string_type, string_adaptor>& executionContext) const
-  {
-    return BoolValue<string_type, string_adaptor>::createValue(isLessThan<string_type, string_adaptor>(baseT::lhs()->evaluate(context, executionContext),
-                                             baseT::rhs()->evaluate(context, executionContext)));
-  } // evaluate
+      ComparisonOperator<string_type, string_adaptor, LessThanPolicy<string_type, string_adaptor> >(lhs, rhs) { }
 }; // class LessThanOperator
 
 template<class string_type, class string_adaptor>
-class LessThanEqualsOperator : public BinaryExpression<string_type, string_adaptor>
+class LessThanEqualsOperator : public ComparisonOperator<string_type, string_adaptor, LessThanEqualsPolicy<string_type, string_adaptor> >
 {
-  typedef BinaryExpression<string_type, string_adaptor> baseT;
 public:
   LessThanEqualsOperator(XPathExpression_impl<string_type, string_adaptor>* lhs, 
                          XPathExpression_impl<string_type, string_adaptor>* rhs) :
-      BinaryExpression<string_type, string_adaptor>(lhs, rhs) { }
-
-  virtual ValueType type() const { return BOOL; }
-
-  virtual XPathValue<string_type, string_adaptor> evaluate(const DOM::Node<string_type, string_adaptor>& context, 
-                                              const ExecutionContext<string_type, string_adaptor>& executionContext) const
-  {
-    return BoolValue<string_type, string_adaptor>::createValue(isLessThanEquals<string_type, string_adaptor>(baseT::lhs()->evaluate(context, executionContext),
-                                                   baseT::rhs()->evaluate(context, executionContext)));
-  } // evaluate
+      ComparisonOperator<string_type, string_adaptor, LessThanEqualsPolicy<string_type, string_adaptor> >(lhs, rhs) { }
 }; // class LessThanEqualsOperator
 
 template<class string_type, class string_adaptor>
-class GreaterThanOperator : public BinaryExpression<string_type, string_adaptor>
+class GreaterThanOperator : public ComparisonOperator<string_type, string_adaptor, 
+                                                      SwappedPolicy<string_type, string_adaptor, LessThanPolicy<string_type, string_adaptor> > >
 {
-  typedef BinaryExpression<string_type, string_adaptor> baseT;
 public:
   GreaterThanOperator(XPathExpression_impl<string_type, string_adaptor>* lhs, 
                       XPathExpression_impl<string_type, string_adaptor>* rhs) :
-      BinaryExpression<string_type, string_adaptor>(lhs, rhs) { }
-
-  virtual ValueType type() const { return BOOL; }
-
-  virtual XPathValue<string_type, string_adaptor> evaluate(const DOM::Node<string_type, string_adaptor>& context, 
-                                              const ExecutionContext<string_type, string_adaptor>& executionContext) const
-  {
-    return BoolValue<string_type, string_adaptor>::createValue(isGreaterThan<string_type, string_adaptor>(baseT::lhs()->evaluate(context, executionContext),
-                                                baseT::rhs()->evaluate(context, executionContext)));
-  } // evaluate
+      ComparisonOperator<string_type, string_adaptor, 
+                         SwappedPolicy<string_type, string_adaptor, LessThanPolicy<string_type, string_adaptor> > >(lhs, rhs) { }
 }; // class GreaterThanOperator
 
 template<class string_type, class string_adaptor>
-class GreaterThanEqualsOperator : public BinaryExpression<string_type, string_adaptor>
+class GreaterThanEqualsOperator : public ComparisonOperator<string_type, string_adaptor, 
+                                                            SwappedPolicy<string_type, string_adaptor, LessThanEqualsPolicy<string_type, string_adaptor> > >
 {
-  typedef BinaryExpression<string_type, string_adaptor> baseT;
 public:
   GreaterThanEqualsOperator(XPathExpression_impl<string_type, string_adaptor>* lhs, 
                             XPathExpression_impl<string_type, string_adaptor>* rhs) :
-      BinaryExpression<string_type, string_adaptor>(lhs, rhs) { }
-
-  virtual ValueType type() const { return BOOL; }
-
-  virtual XPathValue<string_type, string_adaptor> evaluate(const DOM::Node<string_type, string_adaptor>& context, 
-                                              const ExecutionContext<string_type, string_adaptor>& executionContext) const
-  {
-    return BoolValue<string_type, string_adaptor>::createValue(isGreaterThanEquals<string_type, string_adaptor>(baseT::lhs()->evaluate(context, executionContext),
-                                                      baseT::rhs()->evaluate(context, executionContext)));
-  } // evaluate
+      ComparisonOperator<string_type, string_adaptor, 
+                         SwappedPolicy<string_type, string_adaptor, LessThanEqualsPolicy<string_type, string_adaptor> > >(lhs, rhs) { }
 }; // class GreaterThanEqualsOperator
 
 } // namespace impl
@@ -11,6 +11,7 @@
 #include "xpath_ast_ids.hpp"
 #include "xpath_namespace_context.hpp"
 #include "xpath_compile_context.hpp"
+#include "xpath_positional.hpp"
 
 namespace Arabica
 {
@@ -45,19 +46,34 @@ public:
   bool has_predicates() const { return !predicates_.empty(); }
 
 protected:
-  NodeSet<string_type, string_adaptor> applyPredicates(NodeSet<string_type, string_adaptor>& nodes, const ExecutionContext<string_type, string_adaptor>& parentContext) const
+  // applies the predicates from the skip'th on
+  NodeSet<string_type, string_adaptor> applyPredicates(NodeSet<string_type, string_adaptor>& nodes, 
+                                                       const ExecutionContext<string_type, string_adaptor>& parentContext,
+                                                       size_t skip = 0) const
   {
-    for(typename std::vector<XPathExpression_impl<string_type, string_adaptor>*>::const_iterator p = predicates_.begin(), e = predicates_.end();
+    for(typename std::vector<XPathExpression_impl<string_type, string_adaptor>*>::const_iterator p = predicates_.begin() + skip, e = predicates_.end();
         (p != e) && (!nodes.empty()); ++p)
       nodes = applyPredicate(nodes, *p, parentContext);
     return nodes;
   } // applyPredicates
 
+  // the first predicate, if it selects by position alone, otherwise 0
+  const PositionalPredicate<string_type, string_adaptor>* leadingPositional() const
+  {
+    if(predicates_.empty())
+      return 0;
+    return dynamic_cast<const PositionalPredicate<string_type, string_adaptor>*>(predicates_.front());
+  } // leadingPositional
+
 private:
   NodeSet<string_type, string_adaptor> applyPredicate(NodeSet<string_type, string_adaptor>& nodes, 
                                       XPathExpression_impl<string_type, string_adaptor>* predicate, 
                                       const ExecutionContext<string_type, string_adaptor>& parentContext) const
   {
+    const PositionalPredicate<string_type, string_adaptor>* positional = dynamic_cast<const PositionalPredicate<string_type, string_adaptor>*>(predicate);
+    if(positional != 0)
+      return positional->select(nodes);
+
     ExecutionContext<string_type, string_adaptor> executionContext(nodes.size(), parentContext);
     NodeSet<string_type, string_adaptor> results(nodes.forward());
     unsigned int position = 1;
@@ -134,6 +150,13 @@ private:
                      NodeSet<string_type, string_adaptor>& results, 
                      const ExecutionContext<string_type, string_adaptor>& parentContext) const
   {
+    const PositionalPredicate<string_type, string_adaptor>* positional = baseT::leadingPositional();
+    if(positional != 0)
+    {
+      enumeratePositions(context, *positional, results, parentContext);
+      return;
+    } // if ...
+
     AxisEnumerator<string_type, string_adaptor> enumerator(context, axis_);
     results.forward(enumerator.forward());
     NodeSet<string_type, string_adaptor> intermediate(enumerator.forward());
@@ -155,6 +178,58 @@ private:
     results.insert(results.end(), intermediate.begin(), intermediate.end());
   } // enumerateOver
 
+  // Picks out the nodes selected by a leading positional predicate as the
+  // axis is walked, stopping once past them, then applies the rest.
+  void enumeratePositions(const DOM::Node<string_type, string_adaptor>& context, 
+                          const PositionalPredicate<string_type, string_adaptor>& positional,
+                          NodeSet<string_type, string_adaptor>& results, 
+                          const ExecutionContext<string_type, string_adaptor>& parentContext) const
+  {
+    NodeSet<string_type, string_adaptor> intermediate;
+    if(positional.selectsLast() && AxisEnumerator<string_type, string_adaptor>::reversible(axis_))
+    {
+      // the first match walking backwards - the results still run in
+      // the axis's own direction
+      AxisEnumerator<string_type, string_adaptor> enumerator(context, axis_, true);
+      results.forward(enumerator.reverse());
+      intermediate.forward(enumerator.reverse());
+      for( ; *enumerator != 0; ++enumerator)
+        if((*test_)(*enumerator))
+        {
+          intermediate.push_back(*enumerator);
+          break;
+        } // if ...
+    }
+    else
+    {
+      AxisEnumerator<string_type, string_adaptor> enumerator(context, axis_);
+      results.forward(enumerator.forward());
+      intermediate.forward(enumerator.forward());
+      DOM::Node<string_type, string_adaptor> last;
+      unsigned long position = 0;
+      for( ; *enumerator != 0; ++enumerator)
+      {
+        DOM::Node<string_type, string_adaptor> node = *enumerator;
+        if(!(*test_)(node))
+          continue;
+        if(positional.selectsLast())
+        {
+          last = node;
+          continue;
+        } // if ...
+        if(++position > positional.to())
+          break;
+        if(position >= positional.from())
+          intermediate.push_back(node);
+      } // for ...
+      if(last != 0)
+        intermediate.push_back(last);
+    } // if ...
+
+    intermediate = baseT::applyPredicates(intermediate, parentContext, 1);
+    results.insert(results.end(), intermediate.begin(), intermediate.end());
+  } // enumeratePositions
+
   Axis axis_;
   NodeTest<string_type, string_adaptor>* test_;
 
@@ -342,7 +417,14 @@ private:
       typename types<string_adaptor>::node_iter_t c = node->children.begin();
       assert(getNodeId<string_adaptor>(c) == impl::LeftSquare_id);
       ++c;
-      preds.push_back(XPath<string_type, string_adaptor>::compile_expression(c, node->children.end(), context));
+      // a predicate is evaluated for each node it filters, even inside
+      // an expression which is itself hoisted
+      Dependency enclosing = context.setEnclosing(DEPENDS_ON_CONTEXT);
+      context.enterPredicate();
+      preds.push_back(PositionalPredicate<string_type, string_adaptor>::classify(
+                        XPath<string_type, string_adaptor>::compile_expression(c, node->children.end(), context)));
+      context.leavePredicate();
+      context.setEnclosing(enclosing);
       ++c;
       assert(getNodeId<string_adaptor>(c) == impl::RightSquare_id);
       
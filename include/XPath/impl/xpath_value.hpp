@@ -106,13 +106,9 @@ public:
   virtual double asNumber() const { return value_; }
   virtual string_type asString() const
   {
-    if(isNaN(value_)) 
-      return string_adaptor::construct_from_utf8("NaN");
-    if(isInfinity(value_))
-      return string_adaptor::construct_from_utf8("Infinity");
-    if(isNegativeInfinity(value_))
-      return string_adaptor::construct_from_utf8("-Infinity");
-    return string_adaptor::construct_from_utf8(boost::lexical_cast<std::string>(value_).c_str());
+    char buffer[impl::NumberBufferSize];
+    impl::formatNumber(value_, buffer);
+    return string_adaptor::construct_from_utf8(buffer);
   } // asString
   virtual const NodeSet<string_type, string_adaptor>& asNodeSet() const { static NodeSet<string_type, string_adaptor> empty; return empty; }
 
@@ -0,0 +1,417 @@
+#ifndef ARABICA_XSLT_BATCH_TRANSFORMER_HPP
+#define ARABICA_XSLT_BATCH_TRANSFORMER_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdio>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <XSLT/XSLT.hpp>
+#include <SAX/helpers/CatchErrorHandler.hpp>
+
+namespace Arabica
+{
+namespace XSLT
+{
+
+/**
+Makes somewhere for the result of each transformation in a batch to go.
+
+open and close are called on the thread doing the transformation, so
+several sinks may be open at once.
+**/
+template<class string_type, class string_adaptor = Arabica::default_string_adaptor<string_type> >
+class SinkFactory
+{
+public:
+  virtual ~SinkFactory() { }
+
+  /**
+  A sink for the result of transforming systemId, the index'th input of
+  the batch.  Throw to give up on the document.
+  **/
+  virtual Sink<string_type, string_adaptor>* open(const string_type& systemId, size_t index) = 0;
+
+  /**
+  The transformation into sink is over, and succeeded says how it went.
+  **/
+  virtual void close(Sink<string_type, string_adaptor>* sink, bool /* succeeded */)
+  {
+    delete sink;
+  } // close
+}; // class SinkFactory
+
+/**
+Writes each result to a file in directory, named after its input, with
+the input's extension replaced by extension if one is given.  Inputs of
+the same name from different directories write over each other.  The
+output of a failed transformation is removed.
+**/
+template<class string_type, class string_adaptor = Arabica::default_string_adaptor<string_type> >
+class DirectorySinkFactory : public SinkFactory<string_type, string_adaptor>
+{
+public:
+  DirectorySinkFactory(const std::string& directory, const std::string& extension = std::string()) :
+    directory_(directory),
+    extension_(extension)
+  {
+  } // DirectorySinkFactory
+
+  virtual Sink<string_type, string_adaptor>* open(const string_type& systemId, size_t /* index */)
+  {
+    return new FileSink(path(string_adaptor::asStdString(systemId)));
+  } // open
+
+  virtual void close(Sink<string_type, string_adaptor>* sink, bool succeeded)
+  {
+    FileSink* file = static_cast<FileSink*>(sink);
+    std::string path = file->path();
+    delete file;
+    if(!succeeded)
+      std::remove(path.c_str());
+  } // close
+
+  std::string path(const std::string& systemId) const
+  {
+    std::string::size_type slash = systemId.find_last_of("/\\");
+    std::string name = systemId.substr((slash == std::string::npos) ? 0 : slash + 1);
+    if(!extension_.empty())
+    {
+      std::string::size_type dot = name.rfind('.');
+      if(dot != std::string::npos)
+        name.erase(dot);
+      name += extension_;
+    } // if ...
+    return directory_.empty() ? name : directory_ + '/' + name;
+  } // path
+
+private:
+  // the file has to be opened before, and closed after, the sink writing to it
+  struct File
+  {
+    File(const std::string& path) : path_(path), stream_(path.c_str()) { }
+
+    std::string path_;
+    std::basic_ofstream<typename string_adaptor::value_type> stream_;
+  }; // struct File
+
+  class FileSink : private File, public StreamSink<string_type, string_adaptor>
+  {
+  public:
+    FileSink(const std::string& path) :
+      File(path),
+      StreamSink<string_type, string_adaptor>(File::stream_)
+    {
+      if(!File::stream_)
+        throw std::runtime_error("Couldn't open " + path);
+    } // FileSink
+
+    const std::string& path() const { return File::path_; }
+  }; // class FileSink
+
+  const std::string directory_;
+  const std::string extension_;
+}; // class DirectorySinkFactory
+
+template<class string_type, class string_adaptor> class BatchTransformer;
+
+/**
+How a batch went.  A document's latency is the time from the start of
+its parse to the end of its transformation, in seconds.
+**/
+class BatchResults
+{
+public:
+  BatchResults() :
+    documents_(0),
+    failures_(0),
+    seconds_(0)
+  {
+  } // BatchResults
+
+  size_t documents() const { return documents_; }
+  size_t failures() const { return failures_; }
+
+  /**
+  Wall clock time for the whole batch.
+  **/
+  double seconds() const { return seconds_; }
+
+  /**
+  Documents a second.
+  **/
+  double throughput() const { return (seconds_ > 0) ? documents_ / seconds_ : 0; }
+
+  /**
+  The latency that the fraction p, from 0 to 1, of documents took no
+  longer than.
+  **/
+  double percentile(double p) const
+  {
+    if(latencies_.empty())
+      return 0;
+    size_t rank = static_cast<size_t>(p * (latencies_.size() - 1) + 0.5);
+    return latencies_[std::min(rank, latencies_.size() - 1)];
+  } // percentile
+
+  /**
+  Every document's latency, shortest first.
+  **/
+  const std::vector<double>& latencies() const { return latencies_; }
+
+private:
+  size_t documents_;
+  size_t failures_;
+  double seconds_;
+  std::vector<double> latencies_;
+
+  template<class string_type, class string_adaptor> friend class BatchTransformer;
+}; // class BatchResults
+
+/**
+Runs a stylesheet over many documents, on a pool of threads.
+
+The calling thread puts the inputs on a bounded queue, so they can be
+read lazily from anywhere an iterator can reach.  Each worker has a
+parser of its own, and takes one input at a time - parsing it, then
+transforming it into a sink from the SinkFactory.  Anything a
+transformation says, through xsl:message or by failing, is gathered up
+and written to the error output in one piece once the document is done.
+
+The stylesheet's parameters should be set before the batch starts, and
+not changed while it's running.
+**/
+template<class string_type, class string_adaptor = Arabica::default_string_adaptor<string_type> >
+class BatchTransformer
+{
+  typedef standard_stream<typename string_adaptor::value_type> streams;
+public:
+  typedef Stylesheet<string_type, string_adaptor> StylesheetT;
+  typedef SinkFactory<string_type, string_adaptor> SinkFactoryT;
+  typedef std::basic_ostream<typename string_adaptor::value_type> ostreamT;
+
+  BatchTransformer(const StylesheetT& stylesheet) :
+    stylesheet_(stylesheet),
+    threads_(0),
+    queue_size_(0),
+    error_output_(&streams::err())
+  {
+  } // BatchTransformer
+
+  /**
+  How many worker threads to run.  The default, 0, is one for each
+  hardware thread.
+  **/
+  void set_threads(unsigned int threads) { threads_ = threads; }
+
+  /**
+  How many inputs may be waiting for a worker.  The default, 0, is two
+  for each worker.
+  **/
+  void set_queue_size(size_t size) { queue_size_ = size; }
+
+  void set_error_output(ostreamT& os) { error_output_ = &os; }
+
+  /**
+  Transforms each of the systemIds from first to last.
+  **/
+  template<class InputIterator>
+  BatchResults transform(InputIterator first, InputIterator last, SinkFactoryT& sinks) const
+  {
+    unsigned int threads = threads_;
+    if(threads == 0)
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    WorkQueue queue(queue_size_ ? queue_size_ : threads * 2);
+    BatchResults results;
+    Tally tally(results);
+
+    Clock::time_point start = Clock::now();
+    std::vector<std::thread> workers;
+    for(unsigned int t = 0; t != threads; ++t)
+      workers.push_back(std::thread(&BatchTransformer::work, this, std::ref(queue), std::ref(sinks), std::ref(tally)));
+
+    size_t index = 0;
+    try
+    {
+      for( ; first != last; ++first, ++index)
+        queue.push(WorkItem(*first, index));
+    } // try
+    catch(...)
+    {
+      queue.close();
+      join(workers);
+      throw;
+    } // catch
+    queue.close();
+    join(workers);
+
+    results.documents_ = index;
+    results.seconds_ = seconds(start);
+    std::sort(results.latencies_.begin(), results.latencies_.end());
+    return results;
+  } // transform
+
+private:
+  typedef std::chrono::steady_clock Clock;
+  typedef SAX2DOM::Parser<string_type, string_adaptor> ParserT;
+  typedef SAX::CatchErrorHandler<string_type, string_adaptor> ErrorHandlerT;
+  typedef std::basic_ostringstream<typename string_adaptor::value_type> MessagesT;
+
+  struct WorkItem
+  {
+    WorkItem() : index(0) { }
+    WorkItem(const string_type& s, size_t i) : systemId(s), index(i) { }
+
+    string_type systemId;
+    size_t index;
+  }; // struct WorkItem
+
+  class WorkQueue
+  {
+  public:
+    WorkQueue(size_t capacity) :
+      capacity_(capacity),
+      closed_(false)
+    {
+    } // WorkQueue
+
+    void push(const WorkItem& item)
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while(items_.size() >= capacity_)
+        not_full_.wait(lock);
+      items_.push_back(item);
+      not_empty_.notify_one();
+    } // push
+
+    // false once the queue is closed and empty
+    bool pop(WorkItem& item)
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while(items_.empty() && !closed_)
+        not_empty_.wait(lock);
+      if(items_.empty())
+        return false;
+      item = items_.front();
+      items_.pop_front();
+      not_full_.notify_one();
+      return true;
+    } // pop
+
+    void close()
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+      not_empty_.notify_all();
+    } // close
+
+  private:
+    const size_t capacity_;
+    bool closed_;
+    std::deque<WorkItem> items_;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+  }; // class WorkQueue
+
+  // what the workers share - the results, and the error output
+  struct Tally
+  {
+    Tally(BatchResults& r) : results(r) { }
+
+    BatchResults& results;
+    std::mutex mutex;
+  }; // struct Tally
+
+  void work(WorkQueue& queue, SinkFactoryT& sinks, Tally& tally) const
+  {
+    ParserT parser;
+    ErrorHandlerT errors;
+    parser.setErrorHandler(errors);
+    parser.setTrusted(true);
+    StripSpaceFilter<string_type, string_adaptor> stripper(stylesheet_);
+    if(stylesheet_.strips_whitespace())
+      parser.setFilter(stripper);
+    MessagesT messages;
+    std::vector<double> latencies;
+    size_t failures = 0;
+
+    WorkItem item;
+    while(queue.pop(item))
+    {
+      Clock::time_point start = Clock::now();
+      if(!transform(item, parser, errors, sinks, messages))
+        ++failures;
+      latencies.push_back(seconds(start));
+
+      if(messages.tellp() > 0)
+      {
+        if(messages.str()[messages.str().length() - 1] != '\n')
+          messages << std::endl;
+        std::lock_guard<std::mutex> lock(tally.mutex);
+        *error_output_ << messages.str() << std::flush;
+        messages.str(std::basic_string<typename string_adaptor::value_type>());
+      } // if ...
+    } // while ...
+
+    std::lock_guard<std::mutex> lock(tally.mutex);
+    tally.results.failures_ += failures;
+    tally.results.latencies_.insert(tally.results.latencies_.end(), latencies.begin(), latencies.end());
+  } // work
+
+  bool transform(const WorkItem& item, ParserT& parser, ErrorHandlerT& errors, SinkFactoryT& sinks, MessagesT& messages) const
+  {
+    Sink<string_type, string_adaptor>* sink = 0;
+    bool succeeded = false;
+    try
+    {
+      errors.reset();
+      SAX::InputSource<string_type, string_adaptor> source(item.systemId);
+      parser.parse(source);
+      DOM::Document<string_type, string_adaptor> document = parser.getDocument();
+      if(errors.errorsReported() || (document == 0))
+        throw std::runtime_error(errors.errorsReported() ? errors.errors() : std::string("Could not parse"));
+
+      sink = sinks.open(item.systemId, item.index);
+      stylesheet_.execute(document, *sink, messages);
+      succeeded = true;
+    } // try
+    catch(const std::exception& ex)
+    {
+      messages << item.systemId << string_adaptor::construct_from_utf8(": ")
+               << string_adaptor::construct_from_utf8(ex.what()) << std::endl;
+    } // catch
+
+    if(sink != 0)
+      sinks.close(sink, succeeded);
+    return succeeded;
+  } // transform
+
+  static double seconds(Clock::time_point start)
+  {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+  } // seconds
+
+  static void join(std::vector<std::thread>& workers)
+  {
+    for(std::vector<std::thread>::iterator w = workers.begin(), we = workers.end(); w != we; ++w)
+      w->join();
+  } // join
+
+  const StylesheetT& stylesheet_;
+  unsigned int threads_;
+  size_t queue_size_;
+  ostreamT* error_output_;
+}; // class BatchTransformer
+
+} // namespace XSLT
+} // namespace Arabica
+
+#endif
@@ -47,6 +47,7 @@ public:
       if(attrs[SC::mode] != string_adaptor::empty_string())
         mode = context_.processInternalQName(attrs[SC::mode]).clarkName();
       applyTemplates_ = new ApplyTemplates<string_type, string_adaptor>(xpath, mode);
+      context_.describe(applyTemplates_, "select", select, attrs[SC::mode]);
 
       return;
     } // if(applyTemplates_ == 0)
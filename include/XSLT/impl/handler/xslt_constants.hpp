@@ -75,6 +75,7 @@ struct StylesheetConstant : public Arabica::text::Unicode<typename string_adapto
   static const string_type omit_xml_declaration;
   static const string_type standalone;
   static const string_type space;
+  static const string_type preserve;
   static const string_type media_type;
   static const string_type encoding;
   static const string_type doctype_public;
@@ -82,6 +83,7 @@ struct StylesheetConstant : public Arabica::text::Unicode<typename string_adapto
   static const string_type stylesheet_prefix;
   static const string_type result_prefix;
   static const string_type cdata_section_elements;
+  static const string_type elements;
   static const string_type use_attribute_sets;
   static const string_type test;
   static const string_type lang;
@@ -192,6 +194,7 @@ STYLESHEETCONSTANT(indent, "indent");
 STYLESHEETCONSTANT(omit_xml_declaration, "omit-xml-declaration");
 STYLESHEETCONSTANT(standalone, "standalone");
 STYLESHEETCONSTANT(space, "space");
+STYLESHEETCONSTANT(preserve, "preserve");
 STYLESHEETCONSTANT(media_type, "media-type");
 STYLESHEETCONSTANT(encoding, "encoding");
 STYLESHEETCONSTANT(doctype_public, "doctype-public");
@@ -199,6 +202,7 @@ STYLESHEETCONSTANT(doctype_system, "doctype-system");
 STYLESHEETCONSTANT(stylesheet_prefix, "stylesheet-prefix");
 STYLESHEETCONSTANT(result_prefix, "result-prefix");
 STYLESHEETCONSTANT(cdata_section_elements, "cdata-section-elements");
+STYLESHEETCONSTANT(elements, "elements");
 STYLESHEETCONSTANT(use_attribute_sets, "use-attribute-sets");
 STYLESHEETCONSTANT(test, "test");
 STYLESHEETCONSTANT(disable_output_escaping, "disable-output-escaping");
@@ -33,7 +33,9 @@ protected:
     static const AV rules = AV::rule(SC::select, true);
     string_type select = rules.gather(qName, atts)[SC::select];
 
-    return new ForEach<string_type, string_adaptor>(baseT::context().xpath_expression(select));
+    ForEach<string_type, string_adaptor>* forEach = new ForEach<string_type, string_adaptor>(baseT::context().xpath_expression(select));
+    baseT::context().describe(forEach, "select", select);
+    return forEach;
   } // createContainer
 
   virtual bool createChild(const string_type& namespaceURI,
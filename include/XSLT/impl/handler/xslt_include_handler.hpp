@@ -41,6 +41,11 @@ public:
     startElement(namespaceURI, localName, qName, atts);
   } // start_include
 
+  virtual void setDocumentLocator(const SAX::Locator<string_type, string_adaptor>& locator)
+  {
+    context_->set_locator(&locator);
+  } // setDocumentLocator
+
   virtual void startDocument()
   {
     context_->parentHandler().startDocument();
@@ -162,7 +167,9 @@ private:
     include_parser.setContentHandler(*this);
     include_parser.setErrorHandler(errorHandler);
     
+    const SAX::Locator<string_type, string_adaptor>* prevLocator = context_->set_locator(0);
     include_parser.parse(source);
+    context_->set_locator(prevLocator);
 
     context_->setBase(prev);
 
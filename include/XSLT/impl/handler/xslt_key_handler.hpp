@@ -42,6 +42,7 @@ public:
       Arabica::XPath::XPathExpression<string_type, string_adaptor> use = context_.xpath_expression_no_variables(attrs[SC::use]);
 
       key_ = new Key<string_type, string_adaptor>(matches, use);
+      context_.describe(key_, "name", attrs[SC::name]);
     } // try
     catch(const Arabica::XPath::UnboundVariableException&)
     {
@@ -51,6 +51,7 @@ public:
                        datatype, 
                        order,
                        caseorder);
+      context_.describe(sort_, "select", attr[SC::select]);
       return;
     } // if(sort_ == 0)
 
@@ -0,0 +1,100 @@
+#ifndef ARABICA_XSLT_STRIP_SPACE_HANDLER_HPP
+#define ARABICA_XSLT_STRIP_SPACE_HANDLER_HPP
+
+#include <XML/XMLCharacterClasses.hpp>
+#include <text/normalize_whitespace.hpp>
+
+#include "xslt_constants.hpp"
+
+namespace Arabica
+{
+namespace XSLT
+{
+
+// xsl:strip-space if strip, xsl:preserve-space if not
+template<class string_type, class string_adaptor, bool strip>
+class WhitespaceHandler : public SAX::DefaultHandler<string_type, string_adaptor>
+{
+  typedef StylesheetConstant<string_type, string_adaptor> SC;
+  typedef AttributeValidators<string_type, string_adaptor> AV;
+
+public:
+  WhitespaceHandler(CompilationContext<string_type, string_adaptor>& context) :
+    context_(context),
+    done_(false)
+  {
+  } // WhitespaceHandler
+
+  virtual void startElement(const string_type& /* namespaceURI */,
+                            const string_type& /* localName */,
+                            const string_type& qName,
+                            const SAX::Attributes<string_type, string_adaptor>& atts)
+  {
+    if(done_)
+      throw SAX::SAXException(string_adaptor::asStdString(qName) + " can not contain elements");
+    done_ = true;
+
+    static const AV rules = AV::rule(SC::elements, true);
+    std::map<string_type, string_type> attrs = rules.gather(qName, atts);
+
+    string_type elements = text::normalize_whitespace<string_type, string_adaptor>(attrs[SC::elements]);
+    if(string_adaptor::empty(elements))
+      return;
+
+    std::basic_stringstream<typename string_adaptor::value_type> is;
+    is << elements;
+    while(!is.eof())
+    {
+      std::basic_string<typename string_adaptor::value_type> e;
+      is >> e;
+      addNameTest(qName, string_adaptor::construct(e));
+    } // while
+  } // startElement
+
+  virtual void endElement(const string_type& /* namespaceURI */,
+                          const string_type& /* localName */,
+                          const string_type& /* qName */)
+  {
+    context_.pop();
+  } // endElement
+
+  virtual void characters(const string_type& ch)
+  {
+    verifyNoCharacterData<string_type, string_adaptor>(ch, strip ? SC::strip_space : SC::preserve_space);
+  } // characters
+
+private:
+  void addNameTest(const string_type& qName, const string_type& nameTest)
+  {
+    static const string_type asterisk = string_adaptor::construct_from_utf8("*");
+    static const string_type colon_asterisk = string_adaptor::construct_from_utf8(":*");
+
+    if(nameTest == asterisk)
+    {
+      context_.stylesheet().add_whitespace_rule(string_adaptor::empty_string(), asterisk, true, strip, context_.precedence());
+      return;
+    } // if ...
+
+    size_t length = string_adaptor::length(nameTest);
+    if(length > 2 && string_adaptor::substr(nameTest, length - 2) == colon_asterisk)
+    {
+      string_type prefix = string_adaptor::substr(nameTest, 0, length - 2);
+      std::map<string_type, string_type> namespaces = context_.inScopeNamespaces();
+      if(namespaces.find(prefix) == namespaces.end())
+        throw SAX::SAXException(string_adaptor::asStdString(qName) + " " + string_adaptor::asStdString(prefix) + " is not a declared namespace prefix");
+      context_.stylesheet().add_whitespace_rule(namespaces[prefix], asterisk, false, strip, context_.precedence());
+      return;
+    } // if ...
+
+    XML::QualifiedName<string_type, string_adaptor> name = context_.processInternalQName(nameTest);
+    context_.stylesheet().add_whitespace_rule(name.namespaceUri(), name.localName(), false, strip, context_.precedence());
+  } // addNameTest
+
+  CompilationContext<string_type, string_adaptor>& context_;
+  bool done_;
+}; // class WhitespaceHandler
+
+} // namespace XSLT
+} // namespace Arabica
+
+#endif
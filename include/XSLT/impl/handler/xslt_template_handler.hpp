@@ -75,17 +75,24 @@ protected:
     if(attributes[SC::mode] != string_adaptor::empty_string())
       mode = baseT::context().processInternalQName(attributes[SC::mode]).clarkName();
 
+    Template<string_type, string_adaptor>* t;
     if(match == string_adaptor::empty_string())
-      return new Template<string_type, string_adaptor>(name,
+      t = new Template<string_type, string_adaptor>(name,
+			  mode,
+			  priority,
+        baseT::context().precedence());
+    else
+      t = new Template<string_type, string_adaptor>(baseT::context().xpath_match(match),
+			  name,
 			  mode,
 			  priority,
         baseT::context().precedence());
 
-    return new Template<string_type, string_adaptor>(baseT::context().xpath_match(match),
-			name,
-			mode,
-			priority,
-      baseT::context().precedence());
+    if(match == string_adaptor::empty_string())
+      baseT::context().describe(t, "name", attributes[SC::name]);
+    else
+      baseT::context().describe(t, "match", match, attributes[SC::mode]);
+    return t;
   } // createContainer
 
   virtual bool createChild(const string_type& namespaceURI,
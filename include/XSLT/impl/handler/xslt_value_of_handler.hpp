@@ -34,6 +34,7 @@ public:
       std::map<string_type, string_type> attrs = rules.gather(qName, atts);
       valueOf_ = new ValueOf<string_type, string_adaptor>(context_.xpath_expression(attrs[SC::select]), 
 			                                               attrs[SC::disable_output_escaping] == SC::yes);
+      context_.describe(valueOf_, "select", attrs[SC::select]);
       return;
     } // if(valueOf_ == 0)
 
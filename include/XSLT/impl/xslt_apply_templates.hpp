@@ -28,12 +28,17 @@ public:
   virtual void execute(const DOM::Node<string_type, string_adaptor>& node, 
                        ExecutionContext<string_type, string_adaptor>& context) const
   {
+    ProfileFrame frame(context.profiler(), this, "apply-templates");
     ParamPasser<string_type, string_adaptor> passer(*this, node, context);
 
     if(!SortableT::has_sort() && select_ == 0)
     {
       if(node.hasChildNodes())
-        context.stylesheet().applyTemplates(node.getChildNodes(), context, mode_);
+      {
+        DOM::NodeList<string_type, string_adaptor> children = node.getChildNodes();
+        frame.nodes(children.getLength());
+        context.stylesheet().applyTemplates(children, context, mode_);
+      } // if ...
       return;
     }
 
@@ -48,6 +53,7 @@ public:
         throw std::runtime_error("apply-templates select expression is not a node-set");
       nodes = value.asNodeSet();
     }
+    frame.nodes(nodes.size());
     this->sort(node, nodes, context);
     context.stylesheet().applyTemplates(nodes, context, mode_);
   } // execute
@@ -9,6 +9,7 @@
 
 #include "xslt_stylesheet_parser.hpp"
 #include "xslt_functions.hpp"
+#include "xslt_profiler.hpp"
 
 namespace Arabica
 {
@@ -33,6 +34,7 @@ public:
   typedef SAX::DefaultHandler<string_type, string_adaptor> DefaultHandlerT;
   typedef SAX::ContentHandler<string_type, string_adaptor> ContentHandlerT;
   typedef SAX::Attributes<string_type, string_adaptor> AttributesT;
+  typedef SAX::Locator<string_type, string_adaptor> LocatorT;
   typedef Arabica::XPath::XPathExpressionPtr<string_type, string_adaptor> XPathExpressionPtrT;
   typedef Arabica::XPath::MatchExpr<string_type, string_adaptor> MatchExprT;
   typedef XML::QualifiedName<string_type, string_adaptor> QualifiedNameT;
@@ -42,6 +44,7 @@ public:
                      CompiledStylesheetT& stylesheet) :
     parser_(parser),
     stylesheet_(stylesheet),
+    locator_(0),
     autoNs_(1),
     current_allowed_(false),
     variables_allowed_(true),    
@@ -113,6 +116,40 @@ public:
     return parser_.currentBase();
   } // currentBase
 
+  /**
+  Where the stylesheet currently being parsed reports its position.  Returns
+  the previous locator, so an included stylesheet's can be swapped back out.
+  **/
+  const LocatorT* set_locator(const LocatorT* locator)
+  {
+    const LocatorT* prev = locator_;
+    locator_ = locator;
+    return prev;
+  } // set_locator
+
+  /**
+  Tells the stylesheet what the template or instruction site is, and where
+  it is, for the profiler - eg attribute "select" with value "para" is 
+  described as select="para".
+  **/
+  void describe(const void* site, 
+                const char* attribute, 
+                const string_type& value, 
+                const string_type& mode = string_type()) const
+  {
+    ProfileSite description;
+    description.description = std::string(attribute) + "=\"" + string_adaptor::asStdString(value) + '"';
+    description.mode = string_adaptor::asStdString(mode);
+    if(locator_ != 0)
+    {
+      description.systemId = string_adaptor::asStdString(locator_->getSystemId());
+      description.line = locator_->getLineNumber();
+    } // if ...
+    if(description.systemId.empty())
+      description.systemId = string_adaptor::asStdString(currentBase());
+    stylesheet_.describe(site, description);
+  } // describe
+
   void push(ItemContainer<string_type, string_adaptor>* parent,
             DefaultHandlerT* newHandler,
             const string_type& namespaceURI,
@@ -209,7 +246,7 @@ private:
 
     // document
     if(name == DocumentFunction<string_type, string_adaptor>::name())
-      return new DocumentFunction<string_type, string_adaptor>(parser_.currentBase(), argExprs);
+      return new DocumentFunction<string_type, string_adaptor>(parser_.currentBase(), stylesheet_, argExprs);
     // key
     if(name == KeyFunction<string_type, string_adaptor>::name())
       return new KeyFunction<string_type, string_adaptor>(stylesheet_.keys(), parser_.inScopeNamespaces(), argExprs);
@@ -269,6 +306,7 @@ private:
 
   StylesheetParser<string_type, string_adaptor>& parser_;
   CompiledStylesheetT& stylesheet_;
+  const LocatorT* locator_;
   mutable int autoNs_;
   mutable bool current_allowed_;
   mutable bool variables_allowed_;
@@ -4,12 +4,14 @@
 #include <vector>
 #include <iostream>
 #include <XPath/XPath.hpp>
+#include <Arabica/stats.hpp>
 
 #include "xslt_execution_context.hpp"
 #include "xslt_template.hpp"
 #include "xslt_top_level_param.hpp"
 #include "xslt_key.hpp"
 #include "xslt_stylesheet.hpp"
+#include "xslt_strip_space.hpp"
 
 namespace Arabica
 {
@@ -52,7 +54,8 @@ public:
 
   CompiledStylesheet() :
       output_(new StreamSink<string_type, string_adaptor>(streams::out())),
-      error_output_(&streams::err())
+      error_output_(&streams::err()),
+      profiler_(0)
   {
   } // CompiledStylesheet
 
@@ -94,15 +97,36 @@ public:
     error_output_ = &os;
   } // set_error_output
 
+  virtual void set_profiler(Profiler* profiler)
+  {
+    profiler_ = profiler;
+  } // set_profiler
+
+  Profiler* profiler() const { return profiler_; }
+
   virtual void execute(const DOMNode& initialNode) const
+  {
+    execute(initialNode, output_.get(), *error_output_);
+  } // execute
+
+  virtual void execute(const DOMNode& initialNode,
+                       Sink<string_type, string_adaptor>& output,
+                       std::basic_ostream<typename string_adaptor::value_type>& error_output) const
   {
     if(initialNode == 0)
       throw std::runtime_error("Input document is empty");
+    ARABICA_STATS_TIME(xslt_execute);
+
+    // taken out while the stylesheet runs, and put back afterwards
+    StrippedWhitespace<string_type, string_adaptor> stripped(whitespace_rules_, initialNode);
 
     NodeSet ns;
     ns.push_back(initialNode);
 
-    ExecutionContext<string_type, string_adaptor> context(*this, output_.get(), *error_output_);
+    if(profiler_)
+      profiler_->start(profile_sites_);
+    KeyIndexes<string_type, string_adaptor> keyIndexes(profiler_);
+    ExecutionContext<string_type, string_adaptor> context(*this, output, error_output);
 
     // set up variables and so forth
     for(ParamListIterator pi = params_.begin(), pe = params_.end(); pi != pe; ++pi)
@@ -112,11 +136,26 @@ public:
     context.freezeTopLevel();
 
     // go!
-    output_.get().asOutput().start_document(output_settings_, output_cdata_elements_);
+    output.asOutput().start_document(output_settings_, output_cdata_elements_);
     applyTemplates(ns, context, string_adaptor::empty_string());
-    output_.get().asOutput().end_document();
+    output.asOutput().end_document();
   } // execute
 
+  virtual bool strips_whitespace() const
+  {
+    return whitespace_rules_.strips();
+  } // strips_whitespace
+
+  virtual bool strips_whitespace(const string_type& namespaceURI, const string_type& localName) const
+  {
+    return whitespace_rules_.strips(namespaceURI, localName);
+  } // strips_whitespace
+
+  virtual void strip_whitespace(const DOMNode& node) const
+  {
+    whitespace_rules_.strip(node);
+  } // strip_whitespace
+
   ////////////////////////////////////////
   const DeclaredKeys<string_type, string_adaptor>& keys() const { return keys_; }
 
@@ -155,12 +194,30 @@ public:
     topLevelVars_.push_back(item);
   } // add_item
 
+  void add_whitespace_rule(const string_type& namespaceURI,
+                           const string_type& localName,
+                           bool anyNamespace,
+                           bool strip,
+                           const Precedence& precedence)
+  {
+    whitespace_rules_.add(namespaceURI, localName, anyNamespace, strip, precedence);
+  } // add_whitespace_rule
+
   void add_key(const string_type& name,
 	             Key<string_type, string_adaptor>* key)
   {
     keys_.add(name, key);
   } // add_key
 
+  /**
+  Notes down what and where site - a template or instruction - is, for
+  the profiler's report.
+  **/
+  void describe(const void* site, const ProfileSite& description)
+  {
+    profile_sites_[site] = description;
+  } // describe
+
   void output_settings(const typename Output<string_type, string_adaptor>::Settings& settings, 
                        const typename Output<string_type, string_adaptor>::CDATAElements& cdata_elements)
   {
@@ -228,7 +285,9 @@ public:
 
   void applyImports(const DOMNode& node, ExecutionContext<string_type, string_adaptor>& context) const
   {
-    doApplyTemplates(node, context, current_mode_, current_generation_);
+    const string_type mode = context.currentMode();
+    const Precedence generation = context.currentGeneration();
+    doApplyTemplates(node, context, mode, generation);
   } // applyImports
 
 private:
@@ -238,6 +297,7 @@ private:
                         const Precedence& generation) const
   {
     StackFrame<string_type, string_adaptor> frame(context);
+    ARABICA_STATS_COUNT(templates_applied);
 
     std::vector<Precedence> lower_precedences;
     for(TemplateStackIterator ts = templates_.begin(), tse = templates_.end(); ts != tse; ++ts)
@@ -245,24 +305,28 @@ private:
         lower_precedences.push_back(ts->first);
     std::sort(lower_precedences.rbegin(), lower_precedences.rend());
 
-    current_mode_ = mode;
+    context.setCurrentMode(mode);
 
     for(std::vector<Precedence>::const_iterator p = lower_precedences.begin(), pe = lower_precedences.end(); p != pe; ++p)
     { 
-      current_generation_ = *p;
-      ModeTemplates ts = templates_.find(current_generation_)->second;
+      context.setCurrentGeneration(*p);
+      ModeTemplates ts = templates_.find(*p)->second;
       ModeTemplatesIterator mt = ts.find(mode);
       if(mt != ts.end())
       {
         const MatchTemplates& templates = mt->second;
 	      for(MatchTemplatesIterator t = templates.begin(), te = templates.end(); t != te; ++t)
+	      {
+	        ARABICA_STATS_COUNT(template_match_tests);
 	        if(t->match().evaluate(node, context.xpathContext()))
 	        {
 	          t->action()->execute(node, context);
 	          return;
 	        } // if ...
+	      } // for ...
       } // if ...
     } // for ...
+    ARABICA_STATS_COUNT(builtin_templates);
     defaultAction(node, context, mode);
   } // doApplyTemplates
 
@@ -357,15 +421,16 @@ private:
   TemplateStack templates_;
   VariableDeclList topLevelVars_;
   DeclaredKeys<string_type, string_adaptor> keys_;
+  WhitespaceRules<string_type, string_adaptor> whitespace_rules_;
   ParamList params_;
 
-  mutable string_type current_mode_;
-  mutable Precedence current_generation_;
 
   typename Output<string_type, string_adaptor>::Settings output_settings_;
   typename Output<string_type, string_adaptor>::CDATAElements output_cdata_elements_;
   SinkHolder<string_type, string_adaptor> output_;
-  mutable std::basic_ostream<typename string_adaptor::value_type>* error_output_;
+  std::basic_ostream<typename string_adaptor::value_type>* error_output_;
+  Profiler* profiler_;
+  ProfileSites profile_sites_;
 }; // class CompiledStylesheet
 
 } // namespace XSLT
@@ -4,6 +4,7 @@
 #include <ostream>
 #include "xslt_sink.hpp"
 #include "xslt_variable_stack.hpp"
+#include "xslt_profiler.hpp"
 
 namespace Arabica
 {
@@ -44,7 +45,9 @@ public:
       stylesheet_(stylesheet),
       sink_(output.asOutput()),
       message_sink_(error_output),
-      to_msg_(0)
+      to_msg_(0),
+      currentRule_(&rule_),
+      profiler_(stylesheet.profiler())
   {
 		xpathContext_.setVariableResolver(stack_);
     sink_.set_warning_sink(message_sink_.asOutput());
@@ -57,7 +60,9 @@ public:
     stack_(rhs.stack_),
     sink_(output.asOutput()),
     message_sink_(rhs.message_sink_),
-    to_msg_(false)
+    to_msg_(false),
+    currentRule_(rhs.currentRule_),
+    profiler_(rhs.profiler_)
   {
 		xpathContext_.setVariableResolver(stack_);
     xpathContext_.setCurrentNode(rhs.xpathContext().currentNode());
@@ -76,6 +81,11 @@ public:
 
   const Arabica::XPath::ExecutionContext<string_type, string_adaptor>& xpathContext() const { return xpathContext_; }
 
+  /**
+  The profiler the transformation is being timed by, or 0 if it isn't.
+  **/
+  Profiler* profiler() const { return profiler_; }
+
   void topLevelParam(const DOM::Node<string_type, string_adaptor>& node, const Variable_declaration<string_type, string_adaptor>& param);
   string_type passParam(const DOM::Node<string_type, string_adaptor>& node, const Variable_declaration<string_type, string_adaptor>& param);
   void unpassParam(const string_type& name);
@@ -98,6 +108,17 @@ public:
     return old;
   } // setLast
 
+  /**
+  The mode and import precedence of the template rule most recently
+  looked for, which xsl:apply-imports carries on from.  They are part of
+  the transformation, not the stylesheet, and are shared with the
+  contexts made for variables.
+  **/
+  const string_type& currentMode() const { return currentRule_->mode; }
+  const Precedence& currentGeneration() const { return currentRule_->generation; }
+  void setCurrentMode(const string_type& mode) { currentRule_->mode = mode; }
+  void setCurrentGeneration(const Precedence& generation) { currentRule_->generation = generation; }
+
 private:
   void pushStackFrame() { stack_.pushScope(); }
   void chainStackFrame() { stack_.chainScope(); }
@@ -111,6 +132,15 @@ private:
   StreamSink<string_type, string_adaptor> message_sink_;
   int to_msg_;
 
+  struct TemplateRule
+  {
+    string_type mode;
+    Precedence generation;
+  }; // struct TemplateRule
+  TemplateRule rule_;
+  TemplateRule* currentRule_;
+  Profiler* profiler_;
+
   friend class StackFrame<string_type, string_adaptor> ;
   friend class ChainStackFrame<string_type, string_adaptor> ;
 }; // class ExecutionContext
@@ -35,11 +35,13 @@ public:
   virtual void execute(const DOMNode& node, 
                        ExecutionContext<string_type, string_adaptor>& context) const
   {
+    ProfileFrame frame(context.profiler(), this, "for-each");
     XPathValue sel = select_->evaluate(node, context.xpathContext());
     if(sel.type() != Arabica::XPath::NODE_SET)
       throw SAX::SAXException("xsl:for-each must select a node set");
 
     NodeSet nodes = sel.asNodeSet();
+    frame.nodes(nodes.size());
     this->sort(node, nodes, context);
 
     LastFrame<string_type, string_adaptor> last(context, nodes.size());
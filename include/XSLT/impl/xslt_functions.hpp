@@ -3,6 +3,7 @@
 
 #include <DOM/SAX2DOM/SAX2DOM.hpp>
 #include <SAX/helpers/CatchErrorHandler.hpp>
+#include "xslt_strip_space.hpp"
 
 namespace Arabica
 {
@@ -23,6 +24,7 @@ class DocumentFunction : public Arabica::XPath::NodeSetXPathFunction<string_type
 
   typedef Arabica::XPath::ExecutionContext<string_type, string_adaptor> XPathExecutionContext;
   typedef DOM::Node<string_type, string_adaptor> DOMNode;
+  typedef Stylesheet<string_type, string_adaptor> StylesheetT;
   
 public:
   static const string_type& name()
@@ -32,9 +34,11 @@ public:
   } // name
 
   DocumentFunction(const string_type& currentBase, 
+                   const StylesheetT& stylesheet,
                    const ArgList& args) :
       baseT(1, 2, args),
-      baseURI_(currentBase)
+      baseURI_(currentBase),
+      stylesheet_(stylesheet)
   { } 
 
 protected:
@@ -59,6 +63,9 @@ private:
     SAX2DOM::Parser<string_type, string_adaptor> domParser;
     SAX::CatchErrorHandler<string_type, string_adaptor> eh;
     domParser.setErrorHandler(eh);
+    StripSpaceFilter<string_type, string_adaptor> stripper(stylesheet_);
+    if(stylesheet_.strips_whitespace())
+      domParser.setFilter(stripper);
 
     Arabica::io::URI base(string_adaptor::asStdString(baseURI_));
     Arabica::io::URI absolute(base, string_adaptor::asStdString(location));
@@ -72,6 +79,7 @@ private:
   } // load_document
 
   string_type baseURI_; 
+  const StylesheetT& stylesheet_;
 }; // DocumentFunction
 
 // node-set key(string, object)
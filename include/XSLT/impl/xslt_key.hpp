@@ -8,6 +8,79 @@ namespace Arabica
 namespace XSLT
 {
 
+/**
+The indexes built for xsl:keys during a transformation.  They belong to
+the transformation rather than to the keys, so a compiled stylesheet can
+be run on several threads at once, and no index outlives the document it
+was built over - once a document is gone, another may be given its
+address.
+
+CompiledStylesheet::execute makes one for the length of each
+transformation, and keys find the one belonging to the thread they are
+being looked up on.
+**/
+template<class string_type, class string_adaptor>
+class KeyIndexes
+{
+public:
+  typedef Arabica::XPath::NodeSet<string_type, string_adaptor> NodeSet;
+  typedef std::map<string_type, NodeSet> NodeMap;
+
+  KeyIndexes(Profiler* profiler = 0) :
+    outer_(current_),
+    profiler_(profiler)
+  {
+    current_ = this;
+  } // KeyIndexes
+
+  ~KeyIndexes()
+  {
+    current_ = outer_;
+  } // ~KeyIndexes
+
+  /**
+  The indexes of the transformation running on this thread, or 0 if
+  there isn't one.
+  **/
+  static KeyIndexes* current() { return current_; }
+
+  /**
+  The profiler the transformation is being timed by, or 0.
+  **/
+  Profiler* profiler() const { return profiler_; }
+
+  /**
+  The index of key over the document doc.  built says whether it has
+  been filled in already.
+  **/
+  NodeMap& index(const void* key, const DOM::Node_impl<string_type, string_adaptor>* doc, bool& built)
+  {
+    const IndexName name(key, doc);
+    typename Indexes::iterator i = indexes_.find(name);
+    built = (i != indexes_.end());
+    if(!built)
+      i = indexes_.insert(std::make_pair(name, NodeMap())).first;
+    return i->second;
+  } // index
+
+private:
+  typedef std::pair<const void*, const DOM::Node_impl<string_type, string_adaptor>*> IndexName;
+  typedef std::map<IndexName, NodeMap> Indexes;
+
+  Indexes indexes_;
+  KeyIndexes* outer_;
+  Profiler* profiler_;
+
+  static thread_local KeyIndexes* current_;
+
+  KeyIndexes(const KeyIndexes&);
+  KeyIndexes& operator=(const KeyIndexes&);
+  bool operator==(const KeyIndexes&) const;
+}; // class KeyIndexes
+
+template<class string_type, class string_adaptor>
+thread_local KeyIndexes<string_type, string_adaptor>* KeyIndexes<string_type, string_adaptor>::current_ = 0;
+
 template<class string_type, class string_adaptor>
 class Key
 {
@@ -27,35 +100,50 @@ public:
 
   NodeSet lookup(const string_type& value, const XPathContext& context) const
   {
+    KeyIndexes<string_type, string_adaptor>* indexes = KeyIndexes<string_type, string_adaptor>::current();
+    if(indexes == 0)
+    {
+      // outside a transformation, so nowhere to keep an index
+      NodeMap nodes;
+      populate(nodes, context);
+      return find(nodes, value);
+    } // if ...
+
+    ProfileFrame frame(indexes->profiler(), this, "key");
     DOMNode doc = XPath::impl::get_owner_document(context.currentNode());
-    DocumentNodeMapIterator nm = nodesPerDocument_.find(doc.underlying_impl());
-    if(nm == nodesPerDocument_.end())
-      populate(nodesPerDocument_[doc.underlying_impl()], context);
+    bool built;
+    NodeMap& nodes = indexes->index(this, doc.underlying_impl(), built);
+    if(!built)
+      frame.nodes(populate(nodes, context));
+    return find(nodes, value);
+  } // lookup
+
+private:
+  typedef typename KeyIndexes<string_type, string_adaptor>::NodeMap NodeMap;
+  typedef typename NodeMap::const_iterator NodeMapIterator;
+  typedef typename NodeSet::iterator NodeSetIterator;
+  typedef typename MatchExprList::const_iterator MatchExprListIterator;
 
-    const NodeMap& nodes = nodesPerDocument_[doc.underlying_impl()];
+  static NodeSet find(const NodeMap& nodes, const string_type& value)
+  {
     NodeMapIterator f = nodes.find(value);
     if(f == nodes.end())
       return NodeSet(0);
 
     return f->second;
-  } // lookup
+  } // find
 
-private:
-  typedef std::map<string_type, NodeSet> NodeMap;
-  typedef typename NodeMap::const_iterator NodeMapIterator;
-  typedef std::map<DOM::Node_impl<string_type, string_adaptor>*, NodeMap> DocumentNodeMap;
-  typedef typename DocumentNodeMap::const_iterator DocumentNodeMapIterator;
-  typedef typename NodeSet::iterator NodeSetIterator;
-  typedef typename MatchExprList::const_iterator MatchExprListIterator;
- 
-  void populate(NodeMap& nodes, const XPathContext& context) const
+  // returns the number of nodes looked at
+  size_t populate(NodeMap& nodes, const XPathContext& context) const
   {
     typedef XPath::AxisEnumerator<string_type, string_adaptor> AxisEnum;
 
     DOMNode current = XPath::impl::get_owner_document(context.currentNode());
 
+    size_t visited = 0;
     for(AxisEnum ae(current, XPath::DESCENDANT_OR_SELF); *ae != 0; ++ae)
     {
+      ++visited;
       DOMNode node = *ae;
       for(MatchExprListIterator me = matches_.begin(), mee = matches_.end(); me != mee; ++me)
         if(me->evaluate(node, context))
@@ -69,11 +157,11 @@ private:
           break;
         } // if ...
     } // for 
+    return visited;
   } // populate
 
   MatchExprList matches_;
   XPathExpression use_;
-  mutable DocumentNodeMap nodesPerDocument_;
 
 }; // class Key
 
@@ -0,0 +1,307 @@
+#ifndef ARABICA_XSLT_PROFILER_HPP
+#define ARABICA_XSLT_PROFILER_HPP
+
+#include <map>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <ostream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+namespace Arabica
+{
+namespace XSLT
+{
+
+/**
+What a template or instruction is, and where it is in the stylesheet.  The
+compiler notes these down for the profiler.
+**/
+struct ProfileSite
+{
+  ProfileSite() : line(-1) { }
+  ProfileSite(const std::string& d, const std::string& m, const std::string& s, int l) :
+    description(d), mode(m), systemId(s), line(l) { }
+
+  std::string description;  // match="item", select="para" and so on
+  std::string mode;
+  std::string systemId;
+  int line;                 // -1 if not known
+
+  std::string location() const
+  {
+    std::ostringstream os;
+    os << systemId;
+    if(line != -1)
+      os << ':' << line;
+    return os.str();
+  } // location
+}; // struct ProfileSite
+
+typedef std::map<const void*, ProfileSite> ProfileSites;
+
+/**
+Times the templates a stylesheet runs, and the instructions most likely to
+make it slow - xsl:apply-templates, xsl:for-each, xsl:sort, key() lookups
+and xsl:value-of.
+
+Give one to Stylesheet::set_profiler, and every transformation the
+stylesheet runs until it's taken away again adds to its figures.  For
+each template and instruction, it counts the calls, the nodes selected,
+sorted or indexed, the time spent in it all told (inclusive) and the time
+spent in it but not in the profiled templates and instructions it called
+(exclusive).  The inclusive time of a template which calls itself only
+counts the outermost call.
+
+A profiler isn't thread-safe, so shouldn't be given to a stylesheet being
+executed on several threads at once.
+**/
+class Profiler
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Entry
+  {
+    Entry(const char* k, const ProfileSite& s) :
+      kind(k), site(s), calls(0), nodes(0), inclusive(0), exclusive(0), active(0) { }
+
+    std::string kind;             // template, apply-templates, for-each, sort, key or value-of
+    ProfileSite site;
+    unsigned long calls;
+    unsigned long nodes;
+    long long inclusive;          // nanoseconds
+    long long exclusive;          // nanoseconds
+    unsigned int active;
+  }; // struct Entry
+
+  Profiler() :
+    sites_(0)
+  {
+  } // Profiler
+
+  void reset()
+  {
+    entries_.clear();
+    index_.clear();
+    stack_.clear();
+  } // reset
+
+  /**
+  Every template and instruction which has been run, in the order they
+  were first run.
+  **/
+  const std::vector<Entry>& entries() const { return entries_; }
+
+  /**
+  A table of the templates and instructions, those which took the longest,
+  not counting what they called, first.
+  **/
+  void report(std::ostream& os) const
+  {
+    std::vector<const Entry*> order = sorted(exclusive_first);
+
+    long long total = 0;
+    for(size_t e = 0; e != entries_.size(); ++e)
+      total += entries_[e].exclusive;
+
+    os << std::setw(12) << "exclusive ms" << std::setw(14) << "inclusive ms"
+       << std::setw(10) << "calls" << std::setw(10) << "nodes" << "  what\n";
+    for(std::vector<const Entry*>::const_iterator e = order.begin(), ee = order.end(); e != ee; ++e)
+    {
+      const Entry& entry = **e;
+      os << std::fixed << std::setprecision(3)
+         << std::setw(12) << entry.exclusive / 1e6 << std::setw(14) << entry.inclusive / 1e6
+         << std::setw(10) << entry.calls << std::setw(10) << entry.nodes
+         << "  " << entry.kind;
+      if(!entry.site.description.empty())
+        os << ' ' << entry.site.description;
+      if(!entry.site.mode.empty())
+        os << " mode=\"" << entry.site.mode << '"';
+      std::string location = entry.site.location();
+      if(!location.empty())
+        os << "  " << location;
+      os << '\n';
+    } // for ...
+    os << std::setw(12) << total / 1e6 << "  total\n";
+    os.unsetf(std::ios_base::floatfield);
+  } // report
+
+  /**
+  The same figures as comma separated values, in stylesheet order, so one
+  version of a stylesheet can be compared with another.
+  **/
+  void write_csv(std::ostream& os) const
+  {
+    std::vector<const Entry*> order = sorted(stylesheet_order);
+
+    os << "kind,description,mode,stylesheet,line,calls,nodes,inclusive_us,exclusive_us\n";
+    for(std::vector<const Entry*>::const_iterator e = order.begin(), ee = order.end(); e != ee; ++e)
+    {
+      const Entry& entry = **e;
+      os << entry.kind << ','
+         << quoted(entry.site.description) << ','
+         << quoted(entry.site.mode) << ','
+         << quoted(entry.site.systemId) << ','
+         << entry.site.line << ','
+         << entry.calls << ','
+         << entry.nodes << ','
+         << entry.inclusive / 1000 << ','
+         << entry.exclusive / 1000 << '\n';
+    } // for ...
+  } // write_csv
+
+  ////////////////////////////////////////
+  // called by the stylesheet as it runs
+  void start(const ProfileSites& sites)
+  {
+    sites_ = &sites;
+  } // start
+
+  size_t enter(const void* site, const char* kind)
+  {
+    size_t entry = find(site, kind);
+    ++entries_[entry].active;
+    stack_.push_back(Frame(entry, Clock::now()));
+    return entry;
+  } // enter
+
+  void add_nodes(size_t entry, size_t nodes)
+  {
+    entries_[entry].nodes += nodes;
+  } // add_nodes
+
+  void leave()
+  {
+    const Frame frame = stack_.back();
+    stack_.pop_back();
+
+    long long elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - frame.start).count();
+    Entry& entry = entries_[frame.entry];
+    ++entry.calls;
+    entry.exclusive += elapsed - frame.children;
+    if(--entry.active == 0)
+      entry.inclusive += elapsed;
+    if(!stack_.empty())
+      stack_.back().children += elapsed;
+  } // leave
+
+private:
+  struct Frame
+  {
+    Frame(size_t e, Clock::time_point s) : entry(e), start(s), children(0) { }
+
+    size_t entry;
+    Clock::time_point start;
+    long long children;
+  }; // struct Frame
+
+  // every template and instruction is a different object, so its address
+  // is enough to tell it apart
+  size_t find(const void* site, const char* kind)
+  {
+    std::map<const void*, size_t>::const_iterator i = index_.find(site);
+    if(i != index_.end())
+      return i->second;
+
+    ProfileSite description;
+    if(sites_ != 0)
+    {
+      ProfileSites::const_iterator s = sites_->find(site);
+      if(s != sites_->end())
+        description = s->second;
+    } // if ...
+    entries_.push_back(Entry(kind, description));
+    index_.insert(std::make_pair(site, entries_.size() - 1));
+    return entries_.size() - 1;
+  } // find
+
+  static bool exclusive_first(const Entry* lhs, const Entry* rhs)
+  {
+    return lhs->exclusive > rhs->exclusive;
+  } // exclusive_first
+
+  static bool stylesheet_order(const Entry* lhs, const Entry* rhs)
+  {
+    if(lhs->site.systemId != rhs->site.systemId)
+      return lhs->site.systemId < rhs->site.systemId;
+    if(lhs->site.line != rhs->site.line)
+      return lhs->site.line < rhs->site.line;
+    if(lhs->kind != rhs->kind)
+      return lhs->kind < rhs->kind;
+    if(lhs->site.description != rhs->site.description)
+      return lhs->site.description < rhs->site.description;
+    return lhs->site.mode < rhs->site.mode;
+  } // stylesheet_order
+
+  std::vector<const Entry*> sorted(bool (*order)(const Entry*, const Entry*)) const
+  {
+    std::vector<const Entry*> entries;
+    for(size_t e = 0; e != entries_.size(); ++e)
+      entries.push_back(&entries_[e]);
+    std::stable_sort(entries.begin(), entries.end(), order);
+    return entries;
+  } // sorted
+
+  static std::string quoted(const std::string& field)
+  {
+    if(field.find_first_of(",\"\n") == std::string::npos)
+      return field;
+    std::string q = "\"";
+    for(std::string::const_iterator c = field.begin(), ce = field.end(); c != ce; ++c)
+    {
+      if(*c == '"')
+        q += '"';
+      q += *c;
+    } // for ...
+    return q + '"';
+  } // quoted
+
+  std::vector<Entry> entries_;
+  std::map<const void*, size_t> index_;
+  std::vector<Frame> stack_;
+  const ProfileSites* sites_;
+
+  Profiler(const Profiler&);
+  Profiler& operator=(const Profiler&);
+}; // class Profiler
+
+/**
+Profiles a template or instruction for as long as it's in scope, if
+there's a profiler.
+**/
+class ProfileFrame
+{
+public:
+  ProfileFrame(Profiler* profiler, const void* site, const char* kind) :
+    profiler_(profiler),
+    entry_(profiler ? profiler->enter(site, kind) : 0)
+  {
+  } // ProfileFrame
+
+  ~ProfileFrame()
+  {
+    if(profiler_)
+      profiler_->leave();
+  } // ~ProfileFrame
+
+  void nodes(size_t count)
+  {
+    if(profiler_)
+      profiler_->add_nodes(entry_, count);
+  } // nodes
+
+private:
+  Profiler* profiler_;
+  size_t entry_;
+
+  ProfileFrame(const ProfileFrame&);
+  ProfileFrame& operator=(const ProfileFrame&);
+}; // class ProfileFrame
+
+} // namespace XSLT
+} // namespace Arabica
+
+#endif // ARABICA_XSLT_PROFILER_HPP
@@ -146,7 +146,7 @@ protected:
     {
       stream_ << ' ' << atts.getQName(a) << '=' << '\"';
       string_type ch = atts.getValue(a);
-      std::for_each(string_adaptor::begin(ch), string_adaptor::end(ch), Arabica::XML::attribute_escaper<typename string_adaptor::value_type>(stream_));
+      Arabica::XML::escape_attribute(stream_, string_adaptor::begin(ch), string_adaptor::end(ch));
       stream_ << '\"';
     }
     empty_ = true;
@@ -175,7 +175,7 @@ protected:
     close_element_if_empty();
 
     if(!disable_output_escaping_ && !in_cdata_)
-      std::for_each(string_adaptor::begin(ch), string_adaptor::end(ch), Arabica::XML::text_escaper<typename string_adaptor::value_type>(stream_));
+      Arabica::XML::escape_text(stream_, string_adaptor::begin(ch), string_adaptor::end(ch));
     else if(in_cdata_) 
     {
       size_t breakAt = string_adaptor::find(ch, SC::CDATAEnd);
@@ -202,6 +202,8 @@ protected:
       return;
     }
 
+    ProfileFrame frame(context.profiler(), sort_, "sort");
+    frame.nodes(nodes.size());
     sort_->set_context(node, context);
     std::stable_sort(nodes.begin(), nodes.end(), SortP(*sort_));
   } // sort
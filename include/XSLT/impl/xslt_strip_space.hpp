@@ -0,0 +1,423 @@
+#ifndef ARABICA_XSLT_STRIP_SPACE_HPP
+#define ARABICA_XSLT_STRIP_SPACE_HPP
+
+#include <vector>
+#include <algorithm>
+#include <XML/XMLCharacterClasses.hpp>
+#include <SAX/helpers/XMLFilterImpl.hpp>
+#include <DOM/Node.hpp>
+#include <DOM/Element.hpp>
+
+#include "xslt_precedence.hpp"
+#include "xslt_stylesheet.hpp"
+#include "handler/xslt_constants.hpp"
+
+namespace Arabica
+{
+namespace XSLT
+{
+
+/**
+A stylesheet's xsl:strip-space and xsl:preserve-space declarations.
+
+Whitespace-only text in an element is stripped if, of the declarations
+whose name tests match the element, the one with the highest import
+precedence, and then the most specific name test, is an xsl:strip-space.
+Where that still leaves more than one, the last declared wins.  Nothing is
+stripped inside an element with xml:space="preserve", unless an element
+between has xml:space="default".
+**/
+template<class string_type, class string_adaptor>
+class WhitespaceRules
+{
+  typedef StylesheetConstant<string_type, string_adaptor> SC;
+  typedef DOM::Node<string_type, string_adaptor> DOMNode;
+public:
+  // a stripped text node, and where it was
+  struct Removal
+  {
+    Removal(const DOMNode& p, const DOMNode& t, const DOMNode& n) : parent(p), text(t), next(n) { }
+
+    DOMNode parent;
+    DOMNode text;
+    DOMNode next;
+  }; // struct Removal
+  typedef std::vector<Removal> Removals;
+
+  WhitespaceRules() :
+    strips_(false)
+  {
+  } // WhitespaceRules
+
+  /**
+  Adds a declaration for elements in namespaceURI called localName.  A
+  localName of * matches anything in namespaceURI, and anyNamespace
+  matches everything.
+  **/
+  void add(const string_type& namespaceURI,
+           const string_type& localName,
+           bool anyNamespace,
+           bool strip,
+           const Precedence& precedence)
+  {
+    static const string_type asterisk = string_adaptor::construct_from_utf8("*");
+    int specificity = anyNamespace ? 0 : ((localName == asterisk) ? 1 : 2);
+    rules_.push_back(Rule(namespaceURI, localName, specificity, strip, precedence, rules_.size()));
+    std::stable_sort(rules_.begin(), rules_.end());
+    strips_ = strips_ || strip;
+  } // add
+
+  /**
+  True if any whitespace is stripped at all.
+  **/
+  bool strips() const { return strips_; }
+
+  /**
+  True if whitespace-only text in elements called namespaceURI:localName is
+  stripped, xml:space aside.
+  **/
+  bool strips(const string_type& namespaceURI, const string_type& localName) const
+  {
+    if(!strips_)
+      return false;
+    for(RuleIterator r = rules_.begin(), re = rules_.end(); r != re; ++r)
+      if(r->matches(namespaceURI, localName))
+        return r->strip_;
+    return false;
+  } // strips
+
+  /**
+  Strips whitespace-only text from the document node belongs to.
+  **/
+  void strip(const DOMNode& node) const
+  {
+    strip(node, 0);
+  } // strip
+
+  /**
+  As strip, noting each text node taken out in removed, so restore can
+  put them back.
+  **/
+  void strip(const DOMNode& node, Removals* removed) const
+  {
+    if(!strips_ || node == 0)
+      return;
+
+    DOMNode root = node;
+    if(root.getNodeType() != DOM::Node_base::DOCUMENT_NODE && root.getOwnerDocument() != 0)
+      root = root.getOwnerDocument();
+    stripChildren(root, false, false, removed);
+  } // strip
+
+  /**
+  Puts back what strip took out, last first, so each text node goes back
+  in front of the node it was in front of.
+  **/
+  static void restore(Removals& removed)
+  {
+    for(typename Removals::reverse_iterator r = removed.rbegin(), re = removed.rend(); r != re; ++r)
+      r->parent.insertBefore(r->text, r->next);
+    removed.clear();
+  } // restore
+
+private:
+  struct Rule
+  {
+    Rule(const string_type& namespaceURI, const string_type& localName, int specificity,
+         bool strip, const Precedence& precedence, size_t order) :
+      namespaceURI_(namespaceURI), localName_(localName), specificity_(specificity),
+      strip_(strip), precedence_(precedence), order_(order)
+    {
+    } // Rule
+
+    bool matches(const string_type& namespaceURI, const string_type& localName) const
+    {
+      switch(specificity_)
+      {
+        case 0: return true;
+        case 1: return namespaceURI == namespaceURI_;
+        default: return localName == localName_ && namespaceURI == namespaceURI_;
+      } // switch
+    } // matches
+
+    // best first
+    bool operator<(const Rule& rhs) const
+    {
+      if(!(precedence_ == rhs.precedence_))
+        return precedence_ > rhs.precedence_;
+      if(specificity_ != rhs.specificity_)
+        return specificity_ > rhs.specificity_;
+      return order_ > rhs.order_;
+    } // operator<
+
+    string_type namespaceURI_;
+    string_type localName_;
+    int specificity_;
+    bool strip_;
+    Precedence precedence_;
+    size_t order_;
+  }; // struct Rule
+
+  typedef std::vector<Rule> Rules;
+  typedef typename Rules::const_iterator RuleIterator;
+
+  void stripChildren(const DOMNode& node, bool stripping, bool preserving, Removals* removed) const
+  {
+    DOMNode child = node.getFirstChild();
+    while(child != 0)
+    {
+      if(!isText(child))
+      {
+        if(child.getNodeType() == DOM::Node_base::ELEMENT_NODE)
+        {
+          bool preserve = preserving;
+          DOM::Element<string_type, string_adaptor> element(child);
+          if(element.hasAttributeNS(SC::xml_uri, SC::space))
+            preserve = element.getAttributeNS(SC::xml_uri, SC::space) == SC::preserve;
+          stripChildren(child, !preserve && strips(child.getNamespaceURI(), child.getLocalName()), preserve, removed);
+        } // if ...
+        child = child.getNextSibling();
+        continue;
+      } // if ...
+
+      // adjacent text and CDATA nodes are one text node as far as XPath is concerned
+      DOMNode end = child;
+      bool whitespace = true;
+      while(end != 0 && isText(end))
+      {
+        whitespace = whitespace && isWhitespace(end.getNodeValue());
+        end = end.getNextSibling();
+      } // while ...
+
+      // removed rather than purged, as the caller may be holding on to one
+      while(child != end)
+      {
+        DOMNode text = child;
+        child = child.getNextSibling();
+        if(!stripping || !whitespace)
+          continue;
+        DOMNode(node).removeChild(text);
+        if(removed)
+          removed->push_back(Removal(node, text, child));
+      } // while ...
+    } // while ...
+  } // stripChildren
+
+  static bool isText(const DOMNode& node)
+  {
+    return node.getNodeType() == DOM::Node_base::TEXT_NODE ||
+           node.getNodeType() == DOM::Node_base::CDATA_SECTION_NODE;
+  } // isText
+
+  static bool isWhitespace(const string_type& text)
+  {
+    for(typename string_adaptor::const_iterator c = string_adaptor::begin(text), ce = string_adaptor::end(text); c != ce; ++c)
+      if(!XML::is_space(*c))
+        return false;
+    return true;
+  } // isWhitespace
+
+  Rules rules_;
+  bool strips_;
+}; // class WhitespaceRules
+
+/**
+Strips whitespace-only text from a document for as long as it's in scope,
+then puts it back as it was.
+**/
+template<class string_type, class string_adaptor>
+class StrippedWhitespace
+{
+  typedef WhitespaceRules<string_type, string_adaptor> WhitespaceRulesT;
+public:
+  StrippedWhitespace(const WhitespaceRulesT& rules, const DOM::Node<string_type, string_adaptor>& node)
+  {
+    rules.strip(node, &removed_);
+  } // StrippedWhitespace
+
+  ~StrippedWhitespace()
+  {
+    WhitespaceRulesT::restore(removed_);
+  } // ~StrippedWhitespace
+
+private:
+  typename WhitespaceRulesT::Removals removed_;
+
+  StrippedWhitespace(const StrippedWhitespace&);
+  StrippedWhitespace& operator=(const StrippedWhitespace&);
+}; // class StrippedWhitespace
+
+/**
+Strips whitespace-only text, as a stylesheet's xsl:strip-space and
+xsl:preserve-space declarations ask, as a document is parsed.  Given to
+SAX2DOM::Parser::setFilter, the stripped text never makes it into the DOM.
+Text, and the CDATA sections in it, is held back only while it's all
+whitespace and might be stripped.
+**/
+template<class string_type, class string_adaptor = Arabica::default_string_adaptor<string_type> >
+class StripSpaceFilter : public SAX::XMLFilterImpl<string_type, string_adaptor>
+{
+  typedef SAX::XMLFilterImpl<string_type, string_adaptor> XMLFilterT;
+  typedef SAX::XMLReaderInterface<string_type, string_adaptor> XMLReaderT;
+  typedef SAX::Attributes<string_type, string_adaptor> AttributesT;
+  typedef StylesheetConstant<string_type, string_adaptor> SC;
+public:
+  typedef Stylesheet<string_type, string_adaptor> StylesheetT;
+
+  StripSpaceFilter(const StylesheetT& stylesheet) :
+    XMLFilterT(),
+    stylesheet_(stylesheet),
+    passing_(false)
+  {
+  } // StripSpaceFilter
+
+  StripSpaceFilter(XMLReaderT& parent, const StylesheetT& stylesheet) :
+    XMLFilterT(parent),
+    stylesheet_(stylesheet),
+    passing_(false)
+  {
+  } // StripSpaceFilter
+
+  virtual void startDocument()
+  {
+    elements_.clear();
+    drop();
+    XMLFilterT::startDocument();
+  } // startDocument
+
+  virtual void startElement(const string_type& namespaceURI, const string_type& localName,
+                            const string_type& qName, const AttributesT& atts)
+  {
+    drop();
+
+    bool preserving = !elements_.empty() && elements_.back().preserving;
+    int space = atts.getIndex(SC::xml_uri, SC::space);
+    if(space != -1)
+      preserving = atts.getValue(space) == SC::preserve;
+    elements_.push_back(State(!preserving && stylesheet_.strips_whitespace(namespaceURI, localName), preserving));
+
+    XMLFilterT::startElement(namespaceURI, localName, qName, atts);
+  } // startElement
+
+  virtual void endElement(const string_type& namespaceURI, const string_type& localName,
+                          const string_type& qName)
+  {
+    drop();
+    if(!elements_.empty())
+      elements_.pop_back();
+    XMLFilterT::endElement(namespaceURI, localName, qName);
+  } // endElement
+
+  virtual void characters(const string_type& ch)
+  {
+    if(!holding())
+    {
+      XMLFilterT::characters(ch);
+      return;
+    } // if ...
+
+    pending_.push_back(Pending(Pending::TEXT, ch));
+    for(typename string_adaptor::const_iterator c = string_adaptor::begin(ch), ce = string_adaptor::end(ch); c != ce; ++c)
+      if(!XML::is_space(*c))
+      {
+        pass();
+        return;
+      } // if ...
+  } // characters
+
+  virtual void ignorableWhitespace(const string_type& ch)
+  {
+    characters(ch);
+  } // ignorableWhitespace
+
+  virtual void processingInstruction(const string_type& target, const string_type& data)
+  {
+    drop();
+    XMLFilterT::processingInstruction(target, data);
+  } // processingInstruction
+
+  virtual void comment(const string_type& text)
+  {
+    drop();
+    XMLFilterT::comment(text);
+  } // comment
+
+  virtual void skippedEntity(const string_type& name)
+  {
+    pass();
+    XMLFilterT::skippedEntity(name);
+  } // skippedEntity
+
+  // a CDATA section and the text either side of it are one text node, so
+  // they're kept or stripped together
+  virtual void startCDATA()
+  {
+    if(holding())
+      pending_.push_back(Pending(Pending::START_CDATA));
+    else
+      XMLFilterT::startCDATA();
+  } // startCDATA
+
+  virtual void endCDATA()
+  {
+    if(holding())
+      pending_.push_back(Pending(Pending::END_CDATA));
+    else
+      XMLFilterT::endCDATA();
+  } // endCDATA
+
+private:
+  struct State
+  {
+    State(bool s, bool p) : stripping(s), preserving(p) { }
+
+    bool stripping;
+    bool preserving;
+  }; // struct State
+
+  struct Pending
+  {
+    enum Event { TEXT, START_CDATA, END_CDATA };
+
+    Pending(Event e, const string_type& t = string_type()) : event(e), text(t) { }
+
+    Event event;
+    string_type text;
+  }; // struct Pending
+
+  bool holding() const
+  {
+    return !passing_ && !elements_.empty() && elements_.back().stripping;
+  } // holding
+
+  // the text so far is to be kept, and so is the rest of it
+  void pass()
+  {
+    passing_ = true;
+    for(typename std::vector<Pending>::const_iterator p = pending_.begin(), pe = pending_.end(); p != pe; ++p)
+      switch(p->event)
+      {
+        case Pending::TEXT: XMLFilterT::characters(p->text); break;
+        case Pending::START_CDATA: XMLFilterT::startCDATA(); break;
+        case Pending::END_CDATA: XMLFilterT::endCDATA(); break;
+      } // switch
+    pending_.clear();
+  } // pass
+
+  // the text was all whitespace
+  void drop()
+  {
+    passing_ = false;
+    pending_.clear();
+  } // drop
+
+  const StylesheetT& stylesheet_;
+  std::vector<State> elements_;
+  std::vector<Pending> pending_;
+  bool passing_;
+}; // class StripSpaceFilter
+
+} // namespace XSLT
+} // namespace Arabica
+
+#endif // ARABICA_XSLT_STRIP_SPACE_HPP
@@ -10,6 +10,7 @@ namespace XSLT
 #include <iostream>
 #include <DOM/Node.hpp>
 template<class string_type, class string_adaptor> class Sink;
+class Profiler;
 
 template<class string_type, class string_adaptor = Arabica::default_string_adaptor<string_type> >
 class Stylesheet
@@ -26,7 +27,52 @@ public:
 
   virtual void set_error_output(std::basic_ostream<typename string_adaptor::value_type>& os) = 0;
 
+  /**
+  Profiles every transformation from now on, or stops profiling if
+  profiler is 0.  See Profiler.
+  **/
+  virtual void set_profiler(Profiler* profiler) = 0;
+
   virtual void execute(const DOM::Node<string_type, string_adaptor>& initialNode) const = 0;
+
+  /**
+  Transforms initialNode into output, with messages going to
+  error_output, ignoring whatever set_output and set_error_output have
+  been given.  Once its parameters are set a stylesheet isn't changed by
+  being executed, so this can be called on several threads at once.
+
+  Whitespace xsl:strip-space strips is taken out of initialNode's
+  document while it runs and put back at the end, so while one thread
+  executes on a document no other may read it - unless the whitespace was
+  stripped already, by StripSpaceFilter or strip_whitespace, when the
+  document isn't touched.
+  **/
+  virtual void execute(const DOM::Node<string_type, string_adaptor>& initialNode,
+                       Sink<string_type, string_adaptor>& output,
+                       std::basic_ostream<typename string_adaptor::value_type>& error_output) const = 0;
+
+  /**
+  True if xsl:strip-space strips anything from the source document.
+  execute takes care of that itself, but it's cheaper to leave the
+  stripped text out as the document is built - see StripSpaceFilter - or
+  to take it out once with strip_whitespace, where a document is
+  transformed more than once.
+  **/
+  virtual bool strips_whitespace() const = 0;
+
+  /**
+  True if whitespace-only text in elements called namespaceURI:localName
+  is stripped, unless xml:space says otherwise.
+  **/
+  virtual bool strips_whitespace(const string_type& namespaceURI, const string_type& localName) const = 0;
+
+  /**
+  Removes the whitespace-only text xsl:strip-space strips from the
+  document node belongs to, in place.  A run of adjacent text and CDATA
+  sections is one text node, so it goes only if it's whitespace all
+  through.
+  **/
+  virtual void strip_whitespace(const DOM::Node<string_type, string_adaptor>& node) const = 0;
 }; // class Stylesheet
 
 } // namespace XSLT
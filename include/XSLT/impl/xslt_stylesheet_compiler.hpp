@@ -14,6 +14,7 @@
 #include "handler/xslt_output_handler.hpp"
 #include "handler/xslt_namespace_alias_handler.hpp"
 #include "handler/xslt_key_handler.hpp"
+#include "handler/xslt_strip_space_handler.hpp"
 #include "handler/xslt_foreign_element_handler.hpp"
 
 namespace Arabica
@@ -41,6 +42,11 @@ public:
     includer_.context(context_, this);      
   } // StylesheetHandler
 
+  virtual void setDocumentLocator(const SAX::Locator<string_type, string_adaptor>& locator)
+  {
+    context_.set_locator(&locator);
+  } // setDocumentLocator
+
   virtual void startDocument()
   {
     top_ = true;
@@ -84,6 +90,7 @@ public:
   {
     includer_.unwind_imports();
     context_.stylesheet().prepare();
+    context_.set_locator(0);
   } // endDocument
 
 private:
@@ -198,8 +205,8 @@ private:
                       //"include"
                       .add(SC::key, CreateHandler<KeyHandler<string_type, string_adaptor> >)
                       .add(SC::namespace_alias, CreateHandler<NamespaceAliasHandler<string_type, string_adaptor> >)
-                      .add(SC::preserve_space, CreateHandler<NotImplementedYetHandler<string_type, string_adaptor> >)
-                      .add(SC::strip_space, CreateHandler<NotImplementedYetHandler<string_type, string_adaptor> >);
+                      .add(SC::preserve_space, CreateHandler<WhitespaceHandler<string_type, string_adaptor, false> >)
+                      .add(SC::strip_space, CreateHandler<WhitespaceHandler<string_type, string_adaptor, true> >);
 
      return allowed;
    } // allowedChildren
@@ -54,6 +54,7 @@ public:
 
   virtual void execute(const DOM::Node<string_type, string_adaptor>& node, ExecutionContext<string_type, string_adaptor>& context) const
   {
+    ProfileFrame frame(context.profiler(), this, "template");
     this->execute_children(node, context);
   } // execute
 
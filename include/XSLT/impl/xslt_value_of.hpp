@@ -22,6 +22,7 @@ public:
   virtual void execute(const DOM::Node<string_type, string_adaptor>& node, 
                        ExecutionContext<string_type, string_adaptor>& context) const
   {
+    ProfileFrame frame(context.profiler(), this, "value-of");
     if(disable_)
       context.sink().disableOutputEscaping(true);
 
@@ -38,10 +38,24 @@ class convert_bufadaptor : public std::basic_streambuf<charT, traitsT>
     typedef std::basic_streambuf<externalCharT, externalTraitsT> externalStreambufT;
     typedef std::basic_streambuf<charT, traitsT> streambufT;
 
-    explicit convert_bufadaptor(externalStreambufT& externalbuf) : externalbuf_(&externalbuf), inEof_(false) { }
+    // bufferSize is the number of characters converted at a time, in 
+    // each direction
+    explicit convert_bufadaptor(externalStreambufT& externalbuf, size_t bufferSize = defaultBufferSize) : 
+      externalbuf_(&externalbuf), 
+      bufferSize_(bufferSize ? bufferSize : 1),
+      outState_(),
+      inState_(),
+      inEof_(false),
+      fromBegin_(0),
+      fromEnd_(0)
+    { 
+    } // convert_bufadaptor
     virtual ~convert_bufadaptor() { }
   
-    void set_buffer(externalStreambufT& externalbuf) { externalbuf_ = &externalbuf; inEof_ = false; }
+    void set_buffer(externalStreambufT& externalbuf) { externalbuf_ = &externalbuf; inEof_ = false; fromBegin_ = fromEnd_ = 0; }
+    size_t buffer_size() const { return bufferSize_; }
+
+    static const size_t defaultBufferSize;
 
   protected:
     virtual int_type overflow(int_type c = traitsT::eof());
@@ -52,25 +66,30 @@ class convert_bufadaptor : public std::basic_streambuf<charT, traitsT>
   private:
     typedef typename externalTraitsT::int_type external_int_type;
     typedef typename traitsT::state_type state_t;
+    typedef std::codecvt<charT, externalCharT, state_t> codecvtT;
 
     externalStreambufT* externalbuf_;
+    size_t bufferSize_;
     std::vector<charT> outBuffer_;
+    std::vector<externalCharT> to_;
     state_t outState_;
     std::vector<charT> inBuffer_;
+    std::vector<externalCharT> from_;
     state_t inState_;
     bool inEof_;
+    size_t fromBegin_;
+    size_t fromEnd_;
 
-    void growOutBuffer();
     bool flushOut();
-    void growInBuffer();
+    bool writeOut(const externalCharT* to, size_t length);
     std::streamsize readIn();
+    bool readExternal();
 
-    static const std::streamsize bufferSize_;
     static const std::streamsize pbSize_;
 }; // convert_bufadaptor
 
 template<class charT, class traitsT, class externalCharT, class externalTraitsT>
-const std::streamsize convert_bufadaptor<charT, traitsT, externalCharT, externalTraitsT>::bufferSize_ = 1024;
+const size_t convert_bufadaptor<charT, traitsT, externalCharT, externalTraitsT>::defaultBufferSize = 16 * 1024;
 template<class charT, class traitsT, class externalCharT, class externalTraitsT>
 const std::streamsize convert_bufadaptor<charT, traitsT, externalCharT, externalTraitsT>::pbSize_ = 4;
   // why 4? both Josuttis and Langer&Kreft use 4.
@@ -81,7 +100,23 @@ typename convert_bufadaptor<charT, traitsT, externalCharT, externalTraitsT>::int
   if(traitsT::eq_int_type(traitsT::eof(), c))
     return traitsT::not_eof(c);
 
-  growOutBuffer();
+  if(outBuffer_.empty())
+  {
+    outBuffer_.resize(bufferSize_);
+    streambufT::setp(&outBuffer_[0], &outBuffer_[0] + outBuffer_.size());
+  } // if ...
+  else if(std::use_facet<std::codecvt<charT, externalCharT, std::mbstate_t> >(this->getloc()).encoding() == -1)
+  {
+    // a state-dependent conversion, base64 say, may finish off its
+    // output each time it's called, so only converts when flushed
+    size_t length = outBuffer_.size();
+    outBuffer_.resize(length * 2);
+    streambufT::setp(&outBuffer_[0], &outBuffer_[0] + outBuffer_.size());
+    streambufT::pbump(static_cast<int>(length));
+  } 
+  else if(!flushOut() || (streambufT::pptr() == streambufT::epptr()))
+    return traitsT::eof();
+
   streambufT::sputc(traitsT::to_char_type(c));
 
   return traitsT::not_eof(c);
@@ -117,152 +152,160 @@ typename convert_bufadaptor<charT, traitsT, externalCharT, externalTraitsT>::int
   return traitsT::not_eof(c);
 } // pbackfail
 
-template<class charT, class traitsT, class externalCharT, class externalTraitsT>
-void convert_bufadaptor<charT, traitsT, externalCharT, externalTraitsT>::growOutBuffer()
-{
-  size_t oldsize = outBuffer_.capacity();
-  size_t newsize = (oldsize ? oldsize*2 : bufferSize_);
-  outBuffer_.resize(newsize);
-  streambufT::setp(&outBuffer_[0] + oldsize, &outBuffer_[0] + outBuffer_.capacity());
-} // growOutBuffer
-
-template<class charT, class traitsT, class externalCharT, class externalTraitsT>
-void convert_bufadaptor<charT, traitsT, externalCharT, externalTraitsT>::growInBuffer()
-{
-  size_t oldsize = inBuffer_.capacity();
-  size_t newsize = (oldsize ? oldsize*2 : bufferSize_) + pbSize_;
-  inBuffer_.resize(newsize);
-} // growInBuffer
-
 template<class charT, class traitsT, class externalCharT, class externalTraitsT>
 bool convert_bufadaptor<charT, traitsT, externalCharT, externalTraitsT>::flushOut()
 {
-  size_t length = streambufT::pptr() - &outBuffer_[0];
-  if(!length)
+  charT* const begin = streambufT::pbase();
+  charT* const end = streambufT::pptr();
+  if(begin == end)
     return true;
 
-  bool ok(true);
-  const std::codecvt<charT, externalCharT, state_t>& cvt =
+  const codecvtT& cvt =
       std::use_facet<std::codecvt<charT, externalCharT, std::mbstate_t> >(this->getloc());
 
-  if(cvt.always_noconv())
-    std::copy(&outBuffer_[0], &outBuffer_[0] + length, std::ostreambuf_iterator<externalCharT>(externalbuf_));
-  else
-  {
-    // we must do code conversion
-    length += cvt.max_length(); // add a little 
-    std::vector<externalCharT> to(length);
-    const charT* from_next = &(outBuffer_[0]);
-    std::codecvt_base::result r;
+  if(to_.empty())
+    to_.resize(bufferSize_ + cvt.max_length());
 
+  const charT* from_next = begin;
+  std::codecvt_base::result r = std::codecvt_base::noconv;
+  if(!cvt.always_noconv())
+  {
+    // the whole buffer is converted in as few calls as to_ allows
     do
     {
+      const charT* from = from_next;
       externalCharT* to_next;
-      r = cvt.out(outState_, from_next, streambufT::pptr(), from_next, 
-                  &to[0], &to[0]+length, to_next);
-
+      r = cvt.out(outState_, from, end, from_next, 
+                  &to_[0], &to_[0] + to_.size(), to_next);
+      if(r == std::codecvt_base::error)
+        return false;
       if(r == std::codecvt_base::noconv)
-      {
-        std::copy(&outBuffer_[0], &outBuffer_[0] + length, std::ostreambuf_iterator<externalCharT>(externalbuf_));
         break;
-      }
-      std::copy(&to[0], to_next, std::ostreambuf_iterator<externalCharT>(externalbuf_));
+      if(!writeOut(&to_[0], to_next - &to_[0]))
+        return false;
+      if((from_next == from) && (to_next == &to_[0]))
+        break;
     }
     while(r == std::codecvt_base::partial);
+  } // if ...
+
+  if(r == std::codecvt_base::noconv)
+  {
+    while(from_next != end)
+    {
+      size_t length = std::min<size_t>(end - from_next, to_.size());
+      std::copy(from_next, from_next + length, &to_[0]);
+      if(!writeOut(&to_[0], length))
+        return false;
+      from_next += length;
+    } // while ...
+  } // if ...
 
-    ok = ok ? (r != std::codecvt_base::error) : false;
-  } // if(cvt.always_noconv())
- 
-  if(ok)
-    streambufT::setp(&outBuffer_[0], &outBuffer_[0] + outBuffer_.capacity());
+  // anything left over is an incomplete character, which waits for the
+  // rest of itself
+  size_t left = end - from_next;
+  traitsT::move(&outBuffer_[0], from_next, left);
+  streambufT::setp(&outBuffer_[0], &outBuffer_[0] + outBuffer_.size());
+  streambufT::pbump(static_cast<int>(left));
 
-  return ok;
+  return true;
 } // flushOut
 
 template<class charT, class traitsT, class externalCharT, class externalTraitsT>
-std::streamsize convert_bufadaptor<charT, traitsT, externalCharT, externalTraitsT>::readIn()
+bool convert_bufadaptor<charT, traitsT, externalCharT, externalTraitsT>::writeOut(const externalCharT* to, size_t length)
 {
-  if(!inBuffer_.capacity())
-    growInBuffer();
-
-  size_t pbCount = std::min<size_t>(streambufT::gptr() - streambufT::eback(), pbSize_);
-  memcpy(&(inBuffer_[0]) + (pbSize_-pbCount)*sizeof(charT),
-         streambufT::gptr() - pbCount*sizeof(charT),
-         pbCount*sizeof(charT));
+  return externalbuf_->sputn(to, static_cast<std::streamsize>(length)) == static_cast<std::streamsize>(length);
+} // writeOut
 
-  const std::codecvt<charT, externalCharT, state_t>& cvt =
+template<class charT, class traitsT, class externalCharT, class externalTraitsT>
+std::streamsize convert_bufadaptor<charT, traitsT, externalCharT, externalTraitsT>::readIn()
+{
+  const codecvtT& cvt =
       std::use_facet<std::codecvt<charT, externalCharT, std::mbstate_t> >(this->getloc());
 
-  externalCharT from[1024];
-
-  std::streamsize res = 0;
-  if(!inEof_)
+  if(inBuffer_.empty())
   {
-    external_int_type ec = externalbuf_->sgetc();
-    while((!externalTraitsT::eq_int_type(externalTraitsT::eof(), ec)) && (res != bufferSize_))
-    {
-      from[res++] = static_cast<externalCharT>(ec);
-      ec = externalbuf_->snextc();
-    }
-    inEof_ = (externalTraitsT::eq_int_type(externalTraitsT::eof(), ec));
+    // room for a whole character beyond the buffer, however it's split
+    inBuffer_.resize(bufferSize_ + pbSize_);
+    from_.resize(bufferSize_ + cvt.max_length());
   } // if ...
 
-  std::streamsize converted = 0;
-  if(res > 0)
-  {
-    std::codecvt_base::result r;
-    const externalCharT* from_next = from;
-    do
-    {
-      // can't cache this as may reallocate buffer
-      charT* const to = &(inBuffer_[0])+pbSize_;
-      charT* const to_end = &(inBuffer_[0]) + inBuffer_.capacity() - pbSize_;
-      charT* to_next;
+  charT* const to = &(inBuffer_[0]) + pbSize_;
+  size_t pbCount = std::min<size_t>(streambufT::gptr() - streambufT::eback(), pbSize_);
+  traitsT::move(to - pbCount, streambufT::gptr() - pbCount, pbCount);
 
-      externalCharT* const from_end = from + res;
-      
-      r = cvt.in(inState_, from_next, from_end, from_next,
-                 to + converted, to_end, to_next);
+  charT* to_next = to;
+  bool needInput = (fromBegin_ == fromEnd_);
+  while(to_next == to)
+  {
+    if(needInput && !readExternal())
+      break;
+    needInput = true;
 
-      if(r == std::codecvt_base::noconv)
-      {
-        memcpy(&(inBuffer_[0])+pbSize_, from, res);
-        converted = res;
-      }
-      else
-        converted += static_cast<std::streamsize>(to_next - (to + converted));
+    const externalCharT* from = &from_[0] + fromBegin_;
+    const externalCharT* from_end = &from_[0] + fromEnd_;
+    const externalCharT* from_next = from;
 
-      if(r == std::codecvt_base::partial)
-      {
-        // haven't done everything
-        if(to_next == to_end)
-          growInBuffer();  // need more room!
-        else
-        {
-          int shortfall = (from + res) - from_next;
-          memcpy(from, from_next, shortfall);
-          res = externalbuf_->sgetn(from + shortfall, static_cast<std::streamsize>(bufferSize_ - shortfall));
-          from_next = &from[0];
-          if(res == 0) // oh dear
-            break; // let's bail!
-          res += shortfall;
-        }
-      } // if(r == std::codecvt_base::partial)
-    }
-    while(r == std::codecvt_base::partial);
+    std::codecvt_base::result r = std::codecvt_base::noconv;
+    if(!cvt.always_noconv())
+      r = cvt.in(inState_, from, from_end, from_next,
+                 to, to + bufferSize_, to_next);
 
-    if(r == std::codecvt_base::error)
+    if(r == std::codecvt_base::noconv)
+    {
+      size_t length = std::min<size_t>(from_end - from, bufferSize_);
+      std::copy(from, from + length, to);
+      from_next = from + length;
+      to_next = to + length;
+    } 
+    else if(r == std::codecvt_base::error)
     {
       // couldn't convert - let's bail
       return 0;
-    } // if(r == std::codecvt_base::error)
-  }
+    } // if ...
+
+    fromBegin_ = from_next - &from_[0];
+  } // while ...
 
-  streambufT::setg(&(inBuffer_[0]) + (pbSize_-pbCount), &(inBuffer_[0])+pbSize_, &(inBuffer_[0])+pbSize_+converted);
+  streambufT::setg(to - pbCount, to, to_next);
 
-  return static_cast<int_type>(res);
+  return static_cast<std::streamsize>(to_next - to);
 } // readIn
 
+// Tops up the external characters waiting to be converted.  Beyond the
+// first character, only what the external buffer already has to hand is
+// taken, so a slow source isn't waited on for a whole buffer.
+template<class charT, class traitsT, class externalCharT, class externalTraitsT>
+bool convert_bufadaptor<charT, traitsT, externalCharT, externalTraitsT>::readExternal()
+{
+  if(inEof_)
+    return false;
+
+  if(fromBegin_ != 0)
+  {
+    std::copy(&from_[0] + fromBegin_, &from_[0] + fromEnd_, &from_[0]);
+    fromEnd_ -= fromBegin_;
+    fromBegin_ = 0;
+  } // if ...
+  if(fromEnd_ == from_.size())
+    return false;
+
+  if(externalTraitsT::eq_int_type(externalbuf_->sgetc(), externalTraitsT::eof()))
+  {
+    inEof_ = true;
+    return false;
+  } // if ...
+
+  std::streamsize wanted = static_cast<std::streamsize>(from_.size() - fromEnd_);
+  std::streamsize available = externalbuf_->in_avail();
+  if(available > 0 && available < wanted)
+    wanted = available;
+
+  std::streamsize got = externalbuf_->sgetn(&from_[0] + fromEnd_, wanted);
+  fromEnd_ += static_cast<size_t>(got);
+  return got != 0;
+} // readExternal
+
 ////////////////////////////////////////////////////
 // iconvert_adaptor
 template<typename charT, typename traitsT, typename externalCharT, typename externalTraitsT>
@@ -271,9 +314,11 @@ class convert_adaptor_buffer
   protected:
     typedef std::basic_streambuf<externalCharT, externalTraitsT> externalStreambufT;
 
-    explicit convert_adaptor_buffer(externalStreambufT& externalbuf) : bufadaptor_(externalbuf) { }
+    typedef convert_bufadaptor<charT, traitsT, externalCharT, externalTraitsT> bufadaptorT;
+
+    convert_adaptor_buffer(externalStreambufT& externalbuf, size_t bufferSize) : bufadaptor_(externalbuf, bufferSize) { }
 
-    convert_bufadaptor<charT, traitsT, externalCharT, externalTraitsT> bufadaptor_;
+    bufadaptorT bufadaptor_;
 }; // convert_adaptor_buffer
 
 template<typename charT, 
@@ -289,17 +334,17 @@ class iconvert_adaptor : private convert_adaptor_buffer<charT, traitsT, fromChar
   protected:
     using baseBufT::bufadaptor_;
   public:
-    explicit iconvert_adaptor(fromStreamT& fromstream) :
-      baseBufT(*(fromstream.rdbuf())),
+    explicit iconvert_adaptor(fromStreamT& fromstream, size_t bufferSize = baseBufT::bufadaptorT::defaultBufferSize) :
+      baseBufT(*(fromstream.rdbuf()), bufferSize),
       baseStreamT(&bufadaptor_)
       {
       } // iconvert_adaptor
 
     virtual ~iconvert_adaptor() { } 
 
-    baseBufT* rdbuf() const 
+    typename baseBufT::bufadaptorT* rdbuf() const 
     { 
-      return const_cast<baseBufT*>(&bufadaptor_); 
+      return const_cast<typename baseBufT::bufadaptorT*>(&bufadaptor_); 
     } // rdbuf
 
     void set_stream(fromStreamT& fromStream) { bufadaptor_.set_buffer(*fromStream.rdbuf()); }
@@ -320,8 +365,8 @@ class oconvert_adaptor : private convert_adaptor_buffer<charT, traitsT, toCharT,
   protected:
     using baseBufT::bufadaptor_;
   public:
-    explicit oconvert_adaptor(toStreamT &toStream) :
-      baseBufT(*(toStream.rdbuf())),
+    explicit oconvert_adaptor(toStreamT &toStream, size_t bufferSize = baseBufT::bufadaptorT::defaultBufferSize) :
+      baseBufT(*(toStream.rdbuf()), bufferSize),
       baseStreamT(&bufadaptor_)
       {
       } // oconvert_adaptor
@@ -331,9 +376,9 @@ class oconvert_adaptor : private convert_adaptor_buffer<charT, traitsT, toCharT,
       baseStreamT::flush(); 
     } // ~oconvert_adaptor
 
-    convert_bufadaptor<charT, traitsT>* rdbuf() const
+    typename baseBufT::bufadaptorT* rdbuf() const
     {
-      return const_cast<convert_bufadaptor<charT, traitsT, toCharT, toTraitsT>*>(&bufadaptor_); 
+      return const_cast<typename baseBufT::bufadaptorT*>(&bufadaptor_); 
     } // rdbuf
 
     void set_stream(toStreamT& toStream) { bufadaptor_.set_buffer(*toStream.rdbuf()); }
@@ -0,0 +1,138 @@
+#ifndef ARABICA_MAPPED_FILE_H
+#define ARABICA_MAPPED_FILE_H
+///////////////////////////////////////////////////////////////////////
+//
+// mapped_file.hpp
+//
+// mapped_file is a read-only memory mapping of a whole file.
+// basic_memorybuf is a streambuf whose get area is a block of memory
+// owned by someone else, so reading through it copies nothing until the
+// caller's own read.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include <SAX/ArabicaConfig.hpp>
+#include <streambuf>
+#include <istream>
+#include <string>
+#include <cstddef>
+#include <cstring>
+
+namespace Arabica
+{
+namespace io
+{
+
+///////////////////////////////////////////////////////////
+// mapped_file
+class mapped_file
+{
+  public:
+    mapped_file();
+    explicit mapped_file(const std::string& path);
+    ~mapped_file();
+
+    // Maps the file for sequential reading.  Fails for files that can't
+    // be opened, that aren't regular files, and for empty files, which
+    // have nothing to map.
+    bool open(const std::string& path);
+    void close();
+
+    bool is_open() const { return data_ != 0; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+  private:
+    const char* data_;
+    size_t size_;
+#ifdef _WIN32
+    void* file_;
+    void* mapping_;
+#endif
+
+    // no impl
+    mapped_file(const mapped_file&);
+    mapped_file& operator=(const mapped_file&);
+}; // class mapped_file
+
+///////////////////////////////////////////////////////////
+// basic_memorybuf
+template<class charT, class traitsT = std::char_traits<charT> >
+class basic_memorybuf : public std::basic_streambuf<charT, traitsT>
+{
+  public:
+    typedef typename traitsT::int_type int_type;
+    typedef typename traitsT::pos_type pos_type;
+    typedef typename traitsT::off_type off_type;
+
+    using std::basic_streambuf<charT, traitsT>::setg;
+    using std::basic_streambuf<charT, traitsT>::gptr;
+    using std::basic_streambuf<charT, traitsT>::egptr;
+    using std::basic_streambuf<charT, traitsT>::eback;
+
+    basic_memorybuf(const charT* begin, const charT* end)
+    {
+      charT* b = const_cast<charT*>(begin);
+      setg(b, b, b + (end - begin));
+    } // basic_memorybuf
+
+  protected:
+    virtual std::streamsize showmanyc()
+    {
+      return (gptr() != egptr()) ? (egptr() - gptr()) : -1;
+    } // showmanyc
+
+    virtual std::streamsize xsgetn(charT* s, std::streamsize n)
+    {
+      std::streamsize available = egptr() - gptr();
+      if(n > available)
+        n = available;
+      traitsT::copy(s, gptr(), static_cast<size_t>(n));
+      setg(eback(), gptr() + n, egptr());
+      return n;
+    } // xsgetn
+
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::in)
+    {
+      off_type base = 0;
+      if(dir == std::ios_base::cur)
+        base = gptr() - eback();
+      else if(dir == std::ios_base::end)
+        base = egptr() - eback();
+      return seekpos(pos_type(base + off), which);
+    } // seekoff
+
+    virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in)
+    {
+      off_type off = pos;
+      if(!(which & std::ios_base::in) || off < 0 || off > egptr() - eback())
+        return pos_type(off_type(-1));
+      setg(eback(), eback() + off, egptr());
+      return pos;
+    } // seekpos
+}; // class basic_memorybuf
+
+///////////////////////////////////////////////////////////
+// basic_imemorystream
+template<class charT, class traitsT = std::char_traits<charT> >
+class basic_imemorystream : public std::basic_istream<charT, traitsT>
+{
+  public:
+    basic_imemorystream(const charT* begin, const charT* end) :
+      std::basic_istream<charT, traitsT>(0),
+      buf_(begin, end)
+    {
+      std::basic_istream<charT, traitsT>::init(&buf_);
+    } // basic_imemorystream
+
+  private:
+    basic_memorybuf<charT, traitsT> buf_;
+}; // class basic_imemorystream
+
+typedef basic_memorybuf<char> memorybuf;
+typedef basic_imemorystream<char> imemorystream;
+
+} // namespace io
+} // namespace Arabica
+
+#endif
@@ -18,8 +18,11 @@
 #include <sys/un.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
+#include <sys/uio.h>
 #include <unistd.h>
+#include <errno.h>
 #else
 #include <winsock.h>
 #endif
@@ -58,12 +61,21 @@ class basic_socketbuf : public std::basic_streambuf<charT, traitsT>
     using std::basic_streambuf<charT, traitsT>::egptr;
     using std::basic_streambuf<charT, traitsT>::eback;
     using std::basic_streambuf<charT, traitsT>::pptr;
+    using std::basic_streambuf<charT, traitsT>::pbase;
+    using std::basic_streambuf<charT, traitsT>::epptr;
+    using std::basic_streambuf<charT, traitsT>::pbump;
     using std::basic_streambuf<charT, traitsT>::sputc;
 
-    basic_socketbuf();
+    // bufferSize is the size, in characters, of each of the input and
+    // output buffers.  Reads and writes larger than the buffer go
+    // directly between the socket and the caller's memory.
+    explicit basic_socketbuf(size_t bufferSize = defaultBufferSize);
     virtual ~basic_socketbuf();
 
     bool is_open() const;
+    size_t buffer_size() const { return bufferSize_; }
+
+    static const size_t defaultBufferSize;
 
     basic_socketbuf<charT, traitsT>* open(const char* hostname, unsigned short port);
     basic_socketbuf<charT, traitsT>* close();
@@ -73,23 +85,21 @@ class basic_socketbuf : public std::basic_streambuf<charT, traitsT>
     virtual int sync();
     virtual int_type underflow();
     virtual int_type pbackfail(int_type c);
+    virtual std::streamsize xsputn(const charT* s, std::streamsize n);
+    virtual std::streamsize xsgetn(charT* s, std::streamsize n);
 
   private:
-    typedef typename traitsT::state_type state_t;
-
     int sock_;
+    size_t bufferSize_;
     std::vector<charT> outBuffer_;
-    state_t outState_;
     std::vector<charT> inBuffer_;
-    state_t inState_;
 
-    void growOutBuffer();
     bool writeSocket();
+    bool sendAll(const charT* first, size_t firstCount, const charT* second, size_t secondCount);
     void growInBuffer();
     int readSocket();
     int closeSocket(int sock) const;
 
-    static const size_t bufferSize_;
     static const size_t pbSize_;
 
 #ifndef ARABICA_USE_WINSOCK
@@ -99,7 +109,7 @@ class basic_socketbuf : public std::basic_streambuf<charT, traitsT>
 }; // class basic_socketbuf
 
 template<class charT, class traitsT>
-const size_t basic_socketbuf<charT, traitsT>::bufferSize_ = 1024;
+const size_t basic_socketbuf<charT, traitsT>::defaultBufferSize = 64 * 1024;
 template<class charT, class traitsT>
 const size_t basic_socketbuf<charT, traitsT>::pbSize_ = 4;
   // why 4? both Josuttis and Langer&Kreft use 4.
@@ -113,15 +123,13 @@ const int basic_socketbuf<charT, traitsT>::SOCKET_ERROR = -1;
 ///////////////////////////////////////////////////////////
 // basic_socketbuf definition
 template<class charT, class traitsT>
-basic_socketbuf<charT, traitsT>::basic_socketbuf()
+basic_socketbuf<charT, traitsT>::basic_socketbuf(size_t bufferSize)
      : std::basic_streambuf<charT, traitsT>(),
        sock_(INVALID_SOCKET),
+       bufferSize_(bufferSize ? bufferSize : 1),
        outBuffer_(0),
        inBuffer_(0)
 {
-//  outState_ = 0;
-//  inState_ = 0;
-
   setp(0, 0);
   setg(0, 0, 0);
 } // basic_socketbuf
@@ -179,6 +187,11 @@ basic_socketbuf<charT, traitsT>* basic_socketbuf<charT, traitsT>::open(const cha
     return 0;
   }
 
+  // output is already gathered into large writes, so there's nothing
+  // to gain from the kernel holding back the tail of each one
+  int nodelay = 1;
+  setsockopt(tmpsock, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&nodelay), sizeof(nodelay));
+
   // hurray, we've connected so initialise everything else we need to
   sock_ = tmpsock;
 
@@ -208,7 +221,14 @@ typename basic_socketbuf<charT, traitsT>::int_type basic_socketbuf<charT, traits
   if(!is_open())
     return traitsT::eof();
 
-  growOutBuffer();
+  if(outBuffer_.empty())
+  {
+    outBuffer_.resize(bufferSize_);
+    setp(&outBuffer_[0], &outBuffer_[0] + outBuffer_.size());
+  } // if ...
+  else if(!writeSocket())
+    return traitsT::eof();
+
   sputc(traitsT::to_char_type(c));
 
   return traitsT::not_eof(c);
@@ -248,37 +268,153 @@ typename basic_socketbuf<charT, traitsT>::int_type basic_socketbuf<charT, traits
 } // pbackfail
 
 template<class charT, class traitsT>
-void basic_socketbuf<charT, traitsT>::growOutBuffer()
+std::streamsize basic_socketbuf<charT, traitsT>::xsputn(const charT* s, std::streamsize n)
 {
-  size_t oldsize = outBuffer_.capacity();
-  size_t newsize = (oldsize ? oldsize*2 : bufferSize_);
-  outBuffer_.resize(newsize);
-  
-  char* out_begin = &(outBuffer_[0]);
-  setp(out_begin + oldsize, out_begin + newsize);
-} // growOutBuffer
+  if(outBuffer_.empty() && static_cast<size_t>(n) < bufferSize_)
+  {
+    outBuffer_.resize(bufferSize_);
+    setp(&outBuffer_[0], &outBuffer_[0] + outBuffer_.size());
+  } // if ...
+
+  if(n <= epptr() - pptr())
+  {
+    traitsT::copy(pptr(), s, static_cast<size_t>(n));
+    pbump(static_cast<int>(n));
+    return n;
+  } // if ...
+
+  if(!is_open())
+    return 0;
+
+  // doesn't fit, so whatever is buffered and the new characters go
+  // out together in one write
+  if(!sendAll(pbase(), pptr() - pbase(), s, static_cast<size_t>(n)))
+    return 0;
+  if(!outBuffer_.empty())
+    setp(&outBuffer_[0], &outBuffer_[0] + outBuffer_.size());
+
+  return n;
+} // xsputn
+
+template<class charT, class traitsT>
+std::streamsize basic_socketbuf<charT, traitsT>::xsgetn(charT* s, std::streamsize n)
+{
+  std::streamsize got = std::min<std::streamsize>(n, egptr() - gptr());
+  traitsT::copy(s, gptr(), static_cast<size_t>(got));
+  setg(eback(), gptr() + got, egptr());
+
+#ifndef ARABICA_USE_WINSOCK
+  // the rest is read straight into the caller's memory, and anything the
+  // socket has beyond that lands in the input buffer
+  while(got != n && is_open())
+  {
+    if(inBuffer_.empty())
+      growInBuffer();
+
+    size_t wanted = static_cast<size_t>(n - got);
+    iovec iov[2];
+    iov[0].iov_base = s + got;
+    iov[0].iov_len = wanted * sizeof(charT);
+    iov[1].iov_base = &inBuffer_[0] + pbSize_;
+    iov[1].iov_len = (inBuffer_.size() - pbSize_) * sizeof(charT);
+
+    ssize_t res = ::readv(sock_, iov, 2);
+    if(res == SOCKET_ERROR && errno == EINTR)
+      continue;
+    if(res <= 0)
+    {
+      close();
+      break;
+    } // if ...
+
+    size_t count = static_cast<size_t>(res) / sizeof(charT);
+    size_t direct = std::min(count, wanted);
+    got += direct;
+
+    // the last few characters the caller got are kept for putback
+    size_t pbCount = std::min<size_t>(got, pbSize_);
+    charT* to_begin = &(inBuffer_[0]) + pbSize_;
+    traitsT::copy(to_begin - pbCount, s + got - pbCount, pbCount);
+    setg(to_begin - pbCount, to_begin, to_begin + (count - direct));
+  } // while ...
+#else
+  if(got != n)
+    got += std::basic_streambuf<charT, traitsT>::xsgetn(s + got, n - got);
+#endif
+
+  return got;
+} // xsgetn
 
 template<class charT, class traitsT>
 bool basic_socketbuf<charT, traitsT>::writeSocket()
 {
-  // write to the socket
-  charT* from_next = &(outBuffer_[0]);
-  size_t length = pptr() - from_next;
-  if(!length)
+  if(pbase() == pptr())
     return true;
 
-  bool ok = (send(sock_, from_next, static_cast<int>(length), 0) != SOCKET_ERROR);
+  bool ok = sendAll(pbase(), pptr() - pbase(), 0, 0);
 
   if(ok)
-    setp(from_next, from_next + outBuffer_.capacity());
+    setp(&outBuffer_[0], &outBuffer_[0] + outBuffer_.size());
 
   return ok;
 } // writeSocket
 
+template<class charT, class traitsT>
+bool basic_socketbuf<charT, traitsT>::sendAll(const charT* first, size_t firstCount, const charT* second, size_t secondCount)
+{
+  const char* data[2] = { reinterpret_cast<const char*>(first), reinterpret_cast<const char*>(second) };
+  size_t length[2] = { firstCount * sizeof(charT), secondCount * sizeof(charT) };
+
+#ifndef ARABICA_USE_WINSOCK
+  while(length[0] + length[1] != 0)
+  {
+    iovec iov[2];
+    int count = 0;
+    for(int i = 0; i != 2; ++i)
+      if(length[i] != 0)
+      {
+        iov[count].iov_base = const_cast<char*>(data[i]);
+        iov[count].iov_len = length[i];
+        ++count;
+      } // if ...
+
+    ssize_t sent = ::writev(sock_, iov, count);
+    if(sent == SOCKET_ERROR)
+    {
+      if(errno == EINTR)
+        continue;
+      return false;
+    } // if ...
+
+    // a short write leaves the remainder for the next time round
+    size_t done = static_cast<size_t>(sent);
+    for(int i = 0; i != 2; ++i)
+    {
+      size_t n = std::min(done, length[i]);
+      data[i] += n;
+      length[i] -= n;
+      done -= n;
+    } // for ...
+  } // while ...
+#else
+  for(int i = 0; i != 2; ++i)
+    while(length[i] != 0)
+    {
+      int sent = send(sock_, data[i], static_cast<int>(std::min<size_t>(length[i], 0x7fffffff)), 0);
+      if(sent == SOCKET_ERROR)
+        return false;
+      data[i] += sent;
+      length[i] -= sent;
+    } // while ...
+#endif
+
+  return true;
+} // sendAll
+
 template<class charT, class traitsT>
 void basic_socketbuf<charT, traitsT>::growInBuffer()
 {
-  size_t oldsize = inBuffer_.capacity();
+  size_t oldsize = inBuffer_.size();
   size_t newsize = (oldsize ? oldsize*2 : bufferSize_+pbSize_);
   inBuffer_.resize(newsize);
 } // growInBuffer
@@ -286,16 +422,14 @@ void basic_socketbuf<charT, traitsT>::growInBuffer()
 template <class charT, class traitsT>
 int basic_socketbuf<charT, traitsT>::readSocket()
 {
-  if(!inBuffer_.capacity())
+  if(inBuffer_.empty())
     growInBuffer();
 
   size_t pbCount = std::min<size_t>(gptr() - eback(), pbSize_);
+  charT* to_begin = &(inBuffer_[0]) + pbSize_;
+  traitsT::move(to_begin - pbCount, gptr() - pbCount, pbCount);
 
-  memcpy(&(inBuffer_[0]) + (pbSize_-pbCount)*sizeof(charT), 
-         gptr() - pbCount*sizeof(charT),
-         pbCount*sizeof(charT));
-
-  int res = recv(sock_, &(inBuffer_[0]) + pbSize_, static_cast<int>(inBuffer_.capacity() - pbSize_), 0);
+  int res = recv(sock_, reinterpret_cast<char*>(to_begin), static_cast<int>((inBuffer_.size() - pbSize_) * sizeof(charT)), 0);
   if(res == 0)
   {
     // server closed the socket
@@ -308,9 +442,13 @@ int basic_socketbuf<charT, traitsT>::readSocket()
     if(GetLastError() == WSAEMSGSIZE)
     {
       // buffer was too small, so make it bigger
+      setg(0, 0, 0);
       growInBuffer();
       return readSocket();
     } // if(GetLastError() != WSAEMSGSIZE)
+#else
+    if(errno == EINTR)
+      return readSocket();
 #endif 
 
     // unclever error handling
@@ -318,12 +456,13 @@ int basic_socketbuf<charT, traitsT>::readSocket()
     return 0;
   } // if(res == SOCKET_ERROR)
 
-  charT* to_begin = &(inBuffer_[0]) + pbSize_;
-  setg(to_begin - pbCount, to_begin, to_begin + res);
+  size_t count = static_cast<size_t>(res) / sizeof(charT);
+  setg(to_begin - pbCount, to_begin, to_begin + count);
 
-  return res;
+  return static_cast<int>(count);
 } // readSocket
 
+
 template <class charT, class traitsT>
 int basic_socketbuf<charT, traitsT>::closeSocket(int sock) const
 {
@@ -342,6 +481,11 @@ class socketstreambuf_init
 public:
   typedef basic_socketbuf<charT, traitsT> sockbuf;
 
+  explicit socketstreambuf_init(size_t bufferSize = sockbuf::defaultBufferSize) :
+    buf_(bufferSize)
+  {
+  } // socketstreambuf_init
+
   sockbuf* buf() const
   {
     return &buf_;
@@ -360,8 +504,8 @@ class basic_socketstream :
     using std::basic_iostream<charT, traitsT>::setstate;
     using std::basic_iostream<charT, traitsT>::badbit;
 
-    basic_socketstream();
-    explicit basic_socketstream(const char* hostname, int port);
+    explicit basic_socketstream(size_t bufferSize = basic_socketbuf<charT, traitsT>::defaultBufferSize);
+    basic_socketstream(const char* hostname, int port, size_t bufferSize = basic_socketbuf<charT, traitsT>::defaultBufferSize);
 
     virtual ~basic_socketstream();
 
@@ -374,15 +518,15 @@ class basic_socketstream :
 ////////////////////////////////////////////////////////////////
 // basic_socketstream definition
 template<class charT, class traitsT>
-basic_socketstream<charT, traitsT>::basic_socketstream() :
-    socketstreambuf_init<charT, traitsT>(), 
+basic_socketstream<charT, traitsT>::basic_socketstream(size_t bufferSize) :
+    socketstreambuf_init<charT, traitsT>(bufferSize), 
     std::basic_iostream<charT, traitsT>(socketstreambuf_init<charT, traitsT>::buf())
 {
 } // basic_socketstream
 
 template<class charT, class traitsT>
-basic_socketstream<charT, traitsT>::basic_socketstream(const char* hostname, int port) :
-    socketstreambuf_init<charT, traitsT>(), 
+basic_socketstream<charT, traitsT>::basic_socketstream(const char* hostname, int port, size_t bufferSize) :
+    socketstreambuf_init<charT, traitsT>(bufferSize), 
     std::basic_iostream<charT, traitsT>(socketstreambuf_init<charT, traitsT>::buf())
 {
   open(hostname, port);
@@ -4,43 +4,39 @@
 #include <Arabica/StringAdaptor.hpp>
 #include <XML/XMLCharacterClasses.hpp>
 #include <text/UnicodeCharacters.hpp>
+#include <text/string_kernels.hpp>
 
 namespace Arabica
 {
 namespace text
 {
 
+// the string adaptors keep their characters one after the other, so the
+// whitespace can be collapsed in place in a copy of the string
 template<class string_type, class string_adaptor>
 inline string_type normalize_whitespace(const string_type& ch)
 {
-  std::string value = string_adaptor::asStdString(ch);
-  std::string stripped = normalize_whitespace<std::string, Arabica::default_string_adaptor<std::string> >(value);
-  return string_adaptor::construct_from_utf8(stripped.c_str());
+  if(string_adaptor::empty(ch))
+    return ch;
+
+  string_type value(ch);
+  typename string_adaptor::value_type* begin = &*string_adaptor::begin(value);
+  typename string_adaptor::value_type* end = begin + string_adaptor::length(value);
+  typename string_adaptor::value_type* last = collapse_whitespace(begin, end, begin);
+  if(last == end)
+    return value;
+  return string_adaptor::construct(string_adaptor::begin(value), string_adaptor::begin(value) + (last - begin));
 } // normalize_whitespace
 
 template<>
 inline std::string normalize_whitespace<std::string, Arabica::default_string_adaptor<std::string> >(const std::string& ch)
 {
   std::string value(ch);
-  std::string::const_iterator i = value.begin(), ie = value.end();
-  std::string::iterator p = value.begin(), pe = value.end();
-
-  // string leading space
-  while((i != ie) && (Arabica::XML::is_space(static_cast<char>(*i))))
-    ++i;
-    
-  while(i != ie)
+  if(!value.empty())
   {
-    while((i != ie) && (!Arabica::XML::is_space(static_cast<char>(*i)))) 
-      *p++ = *i++;
-    while((i != ie) && (Arabica::XML::is_space(static_cast<char>(*i))))
-      ++i;
-    if(i != ie)
-      *p++ = Arabica::text::Unicode<char>::SPACE;
-  } // while ...
-  if(p != pe)
-    value.erase(p, pe);
-
+    char* begin = &value[0];
+    value.resize(collapse_whitespace(begin, begin + value.size(), begin) - begin);
+  } // if ...
   return value;
 } // normalize_whitespace
 
@@ -0,0 +1,208 @@
+#ifndef ARABICA_TEXT_STRING_KERNELS_HPP
+#define ARABICA_TEXT_STRING_KERNELS_HPP
+
+/**
+The loops underneath normalize_whitespace and the XPath string functions.
+
+They work on characters stored one after the other, as every string
+adaptor's are, between a pair of pointers.  Those which change a string
+write their result over the characters they read and return the new end,
+so the caller only has to shorten the string.
+
+Each is a template for any character type, with a quicker version for char
+- memchr and memcmp for the searches, a 256 entry table for translate, and
+SSE2 (see Arabica/simd.hpp) to copy the words between whitespace 16
+characters at a time.  All of them treat a string as a sequence of
+characters, so a UTF-8 std::string is a sequence of bytes, as it always has
+been for translate().
+**/
+
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <Arabica/simd.hpp>
+#include <text/UnicodeCharacters.hpp>
+
+namespace Arabica
+{
+namespace text
+{
+
+// the same characters as XML::is_space, but inline
+template<typename charT>
+inline bool is_whitespace(charT c)
+{
+  typedef Unicode<charT> UnicodeT;
+  return (c == UnicodeT::SPACE) ||
+         (c == UnicodeT::HORIZONTAL_TABULATION) ||
+         (c == UnicodeT::CARRIAGE_RETURN) ||
+         (c == UnicodeT::LINE_FEED);
+} // is_whitespace
+
+//////////////////////////////////////////////////
+// the first c in [begin, end), or end
+template<typename charT>
+inline const charT* find_char(const charT* begin, const charT* end, charT c)
+{
+  return std::find(begin, end, c);
+} // find_char
+
+inline const char* find_char(const char* begin, const char* end, char c)
+{
+  if(begin == end)
+    return end;
+  const void* found = std::memchr(begin, c, end - begin);
+  return found ? static_cast<const char*>(found) : end;
+} // find_char
+
+//////////////////////////////////////////////////
+// the first occurrence of [what, what_end) in [begin, end), or end
+template<typename charT>
+inline const charT* find_string(const charT* begin, const charT* end, const charT* what, const charT* what_end)
+{
+  return std::search(begin, end, what, what_end);
+} // find_string
+
+inline const char* find_string(const char* begin, const char* end, const char* what, const char* what_end)
+{
+  const size_t length = what_end - what;
+  if(length == 0)
+    return begin;
+  if(static_cast<size_t>(end - begin) < length)
+    return end;
+
+  // memchr to the next place the first character is, then memcmp the rest
+  const char* const last_start = end - length;
+  for(const char* c = begin; c <= last_start; ++c)
+  {
+    c = static_cast<const char*>(std::memchr(c, *what, last_start - c + 1));
+    if(c == 0)
+      break;
+    if(std::memcmp(c + 1, what + 1, length - 1) == 0)
+      return c;
+  } // for ...
+  return end;
+} // find_string
+
+template<typename charT>
+inline bool starts_with(const charT* begin, const charT* end, const charT* what, const charT* what_end)
+{
+  return ((what_end - what) <= (end - begin)) && std::equal(what, what_end, begin);
+} // starts_with
+
+//////////////////////////////////////////////////
+// normalize-space - strips leading and trailing whitespace and replaces
+// each run of whitespace in between with a single space, writing the
+// result to out, which may be begin
+template<typename charT>
+charT* collapse_whitespace(const charT* begin, const charT* end, charT* out)
+{
+  while((begin != end) && is_whitespace(*begin))
+    ++begin;
+
+  while(begin != end)
+  {
+    while((begin != end) && !is_whitespace(*begin))
+      *out++ = *begin++;
+    while((begin != end) && is_whitespace(*begin))
+      ++begin;
+    if(begin != end)
+      *out++ = Unicode<charT>::SPACE;
+  } // while ...
+  return out;
+} // collapse_whitespace
+
+inline char* collapse_whitespace(const char* begin, const char* end, char* out)
+{
+  while((begin != end) && is_whitespace(*begin))
+    ++begin;
+
+#if defined(ARABICA_SSE2)
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+#endif
+  while(begin != end)
+  {
+#if defined(ARABICA_SSE2)
+    // whole blocks without whitespace are stored in one go - out is never
+    // ahead of begin, so that only overwrites characters already loaded
+    while(end - begin >= 16)
+    {
+      const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+      const __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space),
+                                                     _mm_cmpeq_epi8(chunk, tab)),
+                                        _mm_or_si128(_mm_cmpeq_epi8(chunk, cr),
+                                                     _mm_cmpeq_epi8(chunk, lf)));
+      const unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(hits));
+      if(mask != 0)
+      {
+        const unsigned int word = simd::first_set_bit(mask);
+        std::memmove(out, begin, word);
+        out += word;
+        begin += word;
+        break;
+      } // if ...
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out), chunk);
+      out += 16;
+      begin += 16;
+    } // while ...
+#endif
+    while((begin != end) && !is_whitespace(*begin))
+      *out++ = *begin++;
+    while((begin != end) && is_whitespace(*begin))
+      ++begin;
+    if(begin != end)
+      *out++ = Unicode<char>::SPACE;
+  } // while ...
+  return out;
+} // collapse_whitespace
+
+//////////////////////////////////////////////////
+// translate() - replaces each character in [begin, end) which appears in
+// [from, from_end) with the character at the same position in [to,
+// to_end), or removes it if to is shorter.  The first occurrence in from
+// counts.  Returns the new end.
+template<typename charT>
+charT* translate(charT* begin, charT* end, const charT* from, const charT* from_end, const charT* to, const charT* to_end)
+{
+  const size_t to_length = to_end - to;
+  charT* out = begin;
+  for( ; begin != end; ++begin)
+  {
+    const size_t at = std::find(from, from_end, *begin) - from;
+    if(from + at == from_end)
+      *out++ = *begin;
+    else if(at < to_length)
+      *out++ = to[at];
+  } // for ...
+  return out;
+} // translate
+
+inline char* translate(char* begin, char* end, const char* from, const char* from_end, const char* to, const char* to_end)
+{
+  // what each byte becomes, or -1 to remove it - filled in from the back of
+  // from, so the first occurrence is the one left in the table
+  short table[256];
+  for(int c = 0; c != 256; ++c)
+    table[c] = static_cast<short>(c);
+  const ptrdiff_t to_length = to_end - to;
+  for(ptrdiff_t f = from_end - from - 1; f >= 0; --f)
+    table[static_cast<unsigned char>(from[f])] =
+      (f < to_length) ? static_cast<short>(static_cast<unsigned char>(to[f])) : static_cast<short>(-1);
+
+  char* out = begin;
+  for( ; begin != end; ++begin)
+  {
+    const short c = table[static_cast<unsigned char>(*begin)];
+    if(c != -1)
+      *out++ = static_cast<char>(c);
+  } // for ...
+  return out;
+} // translate
+
+} // namespace text
+} // namespace Arabica
+
+#endif // ARABICA_TEXT_STRING_KERNELS_HPP
@@ -0,0 +1,16 @@
+AC_DEFUN([ARABICA_WANT_STATS],
+[
+  AC_ARG_ENABLE([stats],
+              AS_HELP_STRING([--enable-stats],
+              [Build with the parser, DOM, XPath and XSLT statistics counters and timers.  Needs C++11]),
+              [if test "$enableval" = "yes"; then
+                 want_stats="yes"
+               else
+                 want_stats="no"
+               fi],
+              [want_stats="no"])
+  if test "$want_stats" = "yes"; then
+    AC_DEFINE([STATS], ,[define to build with statistics counters and timers])
+    AC_MSG_NOTICE([[Statistics counters and timers enabled.]])
+  fi
+])
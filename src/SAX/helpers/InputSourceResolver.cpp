@@ -15,10 +15,22 @@
 
 using namespace Arabica::SAX;
 
+namespace 
+{
+  std::istream* fileResolver(const std::string& fileURI);
+} // namespace
+
 void InputSourceResolver::open(const std::string& /* publicId */, 
             const std::string& systemId,
             std::istream* byteStream)
 {
+    if(bytes_ != 0)
+    {
+      byteStream_ = new Arabica::io::imemorystream(bytes_, bytes_ + byteCount_);
+      deleteStream_ = true;
+      return;
+    } // if ...
+
     if(byteStream != 0)
     {
       byteStream_ = byteStream;
@@ -30,6 +42,10 @@ void InputSourceResolver::open(const std::string& /* publicId */,
     if(!url.scheme().empty())
     {
       URIResolver res = findResolver(url.scheme());
+      // local files are mapped, unless someone has registered their
+      // own way of reading them
+      if(res == fileResolver && openMapped(url.path()))
+        return;
       if(res)
         byteStream_ = res(systemId);
       if(byteStream_)
@@ -40,6 +56,9 @@ void InputSourceResolver::open(const std::string& /* publicId */,
     } // if ...
 
     // try and open it as a file
+    if(openMapped(url.path()))
+      return;
+
     std::ifstream* ifs = new std::ifstream(url.path().c_str());
     if(ifs->is_open())
     {
@@ -50,8 +69,21 @@ void InputSourceResolver::open(const std::string& /* publicId */,
       delete ifs;
 } // InputSourceResolver
 
+bool InputSourceResolver::openMapped(const std::string& path)
+{
+  if(!mapping_.open(path))
+    return false;
+
+  bytes_ = mapping_.data();
+  byteCount_ = mapping_.size();
+  byteStream_ = new Arabica::io::imemorystream(bytes_, bytes_ + byteCount_);
+  deleteStream_ = true;
+  return true;
+} // openMapped
+
 InputSourceResolver::~InputSourceResolver()
 {
+  // the stream may be reading from the mapping, so goes first
   if(deleteStream_)
     delete byteStream_;
 } // ~InputSourceResolver
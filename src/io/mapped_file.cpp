@@ -0,0 +1,134 @@
+#ifdef _MSC_VER
+#pragma warning(disable: 4786)
+#endif
+
+#include <io/mapped_file.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace Arabica::io;
+
+mapped_file::mapped_file() :
+  data_(0),
+  size_(0)
+#ifdef _WIN32
+  , file_(INVALID_HANDLE_VALUE),
+  mapping_(0)
+#endif
+{
+} // mapped_file
+
+mapped_file::mapped_file(const std::string& path) :
+  data_(0),
+  size_(0)
+#ifdef _WIN32
+  , file_(INVALID_HANDLE_VALUE),
+  mapping_(0)
+#endif
+{
+  open(path);
+} // mapped_file
+
+mapped_file::~mapped_file()
+{
+  close();
+} // ~mapped_file
+
+#ifndef _WIN32
+bool mapped_file::open(const std::string& path)
+{
+  close();
+
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if(fd == -1)
+    return false;
+
+  struct stat st;
+  if(::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+  {
+    ::close(fd);
+    return false;
+  } // if ...
+
+  size_t size = static_cast<size_t>(st.st_size);
+  void* p = ::mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);    // the mapping holds its own reference to the file
+  if(p == MAP_FAILED)
+    return false;
+
+#ifdef MADV_SEQUENTIAL
+  ::madvise(p, size, MADV_SEQUENTIAL);
+#endif
+
+  data_ = static_cast<const char*>(p);
+  size_ = size;
+  return true;
+} // open
+
+void mapped_file::close()
+{
+  if(data_)
+    ::munmap(const_cast<char*>(data_), size_);
+  data_ = 0;
+  size_ = 0;
+} // close
+
+#else
+
+bool mapped_file::open(const std::string& path)
+{
+  close();
+
+  file_ = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+  if(file_ == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER size;
+  if(!::GetFileSizeEx(file_, &size) || size.QuadPart == 0 || static_cast<unsigned long long>(size.QuadPart) > static_cast<size_t>(-1))
+  {
+    close();
+    return false;
+  } // if ...
+
+  mapping_ = ::CreateFileMappingA(file_, 0, PAGE_READONLY, 0, 0, 0);
+  if(mapping_ == 0)
+  {
+    close();
+    return false;
+  } // if ...
+
+  data_ = static_cast<const char*>(::MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+  if(data_ == 0)
+  {
+    close();
+    return false;
+  } // if ...
+  size_ = static_cast<size_t>(size.QuadPart);
+  return true;
+} // open
+
+void mapped_file::close()
+{
+  if(data_)
+    ::UnmapViewOfFile(data_);
+  if(mapping_)
+    ::CloseHandle(mapping_);
+  if(file_ != INVALID_HANDLE_VALUE)
+    ::CloseHandle(file_);
+  data_ = 0;
+  size_ = 0;
+  mapping_ = 0;
+  file_ = INVALID_HANDLE_VALUE;
+} // close
+
+#endif
+
+// end of file
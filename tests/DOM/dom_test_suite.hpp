@@ -20,6 +20,8 @@
 #include "test_TreeWalker.hpp"
 #include "test_NamedNodeMap.hpp"
 #include "test_Stream.hpp"
+#include "test_Writer.hpp"
+#include "test_DualMode.hpp"
 
 #include "conformance/level1/core/alltests.hpp"
 
@@ -43,6 +45,8 @@ bool DOM_test_suite(int argc, const char** argv)
   runner.addTest("NamedNodeMapTest", NamedNodeMapTest_suite<string_type, string_adaptor>());
   runner.addTest("TreeWalkerTest", TreeWalkerTest_suite<string_type, string_adaptor>());
   runner.addTest("StreamTest", StreamTest_suite<string_type, string_adaptor>());
+  runner.addTest("WriterTest", WriterTest_suite<string_type, string_adaptor>());
+  runner.addTest("DualModeTest", DualModeTest_suite<string_type, string_adaptor>());
 
   runner.addTest("level1-core", DOM_Level_1_Core_Test_Suite<string_type, string_adaptor>());
 
@@ -0,0 +1,223 @@
+#ifndef test_DualMode_HPP
+#define test_DualMode_HPP
+
+#include "../CppUnit/framework/TestCase.h"
+#include "../CppUnit/framework/TestSuite.h"
+#include "../CppUnit/framework/TestCaller.h"
+#include <sstream>
+#include <vector>
+#include <DOM/DualMode/DualMode.hpp>
+#include <SAX/helpers/CatchErrorHandler.hpp>
+
+template<class string_type, class string_adaptor>
+class DualModeTest : public TestCase
+{
+  typedef string_adaptor SA;
+  typedef Arabica::DualMode::Parser<string_type, string_adaptor> ParserT;
+  typedef Arabica::DOM::Node<string_type, string_adaptor> NodeT;
+  typedef Arabica::DOM::Element<string_type, string_adaptor> ElementT;
+  typedef Arabica::DOM::Document<string_type, string_adaptor> DocumentT;
+
+  // notes down each element, and what it's in
+  struct Recorder
+  {
+    Recorder(std::string& seen) : seen_(&seen) { }
+
+    void operator()(NodeT& parent, NodeT& element)
+    {
+      *seen_ += SA::asStdString(parent.getNodeName()) + "/" + SA::asStdString(element.getNodeName()) + " ";
+    } // operator()
+
+    std::string* seen_;
+  }; // struct Recorder
+
+  // releases every item the same way, and totals their n attributes
+  struct Releaser
+  {
+    Releaser(Arabica::DualMode::Release release, int& total, std::vector<NodeT>* detached = 0) :
+      release_(release), total_(&total), detached_(detached) { }
+
+    Arabica::DualMode::Release operator()(NodeT& /* parent */, NodeT& element)
+    {
+      if(element.getLocalName() != SA::construct_from_utf8("item"))
+        return Arabica::DualMode::KEEP;
+      ElementT item(element);
+      std::istringstream n(SA::asStdString(item.getAttribute(SA::construct_from_utf8("n"))));
+      int value = 0;
+      n >> value;
+      *total_ += value;
+      if(item.hasAttribute(SA::construct_from_utf8("keep")))
+        return Arabica::DualMode::KEEP;
+      if(detached_ != 0)
+        detached_->push_back(element);
+      return release_;
+    } // operator()
+
+    Arabica::DualMode::Release release_;
+    int* total_;
+    std::vector<NodeT>* detached_;
+  }; // struct Releaser
+
+  public:
+    DualModeTest(std::string name) :
+        TestCase(name)
+    {
+    } // DualModeTest
+
+    void setUp()
+    {
+    } // setUp
+
+    void testEndHandlerKeepsEverything()
+    {
+      std::string seen;
+      ParserT parser;
+      parser.setElementEndHandler(Recorder(seen));
+      DocumentT doc = parse(parser, items());
+
+      assertEquals("head/title root/head item/b root/item root/item root/item root/tail #document/root ", seen);
+      assertEquals("head item item item tail ", children(doc.getDocumentElement()));
+    } // testEndHandlerKeepsEverything
+
+    void testDiscard()
+    {
+      int total = 0;
+      ParserT parser;
+      parser.setElementReleaseHandler(Releaser(Arabica::DualMode::DISCARD, total));
+      DocumentT doc = parse(parser, items());
+
+      assertEquals(6, total);
+      assertEquals("head tail ", children(doc.getDocumentElement()));
+      // the whitespace before each item went with it
+      assertTrue(doc.getDocumentElement().getChildNodes().getLength() == 5);
+    } // testDiscard
+
+    void testDetach()
+    {
+      int total = 0;
+      std::vector<NodeT> detached;
+      ParserT parser;
+      parser.setElementReleaseHandler(Releaser(Arabica::DualMode::DETACH, total, &detached));
+      DocumentT doc = parse(parser, items());
+
+      assertEquals("head tail ", children(doc.getDocumentElement()));
+      assertTrue(detached.size() == 3);
+      assertTrue(detached[0].getParentNode() == 0);
+      assertTrue(detached[0].getOwnerDocument() == doc);
+      assertEquals("b ", children(detached[0]));
+      assertEquals("3", SA::asStdString(ElementT(detached[2]).getAttribute(SA::construct_from_utf8("n"))));
+    } // testDetach
+
+    void testRecords()
+    {
+      std::string seen;
+      ParserT parser;
+      parser.setRecordElement(SA::construct_from_utf8(""), SA::construct_from_utf8("item"));
+      parser.setElementEndHandler(Recorder(seen));
+      DocumentT doc = parse(parser, items());
+
+      assertEquals("head/title root/head item/b root/item root/item root/item root/tail #document/root ", seen);
+      assertEquals("head tail ", children(doc.getDocumentElement()));
+    } // testRecords
+
+    void testRecordsKeptOnRequest()
+    {
+      int total = 0;
+      ParserT parser;
+      parser.setRecordElement(SA::construct_from_utf8(""), SA::construct_from_utf8("item"));
+      parser.setElementReleaseHandler(Releaser(Arabica::DualMode::DISCARD, total));
+      DocumentT doc = parse(parser, "<root><item n='1'/><item n='2' keep='y'/><item n='3'/></root>");
+
+      assertEquals(6, total);
+      assertEquals("item ", children(doc.getDocumentElement()));
+      assertEquals("2", SA::asStdString(ElementT(doc.getDocumentElement().getFirstChild()).getAttribute(SA::construct_from_utf8("n"))));
+    } // testRecordsKeptOnRequest
+
+    void testNamespacedRecords()
+    {
+      std::string seen;
+      ParserT parser;
+      parser.setRecordElement(SA::construct_from_utf8("urn:r"), SA::construct_from_utf8("item"));
+      parser.setElementEndHandler(Recorder(seen));
+      DocumentT doc = parse(parser, "<root xmlns:r='urn:r'><item/><r:item><b/></r:item><r:item/></root>");
+
+      assertEquals("root/item r:item/b root/r:item root/r:item #document/root ", seen);
+      assertEquals("item ", children(doc.getDocumentElement()));
+    } // testNamespacedRecords
+
+    void testClearRecordElement()
+    {
+      ParserT parser;
+      parser.setRecordElement(SA::construct_from_utf8(""), SA::construct_from_utf8("item"));
+      parser.clearRecordElement();
+      DocumentT doc = parse(parser, items());
+
+      assertEquals("head item item item tail ", children(doc.getDocumentElement()));
+    } // testClearRecordElement
+
+    void testDiscardedIdsAreForgotten()
+    {
+      ParserT parser;
+      parser.setRecordElement(SA::construct_from_utf8(""), SA::construct_from_utf8("item"));
+      DocumentT doc = parse(parser, "<!DOCTYPE root [ <!ATTLIST item id ID #IMPLIED> <!ATTLIST head id ID #IMPLIED> ]>"
+                                    "<root><head id='h'/><item id='a'/><item id='b'/></root>");
+
+      assertTrue(doc.getElementById(SA::construct_from_utf8("a")) == 0);
+      assertTrue(doc.getElementById(SA::construct_from_utf8("b")) == 0);
+      assertTrue(doc.getElementById(SA::construct_from_utf8("h")) == doc.getDocumentElement().getFirstChild());
+    } // testDiscardedIdsAreForgotten
+
+  private:
+    DocumentT parse(ParserT& parser, const std::string& str)
+    {
+      std::stringstream ss;
+      ss << str;
+
+      Arabica::SAX::InputSource<string_type, string_adaptor> is(ss);
+      Arabica::SAX::CatchErrorHandler<string_type, string_adaptor> eh;
+      parser.setErrorHandler(eh);
+      parser.parse(is);
+      if(eh.errorsReported())
+        throw std::runtime_error(eh.errors());
+
+      return parser.getDocument();
+    } // parse
+
+    static std::string items()
+    {
+      return "<root>\n"
+             "  <head><title/></head>\n"
+             "  <item n='1'><b/></item>\n"
+             "  <item n='2'/>\n"
+             "  <item n='3'/>\n"
+             "  <tail/>\n"
+             "</root>";
+    } // items
+
+    // the names of the child elements of node
+    static std::string children(const NodeT& node)
+    {
+      std::string names;
+      for(NodeT child = node.getFirstChild(); child != 0; child = child.getNextSibling())
+        if(child.getNodeType() == Arabica::DOM::Node_base::ELEMENT_NODE)
+          names += SA::asStdString(child.getNodeName()) + " ";
+      return names;
+    } // children
+}; // class DualModeTest
+
+template<class string_type, class string_adaptor>
+TestSuite* DualModeTest_suite()
+{
+  TestSuite *suiteOfTests = new TestSuite;
+  suiteOfTests->addTest(new TestCaller<DualModeTest<string_type, string_adaptor> >("testEndHandlerKeepsEverything", &DualModeTest<string_type, string_adaptor>::testEndHandlerKeepsEverything));
+  suiteOfTests->addTest(new TestCaller<DualModeTest<string_type, string_adaptor> >("testDiscard", &DualModeTest<string_type, string_adaptor>::testDiscard));
+  suiteOfTests->addTest(new TestCaller<DualModeTest<string_type, string_adaptor> >("testDetach", &DualModeTest<string_type, string_adaptor>::testDetach));
+  suiteOfTests->addTest(new TestCaller<DualModeTest<string_type, string_adaptor> >("testRecords", &DualModeTest<string_type, string_adaptor>::testRecords));
+  suiteOfTests->addTest(new TestCaller<DualModeTest<string_type, string_adaptor> >("testRecordsKeptOnRequest", &DualModeTest<string_type, string_adaptor>::testRecordsKeptOnRequest));
+  suiteOfTests->addTest(new TestCaller<DualModeTest<string_type, string_adaptor> >("testNamespacedRecords", &DualModeTest<string_type, string_adaptor>::testNamespacedRecords));
+  suiteOfTests->addTest(new TestCaller<DualModeTest<string_type, string_adaptor> >("testClearRecordElement", &DualModeTest<string_type, string_adaptor>::testClearRecordElement));
+  suiteOfTests->addTest(new TestCaller<DualModeTest<string_type, string_adaptor> >("testDiscardedIdsAreForgotten", &DualModeTest<string_type, string_adaptor>::testDiscardedIdsAreForgotten));
+  return suiteOfTests;
+} // DualModeTest_suite
+
+#endif
@@ -23,7 +23,7 @@ class SAX2DOMTest : public TestCase
     {
     } // setUp
 
-    Arabica::DOM::Document<string_type, string_adaptor> parse(string_type str)
+    Arabica::DOM::Document<string_type, string_adaptor> parse(string_type str, bool trusted = false)
     {
       std::stringstream ss;
       ss << SA::asStdString(str);
@@ -32,6 +32,7 @@ class SAX2DOMTest : public TestCase
       Arabica::SAX::CatchErrorHandler<string_type, string_adaptor> eh;
       Arabica::SAX2DOM::Parser<string_type, string_adaptor> parser;
       parser.setErrorHandler(eh);
+      parser.setTrusted(trusted);
       parser.parse(is);       
 
       //if(eh.errorsReported())
@@ -161,6 +162,75 @@ class SAX2DOMTest : public TestCase
       {
       } 
     } // test12
+
+    void testTrustedBuildsTheSameDocument()
+    {
+      const char* docs[] = {
+        "<root attr='poop'><child/>text<child attr='2'>more</child></root>",
+        "<stuff:elem stuff:attr='something' xmlns:stuff='http://example.com/stuff'><stuff:elem attr='x'/><elem/></stuff:elem>",
+        "<root xmlns='urn:a'><a xmlns=''/><a/><?pi data?><!--comment--></root>",
+        "<root>one<![CDATA[two]]>three &amp; four</root>",
+        0
+      };
+      for(const char** doc = docs; *doc != 0; ++doc)
+        assertEquals(dump(parse(SA::construct_from_utf8(*doc))), dump(parse(SA::construct_from_utf8(*doc), true)));
+    } // testTrustedBuildsTheSameDocument
+
+    void testTrustedJoinsText()
+    {
+      Arabica::DOM::Document<string_type, string_adaptor> d = parse(SA::construct_from_utf8("<root>one &amp; two<![CDATA[three]]>four</root>"), true);
+      Arabica::DOM::Node<string_type, string_adaptor> text = d.getDocumentElement().getFirstChild();
+      assert(text.getNodeType() == Arabica::DOM::Node_base::TEXT_NODE);
+      assertEquals("one & two", SA::asStdString(text.getNodeValue()));
+      assert(text.getNextSibling().getNodeType() == Arabica::DOM::Node_base::CDATA_SECTION_NODE);
+      assertEquals("four", SA::asStdString(text.getNextSibling().getNextSibling().getNodeValue()));
+      assert(d.getDocumentElement().getChildNodes().getLength() == 3);
+    } // testTrustedJoinsText
+
+    void testTrustedElementsAreIndependent()
+    {
+      Arabica::DOM::Document<string_type, string_adaptor> d = parse(SA::construct_from_utf8("<s:root xmlns:s='urn:s'><s:a s:n='1'/><s:a s:n='2'/></s:root>"), true);
+      Arabica::DOM::Element<string_type, string_adaptor> first = Arabica::DOM::Element<string_type, string_adaptor>(d.getDocumentElement().getFirstChild());
+      Arabica::DOM::Element<string_type, string_adaptor> second = Arabica::DOM::Element<string_type, string_adaptor>(first.getNextSibling());
+      assertEquals("urn:s", SA::asStdString(second.getNamespaceURI()));
+      assertEquals("a", SA::asStdString(second.getLocalName()));
+
+      first.setPrefix(SA::construct_from_utf8("t"));
+      first.setAttributeNS(SA::construct_from_utf8("urn:s"), SA::construct_from_utf8("s:n"), SA::construct_from_utf8("3"));
+      assertEquals("t:a", SA::asStdString(first.getNodeName()));
+      assertEquals("s:a", SA::asStdString(second.getNodeName()));
+      assertEquals("3", SA::asStdString(first.getAttributeNS(SA::construct_from_utf8("urn:s"), SA::construct_from_utf8("n"))));
+      assertEquals("2", SA::asStdString(second.getAttributeNS(SA::construct_from_utf8("urn:s"), SA::construct_from_utf8("n"))));
+    } // testTrustedElementsAreIndependent
+
+    void testTrustedIds()
+    {
+      Arabica::DOM::Document<string_type, string_adaptor> d = parse(SA::construct_from_utf8("<!DOCTYPE root [ <!ATTLIST item id ID #IMPLIED> ]><root><item id='a'/><item id='b'/></root>"), true);
+      assert(d.getElementById(SA::construct_from_utf8("b")) == d.getDocumentElement().getLastChild());
+    } // testTrustedIds
+
+    void testTrustedStillFailsBadDocuments()
+    {
+      assert(parse(SA::construct_from_utf8("<elem stuff:attr='something' poop:attr='fail' xmlns:stuff='http://example.com/stuff'/>"), true) == 0);
+      assert(parse(SA::construct_from_utf8("<root><unclosed></root>"), true) == 0);
+    } // testTrustedStillFailsBadDocuments
+
+  private:
+    // every node, its names, value and attributes
+    static std::string dump(const Arabica::DOM::Node<string_type, string_adaptor>& node)
+    {
+      std::ostringstream os;
+      os << node.getNodeType() << "{" << SA::asStdString(node.getNamespaceURI())
+         << "}" << SA::asStdString(node.getNodeName()) << "=" << SA::asStdString(node.getNodeValue());
+      Arabica::DOM::NamedNodeMap<string_type, string_adaptor> attrs = node.getAttributes();
+      for(unsigned int i = 0; attrs != 0 && i != attrs.getLength(); ++i)
+        os << " @" << dump(attrs.item(i));
+      os << "(";
+      for(Arabica::DOM::Node<string_type, string_adaptor> child = node.getFirstChild(); child != 0; child = child.getNextSibling())
+        os << dump(child);
+      os << ")";
+      return os.str();
+    } // dump
 };
 
 template<class string_type, class string_adaptor>
@@ -179,6 +249,11 @@ TestSuite* SAX2DOMTest_suite()
   suiteOfTests->addTest(new TestCaller<SAX2DOMTest<string_type, string_adaptor> >("test10", &SAX2DOMTest<string_type, string_adaptor>::test10));
   suiteOfTests->addTest(new TestCaller<SAX2DOMTest<string_type, string_adaptor> >("test11", &SAX2DOMTest<string_type, string_adaptor>::test11));
   suiteOfTests->addTest(new TestCaller<SAX2DOMTest<string_type, string_adaptor> >("test12", &SAX2DOMTest<string_type, string_adaptor>::test12));
+  suiteOfTests->addTest(new TestCaller<SAX2DOMTest<string_type, string_adaptor> >("testTrustedBuildsTheSameDocument", &SAX2DOMTest<string_type, string_adaptor>::testTrustedBuildsTheSameDocument));
+  suiteOfTests->addTest(new TestCaller<SAX2DOMTest<string_type, string_adaptor> >("testTrustedJoinsText", &SAX2DOMTest<string_type, string_adaptor>::testTrustedJoinsText));
+  suiteOfTests->addTest(new TestCaller<SAX2DOMTest<string_type, string_adaptor> >("testTrustedElementsAreIndependent", &SAX2DOMTest<string_type, string_adaptor>::testTrustedElementsAreIndependent));
+  suiteOfTests->addTest(new TestCaller<SAX2DOMTest<string_type, string_adaptor> >("testTrustedIds", &SAX2DOMTest<string_type, string_adaptor>::testTrustedIds));
+  suiteOfTests->addTest(new TestCaller<SAX2DOMTest<string_type, string_adaptor> >("testTrustedStillFailsBadDocuments", &SAX2DOMTest<string_type, string_adaptor>::testTrustedStillFailsBadDocuments));
   return suiteOfTests;
 } // SAX2DOMTest_suite
 
@@ -176,6 +176,94 @@ class SiblingsTest : public TestCase
       assert(c1.getNextSibling() == c2);
       assert(c2.getPreviousSibling() == c1);
     } // test4
+
+    void test5()
+    {
+      Arabica::DOM::Document<string_type, string_adaptor> d = factory.createDocument(SA::construct_from_utf8(""), SA::construct_from_utf8(""), 0);
+      Arabica::DOM::Element<string_type, string_adaptor> root = d.createElement(SA::construct_from_utf8("root"));
+      d.appendChild(root);
+      Arabica::DOM::NodeList<string_type, string_adaptor> children = root.getChildNodes();
+
+      for(int i = 0; i != 10; ++i)
+        root.appendChild(d.createTextNode(SA::construct_from_utf8(std::string(1, static_cast<char>('0' + i)).c_str())));
+      assert(children.getLength() == 10);
+
+      // forwards, backwards, and jumping about
+      for(unsigned int i = 0; i != 10; ++i)
+        assert(children.item(i).getNodeValue() == SA::construct_from_utf8(std::string(1, static_cast<char>('0' + i)).c_str()));
+      for(unsigned int i = 10; i != 0; --i)
+        assert(children.item(i-1).getNodeValue() == SA::construct_from_utf8(std::string(1, static_cast<char>('0' + i - 1)).c_str()));
+      assert(children.item(6).getNodeValue() == SA::construct_from_utf8("6"));
+      assert(children.item(2).getNodeValue() == SA::construct_from_utf8("2"));
+      assert(children.item(7).getNodeValue() == SA::construct_from_utf8("7"));
+      assert(children.item(10) == 0);
+
+      // edits move everything after them along
+      root.removeChild(children.item(7));
+      assert(children.getLength() == 9);
+      assert(children.item(7).getNodeValue() == SA::construct_from_utf8("8"));
+      root.insertBefore(d.createTextNode(SA::construct_from_utf8("x")), children.item(2));
+      assert(children.getLength() == 10);
+      assert(children.item(2).getNodeValue() == SA::construct_from_utf8("x"));
+      assert(children.item(3).getNodeValue() == SA::construct_from_utf8("2"));
+      root.replaceChild(d.createTextNode(SA::construct_from_utf8("y")), children.item(3));
+      assert(children.item(3).getNodeValue() == SA::construct_from_utf8("y"));
+      root.removeChild(children.item(0));
+      assert(children.item(0).getNodeValue() == SA::construct_from_utf8("1"));
+      assert(children.item(8).getNodeValue() == SA::construct_from_utf8("9"));
+      assert(root.getLastChild() == children.item(8));
+
+      root.normalize();
+      assert(children.getLength() == 1);
+      assert(root.getFirstChild().getNodeValue() == SA::construct_from_utf8("1xy345689"));
+    } // test5
+
+    void test6()
+    {
+      Arabica::DOM::Document<string_type, string_adaptor> d = factory.createDocument(SA::construct_from_utf8(""), SA::construct_from_utf8(""), 0);
+      Arabica::DOM::Element<string_type, string_adaptor> root = d.createElement(SA::construct_from_utf8("root"));
+      d.appendChild(root);
+      Arabica::DOM::Node<string_type, string_adaptor> c1 = root.appendChild(d.createElement(SA::construct_from_utf8("child1")));
+      Arabica::DOM::Node<string_type, string_adaptor> c2 = root.appendChild(d.createElement(SA::construct_from_utf8("child2")));
+      Arabica::DOM::Node<string_type, string_adaptor> stranger = d.createElement(SA::construct_from_utf8("stranger"));
+
+      // a child in place of itself stays put
+      root.insertBefore(c2, c2);
+      root.replaceChild(c1, c1);
+      assert(root.getFirstChild() == c1);
+      assert(root.getLastChild() == c2);
+      assert(c1.getNextSibling() == c2);
+      assert(root.getChildNodes().getLength() == 2);
+
+      // moving the last child to the front
+      root.insertBefore(c2, c1);
+      assert(root.getFirstChild() == c2);
+      assert(root.getLastChild() == c1);
+      assert(c1.getNextSibling() == 0);
+      assert(c1.getPreviousSibling() == c2);
+      assert(root.getChildNodes().getLength() == 2);
+
+      bool thrown = false;
+      try {
+        root.insertBefore(d.createElement(SA::construct_from_utf8("child3")), stranger);
+      }
+      catch(Arabica::DOM::DOMException& e)
+      {
+        thrown = (e.code() == Arabica::DOM::DOMException::NOT_FOUND_ERR);
+      } // catch
+      assert(thrown);
+      assert(root.getChildNodes().getLength() == 2);
+
+      thrown = false;
+      try {
+        root.removeChild(stranger);
+      }
+      catch(Arabica::DOM::DOMException& e)
+      {
+        thrown = (e.code() == Arabica::DOM::DOMException::NOT_FOUND_ERR);
+      } // catch
+      assert(thrown);
+    } // test6
 };
 
 template<class string_type, class string_adaptor>
@@ -187,6 +275,8 @@ TestSuite* SiblingsTest_suite()
   suiteOfTests->addTest(new TestCaller<SiblingsTest<string_type, string_adaptor> >("test2", &SiblingsTest<string_type, string_adaptor>::test2));
   suiteOfTests->addTest(new TestCaller<SiblingsTest<string_type, string_adaptor> >("test3", &SiblingsTest<string_type, string_adaptor>::test3));
   suiteOfTests->addTest(new TestCaller<SiblingsTest<string_type, string_adaptor> >("test4", &SiblingsTest<string_type, string_adaptor>::test4));
+  suiteOfTests->addTest(new TestCaller<SiblingsTest<string_type, string_adaptor> >("test5", &SiblingsTest<string_type, string_adaptor>::test5));
+  suiteOfTests->addTest(new TestCaller<SiblingsTest<string_type, string_adaptor> >("test6", &SiblingsTest<string_type, string_adaptor>::test6));
 
   return suiteOfTests;
 } // SiblingsTest_suite
@@ -0,0 +1,255 @@
+#ifndef test_Writer_HPP
+#define test_Writer_HPP
+
+#include "../CppUnit/framework/TestCase.h"
+#include "../CppUnit/framework/TestSuite.h"
+#include "../CppUnit/framework/TestCaller.h"
+
+#include <sstream>
+#include <DOM/Simple/DOMImplementation.hpp>
+#include <DOM/SAX2DOM/SAX2DOM.hpp>
+#include <DOM/io/Stream.hpp>
+#include <DOM/io/Writer.hpp>
+
+template<class string_type, class string_adaptor>
+class WriterTest : public TestCase
+{
+  Arabica::DOM::DOMImplementation<string_type, string_adaptor> factory;
+
+  typedef string_adaptor SA;
+  typedef Arabica::DOM::Writer<string_type, string_adaptor> WriterT;
+  typedef Arabica::DOM::Node<string_type, string_adaptor> NodeT;
+  typedef Arabica::DOM::Document<string_type, string_adaptor> DocumentT;
+  typedef Arabica::DOM::Element<string_type, string_adaptor> ElementT;
+  typedef std::basic_ostringstream<typename string_adaptor::value_type> stringstreamT;
+
+  void assertEquals(string_type expected,
+                    string_type actual,
+                    long lineNumber)
+  {
+    if (expected != actual)
+      assertImplementation (false, notEqualsMessage(SA::asStdString(expected), SA::asStdString(actual)), lineNumber, "test_Writer.hpp");
+  }
+
+public:
+  WriterTest(const std::string& name) :
+    TestCase(name)
+  {
+  } // WriterTest
+
+  void setUp()
+  {
+    factory = Arabica::SimpleDOM::DOMImplementation<string_type, string_adaptor>::getDOMImplementation();
+  } // setUp
+
+  string_type s(const char* cs)
+  {
+    return SA::construct_from_utf8(cs);
+  } // s
+
+#ifndef ARABICA_NO_WCHAR_T
+  string_type s(const wchar_t* cs)
+  {
+    return SA::construct_from_utf16(cs);
+  } // s
+#endif
+
+  void testNoNS()
+  {
+    DocumentT doc = factory.createDocument(s(""), s("a"), 0);
+    ElementT a = doc.getDocumentElement();
+    ElementT b = doc.createElement(s("b"));
+    a.appendChild(b);
+    b.appendChild(doc.createElement(s("c")));
+
+    assertEquals(s("<a><b><c/></b></a>"), write(a), __LINE__);
+  } // testNoNS
+
+  void testSameAsStream()
+  {
+    const char* xml[] = {
+      "<a xmlns='urn:test'><b y='&lt;&quot;' x='1'>t&amp;x<![CDATA[c]]>d</b><!--c--><?pi data?></a>",
+      "<t:a xmlns:t='urn:t' xmlns:u='urn:u'><u:b t:x='1' y='2'/><c xmlns='urn:c'><d/></c><t:e u:z='3'/></t:a>",
+      "<root>\n  <child attr='one&#9;two'>text &gt; more</child>\n</root>",
+      0 };
+
+    for(const char** x = xml; *x != 0; ++x)
+    {
+      DocumentT doc = parse(*x);
+      stringstreamT stream;
+      stream << doc;
+      assertEquals(s(stream.str().c_str()), write(doc, WriterT::sort_attributes), __LINE__);
+    } // for ...
+  } // testSameAsStream
+
+  void testLongText()
+  {
+    DocumentT doc = factory.createDocument(s(""), s("a"), 0);
+    ElementT a = doc.getDocumentElement();
+    std::string text;
+    for(int i = 0; i != 2000; ++i)
+      text += "some <text> & ";
+    a.appendChild(doc.createTextNode(s(text.c_str())));
+    a.setAttribute(s("v"), s(text.c_str()));
+
+    stringstreamT stream;
+    stream << a;
+    assertEquals(s(stream.str().c_str()), write(a), __LINE__);
+  } // testLongText
+
+  void testDocumentOrder()
+  {
+    DocumentT doc = parse("<a z='1' b='2' m='3'/>");
+    assertEquals(s("<a z=\"1\" b=\"2\" m=\"3\"/>"), write(doc.getDocumentElement()), __LINE__);
+    assertEquals(s("<a b=\"2\" m=\"3\" z=\"1\"/>"), write(doc.getDocumentElement(), WriterT::sort_attributes), __LINE__);
+  } // testDocumentOrder
+
+  void testEscaping()
+  {
+    DocumentT doc = factory.createDocument(s(""), s("a"), 0);
+    ElementT a = doc.getDocumentElement();
+    a.setAttribute(s("v"), s("<\"&\t\n\r>"));
+    a.appendChild(doc.createTextNode(s("a<b>&c\"\t")));
+
+    assertEquals(s("<a v=\"&lt;&quot;&amp;&#x9;&#xA;&#xD;&gt;\">a&lt;b&gt;&amp;c\"\t</a>"), write(a), __LINE__);
+  } // testEscaping
+
+  void testCDATA()
+  {
+    DocumentT doc = factory.createDocument(s(""), s("a"), 0);
+    ElementT a = doc.getDocumentElement();
+    a.appendChild(doc.createCDATASection(s("x]]>y]]>]]>")));
+
+    stringstreamT stream;
+    stream << a;
+    assertEquals(s(stream.str().c_str()), write(a), __LINE__);
+    assertEquals(s("<a><![CDATA[x]]]]><![CDATA[>y]]]]><![CDATA[>]]]]><![CDATA[>]]></a>"), write(a), __LINE__);
+  } // testCDATA
+
+  void testUndeclareDefault()
+  {
+    DocumentT doc = factory.createDocument(s("urn:test"), s("a"), 0);
+    ElementT a = doc.getDocumentElement();
+    ElementT b = doc.createElement(s("b"));
+    a.appendChild(b);
+    b.appendChild(doc.createElementNS(s("urn:test"), s("c")));
+
+    assertEquals(s("<a xmlns=\"urn:test\"><b xmlns=\"\"><c xmlns=\"urn:test\"/></b></a>"), write(a), __LINE__);
+  } // testUndeclareDefault
+
+  void testAttributeNeedsPrefix()
+  {
+    DocumentT doc = factory.createDocument(s("urn:test"), s("a"), 0);
+    ElementT a = doc.getDocumentElement();
+    a.setAttributeNS(s("urn:test"), s("x"), s("y"));
+
+    assertEquals(s("<a a0:x=\"y\" xmlns=\"urn:test\" xmlns:a0=\"urn:test\"/>"), write(a), __LINE__);
+  } // testAttributeNeedsPrefix
+
+  void testAttributePrefixClash()
+  {
+    DocumentT doc = factory.createDocument(s("urn:test"), s("t:a"), 0);
+    ElementT a = doc.getDocumentElement();
+    a.setAttributeNS(s("urn:other"), s("t:x"), s("y"));
+
+    assertEquals(s("<t:a a0:x=\"y\" xmlns:t=\"urn:test\" xmlns:a0=\"urn:other\"/>"), write(a), __LINE__);
+  } // testAttributePrefixClash
+
+  void testEndTagPrefix()
+  {
+    DocumentT doc = parse("<a xmlns='urn:a' xmlns:p='urn:a'><b p:x='1'><c/></b></a>");
+    assertEquals(s("<a xmlns=\"urn:a\"><b p:x=\"1\" xmlns:p=\"urn:a\"><c/></b></a>"), write(doc.getDocumentElement()), __LINE__);
+
+    doc = parse("<a xmlns='urn:b' xmlns:p='urn:a'><p:b x:y='1' xmlns:x='urn:a'><c/></p:b></a>");
+    assertEquals(s("<a xmlns=\"urn:b\"><p:b p:y=\"1\" xmlns:p=\"urn:a\"><c/></p:b></a>"), write(doc.getDocumentElement(), WriterT::sort_attributes), __LINE__);
+  } // testEndTagPrefix
+
+  void testXmlAttribute()
+  {
+    DocumentT doc = parse("<a xml:lang='en'/>");
+    assertEquals(s("<a xml:lang=\"en\"/>"), write(doc.getDocumentElement()), __LINE__);
+  } // testXmlAttribute
+
+  void testSubtree()
+  {
+    DocumentT doc = parse("<t:a xmlns:t='urn:t' xmlns:u='urn:u'><u:b><c/></u:b></t:a>");
+    NodeT b = doc.getDocumentElement().getFirstChild();
+    assertEquals(s("<u:b xmlns:u=\"urn:u\"><c/></u:b>"), write(b), __LINE__);
+  } // testSubtree
+
+  void testPretty()
+  {
+    DocumentT doc = parse("<a><b><c/></b>  <d>text</d><e>mixed <f/> content</e><!--note--></a>");
+    assertEquals(s("<?xml version=\"1.0\"?>\n"
+                   "<a>\n"
+                   "  <b>\n"
+                   "    <c/>\n"
+                   "  </b>\n"
+                   "  <d>text</d>\n"
+                   "  <e>mixed <f/> content</e>\n"
+                   "  <!--note-->\n"
+                   "</a>\n"),
+                 write(doc, WriterT::pretty), __LINE__);
+  } // testPretty
+
+  void testNoDeclaration()
+  {
+    DocumentT doc = parse("<a/>");
+    assertEquals(s("<a/>"), write(doc, WriterT::no_declaration), __LINE__);
+  } // testNoDeclaration
+
+  void testFragment()
+  {
+    DocumentT doc = factory.createDocument(s(""), s("a"), 0);
+    Arabica::DOM::DocumentFragment<string_type, string_adaptor> frag = doc.createDocumentFragment();
+    frag.appendChild(doc.createElement(s("b")));
+    frag.appendChild(doc.createTextNode(s("&")));
+    frag.appendChild(doc.createElement(s("c")));
+
+    assertEquals(s("<b/>&amp;<c/>"), write(frag), __LINE__);
+  } // testFragment
+
+private:
+  string_type write(const NodeT& node, int options = WriterT::compact)
+  {
+    stringstreamT stream;
+    WriterT writer(stream, options);
+    writer.write(node);
+    return s(stream.str().c_str());
+  } // write
+
+  DocumentT parse(const char* xml)
+  {
+    std::stringstream ss;
+    ss << xml;
+
+    Arabica::SAX::InputSource<string_type, string_adaptor> is(ss);
+    Arabica::SAX2DOM::Parser<string_type, string_adaptor> parser;
+    parser.parse(is);
+    return parser.getDocument();
+  } // parse
+}; // class WriterTest
+
+template<class string_type, class string_adaptor>
+TestSuite* WriterTest_suite()
+{
+  TestSuite* suiteOfTests = new TestSuite;
+  suiteOfTests->addTest(new TestCaller<WriterTest<string_type, string_adaptor> >("testNoNS", &WriterTest<string_type, string_adaptor>::testNoNS));
+  suiteOfTests->addTest(new TestCaller<WriterTest<string_type, string_adaptor> >("testSameAsStream", &WriterTest<string_type, string_adaptor>::testSameAsStream));
+  suiteOfTests->addTest(new TestCaller<WriterTest<string_type, string_adaptor> >("testLongText", &WriterTest<string_type, string_adaptor>::testLongText));
+  suiteOfTests->addTest(new TestCaller<WriterTest<string_type, string_adaptor> >("testDocumentOrder", &WriterTest<string_type, string_adaptor>::testDocumentOrder));
+  suiteOfTests->addTest(new TestCaller<WriterTest<string_type, string_adaptor> >("testEscaping", &WriterTest<string_type, string_adaptor>::testEscaping));
+  suiteOfTests->addTest(new TestCaller<WriterTest<string_type, string_adaptor> >("testCDATA", &WriterTest<string_type, string_adaptor>::testCDATA));
+  suiteOfTests->addTest(new TestCaller<WriterTest<string_type, string_adaptor> >("testUndeclareDefault", &WriterTest<string_type, string_adaptor>::testUndeclareDefault));
+  suiteOfTests->addTest(new TestCaller<WriterTest<string_type, string_adaptor> >("testAttributeNeedsPrefix", &WriterTest<string_type, string_adaptor>::testAttributeNeedsPrefix));
+  suiteOfTests->addTest(new TestCaller<WriterTest<string_type, string_adaptor> >("testAttributePrefixClash", &WriterTest<string_type, string_adaptor>::testAttributePrefixClash));
+  suiteOfTests->addTest(new TestCaller<WriterTest<string_type, string_adaptor> >("testEndTagPrefix", &WriterTest<string_type, string_adaptor>::testEndTagPrefix));
+  suiteOfTests->addTest(new TestCaller<WriterTest<string_type, string_adaptor> >("testXmlAttribute", &WriterTest<string_type, string_adaptor>::testXmlAttribute));
+  suiteOfTests->addTest(new TestCaller<WriterTest<string_type, string_adaptor> >("testSubtree", &WriterTest<string_type, string_adaptor>::testSubtree));
+  suiteOfTests->addTest(new TestCaller<WriterTest<string_type, string_adaptor> >("testPretty", &WriterTest<string_type, string_adaptor>::testPretty));
+  suiteOfTests->addTest(new TestCaller<WriterTest<string_type, string_adaptor> >("testNoDeclaration", &WriterTest<string_type, string_adaptor>::testNoDeclaration));
+  suiteOfTests->addTest(new TestCaller<WriterTest<string_type, string_adaptor> >("testFragment", &WriterTest<string_type, string_adaptor>::testFragment));
+  return suiteOfTests;
+} // WriterTest_suite
+
+#endif
@@ -7,6 +7,11 @@
 #include "../CppUnit/framework/TestSuite.h"
 #include "../silly_string/silly_string.hpp"
 #include "test_WhitespaceStripper.hpp"
+#include "test_AttributesImpl.hpp"
+#include "test_NamespaceSupport.hpp"
+#include "test_InputSourceResolver.hpp"
+#include "test_StreamingXPath.hpp"
+#include "test_Garden.hpp"
 
 ////////////////////////////////////////////////
 int main(int argc, const char* argv[])
@@ -14,6 +19,11 @@ int main(int argc, const char* argv[])
   TestRunner runner;
 
   runner.addTest("WhitespaceStripperTest", WhitespaceStripper_test_suite<silly_string, silly_string_adaptor>());
+  runner.addTest("AttributesImplTest", AttributesImpl_test_suite<silly_string, silly_string_adaptor>());
+  runner.addTest("NamespaceSupportTest", NamespaceSupport_test_suite<silly_string, silly_string_adaptor>());
+  runner.addTest("InputSourceResolverTest", InputSourceResolver_test_suite<silly_string, silly_string_adaptor>());
+  runner.addTest("StreamingXPathTest", StreamingXPath_test_suite<silly_string, silly_string_adaptor>());
+  runner.addTest("GardenTest", Garden_test_suite<silly_string, silly_string_adaptor>());
 
   bool ok = runner.run(argc, argv);
 
@@ -0,0 +1,164 @@
+#ifndef ARABICA_TEST_ATTRIBUTES_IMPL_HPP
+#define ARABICA_TEST_ATTRIBUTES_IMPL_HPP
+
+#include <sstream>
+
+#include <SAX/helpers/AttributesImpl.hpp>
+
+#include "../CppUnit/framework/TestCase.h"
+#include "../CppUnit/framework/TestSuite.h"
+#include "../CppUnit/framework/TestCaller.h"
+
+template<class string_type, class string_adaptor>
+class AttributesImplTest : public TestCase
+{
+  typedef string_adaptor SA;
+  typedef Arabica::SAX::AttributesImpl<string_type, string_adaptor> AttributesImplT;
+
+  public:
+    AttributesImplTest(std::string name) :
+        TestCase(name)
+    {
+    } // AttributesImplTest
+
+    void setUp()
+    {
+    } // setUp
+
+    void testSmall()
+    {
+      AttributesImplT atts;
+      fill(atts, 3);
+      checkLookups(atts, 3);
+    } // testSmall
+
+    void testIndexed()
+    {
+      AttributesImplT atts;
+      fill(atts, 50);
+      checkLookups(atts, 50);
+    } // testIndexed
+
+    void testIndexFollowsChanges()
+    {
+      AttributesImplT atts;
+      fill(atts, 20);
+      assertEquals(5, atts.getIndex(S("a5")));
+
+      atts.removeAttribute(0);
+      assertEquals(4, atts.getIndex(S("a5")));
+      assertEquals(-1, atts.getIndex(S("a0")));
+
+      atts.setQName(4, S("renamed"));
+      assertEquals(-1, atts.getIndex(S("a5")));
+      assertEquals(4, atts.getIndex(S("renamed")));
+
+      atts.addAttribute(S("urn:x"), S("late"), S("x:late"), S("CDATA"), S("v"));
+      assertEquals(19, atts.getIndex(S("urn:x"), S("late")));
+      assert(atts.valueOf(S("x:late")) == S("v"));
+
+      atts.clear();
+      assertEquals(-1, atts.getIndex(S("a6")));
+      fill(atts, 12);
+      assertEquals(6, atts.getIndex(S("a6")));
+    } // testIndexFollowsChanges
+
+    void testIndexAcrossThreshold()
+    {
+      // the index is dropped and built again as the list shrinks and grows
+      AttributesImplT atts;
+      fill(atts, 10);
+      atts.removeAttribute(9);
+      atts.removeAttribute(8);
+      atts.setQName(0, S("first"));
+      assertEquals(0, atts.getIndex(S("first")));
+      atts.addAttribute(SA::empty_string(), S("b8"), S("b8"), S("CDATA"), S("v"));
+      atts.addAttribute(SA::empty_string(), S("b9"), S("b9"), S("CDATA"), S("v"));
+      assertEquals(0, atts.getIndex(S("first")));
+      assertEquals(9, atts.getIndex(S("b9")));
+      assertEquals(-1, atts.getIndex(S("a9")));
+
+      const AttributesImplT copy(atts);
+      assertEquals(8, copy.getIndex(SA::empty_string(), S("b8")));
+
+      AttributesImplT large;
+      fill(large, 40);
+      atts.setAttributes(large);
+      checkLookups(atts, 40);
+    } // testIndexAcrossThreshold
+
+    void testDuplicateFindsFirst()
+    {
+      AttributesImplT atts;
+      fill(atts, 16);
+      atts.addAttribute(SA::empty_string(), S("dup"), S("dup"), S("CDATA"), S("first"));
+      atts.addAttribute(SA::empty_string(), S("dup"), S("dup"), S("CDATA"), S("second"));
+      assert(atts.valueOf(S("dup")) == S("first"));
+      assertEquals(16, atts.getIndex(SA::empty_string(), S("dup")));
+    } // testDuplicateFindsFirst
+
+    void testNoCopyAccessors()
+    {
+      AttributesImplT atts;
+      fill(atts, 10);
+      const typename AttributesImplT::Attr* a = atts.findAttribute(S("a3"));
+      assert(a != 0);
+      assert(&atts.getAttribute(3) == a);
+      assert(&atts.valueOf(S("a3")) == &a->value_);
+      assert(atts.findAttribute(S("nope")) == 0);
+      assert(SA::empty(atts.valueOf(S("nope"))));
+    } // testNoCopyAccessors
+
+  private:
+    string_type S(const char* str)
+    {
+      return SA::construct_from_utf8(str);
+    } // S
+
+    string_type N(const char* prefix, int i)
+    {
+      std::ostringstream ss;
+      ss << prefix << i;
+      return S(ss.str().c_str());
+    } // N
+
+    void fill(AttributesImplT& atts, int count)
+    {
+      for(int i = 0; i != count; ++i)
+        atts.addAttribute(N("urn:", i % 3), N("a", i), N("a", i), S("CDATA"), N("v", i));
+    } // fill
+
+    void checkLookups(const AttributesImplT& atts, int count)
+    {
+      assertEquals(count, atts.getLength());
+      for(int i = 0; i != count; ++i)
+      {
+        assertEquals(i, atts.getIndex(N("a", i)));
+        assertEquals(i, atts.getIndex(N("urn:", i % 3), N("a", i)));
+        assertEquals(-1, atts.getIndex(N("urn:", (i + 1) % 3), N("a", i)));
+        assert(atts.getValue(N("a", i)) == N("v", i));
+        assert(atts.getValue(N("urn:", i % 3), N("a", i)) == N("v", i));
+        assert(atts.getType(N("a", i)) == S("CDATA"));
+      } // for ...
+      assertEquals(-1, atts.getIndex(S("missing")));
+      assert(SA::empty(atts.getValue(S("missing"))));
+    } // checkLookups
+}; // AttributesImplTest
+
+template<class string_type, class string_adaptor>
+TestSuite* AttributesImpl_test_suite()
+{
+  TestSuite *suiteOfTests = new TestSuite;
+
+  suiteOfTests->addTest(new TestCaller<AttributesImplTest<string_type, string_adaptor> >("testSmall", &AttributesImplTest<string_type, string_adaptor>::testSmall));
+  suiteOfTests->addTest(new TestCaller<AttributesImplTest<string_type, string_adaptor> >("testIndexed", &AttributesImplTest<string_type, string_adaptor>::testIndexed));
+  suiteOfTests->addTest(new TestCaller<AttributesImplTest<string_type, string_adaptor> >("testIndexFollowsChanges", &AttributesImplTest<string_type, string_adaptor>::testIndexFollowsChanges));
+  suiteOfTests->addTest(new TestCaller<AttributesImplTest<string_type, string_adaptor> >("testIndexAcrossThreshold", &AttributesImplTest<string_type, string_adaptor>::testIndexAcrossThreshold));
+  suiteOfTests->addTest(new TestCaller<AttributesImplTest<string_type, string_adaptor> >("testDuplicateFindsFirst", &AttributesImplTest<string_type, string_adaptor>::testDuplicateFindsFirst));
+  suiteOfTests->addTest(new TestCaller<AttributesImplTest<string_type, string_adaptor> >("testNoCopyAccessors", &AttributesImplTest<string_type, string_adaptor>::testNoCopyAccessors));
+
+  return suiteOfTests;
+} // AttributesImpl_test_suite
+
+#endif
+
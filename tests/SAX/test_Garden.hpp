@@ -0,0 +1,317 @@
+#ifndef ARABICA_TEST_GARDEN_HPP
+#define ARABICA_TEST_GARDEN_HPP
+
+#include <sstream>
+#include <string>
+
+#include <SAX/parsers/saxgarden.hpp>
+#include <SAX/InputSource.hpp>
+#include <SAX/helpers/DefaultHandler.hpp>
+
+#include "../CppUnit/framework/TestCase.h"
+#include "../CppUnit/framework/TestSuite.h"
+#include "../CppUnit/framework/TestCaller.h"
+
+// writes what Garden reports as a string - <name a=v>, text, </name>,
+// &skipped; and !declarations - and resolves every external entity to
+// the text it was given
+template<class string_type, class string_adaptor>
+class GardenRecorder : public Arabica::SAX::DefaultHandler<string_type, string_adaptor>
+{
+  typedef string_adaptor SA;
+  typedef Arabica::SAX::DefaultHandler<string_type, string_adaptor> baseT;
+
+public:
+  GardenRecorder(const std::string& external) : external_(external) { }
+
+  std::string log_;
+
+  virtual void startElement(const string_type&, const string_type&,
+                            const string_type& qName, const typename baseT::AttributesT& atts)
+  {
+    log_ += "<" + SA::asStdString(qName);
+    for(int a = 0; a != atts.getLength(); ++a)
+      log_ += " " + SA::asStdString(atts.getQName(a)) + "=" + SA::asStdString(atts.getValue(a));
+    log_ += ">";
+  } // startElement
+
+  virtual void endElement(const string_type&, const string_type&, const string_type& qName)
+  {
+    log_ += "</" + SA::asStdString(qName) + ">";
+  } // endElement
+
+  virtual void characters(const string_type& ch)
+  {
+    log_ += SA::asStdString(ch);
+  } // characters
+
+  virtual void skippedEntity(const string_type& name)
+  {
+    log_ += "&" + SA::asStdString(name) + ";";
+  } // skippedEntity
+
+  virtual void internalEntityDecl(const string_type& name, const string_type& value)
+  {
+    log_ += "!ENTITY " + SA::asStdString(name) + " " + SA::asStdString(value) + "\n";
+  } // internalEntityDecl
+
+  virtual void externalEntityDecl(const string_type& name, const string_type&, const string_type& systemId)
+  {
+    log_ += "!ENTITY " + SA::asStdString(name) + " SYSTEM " + SA::asStdString(systemId) + "\n";
+  } // externalEntityDecl
+
+  virtual void elementDecl(const string_type& name, const string_type& model)
+  {
+    log_ += "!ELEMENT " + SA::asStdString(name) + " " + SA::asStdString(model) + "\n";
+  } // elementDecl
+
+  virtual typename baseT::InputSourceT resolveEntity(const string_type&, const string_type& systemId)
+  {
+    resolved_ += SA::asStdString(systemId);
+    stream_.str(external_);
+    return typename baseT::InputSourceT(stream_);
+  } // resolveEntity
+
+  std::string resolved_;
+
+private:
+  std::string external_;
+  std::istringstream stream_;
+}; // class GardenRecorder
+
+template<class string_type, class string_adaptor>
+class GardenTest : public TestCase
+{
+  typedef string_adaptor SA;
+  typedef Arabica::SAX::Garden<string_type, string_adaptor> GardenT;
+  typedef Arabica::SAX::InputSource<string_type, string_adaptor> InputSourceT;
+  typedef GardenRecorder<string_type, string_adaptor> RecorderT;
+
+  public:
+    GardenTest(std::string name) :
+        TestCase(name)
+    {
+    } // GardenTest
+
+    void testUTF8()
+    {
+      assertEquals("<doc>caf\xC3\xA9</doc>", parse("<doc>caf\xC3\xA9</doc>"));
+    } // testUTF8
+
+    void testUTF8ByteOrderMark()
+    {
+      assertEquals("<doc>caf\xC3\xA9</doc>", parse("\xEF\xBB\xBF<doc>caf\xC3\xA9</doc>"));
+    } // testUTF8ByteOrderMark
+
+    void testLatin1()
+    {
+      assertEquals("<doc>caf\xC3\xA9</doc>", parse("<?xml version='1.0' encoding='ISO-8859-1'?><doc>caf\xE9</doc>"));
+    } // testLatin1
+
+    void testUTF16LittleEndian()
+    {
+      assertEquals("<doc>caf\xC3\xA9</doc>", parse(utf16("\xFF\xFE", "<doc>caf\xE9</doc>", false)));
+    } // testUTF16LittleEndian
+
+    void testUTF16BigEndianWithoutByteOrderMark()
+    {
+      assertEquals("<doc>caf\xC3\xA9</doc>", parse(utf16("", "<doc>caf\xE9</doc>", true)));
+    } // testUTF16BigEndianWithoutByteOrderMark
+
+    void testUnknownEncoding()
+    {
+      assertEquals("error", parse("<?xml version='1.0' encoding='EBCDIC'?><doc/>"));
+    } // testUnknownEncoding
+
+    void testInternalSubset()
+    {
+      RecorderT recorder("");
+      parse("<!DOCTYPE doc [\n"
+            "  <!ELEMENT doc (#PCDATA)>\n"
+            "  <!ENTITY hello 'Hello'>\n"
+            "  <!ENTITY ext SYSTEM 'ext.xml'>\n"
+            "]><doc/>", recorder);
+      assertEquals("!ELEMENT doc (#PCDATA)\n"
+                   "!ENTITY hello Hello\n"
+                   "!ENTITY ext SYSTEM ext.xml\n"
+                   "<doc></doc>", recorder.log_);
+    } // testInternalSubset
+
+    void testAttributeDefaults()
+    {
+      assertEquals("<doc a=1 b=two></doc>",
+                   parse("<!DOCTYPE doc [<!ATTLIST doc a CDATA #IMPLIED b CDATA 'two'>]><doc a='1'/>"));
+    } // testAttributeDefaults
+
+    void testInternalEntities()
+    {
+      assertEquals("<doc>Hello, world!</doc>",
+                   parse("<!DOCTYPE doc [<!ENTITY who 'world'><!ENTITY hello 'Hello, &who;'>]><doc>&hello;!</doc>"));
+    } // testInternalEntities
+
+    void testInternalEntityWithMarkup()
+    {
+      assertEquals("<doc><b>bold</b> & <i>italic</i></doc>",
+                   parse("<!DOCTYPE doc [<!ENTITY m '<b>bold</b> &#38;amp; <i>italic</i>'>]><doc>&m;</doc>"));
+    } // testInternalEntityWithMarkup
+
+    void testEntityInAttribute()
+    {
+      assertEquals("<doc a=x-y></doc>",
+                   parse("<!DOCTYPE doc [<!ENTITY e 'x-y'>]><doc a='&e;'/>"));
+    } // testEntityInAttribute
+
+    void testRecursiveEntity()
+    {
+      assertEquals("error",
+                   parse("<!DOCTYPE doc [<!ENTITY a '&b;'><!ENTITY b '&a;'>]><doc>&a;</doc>"));
+    } // testRecursiveEntity
+
+    void testBillionLaughs()
+    {
+      assertTrue(expansionFails("<doc>&lol9;</doc>"));
+    } // testBillionLaughs
+
+    void testBillionLaughsInAttribute()
+    {
+      assertTrue(expansionFails("<doc a='&lol9;'/>"));
+    } // testBillionLaughsInAttribute
+
+    void testExternalEntitySkippedByDefault()
+    {
+      RecorderT recorder("<p>external</p>");
+      parse("<!DOCTYPE doc [<!ENTITY ext SYSTEM 'ext.xml'>]><doc>&ext;</doc>", recorder);
+      assertEquals("!ENTITY ext SYSTEM ext.xml\n<doc>&ext;</doc>", recorder.log_);
+      assertEquals("", recorder.resolved_);
+    } // testExternalEntitySkippedByDefault
+
+    void testExternalEntityLoaded()
+    {
+      RecorderT recorder("<?xml version='1.0' encoding='UTF-8'?><p>external</p>");
+      parse("<!DOCTYPE doc [<!ENTITY ext SYSTEM 'ext.xml'>]><doc>&ext;</doc>", recorder, true);
+      assertEquals("!ENTITY ext SYSTEM ext.xml\n<doc><p>external</p></doc>", recorder.log_);
+      assertEquals("ext.xml", recorder.resolved_);
+    } // testExternalEntityLoaded
+
+    void testExternalEntityLatin1()
+    {
+      RecorderT recorder("<?xml encoding='ISO-8859-1'?>caf\xE9");
+      parse("<!DOCTYPE doc [<!ENTITY ext SYSTEM 'ext.xml'>]><doc>&ext;</doc>", recorder, true);
+      assertEquals("!ENTITY ext SYSTEM ext.xml\n<doc>caf\xC3\xA9</doc>", recorder.log_);
+    } // testExternalEntityLatin1
+
+    void testExternalEntityInAttribute()
+    {
+      RecorderT recorder("external");
+      assertFalse(parse("<!DOCTYPE doc [<!ENTITY ext SYSTEM 'ext.xml'>]><doc a='&ext;'/>", recorder, true));
+    } // testExternalEntityInAttribute
+
+  private:
+    // lol9 expands to 10^9 lols
+    bool expansionFails(const std::string& doc)
+    {
+      std::string xml = "<!DOCTYPE doc [<!ENTITY lol0 'lol'>";
+      for(char level = '1'; level <= '9'; ++level)
+      {
+        xml += "<!ENTITY lol"; xml += level; xml += " '";
+        for(int ref = 0; ref != 10; ++ref)
+        {
+          xml += "&lol"; xml += static_cast<char>(level - 1); xml += ";";
+        } // for ...
+        xml += "'>";
+      } // for ...
+      xml += "]>" + doc;
+
+      RecorderT recorder("");
+      GardenT parser;
+      parser.setErrorHandler(recorder);
+      std::istringstream stream(xml);
+      InputSourceT source(stream);
+      try
+      {
+        parser.parse(source);
+      } // try
+      catch(const Arabica::SAX::SAXParseException<string_type, string_adaptor>&)
+      {
+        return true;
+      } // catch
+      return false;
+    } // expansionFails
+
+    // just the content
+    std::string parse(const std::string& xml)
+    {
+      RecorderT recorder("");
+      if(!parse(xml, recorder, false, false))
+        return "error";
+      return recorder.log_;
+    } // parse
+
+    bool parse(const std::string& xml, RecorderT& recorder, bool external = false, bool declarations = true)
+    {
+      GardenT parser;
+      parser.setContentHandler(recorder);
+      parser.setErrorHandler(recorder);
+      parser.setEntityResolver(recorder);
+      if(declarations)
+        parser.setDeclHandler(recorder);
+      if(external)
+        parser.setFeature(SA::construct_from_utf8("http://xml.org/sax/features/external-general-entities"), true);
+
+      std::istringstream stream(xml);
+      InputSourceT source(stream);
+      try
+      {
+        parser.parse(source);
+      } // try
+      catch(const Arabica::SAX::SAXException&)
+      {
+        return false;
+      } // catch
+      return true;
+    } // parse
+
+    // Latin-1 text as UTF-16
+    static std::string utf16(const std::string& bom, const std::string& latin1, bool bigEndian)
+    {
+      std::string out(bom);
+      for(std::string::const_iterator c = latin1.begin(); c != latin1.end(); ++c)
+      {
+        if(bigEndian)
+          out += '\0';
+        out += *c;
+        if(!bigEndian)
+          out += '\0';
+      } // for ...
+      return out;
+    } // utf16
+}; // GardenTest
+
+template<class string_type, class string_adaptor>
+TestSuite* Garden_test_suite()
+{
+  TestSuite *suiteOfTests = new TestSuite;
+
+  suiteOfTests->addTest(new TestCaller<GardenTest<string_type, string_adaptor> >("testUTF8", &GardenTest<string_type, string_adaptor>::testUTF8));
+  suiteOfTests->addTest(new TestCaller<GardenTest<string_type, string_adaptor> >("testUTF8ByteOrderMark", &GardenTest<string_type, string_adaptor>::testUTF8ByteOrderMark));
+  suiteOfTests->addTest(new TestCaller<GardenTest<string_type, string_adaptor> >("testLatin1", &GardenTest<string_type, string_adaptor>::testLatin1));
+  suiteOfTests->addTest(new TestCaller<GardenTest<string_type, string_adaptor> >("testUTF16LittleEndian", &GardenTest<string_type, string_adaptor>::testUTF16LittleEndian));
+  suiteOfTests->addTest(new TestCaller<GardenTest<string_type, string_adaptor> >("testUTF16BigEndianWithoutByteOrderMark", &GardenTest<string_type, string_adaptor>::testUTF16BigEndianWithoutByteOrderMark));
+  suiteOfTests->addTest(new TestCaller<GardenTest<string_type, string_adaptor> >("testUnknownEncoding", &GardenTest<string_type, string_adaptor>::testUnknownEncoding));
+  suiteOfTests->addTest(new TestCaller<GardenTest<string_type, string_adaptor> >("testInternalSubset", &GardenTest<string_type, string_adaptor>::testInternalSubset));
+  suiteOfTests->addTest(new TestCaller<GardenTest<string_type, string_adaptor> >("testAttributeDefaults", &GardenTest<string_type, string_adaptor>::testAttributeDefaults));
+  suiteOfTests->addTest(new TestCaller<GardenTest<string_type, string_adaptor> >("testInternalEntities", &GardenTest<string_type, string_adaptor>::testInternalEntities));
+  suiteOfTests->addTest(new TestCaller<GardenTest<string_type, string_adaptor> >("testInternalEntityWithMarkup", &GardenTest<string_type, string_adaptor>::testInternalEntityWithMarkup));
+  suiteOfTests->addTest(new TestCaller<GardenTest<string_type, string_adaptor> >("testEntityInAttribute", &GardenTest<string_type, string_adaptor>::testEntityInAttribute));
+  suiteOfTests->addTest(new TestCaller<GardenTest<string_type, string_adaptor> >("testRecursiveEntity", &GardenTest<string_type, string_adaptor>::testRecursiveEntity));
+  suiteOfTests->addTest(new TestCaller<GardenTest<string_type, string_adaptor> >("testBillionLaughs", &GardenTest<string_type, string_adaptor>::testBillionLaughs));
+  suiteOfTests->addTest(new TestCaller<GardenTest<string_type, string_adaptor> >("testBillionLaughsInAttribute", &GardenTest<string_type, string_adaptor>::testBillionLaughsInAttribute));
+  suiteOfTests->addTest(new TestCaller<GardenTest<string_type, string_adaptor> >("testExternalEntitySkippedByDefault", &GardenTest<string_type, string_adaptor>::testExternalEntitySkippedByDefault));
+  suiteOfTests->addTest(new TestCaller<GardenTest<string_type, string_adaptor> >("testExternalEntityLoaded", &GardenTest<string_type, string_adaptor>::testExternalEntityLoaded));
+  suiteOfTests->addTest(new TestCaller<GardenTest<string_type, string_adaptor> >("testExternalEntityLatin1", &GardenTest<string_type, string_adaptor>::testExternalEntityLatin1));
+  suiteOfTests->addTest(new TestCaller<GardenTest<string_type, string_adaptor> >("testExternalEntityInAttribute", &GardenTest<string_type, string_adaptor>::testExternalEntityInAttribute));
+
+  return suiteOfTests;
+} // Garden_test_suite
+
+#endif
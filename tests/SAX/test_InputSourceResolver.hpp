@@ -0,0 +1,180 @@
+#ifndef ARABICA_TEST_INPUT_SOURCE_RESOLVER_HPP
+#define ARABICA_TEST_INPUT_SOURCE_RESOLVER_HPP
+
+#include <sstream>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+
+#include <SAX/XMLReader.hpp>
+#include <SAX/InputSource.hpp>
+#include <SAX/helpers/InputSourceResolver.hpp>
+#include <SAX/filter/PYXWriter.hpp>
+#include <io/mapped_file.hpp>
+
+#include "../CppUnit/framework/TestCase.h"
+#include "../CppUnit/framework/TestSuite.h"
+#include "../CppUnit/framework/TestCaller.h"
+
+template<class string_type, class string_adaptor>
+class InputSourceResolverTest : public TestCase
+{
+  typedef string_adaptor SA;
+  typedef Arabica::SAX::InputSource<string_type, string_adaptor> InputSourceT;
+
+  public:
+    InputSourceResolverTest(std::string name) :
+        TestCase(name)
+    {
+    } // InputSourceResolverTest
+
+    void setUp()
+    {
+    } // setUp
+
+    void testMemoryStream()
+    {
+      const char* text = "hello world";
+      Arabica::io::imemorystream is(text, text + std::strlen(text));
+      std::string word;
+      is >> word;
+      assertEquals("hello", word);
+      is.seekg(0);
+      is >> word;
+      assertEquals("hello", word);
+      is.seekg(-5, std::ios_base::end);
+      is >> word;
+      assertEquals("world", word);
+      is >> word;
+      assert(is.eof());
+    } // testMemoryStream
+
+    void testBytesAreResolvedInPlace()
+    {
+      const char* doc = "<doc/>";
+      InputSourceT source;
+      source.setBytes(doc, 6);
+      Arabica::SAX::InputSourceResolver is(source, SA());
+      assert(is.bytes() == doc);
+      assertEquals(6, is.byteCount());
+
+      std::ostringstream read;
+      read << is.resolve()->rdbuf();
+      assertEquals("<doc/>", read.str());
+    } // testBytesAreResolvedInPlace
+
+    void testBytesPreferredToStream()
+    {
+      const char* doc = "<doc/>";
+      std::istringstream stream("<other/>");
+      InputSourceT source(stream);
+      source.setBytes(doc, 6);
+      Arabica::SAX::InputSourceResolver is(source, SA());
+      assert(is.bytes() == doc);
+    } // testBytesPreferredToStream
+
+    void testStreamIsNotMapped()
+    {
+      std::istringstream stream("<doc/>");
+      InputSourceT source(stream);
+      Arabica::SAX::InputSourceResolver is(source, SA());
+      assert(is.bytes() == 0);
+      assert(is.resolve() == &stream);
+    } // testStreamIsNotMapped
+
+    void testMissingFileIsNotMapped()
+    {
+      Arabica::io::mapped_file file;
+      assertFalse(file.open("no such file.xml"));
+      assertFalse(file.is_open());
+      assert(file.data() == 0);
+    } // testMissingFileIsNotMapped
+
+    void testFileIsMapped()
+    {
+      const std::string doc = "<test><p a='1'>Woo</p></test>";
+      const char* path = "InputSourceResolverTest.xml";
+      write(path, doc);
+
+      Arabica::io::mapped_file file;
+      assertTrue(file.open(path));
+      assertEquals(doc.size(), file.size());
+      assertTrue(std::memcmp(file.data(), doc.data(), doc.size()) == 0);
+
+      InputSourceT source(SA::construct_from_utf8(path));
+      {
+        Arabica::SAX::InputSourceResolver is(source, SA());
+        assert(is.bytes() != 0);
+        assertEquals(doc.size(), is.byteCount());
+        assertEquals(doc, std::string(is.bytes(), is.byteCount()));
+
+        std::ostringstream read;
+        read << is.resolve()->rdbuf();
+        assertEquals(doc, read.str());
+      }
+
+      std::ostringstream o;
+      Arabica::SAX::XMLReader<std::string> parser;
+      Arabica::SAX::PYXWriter<std::string> writer(o, parser);
+      Arabica::SAX::InputSource<std::string> fileSource(path);
+      writer.parse(fileSource);
+      assertEquals("(test\n(p\nAa 1\n-Woo\n)p\n)test\n", o.str());
+
+      std::remove(path);
+    } // testFileIsMapped
+
+    void testFileURIIsMapped()
+    {
+      const char* path = "InputSourceResolverTest.xml";
+      write(path, "<doc/>");
+
+      InputSourceT source(SA::construct_from_utf8("file:InputSourceResolverTest.xml"));
+      {
+        Arabica::SAX::InputSourceResolver is(source, SA());
+        assert(is.bytes() != 0);
+        assertEquals("<doc/>", std::string(is.bytes(), is.byteCount()));
+      }
+
+      std::remove(path);
+    } // testFileURIIsMapped
+
+    void testParseFromBytes()
+    {
+      const char* doc = "<test><p a='1'>Woo</p></test>";
+      Arabica::SAX::InputSource<std::string> source;
+      source.setBytes(doc, std::strlen(doc));
+
+      std::ostringstream o;
+      Arabica::SAX::XMLReader<std::string> parser;
+      Arabica::SAX::PYXWriter<std::string> writer(o, parser);
+      writer.parse(source);
+      assertEquals("(test\n(p\nAa 1\n-Woo\n)p\n)test\n", o.str());
+    } // testParseFromBytes
+
+  private:
+    static void write(const char* path, const std::string& content)
+    {
+      std::ofstream file(path, std::ios_base::binary);
+      file << content;
+    } // write
+}; // InputSourceResolverTest
+
+template<class string_type, class string_adaptor>
+TestSuite* InputSourceResolver_test_suite()
+{
+  TestSuite *suiteOfTests = new TestSuite;
+
+  suiteOfTests->addTest(new TestCaller<InputSourceResolverTest<string_type, string_adaptor> >("testMemoryStream", &InputSourceResolverTest<string_type, string_adaptor>::testMemoryStream));
+  suiteOfTests->addTest(new TestCaller<InputSourceResolverTest<string_type, string_adaptor> >("testBytesAreResolvedInPlace", &InputSourceResolverTest<string_type, string_adaptor>::testBytesAreResolvedInPlace));
+  suiteOfTests->addTest(new TestCaller<InputSourceResolverTest<string_type, string_adaptor> >("testBytesPreferredToStream", &InputSourceResolverTest<string_type, string_adaptor>::testBytesPreferredToStream));
+  suiteOfTests->addTest(new TestCaller<InputSourceResolverTest<string_type, string_adaptor> >("testStreamIsNotMapped", &InputSourceResolverTest<string_type, string_adaptor>::testStreamIsNotMapped));
+  suiteOfTests->addTest(new TestCaller<InputSourceResolverTest<string_type, string_adaptor> >("testMissingFileIsNotMapped", &InputSourceResolverTest<string_type, string_adaptor>::testMissingFileIsNotMapped));
+  suiteOfTests->addTest(new TestCaller<InputSourceResolverTest<string_type, string_adaptor> >("testFileIsMapped", &InputSourceResolverTest<string_type, string_adaptor>::testFileIsMapped));
+  suiteOfTests->addTest(new TestCaller<InputSourceResolverTest<string_type, string_adaptor> >("testFileURIIsMapped", &InputSourceResolverTest<string_type, string_adaptor>::testFileURIIsMapped));
+  suiteOfTests->addTest(new TestCaller<InputSourceResolverTest<string_type, string_adaptor> >("testParseFromBytes", &InputSourceResolverTest<string_type, string_adaptor>::testParseFromBytes));
+
+  return suiteOfTests;
+} // InputSourceResolver_test_suite
+
+#endif
+
@@ -0,0 +1,133 @@
+#ifndef ARABICA_TEST_NAMESPACE_SUPPORT_HPP
+#define ARABICA_TEST_NAMESPACE_SUPPORT_HPP
+
+#include <SAX/helpers/NamespaceSupport.hpp>
+
+#include "../CppUnit/framework/TestCase.h"
+#include "../CppUnit/framework/TestSuite.h"
+#include "../CppUnit/framework/TestCaller.h"
+
+template<class string_type, class string_adaptor>
+class NamespaceSupportTest : public TestCase
+{
+  typedef string_adaptor SA;
+  typedef Arabica::SAX::NamespaceSupport<string_type, string_adaptor> NamespaceSupportT;
+  typedef Arabica::XML::QualifiedName<string_type, string_adaptor> QualifiedNameT;
+
+  public:
+    NamespaceSupportTest(std::string name) :
+        TestCase(name)
+    {
+    } // NamespaceSupportTest
+
+    void setUp()
+    {
+    } // setUp
+
+    void testXmlPrefix()
+    {
+      NamespaceSupportT ns;
+      assert(ns.getURI(S("xml")) == S("http://www.w3.org/XML/1998/namespace"));
+      assert(SA::empty(ns.getURI(S(""))));
+      assertFalse(ns.declarePrefix(S("xml"), S("urn:nope")));
+      assertFalse(ns.declarePrefix(S("xmlns"), S("urn:nope")));
+    } // testXmlPrefix
+
+    void testShadowAndRestore()
+    {
+      NamespaceSupportT ns;
+      ns.pushContext();
+      ns.declarePrefix(S("a"), S("urn:outer"));
+      ns.declarePrefix(S(""), S("urn:default"));
+
+      ns.pushContext();
+      assert(ns.getURI(S("a")) == S("urn:outer"));
+
+      ns.pushContext();
+      ns.declarePrefix(S("a"), S("urn:inner"));
+      assert(ns.getURI(S("a")) == S("urn:inner"));
+      assert(ns.getURI(S("")) == S("urn:default"));
+      assertEquals(1, ns.getDeclaredPrefixes().size());
+      assert(SA::empty(ns.getPrefix(S("urn:outer"))));
+      assert(ns.getPrefix(S("urn:inner")) == S("a"));
+      ns.popContext();
+
+      assert(ns.getURI(S("a")) == S("urn:outer"));
+      assertEquals(0, ns.getDeclaredPrefixes().size());
+      ns.popContext();
+
+      assertEquals(2, ns.getDeclaredPrefixes().size());
+      ns.popContext();
+
+      assert(SA::empty(ns.getURI(S("a"))));
+      assert(SA::empty(ns.getURI(S(""))));
+    } // testShadowAndRestore
+
+    void testProcessNameFollowsScope()
+    {
+      NamespaceSupportT ns;
+      ns.pushContext();
+      ns.declarePrefix(S(""), S("urn:one"));
+      ns.declarePrefix(S("p"), S("urn:p1"));
+      check(ns.processName(S("e"), false), S("urn:one"), S("e"));
+      check(ns.processName(S("e"), true), S(""), S("e"));
+      check(ns.processName(S("p:e"), false), S("urn:p1"), S("e"));
+
+      ns.pushContext();
+      check(ns.processName(S("e"), false), S("urn:one"), S("e"));
+
+      ns.pushContext();
+      ns.declarePrefix(S(""), S("urn:two"));
+      ns.declarePrefix(S("p"), S("urn:p2"));
+      check(ns.processName(S("e"), false), S("urn:two"), S("e"));
+      check(ns.processName(S("p:e"), true), S("urn:p2"), S("e"));
+      ns.popContext();
+
+      check(ns.processName(S("e"), false), S("urn:one"), S("e"));
+      check(ns.processName(S("p:e"), true), S("urn:p1"), S("e"));
+      ns.popContext();
+      ns.popContext();
+
+      check(ns.processName(S("e"), false), S(""), S("e"));
+      check(ns.processName(S("p:e"), false), S(""), S("e"));
+    } // testProcessNameFollowsScope
+
+    void testReset()
+    {
+      NamespaceSupportT ns;
+      ns.pushContext();
+      ns.declarePrefix(S(""), S("urn:one"));
+      check(ns.processName(S("e"), false), S("urn:one"), S("e"));
+      ns.reset();
+      check(ns.processName(S("e"), false), S(""), S("e"));
+      assert(ns.getURI(S("xml")) == S("http://www.w3.org/XML/1998/namespace"));
+    } // testReset
+
+  private:
+    string_type S(const char* str)
+    {
+      return SA::construct_from_utf8(str);
+    } // S
+
+    void check(const QualifiedNameT& name, const string_type& uri, const string_type& localName)
+    {
+      assert(name.namespaceUri() == uri);
+      assert(name.localName() == localName);
+    } // check
+}; // NamespaceSupportTest
+
+template<class string_type, class string_adaptor>
+TestSuite* NamespaceSupport_test_suite()
+{
+  TestSuite *suiteOfTests = new TestSuite;
+
+  suiteOfTests->addTest(new TestCaller<NamespaceSupportTest<string_type, string_adaptor> >("testXmlPrefix", &NamespaceSupportTest<string_type, string_adaptor>::testXmlPrefix));
+  suiteOfTests->addTest(new TestCaller<NamespaceSupportTest<string_type, string_adaptor> >("testShadowAndRestore", &NamespaceSupportTest<string_type, string_adaptor>::testShadowAndRestore));
+  suiteOfTests->addTest(new TestCaller<NamespaceSupportTest<string_type, string_adaptor> >("testProcessNameFollowsScope", &NamespaceSupportTest<string_type, string_adaptor>::testProcessNameFollowsScope));
+  suiteOfTests->addTest(new TestCaller<NamespaceSupportTest<string_type, string_adaptor> >("testReset", &NamespaceSupportTest<string_type, string_adaptor>::testReset));
+
+  return suiteOfTests;
+} // NamespaceSupport_test_suite
+
+#endif
+
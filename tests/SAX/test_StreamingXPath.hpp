@@ -0,0 +1,305 @@
+#ifndef ARABICA_TEST_STREAMING_XPATH_HPP
+#define ARABICA_TEST_STREAMING_XPATH_HPP
+
+#include <memory>
+#include <sstream>
+#include <iostream>
+
+#include <SAX/XMLReader.hpp>
+#include <SAX/InputSource.hpp>
+#include <SAX/filter/StreamingXPathFilter.hpp>
+#include <SAX/filter/PYXWriter.hpp>
+#include <SAX/filter/Writer.hpp>
+
+#include "../CppUnit/framework/TestCase.h"
+#include "../CppUnit/framework/TestSuite.h"
+#include "../CppUnit/framework/TestCaller.h"
+
+template<class string_type, class string_adaptor>
+class StreamingXPathTest : public TestCase
+{
+  typedef string_adaptor SA;
+
+  class Recorder : public Arabica::SAX::StreamingXPathHandler<std::string>
+  {
+  public:
+    virtual void element(const std::string&, const std::string&,
+                         const std::string& qName, const Arabica::SAX::Attributes<std::string>&)
+    {
+      matches_ += "<" + qName + ">";
+    } // element
+
+    virtual void attribute(const std::string&, const std::string&,
+                           const std::string& qName, const std::string& value)
+    {
+      matches_ += "@" + qName + "=" + value + ";";
+    } // attribute
+
+    virtual void text(const std::string& text)
+    {
+      matches_ += "'" + text + "'";
+    } // text
+
+    std::string matches_;
+  }; // class Recorder
+
+  public:
+    StreamingXPathTest(std::string name) :
+        TestCase(name)
+    {
+    } // StreamingXPathTest
+
+    void setUp()
+    {
+    } // setUp
+
+    void testChildPath()
+    {
+      assertEquals("(id\n-1\n)id\n(id\n-2\n)id\n(id\n-3\n)id\n", pyx("/feed/entry/id"));
+      assertEquals("(id\n-1\n)id\n(id\n-2\n)id\n(id\n-3\n)id\n", pyx("feed/entry/id"));
+      assertEquals("", pyx("/entry/id"));
+    } // testChildPath
+
+    void testWholeSubtree()
+    {
+      assertEquals("(entry\nAtype x\nAv 0.009\n(id\n-2\n)id\n(title\n-Two\n)title\n)entry\n", pyx("/feed/entry[2]"));
+    } // testWholeSubtree
+
+    void testDescendant()
+    {
+      assertEquals("(title\n-One\n)title\n(title\n-Two\n)title\n(title\n-Inner\n)title\n", pyx("//title"));
+      assertEquals("(title\n-One\n)title\n(title\n-Two\n)title\n(title\n-Inner\n)title\n", pyx("descendant::title"));
+      assertEquals("(title\n-Inner\n)title\n", pyx("//section//title"));
+    } // testDescendant
+
+    void testAttributePredicate()
+    {
+      assertEquals("(id\n-2\n)id\n(id\n-3\n)id\n", pyx("/feed/entry[@type='x']/id"));
+      assertEquals("(id\n-1\n)id\n", pyx("/feed/entry[@type!='x']/id"));
+      assertEquals("(id\n-1\n)id\n(id\n-2\n)id\n(id\n-3\n)id\n", pyx("/feed/entry[@type]/id"));
+      assertEquals("(id\n-3\n)id\n", pyx("/feed/entry[@n > 4]/id"));
+      assertEquals("(id\n-1\n)id\n(id\n-3\n)id\n", pyx("/feed/entry[@n = 5 or not(@type = 'x')]/id"));
+      assertEquals("(id\n-3\n)id\n", pyx("/feed/entry[(@type = 'x') and @n]/id"));
+      assertEquals("(id\n-1\n)id\n", pyx("/feed/entry[not (@type = 'x')]/id"));
+    } // testAttributePredicate
+
+    void testNumbers()
+    {
+      assertEquals("(id\n-3\n)id\n", pyx("/feed/entry[@n = 5.0]/id"));
+      assertEquals("(id\n-3\n)id\n", pyx("/feed/entry[@n > '  4.5 ']/id"));
+      assertEquals("(id\n-3\n)id\n", pyx("/feed/entry[@n < 5.000000000000001]/id"));
+      assertEquals("", pyx("/feed/entry[@n < 5.0000000000000001]/id"));
+      assertEquals("", pyx("/feed/entry[@n < '5e1']/id"));
+      // the same double written two ways, which adding up the digits one
+      // at a time doesn't get right
+      assertEquals("(id\n-2\n)id\n", pyx("/feed/entry[@v = 0.00899999999999999932]/id"));
+      assertEquals("(id\n-1\n)id\n(id\n-2\n)id\n", pyx("/feed/entry[position ( ) < 3]/id"));
+    } // testNumbers
+
+    void testPosition()
+    {
+      assertEquals("(id\n-2\n)id\n", pyx("/feed/entry[2]/id"));
+      assertEquals("(id\n-2\n)id\n(id\n-3\n)id\n", pyx("/feed/entry[position() > 1]/id"));
+      // position among the entries that pass the first predicate
+      assertEquals("(id\n-3\n)id\n", pyx("/feed/entry[@type='x'][2]/id"));
+      assertEquals("(id\n-1\n)id\n", pyx("//entry[1]/id"));
+      assertEquals("(id\n-1\n)id\n(id\n-2\n)id\n(id\n-3\n)id\n", pyx("//id[1]"));
+    } // testPosition
+
+    void testUnion()
+    {
+      assertEquals("(id\n-1\n)id\n(title\n-Inner\n)title\n", pyx("/feed/entry[1]/id | //section/title"));
+    } // testUnion
+
+    void testNestedMatchesReportedOnce()
+    {
+      Recorder recorder;
+      assertEquals("(title\n-One\n)title\n(title\n-Two\n)title\n(section\n(title\n-Inner\n)title\n)section\n", pyx("//section | //title", &recorder));
+      assertEquals("<title><title><section><title>", recorder.matches_);
+    } // testNestedMatchesReportedOnce
+
+    void testAttributes()
+    {
+      Recorder recorder;
+      assertEquals("", pyx("/feed/entry/@type", &recorder));
+      assertEquals("@type=y;@type=x;@type=x;", recorder.matches_);
+
+      Recorder descendants;
+      pyx("//@n", &descendants);
+      assertEquals("@n=5;", descendants.matches_);
+    } // testAttributes
+
+    void testText()
+    {
+      Recorder recorder;
+      assertEquals("-One\n-Two\n", pyx("/feed/entry[@type='x' or @type='y']/title[1]/text()", &recorder));
+      assertEquals("'One''Two'", recorder.matches_);
+    } // testText
+
+    void testNamespaces()
+    {
+      Recorder recorder;
+      Arabica::SAX::XMLReader<std::string> parser;
+      Arabica::SAX::StreamingXPathFilter<std::string> filter(parser);
+      filter.declareNamespace("n", "urn:n");
+      filter.setExpression("/n:doc/n:*");
+      filter.setMatchHandler(recorder);
+      filter.parse(*source("<doc xmlns='urn:n'><a/><b xmlns=''/><c/></doc>"));
+      assertEquals("<a><c>", recorder.matches_);
+      assertTrue(filter.matches() == 2);
+    } // testNamespaces
+
+    void testAncestorNamespacesWritten()
+    {
+      std::ostringstream o;
+      Arabica::SAX::XMLReader<std::string> parser;
+      // the Writer declares namespaces from the prefix mappings alone
+      parser.setFeature("http://xml.org/sax/features/namespace-prefixes", false);
+      Arabica::SAX::StreamingXPathFilter<std::string> filter(parser);
+      filter.declareNamespace("a", "http://www.w3.org/2005/Atom");
+      filter.setExpression("/a:feed/a:entry[2]");
+      Arabica::SAX::Writer<std::string> writer(o, filter, 0);
+      writer.parse(*source("<feed xmlns='http://www.w3.org/2005/Atom' xmlns:x='urn:x'>"
+                             "<entry><x:id>1</x:id></entry>"
+                             "<entry xmlns:y='urn:y'><x:id>2</x:id><y:z/></entry>"
+                           "</feed>"));
+      std::string written = o.str();
+      assertTrue(written.find("<entry") != std::string::npos);
+      assertTrue(written.find("xmlns=\"http://www.w3.org/2005/Atom\"") != std::string::npos);
+      assertTrue(written.find("xmlns:x=\"urn:x\"") != std::string::npos);
+      assertTrue(written.find("xmlns:y=\"urn:y\"") != std::string::npos);
+      assertTrue(written.find("<x:id>2</x:id>") != std::string::npos);
+      assertTrue(written.find(">1<") == std::string::npos);
+
+      // and what's written parses back to the same names
+      Arabica::SAX::XMLReader<std::string> reparser;
+      Arabica::SAX::StreamingXPathFilter<std::string> check(reparser);
+      check.declareNamespace("a", "http://www.w3.org/2005/Atom");
+      check.declareNamespace("x", "urn:x");
+      check.setExpression("/a:entry/x:id");
+      check.parse(*source(written));
+      assertTrue(check.matches() == 1);
+    } // testAncestorNamespacesWritten
+
+    void testShadowedPrefixReplayedOnce()
+    {
+      std::ostringstream o;
+      Arabica::SAX::XMLReader<std::string> parser;
+      parser.setFeature("http://xml.org/sax/features/namespace-prefixes", false);
+      Arabica::SAX::StreamingXPathFilter<std::string> filter(parser);
+      filter.setExpression("//a/b");
+      Arabica::SAX::Writer<std::string> writer(o, filter, 0);
+      writer.parse(*source("<r xmlns:p='urn:outer'><a xmlns:p='urn:inner'><b><p:c/></b></a><b/></r>"));
+      std::string written = o.str();
+      assertTrue(written.find("urn:outer") == std::string::npos);
+      assertTrue(written.find("xmlns:p=\"urn:inner\"") != std::string::npos);
+      assertTrue(written.find("xmlns:p", written.find("xmlns:p") + 1) == std::string::npos);
+    } // testShadowedPrefixReplayedOnce
+
+    void testUnsupported()
+    {
+      assertTrue(unsupported("/feed/.."));
+      assertTrue(unsupported("/feed/entry[last()]"));
+      assertTrue(unsupported("/feed/following::entry"));
+      assertTrue(unsupported("descendant::entry[1]"));
+      assertTrue(unsupported("/feed/entry[title]"));
+      assertTrue(unsupported("/feed/@type/id"));
+      assertTrue(unsupported("/"));
+    } // testUnsupported
+
+    void testBadSyntax()
+    {
+      assertTrue(bad("/feed/entry["));
+      assertTrue(bad("/feed/entry[@type='x'"));
+      assertTrue(bad("/feed/p:entry"));
+      assertTrue(bad("/feed/entry]"));
+    } // testBadSyntax
+
+  private:
+    std::string pyx(const std::string& xpath, Recorder* recorder = 0)
+    {
+      std::ostringstream o;
+      Arabica::SAX::XMLReader<std::string> parser;
+      Arabica::SAX::StreamingXPathFilter<std::string> filter(parser);
+      filter.setExpression(xpath);
+      if(recorder)
+        filter.setMatchHandler(*recorder);
+      Arabica::SAX::PYXWriter<std::string> writer(o, filter);
+      writer.parse(*source(feed()));
+      return o.str();
+    } // pyx
+
+    bool unsupported(const std::string& xpath)
+    {
+      Arabica::SAX::StreamingXPathFilter<std::string> filter;
+      try
+      {
+        filter.setExpression(xpath);
+      }
+      catch(const Arabica::SAX::SAXNotSupportedException&)
+      {
+        return true;
+      } // catch
+      return false;
+    } // unsupported
+
+    bool bad(const std::string& xpath)
+    {
+      Arabica::SAX::StreamingXPathFilter<std::string> filter;
+      try
+      {
+        filter.setExpression(xpath);
+      }
+      catch(const Arabica::SAX::SAXNotSupportedException&)
+      {
+        return false;
+      }
+      catch(const Arabica::SAX::SAXException&)
+      {
+        return true;
+      } // catch
+      return false;
+    } // bad
+
+    static std::string feed()
+    {
+      return "<feed>"
+               "<entry type='y'><id>1</id><title>One</title></entry>"
+               "<entry type='x' v='0.009'><id>2</id><title>Two</title></entry>"
+               "<entry type='x' n='5'><id>3</id><section><title>Inner</title></section></entry>"
+             "</feed>";
+    } // feed
+
+    std::auto_ptr<Arabica::SAX::InputSource<std::string> > source(const std::string& str)
+    {
+      std::auto_ptr<std::iostream> ss(new std::stringstream());
+      (*ss) << str;
+      return std::auto_ptr<Arabica::SAX::InputSource<std::string> >(new Arabica::SAX::InputSource<std::string>(ss));
+    } // source
+}; // StreamingXPathTest
+
+template<class string_type, class string_adaptor>
+TestSuite* StreamingXPath_test_suite()
+{
+  TestSuite *suiteOfTests = new TestSuite;
+
+  suiteOfTests->addTest(new TestCaller<StreamingXPathTest<string_type, string_adaptor> >("testChildPath", &StreamingXPathTest<string_type, string_adaptor>::testChildPath));
+  suiteOfTests->addTest(new TestCaller<StreamingXPathTest<string_type, string_adaptor> >("testWholeSubtree", &StreamingXPathTest<string_type, string_adaptor>::testWholeSubtree));
+  suiteOfTests->addTest(new TestCaller<StreamingXPathTest<string_type, string_adaptor> >("testDescendant", &StreamingXPathTest<string_type, string_adaptor>::testDescendant));
+  suiteOfTests->addTest(new TestCaller<StreamingXPathTest<string_type, string_adaptor> >("testAttributePredicate", &StreamingXPathTest<string_type, string_adaptor>::testAttributePredicate));
+  suiteOfTests->addTest(new TestCaller<StreamingXPathTest<string_type, string_adaptor> >("testPosition", &StreamingXPathTest<string_type, string_adaptor>::testPosition));
+  suiteOfTests->addTest(new TestCaller<StreamingXPathTest<string_type, string_adaptor> >("testUnion", &StreamingXPathTest<string_type, string_adaptor>::testUnion));
+  suiteOfTests->addTest(new TestCaller<StreamingXPathTest<string_type, string_adaptor> >("testNestedMatchesReportedOnce", &StreamingXPathTest<string_type, string_adaptor>::testNestedMatchesReportedOnce));
+  suiteOfTests->addTest(new TestCaller<StreamingXPathTest<string_type, string_adaptor> >("testAttributes", &StreamingXPathTest<string_type, string_adaptor>::testAttributes));
+  suiteOfTests->addTest(new TestCaller<StreamingXPathTest<string_type, string_adaptor> >("testText", &StreamingXPathTest<string_type, string_adaptor>::testText));
+  suiteOfTests->addTest(new TestCaller<StreamingXPathTest<string_type, string_adaptor> >("testNumbers", &StreamingXPathTest<string_type, string_adaptor>::testNumbers));
+  suiteOfTests->addTest(new TestCaller<StreamingXPathTest<string_type, string_adaptor> >("testNamespaces", &StreamingXPathTest<string_type, string_adaptor>::testNamespaces));
+  suiteOfTests->addTest(new TestCaller<StreamingXPathTest<string_type, string_adaptor> >("testAncestorNamespacesWritten", &StreamingXPathTest<string_type, string_adaptor>::testAncestorNamespacesWritten));
+  suiteOfTests->addTest(new TestCaller<StreamingXPathTest<string_type, string_adaptor> >("testShadowedPrefixReplayedOnce", &StreamingXPathTest<string_type, string_adaptor>::testShadowedPrefixReplayedOnce));
+  suiteOfTests->addTest(new TestCaller<StreamingXPathTest<string_type, string_adaptor> >("testUnsupported", &StreamingXPathTest<string_type, string_adaptor>::testUnsupported));
+  suiteOfTests->addTest(new TestCaller<StreamingXPathTest<string_type, string_adaptor> >("testBadSyntax", &StreamingXPathTest<string_type, string_adaptor>::testBadSyntax));
+
+  return suiteOfTests;
+} // StreamingXPath_test_suite
+
+#endif
@@ -4,9 +4,13 @@
 #include <memory>
 #include <sstream>
 #include <iostream>
+#include <stdexcept>
 
 #include <SAX/filter/Writer.hpp>
 #include <Taggle/Taggle.hpp>
+#include <DOM/SAX2DOM/SAX2DOM.hpp>
+#include <DOM/SAX2DOM/TaggleParser.hpp>
+#include <DOM/io/Stream.hpp>
 
 #include "../CppUnit/framework/TestCase.h"
 #include "../CppUnit/framework/TestSuite.h"
@@ -34,7 +38,143 @@ class TaggleTest : public TestCase
       assertEquals("<?xml version=\"1.0\"?>\n<html xmlns:html=\"http://www.w3.org/1999/xhtml\">\n  <body>woo!\n    <br clear=\"none\"/>\n  </body>\n</html>\n", sink.str());
     } // senseTest
 
+    void testElementNameCase()
+    {
+      assertEquals(clean("<html><body>woo!<br></body></html>"), clean("<HTML><BoDy>woo!<Br></bODY></html>"));
+    } // testElementNameCase
+
+    void testTextEntities()
+    {
+      assertEquals("<p>a &amp; b &lt; c</p>", body("<p>a &amp; b &lt; c"));
+      assertEquals("<p>\xC2\xA0\xC3\xA9\xC3\xBF</p>", body("<p>&nbsp;&eacute;&yuml;"));
+      assertEquals("<p>A\xE2\x82\xAC\xF0\x9F\x98\x80</p>", body("<p>&#65;&#x20AC;&#x1F600;"));
+      assertEquals("<p>&amp;nosuch; &amp;</p>", body("<p>&nosuch; &amp"));
+    } // testTextEntities
+
+    void testAttributeEntities()
+    {
+      assertEquals("<p title=\"a&amp;b\"/>", body("<p title='a&amp;b'>"));
+      assertEquals("<p title=\"\xC3\xA9" "A\xE2\x82\xAC\"/>", body("<p title='&eacute;&#65;&#x20ac;'>"));
+      assertEquals("<p title=\"&amp;nosuch; &amp;amp &amp;lt\"/>", body("<p title='&nosuch; &amp &lt'>"));
+      assertEquals("<p title=\"&amp;amp&lt;\"/>", body("<p title='&amp&lt;'>"));
+    } // testAttributeEntities
+
+    void testDirectDOM()
+    {
+      assertEquals(viaSAX("<html><body>woo!<br></body></html>"), direct("<html><body>woo!<br></body></html>"));
+      assertEquals(viaSAX("<p>a &amp; b<p>c</p>d"), direct("<p>a &amp; b<p>c</p>d"));
+      assertEquals(viaSAX("<HTML><Table border=1><TR><td>x<td>y</table>"), direct("<HTML><Table border=1><TR><td>x<td>y</table>"));
+      assertEquals(viaSAX("<b>bold<p>still bold</b> not</p>"), direct("<b>bold<p>still bold</b> not</p>"));
+      assertEquals(viaSAX("<!-- hi --><?pi data?><p title='&eacute;' id=p1>x</p><bogon a=b>y</bogon>"),
+                   direct("<!-- hi --><?pi data?><p title='&eacute;' id=p1>x</p><bogon a=b>y</bogon>"));
+      assertEquals(viaSAX("<script>if(a</b) {}</script><p><![CDATA[x<y]]>"), direct("<script>if(a</b) {}</script><p><![CDATA[x<y]]>"));
+      assertEquals(viaSAX("<svg:rect xml:lang=en>r</svg:rect>"), direct("<svg:rect xml:lang=en>r</svg:rect>"));
+    } // testDirectDOM
+
+    void testDirectDOMDoctype()
+    {
+      Arabica::SAX2DOM::TaggleParser<std::string> parser;
+      parser.parse(*source("<!DOCTYPE html PUBLIC \"-//W3C//DTD HTML 4.01//EN\"><html><body>x</body></html>"));
+      Arabica::DOM::Document<std::string> doc = parser.getDocument();
+      assertTrue(doc != 0);
+      assertTrue(doc.getDoctype() != 0);
+      assertEquals("html", doc.getDoctype().getName());
+      assertEquals("-//W3C//DTD HTML 4.01//EN", doc.getDoctype().getPublicId());
+      assertEquals("html", doc.getDocumentElement().getLocalName());
+      assertEquals("http://www.w3.org/1999/xhtml", doc.getDocumentElement().getNamespaceURI());
+      assertEquals(1, doc.getElementsByTagName("body").getLength());
+    } // testDirectDOMDoctype
+
+    void testDirectDOMNoNamespaces()
+    {
+      Arabica::SAX2DOM::TaggleParser<std::string> parser;
+      parser.setFeature(Arabica::SAX::Taggle<std::string>::namespacesFeature, false);
+      parser.parse(*source("<p>x</p>"));
+      Arabica::DOM::Document<std::string> doc = parser.getDocument();
+      assertEquals("", doc.getDocumentElement().getNamespaceURI());
+      assertEquals("html", doc.getDocumentElement().getNodeName());
+    } // testDirectDOMNoNamespaces
+
+    void testDirectDOMAfterFailure()
+    {
+      Arabica::SAX2DOM::TaggleParser<std::string> parser;
+      FailingBuffer buffer("<html><body><p>x<p>y");
+      std::auto_ptr<std::iostream> broken(new std::iostream(&buffer));
+      broken->exceptions(std::ios_base::badbit);
+      Arabica::SAX::InputSource<std::string> is(broken);
+      try
+      {
+        parser.parse(is);
+        assertTrue(false);
+      }
+      catch(const std::runtime_error&)
+      {
+      } // catch
+
+      parser.parse(*source("<html><body><p>z</p></body></html>"));
+      Arabica::DOM::Document<std::string> doc = parser.getDocument();
+      assertEquals("p", doc.getElementsByTagName("p").item(0).getLocalName());
+      assertTrue(doc.getElementsByTagName("p").item(0).getOwnerDocument() == doc);
+      std::ostringstream os;
+      os << doc;
+      assertEquals(viaSAX("<html><body><p>z</p></body></html>"), os.str());
+    } // testDirectDOMAfterFailure
+
   private:
+    // gives up its text, then throws
+    class FailingBuffer : public std::streambuf
+    {
+    public:
+      FailingBuffer(const std::string& text) : text_(text)
+      {
+        setg(&text_[0], &text_[0], &text_[0] + text_.size());
+      } // FailingBuffer
+
+    protected:
+      virtual int_type underflow()
+      {
+        throw std::runtime_error("read failed");
+      } // underflow
+
+    private:
+      std::string text_;
+    }; // class FailingBuffer
+
+    std::string viaSAX(const std::string& html)
+    {
+      Arabica::SAX2DOM::Parser<std::string, Arabica::SAX::Taggle<std::string> > parser;
+      parser.parse(*source(html));
+      std::ostringstream os;
+      os << parser.getDocument();
+      return os.str();
+    } // viaSAX
+
+    std::string direct(const std::string& html)
+    {
+      Arabica::SAX2DOM::TaggleParser<std::string> parser;
+      parser.parse(*source(html));
+      std::ostringstream os;
+      os << parser.getDocument();
+      return os.str();
+    } // direct
+
+    std::string clean(const std::string& html)
+    {
+      Arabica::SAX::Taggle<std::string> parser;
+      std::ostringstream sink;
+      Arabica::SAX::Writer<std::string> writer(sink, parser, 0);
+      writer.parse(*source(html));
+      return sink.str();
+    } // clean
+
+    // what's inside the body element
+    std::string body(const std::string& html)
+    {
+      std::string xml = clean(html);
+      std::string::size_type start = xml.find("<body>") + 6;
+      return xml.substr(start, xml.find("</body>") - start);
+    } // body
+
     std::auto_ptr<Arabica::SAX::InputSource<std::string> > source(const std::string& str)
     {
       std::auto_ptr<std::iostream> ss(new std::stringstream());
@@ -48,6 +188,13 @@ TestSuite* Taggle_test_suite()
   TestSuite *suiteOfTests = new TestSuite;
 
   suiteOfTests->addTest(new TestCaller<TaggleTest>("senseTest", &TaggleTest::senseTest));
+  suiteOfTests->addTest(new TestCaller<TaggleTest>("testElementNameCase", &TaggleTest::testElementNameCase));
+  suiteOfTests->addTest(new TestCaller<TaggleTest>("testTextEntities", &TaggleTest::testTextEntities));
+  suiteOfTests->addTest(new TestCaller<TaggleTest>("testAttributeEntities", &TaggleTest::testAttributeEntities));
+  suiteOfTests->addTest(new TestCaller<TaggleTest>("testDirectDOM", &TaggleTest::testDirectDOM));
+  suiteOfTests->addTest(new TestCaller<TaggleTest>("testDirectDOMDoctype", &TaggleTest::testDirectDOMDoctype));
+  suiteOfTests->addTest(new TestCaller<TaggleTest>("testDirectDOMNoNamespaces", &TaggleTest::testDirectDOMNoNamespaces));
+  suiteOfTests->addTest(new TestCaller<TaggleTest>("testDirectDOMAfterFailure", &TaggleTest::testDirectDOMAfterFailure));
 
   return suiteOfTests;
 } // TaggleTest_suite
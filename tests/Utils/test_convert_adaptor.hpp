@@ -0,0 +1,138 @@
+#ifndef UTILS_CONVERT_ADAPTOR_TEST_HPP
+#define UTILS_CONVERT_ADAPTOR_TEST_HPP
+
+#include <io/convert_adaptor.hpp>
+#include <convert/base64codecvt.hpp>
+#include <convert/rot13codecvt.hpp>
+#include <convert/utf8ucs2codecvt.hpp>
+#include <sstream>
+#include <string>
+
+class ConvertAdaptorTest : public TestCase
+{
+  public:
+    ConvertAdaptorTest(std::string name) :
+      TestCase(name)
+    {
+    } // ConvertAdaptorTest
+
+    void testRot13RoundTrip()
+    {
+      for(size_t bufferSize = 1; bufferSize < 100; bufferSize += 7)
+      {
+        std::string text = sample();
+        std::ostringstream encoded;
+        {
+          Arabica::io::oconvert_adaptor<char> out(encoded, bufferSize);
+          out.imbue(std::locale(out.getloc(), new Arabica::convert::rot13codecvt()));
+          out << text;
+        }
+        assert(encoded.str() != text);
+
+        std::istringstream in(encoded.str());
+        Arabica::io::iconvert_adaptor<char> decoder(in, bufferSize);
+        decoder.imbue(std::locale(decoder.getloc(), new Arabica::convert::rot13codecvt()));
+        std::ostringstream decoded;
+        decoded << decoder.rdbuf();
+        assertEquals(text, decoded.str());
+      } // for ...
+    } // testRot13RoundTrip
+
+    void testBase64EncodesWhenFlushed()
+    {
+      // base64 pads its output each time it's converted, so the whole
+      // of the text between flushes must go in one piece
+      std::ostringstream encoded;
+      {
+        Arabica::io::oconvert_adaptor<char> out(encoded, 2);
+        out.imbue(std::locale(out.getloc(), new Arabica::convert::base64codecvt()));
+        out << "ABCD";
+      }
+      assertEquals("QUJDRA==", encoded.str());
+    } // testBase64EncodesWhenFlushed
+
+    void testBase64DecodesAcrossBuffers()
+    {
+      std::istringstream in("QUJDRA==");
+      Arabica::io::iconvert_adaptor<char> decoder(in, 3);
+      decoder.imbue(std::locale(decoder.getloc(), new Arabica::convert::base64codecvt()));
+      std::ostringstream decoded;
+      decoded << decoder.rdbuf();
+      assertEquals("ABCD", decoded.str());
+    } // testBase64DecodesAcrossBuffers
+
+#ifndef ARABICA_NO_WCHAR_T
+    void testUtf8SplitAcrossBuffers()
+    {
+      typedef Arabica::io::iconvert_adaptor<wchar_t, std::char_traits<wchar_t>, char, std::char_traits<char> > Widener;
+      typedef Arabica::io::oconvert_adaptor<wchar_t, std::char_traits<wchar_t>, char, std::char_traits<char> > Narrower;
+
+      std::string utf8;
+      for(int i = 0; i != 50; ++i)
+        utf8 += "h\xC3\xA9llo w\xE2\x82\xACrld ";
+
+      for(size_t bufferSize = 1; bufferSize < 20; ++bufferSize)
+      {
+        std::istringstream in(utf8);
+        Widener widener(in, bufferSize);
+        widener.imbue(std::locale(widener.getloc(), new Arabica::convert::utf8ucs2codecvt()));
+        std::wstring wide;
+        wchar_t c;
+        while(widener.get(c))
+          wide += c;
+        assertEquals(50*12, wide.length());
+        assert(wide[1] == 0xE9);
+        assert(wide[7] == 0x20AC);
+
+        std::ostringstream out;
+        {
+          Narrower narrower(out, bufferSize);
+          narrower.imbue(std::locale(narrower.getloc(), new Arabica::convert::utf8ucs2codecvt()));
+          narrower << wide;
+        }
+        assertEquals(utf8, out.str());
+      } // for ...
+    } // testUtf8SplitAcrossBuffers
+#endif
+
+    void testPutback()
+    {
+      std::istringstream in("abcdef");
+      Arabica::io::iconvert_adaptor<char> adaptor(in, 2);
+      char c;
+      adaptor.get(c);
+      adaptor.get(c);
+      adaptor.get(c);
+      assertEquals('c', c);
+      adaptor.unget();
+      adaptor.unget();
+      adaptor.get(c);
+      assertEquals('b', c);
+    } // testPutback
+
+  private:
+    std::string sample()
+    {
+      std::string text;
+      for(int i = 0; i != 100; ++i)
+        text += "The quick brown fox jumps over the lazy dog. ";
+      return text;
+    } // sample
+}; // class ConvertAdaptorTest
+
+TestSuite* ConvertAdaptorTest_suite()
+{
+  TestSuite* suiteOfTests = new TestSuite();
+
+  suiteOfTests->addTest(new TestCaller<ConvertAdaptorTest>("testRot13RoundTrip", &ConvertAdaptorTest::testRot13RoundTrip));
+  suiteOfTests->addTest(new TestCaller<ConvertAdaptorTest>("testBase64EncodesWhenFlushed", &ConvertAdaptorTest::testBase64EncodesWhenFlushed));
+  suiteOfTests->addTest(new TestCaller<ConvertAdaptorTest>("testBase64DecodesAcrossBuffers", &ConvertAdaptorTest::testBase64DecodesAcrossBuffers));
+#ifndef ARABICA_NO_WCHAR_T
+  suiteOfTests->addTest(new TestCaller<ConvertAdaptorTest>("testUtf8SplitAcrossBuffers", &ConvertAdaptorTest::testUtf8SplitAcrossBuffers));
+#endif
+  suiteOfTests->addTest(new TestCaller<ConvertAdaptorTest>("testPutback", &ConvertAdaptorTest::testPutback));
+
+  return suiteOfTests;
+} // ConvertAdaptorTest_suite
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef UTILS_ESCAPER_TEST_HPP
+#define UTILS_ESCAPER_TEST_HPP
+
+#include <XML/escaper.hpp>
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+class EscaperTest : public TestCase
+{
+  public:
+    EscaperTest(std::string name) :
+      TestCase(name)
+    {
+    } // EscaperTest
+
+    void testEscapeText()
+    {
+      assertEquals("", text(""));
+      assertEquals("plain", text("plain"));
+      assertEquals("&lt;a&gt; &amp; &lt;/a&gt;", text("<a> & </a>"));
+      assertEquals("\"quoted\"\t\n", text("\"quoted\"\t\n"));
+    } // testEscapeText
+
+    void testEscapeAttribute()
+    {
+      assertEquals("", attribute(""));
+      assertEquals("&lt;&gt;&amp;&quot;", attribute("<>&\""));
+      assertEquals("a&#x9;b&#xA;c&#xD;d", attribute("a\tb\nc\rd"));
+      // control characters without a reference are written as they are
+      assertEquals("a\x01" "b", attribute("a\x01" "b"));
+    } // testEscapeAttribute
+
+    void testLongRuns()
+    {
+      // long enough to cross the 16 and 32 character blocks
+      std::string clean(100, 'x');
+      assertEquals(clean, text(clean));
+      assertEquals(clean, attribute(clean));
+      assertEquals(clean + "&amp;" + clean, text(clean + "&" + clean));
+      assertEquals(clean + "&quot;" + clean, attribute(clean + "\"" + clean));
+    } // testLongRuns
+
+    void testFindEveryPosition()
+    {
+      const char specials[] = { '<', '>', '&', '"', '\t', '\n', '\r', '\x01', '\x1F' };
+      const int count = sizeof(specials) / sizeof(specials[0]);
+      for(size_t length = 1; length != 80; ++length)
+        for(size_t at = 0; at != length; ++at)
+          for(int s = 0; s != count; ++s)
+          {
+            std::string str(length, 'a');
+            str[at] = specials[s];
+            const char* b = str.data();
+            const char* e = b + str.size();
+
+            bool inText = (specials[s] == '<') || (specials[s] == '>') || (specials[s] == '&');
+            assertEquals(inText ? at : length, static_cast<size_t>(Arabica::XML::find_text_escape(b, e) - b));
+            assertEquals(at, static_cast<size_t>(Arabica::XML::find_attribute_escape(b, e) - b));
+          } // for ...
+    } // testFindEveryPosition
+
+    void testFindFirst()
+    {
+      std::string str(70, 'a');
+      str[40] = '&';
+      str[20] = '<';
+      str[50] = '"';
+      str[10] = '\n';
+      const char* b = str.data();
+      const char* e = b + str.size();
+      assertEquals(20, Arabica::XML::find_text_escape(b, e) - b);
+      assertEquals(10, Arabica::XML::find_attribute_escape(b, e) - b);
+      assertEquals(40, Arabica::XML::find_text_escape(b + 21, e) - b);
+      assertEquals(50, Arabica::XML::find_attribute_escape(b + 41, e) - b);
+    } // testFindFirst
+
+    void testHighCharacters()
+    {
+      // UTF-8 sequences, and DEL, don't need escaping
+      std::string str;
+      for(int c = 0x7F; c != 0x100; ++c)
+        str += static_cast<char>(c);
+      str += str;
+      const char* b = str.data();
+      const char* e = b + str.size();
+      assertTrue(Arabica::XML::find_text_escape(b, e) == e);
+      assertTrue(Arabica::XML::find_attribute_escape(b, e) == e);
+      assertEquals(str, attribute(str));
+    } // testHighCharacters
+
+    void testSameAsEscapers()
+    {
+      std::string str;
+      for(int i = 0; i != 300; ++i)
+        str += static_cast<char>((i * 37) % 256);
+
+      std::ostringstream expected;
+      std::for_each(str.begin(), str.end(), Arabica::XML::attribute_escaper<char>(expected));
+      assertEquals(expected.str(), attribute(str));
+
+      expected.str("");
+      std::for_each(str.begin(), str.end(), Arabica::XML::text_escaper<char>(expected));
+      assertEquals(expected.str(), text(str));
+    } // testSameAsEscapers
+
+#ifndef ARABICA_NO_WCHAR_T
+    void testWide()
+    {
+      std::wstring str(50, L'w');
+      str += L"<\"\x263A\">";
+
+      std::wostringstream os;
+      Arabica::XML::escape_attribute(os, str.begin(), str.end());
+      assertTrue(std::wstring(50, L'w') + L"&lt;&quot;\x263A&quot;&gt;" == os.str());
+    } // testWide
+#endif
+
+  private:
+    std::string text(const std::string& str)
+    {
+      std::ostringstream os;
+      Arabica::XML::escape_text(os, str.begin(), str.end());
+      return os.str();
+    } // text
+
+    std::string attribute(const std::string& str)
+    {
+      std::ostringstream os;
+      Arabica::XML::escape_attribute(os, str.begin(), str.end());
+      return os.str();
+    } // attribute
+}; // class EscaperTest
+
+TestSuite* EscaperTest_suite()
+{
+  TestSuite* suiteOfTests = new TestSuite();
+
+  suiteOfTests->addTest(new TestCaller<EscaperTest>("testEscapeText", &EscaperTest::testEscapeText));
+  suiteOfTests->addTest(new TestCaller<EscaperTest>("testEscapeAttribute", &EscaperTest::testEscapeAttribute));
+  suiteOfTests->addTest(new TestCaller<EscaperTest>("testLongRuns", &EscaperTest::testLongRuns));
+  suiteOfTests->addTest(new TestCaller<EscaperTest>("testFindEveryPosition", &EscaperTest::testFindEveryPosition));
+  suiteOfTests->addTest(new TestCaller<EscaperTest>("testFindFirst", &EscaperTest::testFindFirst));
+  suiteOfTests->addTest(new TestCaller<EscaperTest>("testHighCharacters", &EscaperTest::testHighCharacters));
+  suiteOfTests->addTest(new TestCaller<EscaperTest>("testSameAsEscapers", &EscaperTest::testSameAsEscapers));
+#ifndef ARABICA_NO_WCHAR_T
+  suiteOfTests->addTest(new TestCaller<EscaperTest>("testWide", &EscaperTest::testWide));
+#endif
+
+  return suiteOfTests;
+} // EscaperTest_suite
+
+#endif
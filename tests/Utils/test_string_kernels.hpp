@@ -0,0 +1,181 @@
+#ifndef UTILS_STRING_KERNELS_TEST_HPP
+#define UTILS_STRING_KERNELS_TEST_HPP
+
+#include <text/string_kernels.hpp>
+#include <string>
+
+// the char versions are checked against the plain templates, which are
+// called explicitly with <char>
+class StringKernelsTest : public TestCase
+{
+  public:
+    StringKernelsTest(std::string name) :
+      TestCase(name)
+    {
+    } // StringKernelsTest
+
+    void testFindChar()
+    {
+      std::string str = "hello world";
+      assertEquals(4, find_char(str, 'o'));
+      assertEquals(11, find_char(str, 'z'));
+      assertEquals(0, find_char("", 'z'));
+    } // testFindChar
+
+    void testFindString()
+    {
+      assertEquals(6, find_string("hello world", "world"));
+      assertEquals(0, find_string("hello world", ""));
+      assertEquals(11, find_string("hello world", "worlds"));
+      assertEquals(11, find_string("hello world", "wordl"));
+      assertEquals(3, find_string("aaaab", "ab"));
+      assertEquals(0, find_string("", ""));
+      assertEquals(0, find_string("", "a"));
+      assertEquals(1, find_string("ab", "b"));
+    } // testFindString
+
+    void testFindStringEveryPosition()
+    {
+      for(size_t length = 1; length != 50; ++length)
+        for(size_t at = 0; at != length; ++at)
+          for(size_t n = 1; n + at <= length; n += 3)
+          {
+            std::string str(length, 'a');
+            for(size_t i = at; i != at + n; ++i)
+              str[i] = static_cast<char>('b' + (i % 3));
+            std::string what = str.substr(at, n);
+            const char* b = str.data();
+            const char* e = b + str.size();
+            assertTrue(Arabica::text::find_string(b, e, what.data(), what.data() + n) ==
+                       Arabica::text::find_string<char>(b, e, what.data(), what.data() + n));
+          } // for ...
+    } // testFindStringEveryPosition
+
+    void testStartsWith()
+    {
+      std::string str = "hello";
+      const char* b = str.data();
+      assertTrue(Arabica::text::starts_with(b, b + 5, b, b + 3));
+      assertTrue(Arabica::text::starts_with(b, b + 5, b, b));
+      assertFalse(Arabica::text::starts_with(b, b + 3, b, b + 5));
+      assertFalse(Arabica::text::starts_with(b + 1, b + 5, b, b + 2));
+    } // testStartsWith
+
+    void testCollapse()
+    {
+      assertEquals("", collapse(""));
+      assertEquals("", collapse(" \t\r\n "));
+      assertEquals("a b c", collapse("  a \t b\r\n\r\nc  "));
+      assertEquals("a-long-word-without-spaces", collapse("a-long-word-without-spaces"));
+      assertEquals("a-long-word-without-spaces and-a-second-long-word", collapse("   a-long-word-without-spaces\n\n\nand-a-second-long-word\t"));
+    } // testCollapse
+
+    void testCollapseSameAsTemplate()
+    {
+      const char chars[] = { 'x', 'y', ' ', '\t', '\n', '\r', '\xE9' };
+      unsigned int seed = 1;
+      for(int run = 0; run != 500; ++run)
+      {
+        std::string str;
+        for(size_t length = run % 97; length != 0; --length)
+        {
+          seed = seed * 1103515245 + 12345;
+          // mostly words, with some whitespace
+          size_t c = (seed >> 16) % 16;
+          str += chars[c < 7 ? c : c % 2];
+        } // for ...
+
+        std::string expected(str);
+        std::string actual(str);
+        if(!str.empty())
+        {
+          char* e = &expected[0];
+          expected.resize(Arabica::text::collapse_whitespace<char>(e, e + str.size(), e) - e);
+          char* a = &actual[0];
+          actual.resize(Arabica::text::collapse_whitespace(a, a + str.size(), a) - a);
+        } // if ...
+        assertEquals(expected, actual);
+      } // for ...
+    } // testCollapseSameAsTemplate
+
+    void testTranslate()
+    {
+      assertEquals("BAr", translate("bar", "abc", "ABC"));
+      assertEquals("AAA", translate("--aaa--", "abc-", "ABC"));
+      assertEquals("abc", translate("a-b-c", "-", ""));
+      // the first occurrence in from counts
+      assertEquals("xzcxzc", translate("abcabc", "aab", "xyz"));
+      assertEquals("\xE9t\xE9", translate("ete", "e", "\xE9"));
+      assertEquals("bar", translate("bar", "", "xyz"));
+    } // testTranslate
+
+    void testTranslateSameAsTemplate()
+    {
+      std::string str;
+      for(int c = 0; c != 256; ++c)
+        str += static_cast<char>(c);
+      std::string from = "zyx\x80\xFF\x01 yz";
+      std::string to = "ABC\x7F";
+
+      std::string expected(str);
+      char* e = &expected[0];
+      expected.resize(Arabica::text::translate<char>(e, e + str.size(), from.data(), from.data() + from.size(), to.data(), to.data() + to.size()) - e);
+      assertEquals(expected, translate(str, from, to));
+      assertEquals(253, expected.size());
+    } // testTranslateSameAsTemplate
+
+  private:
+    size_t find_char(const std::string& str, char c)
+    {
+      const char* b = str.data();
+      return Arabica::text::find_char(b, b + str.size(), c) - b;
+    } // find_char
+
+    size_t find_string(const std::string& str, const std::string& what)
+    {
+      const char* b = str.data();
+      return Arabica::text::find_string(b, b + str.size(), what.data(), what.data() + what.size()) - b;
+    } // find_string
+
+    std::string collapse(const std::string& str)
+    {
+      std::string value(str);
+      if(!value.empty())
+      {
+        char* b = &value[0];
+        value.resize(Arabica::text::collapse_whitespace(b, b + value.size(), b) - b);
+      } // if ...
+      return value;
+    } // collapse
+
+    std::string translate(const std::string& str, const std::string& from, const std::string& to)
+    {
+      std::string value(str);
+      if(!value.empty())
+      {
+        char* b = &value[0];
+        value.resize(Arabica::text::translate(b, b + value.size(),
+                                              from.data(), from.data() + from.size(),
+                                              to.data(), to.data() + to.size()) - b);
+      } // if ...
+      return value;
+    } // translate
+}; // class StringKernelsTest
+
+TestSuite* StringKernelsTest_suite()
+{
+  TestSuite* suiteOfTests = new TestSuite();
+
+  suiteOfTests->addTest(new TestCaller<StringKernelsTest>("testFindChar", &StringKernelsTest::testFindChar));
+  suiteOfTests->addTest(new TestCaller<StringKernelsTest>("testFindString", &StringKernelsTest::testFindString));
+  suiteOfTests->addTest(new TestCaller<StringKernelsTest>("testFindStringEveryPosition", &StringKernelsTest::testFindStringEveryPosition));
+  suiteOfTests->addTest(new TestCaller<StringKernelsTest>("testStartsWith", &StringKernelsTest::testStartsWith));
+  suiteOfTests->addTest(new TestCaller<StringKernelsTest>("testCollapse", &StringKernelsTest::testCollapse));
+  suiteOfTests->addTest(new TestCaller<StringKernelsTest>("testCollapseSameAsTemplate", &StringKernelsTest::testCollapseSameAsTemplate));
+  suiteOfTests->addTest(new TestCaller<StringKernelsTest>("testTranslate", &StringKernelsTest::testTranslate));
+  suiteOfTests->addTest(new TestCaller<StringKernelsTest>("testTranslateSameAsTemplate", &StringKernelsTest::testTranslateSameAsTemplate));
+
+  return suiteOfTests;
+} // StringKernelsTest_suite
+
+#endif
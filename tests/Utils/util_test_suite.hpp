@@ -7,9 +7,12 @@
 
 #include "test_normalize_whitespace.hpp"
 #include "test_base64.hpp"
+#include "test_convert_adaptor.hpp"
 #include "test_uri.hpp"
 #include "test_xml_strings.hpp"
 #include "test_qname.hpp"
+#include "test_escaper.hpp"
+#include "test_string_kernels.hpp"
 
 template<class string_type, class string_adaptor>
 bool Util_test_suite(int argc, const char** argv)
@@ -18,9 +21,12 @@ bool Util_test_suite(int argc, const char** argv)
 
   runner.addTest("NormalizeWhitespaceTest", NormalizeWhitespaceTest_suite<string_type, string_adaptor >());
   runner.addTest("Base64Test", Base64Test_suite());
+  runner.addTest("ConvertAdaptorTest", ConvertAdaptorTest_suite());
   runner.addTest("URITest", URITest_suite());
   runner.addTest("XMLString", XMLStringTest_suite<string_type, string_adaptor>());
   runner.addTest("QualifiedName", QualifiedNameTest_suite<string_type, string_adaptor>());
+  runner.addTest("EscaperTest", EscaperTest_suite());
+  runner.addTest("StringKernelsTest", StringKernelsTest_suite());
   
   return runner.run(argc, argv);
 } // main
@@ -903,6 +903,29 @@ public:
     assertTrue(element3_ == result.asNodeSet()[0]);
   } // testUnion14
 
+  void testUnion15()
+  {
+    using namespace Arabica::XPath;
+    XPathValue<string_type, string_adaptor> result = parser.evaluate_expr(SA::construct_from_utf8("/root/child3|//processing-instruction()|//comment()|//@*|//text()|//spinkle|/root/child2|/root/child1|/root"), document_);
+    assertValuesEqual(NODE_SET, result.type());
+    const NodeSet<string_type, string_adaptor>& nodes = result.asNodeSet();
+    assertValuesEqual(13, nodes.size());
+    assertTrue(root_ == nodes[0]);
+    assertTrue(element1_ == nodes[1]);
+    assertTrue(attr_ == nodes[2]);
+    assertTrue(element2_ == nodes[3]);
+    for(size_t a = 4; a != 8; ++a)
+    {
+      Arabica::DOM::Attr<string_type, string_adaptor> attr(nodes[a]);
+      assertTrue(element2_ == attr.getOwnerElement());
+    } // for ...
+    assertTrue(text_ == nodes[8]);
+    assertTrue(spinkle_ == nodes[9]);
+    assertTrue(comment_ == nodes[10]);
+    assertTrue(processingInstruction_ == nodes[11]);
+    assertTrue(element3_ == nodes[12]);
+  } // testUnion15
+
   void testPlus1()
   {
     using namespace Arabica::XPath;
@@ -1853,6 +1876,14 @@ public:
     assertTrue(SA::construct_from_utf8("1 2 3 4 5") == result.asString());
   } // testNormalizeSpaceFn9
 
+  void testNormalizeSpaceFn10()
+  {
+    using namespace Arabica::XPath;
+    XPathValue<string_type, string_adaptor> result = parser.evaluate_expr(SA::construct_from_utf8("normalize-space('  a-long-word-without-any-spaces-in-it \t\n and-another-long-one-after-it  ')"), document_);
+    assertValuesEqual(STRING, result.type());
+    assertTrue(SA::construct_from_utf8("a-long-word-without-any-spaces-in-it and-another-long-one-after-it") == result.asString());
+  } // testNormalizeSpaceFn10
+
   void testTranslateFn1()
   {
     using namespace Arabica::XPath;
@@ -1869,6 +1900,22 @@ public:
     assertTrue(SA::construct_from_utf8("AAA") == result.asString());
   } // testTranslateFn2
 
+  void testTranslateFn3()
+  {
+    using namespace Arabica::XPath;
+    XPathValue<string_type, string_adaptor> result = parser.evaluate_expr(SA::construct_from_utf8("translate('a-b-c','-','')"), document_);
+    assertValuesEqual(STRING, result.type());
+    assertTrue(SA::construct_from_utf8("abc") == result.asString());
+  } // testTranslateFn3
+
+  void testTranslateFn4()
+  {
+    using namespace Arabica::XPath;
+    XPathValue<string_type, string_adaptor> result = parser.evaluate_expr(SA::construct_from_utf8("translate('abcabc','aab','xyz')"), document_);
+    assertValuesEqual(STRING, result.type());
+    assertTrue(SA::construct_from_utf8("xzcxzc") == result.asString());
+  } // testTranslateFn4
+
   void testLocalNameFn1()
   {
     using namespace Arabica::XPath;
@@ -2598,6 +2645,7 @@ TestSuite* ExecuteTest_suite()
   suiteOfTests->addTest(new TestCaller<ExecuteTest<string_type, string_adaptor> >("testUnion12", &ExecuteTest<string_type, string_adaptor>::testUnion12));
   suiteOfTests->addTest(new TestCaller<ExecuteTest<string_type, string_adaptor> >("testUnion13", &ExecuteTest<string_type, string_adaptor>::testUnion13));
   suiteOfTests->addTest(new TestCaller<ExecuteTest<string_type, string_adaptor> >("testUnion14", &ExecuteTest<string_type, string_adaptor>::testUnion14));
+  suiteOfTests->addTest(new TestCaller<ExecuteTest<string_type, string_adaptor> >("testUnion15", &ExecuteTest<string_type, string_adaptor>::testUnion15));
   suiteOfTests->addTest(new TestCaller<ExecuteTest<string_type, string_adaptor> >("testPlus1", &ExecuteTest<string_type, string_adaptor>::testPlus1));
   suiteOfTests->addTest(new TestCaller<ExecuteTest<string_type, string_adaptor> >("testPlus2", &ExecuteTest<string_type, string_adaptor>::testPlus2));
   suiteOfTests->addTest(new TestCaller<ExecuteTest<string_type, string_adaptor> >("testNodeSetEquality1", &ExecuteTest<string_type, string_adaptor>::testNodeSetEquality1));
@@ -2715,8 +2763,11 @@ TestSuite* ExecuteTest_suite()
   suiteOfTests->addTest(new TestCaller<ExecuteTest<string_type, string_adaptor> >("testNormalizeSpaceFn7", &ExecuteTest<string_type, string_adaptor>::testNormalizeSpaceFn7));
   suiteOfTests->addTest(new TestCaller<ExecuteTest<string_type, string_adaptor> >("testNormalizeSpaceFn8", &ExecuteTest<string_type, string_adaptor>::testNormalizeSpaceFn8));
   suiteOfTests->addTest(new TestCaller<ExecuteTest<string_type, string_adaptor> >("testNormalizeSpaceFn9", &ExecuteTest<string_type, string_adaptor>::testNormalizeSpaceFn9));
+  suiteOfTests->addTest(new TestCaller<ExecuteTest<string_type, string_adaptor> >("testNormalizeSpaceFn10", &ExecuteTest<string_type, string_adaptor>::testNormalizeSpaceFn10));
   suiteOfTests->addTest(new TestCaller<ExecuteTest<string_type, string_adaptor> >("testTranslateFn1", &ExecuteTest<string_type, string_adaptor>::testTranslateFn1));
   suiteOfTests->addTest(new TestCaller<ExecuteTest<string_type, string_adaptor> >("testTranslateFn2", &ExecuteTest<string_type, string_adaptor>::testTranslateFn2));
+  suiteOfTests->addTest(new TestCaller<ExecuteTest<string_type, string_adaptor> >("testTranslateFn3", &ExecuteTest<string_type, string_adaptor>::testTranslateFn3));
+  suiteOfTests->addTest(new TestCaller<ExecuteTest<string_type, string_adaptor> >("testTranslateFn4", &ExecuteTest<string_type, string_adaptor>::testTranslateFn4));
   suiteOfTests->addTest(new TestCaller<ExecuteTest<string_type, string_adaptor> >("testLocalNameFn1", &ExecuteTest<string_type, string_adaptor>::testLocalNameFn1));
   suiteOfTests->addTest(new TestCaller<ExecuteTest<string_type, string_adaptor> >("testLocalNameFn2", &ExecuteTest<string_type, string_adaptor>::testLocalNameFn2));
   suiteOfTests->addTest(new TestCaller<ExecuteTest<string_type, string_adaptor> >("testLocalNameFn3", &ExecuteTest<string_type, string_adaptor>::testLocalNameFn3));
@@ -0,0 +1,181 @@
+#ifndef XPATHIC_NUMBER_TEST_H
+#define XPATHIC_NUMBER_TEST_H
+
+#include "../CppUnit/framework/TestCase.h"
+#include "../CppUnit/framework/TestSuite.h"
+#include "../CppUnit/framework/TestCaller.h"
+
+#include <XPath/XPath.hpp>
+#include <cstdlib>
+
+template<class string_type, class string_adaptor>
+class NumberTest : public TestCase
+{
+  typedef string_adaptor SA;
+
+public:
+  NumberTest(const std::string& name) : TestCase(name)
+  {
+  } // NumberTest
+
+  void setUp()
+  {
+  } // setUp
+
+  void testParseInteger()
+  {
+    assertDoublesEqual(42.0, parse("42"), 0.0);
+    assertDoublesEqual(-42.0, parse("-42"), 0.0);
+    assertDoublesEqual(7.0, parse("007"), 0.0);
+  } // testParseInteger
+
+  void testParseFraction()
+  {
+    assertDoublesEqual(1.5, parse("1.5"), 0.0);
+    assertDoublesEqual(0.5, parse(".5"), 0.0);
+    assertDoublesEqual(5.0, parse("5."), 0.0);
+    assertDoublesEqual(0.1, parse("0.1"), 0.0);
+    assertDoublesEqual(0.005, parse("0.005"), 0.0);
+  } // testParseFraction
+
+  void testParseWhitespace()
+  {
+    assertDoublesEqual(-1.5, parse(" \t\r\n-1.5 \t\r\n"), 0.0);
+    assertTrue(Arabica::XPath::isNaN(parse("- 1.5")));
+    assertTrue(Arabica::XPath::isNaN(parse("1 5")));
+  } // testParseWhitespace
+
+  void testParseNotANumber()
+  {
+    using Arabica::XPath::isNaN;
+    assertTrue(isNaN(parse("")));
+    assertTrue(isNaN(parse("   ")));
+    assertTrue(isNaN(parse("-")));
+    assertTrue(isNaN(parse(".")));
+    assertTrue(isNaN(parse("+1.5")));
+    assertTrue(isNaN(parse("1e5")));
+    assertTrue(isNaN(parse("1.2.3")));
+    assertTrue(isNaN(parse("NaN")));
+    assertTrue(isNaN(parse("Infinity")));
+    assertTrue(isNaN(parse("0x10")));
+    assertTrue(isNaN(parse("trousers")));
+  } // testParseNotANumber
+
+  void testParseNegativeZero()
+  {
+    double z = parse("-0");
+    assertDoublesEqual(0.0, z, 0.0);
+    assertTrue(1/z < 0);
+  } // testParseNegativeZero
+
+  void testParseLongNumbers()
+  {
+    assertDoublesEqual(1.2345678901234568e29, parse("123456789012345678901234567890"), 0.0);
+    assertDoublesEqual(0.30000000000000004, parse("0.30000000000000004"), 0.0);
+    assertDoublesEqual(9007199254740993.0, parse("9007199254740993"), 0.0);
+    assertDoublesEqual(1e23, parse("100000000000000000000000"), 0.0);
+    assertDoublesEqual(1e-30, parse("0.000000000000000000000000000001"), 0.0);
+
+    // a halfway case which can only be decided by the very last digit
+    std::string halfway = "9007199254740993";
+    std::string above = halfway + "." + std::string(1000, '0') + "1";
+    assertDoublesEqual(9007199254740994.0, parse(above.c_str()), 0.0);
+  } // testParseLongNumbers
+
+  void testParseExtremes()
+  {
+    std::string huge = "1" + std::string(400, '0');
+    assertTrue(Arabica::XPath::isInfinity(parse(huge.c_str())));
+    std::string tiny = "0." + std::string(323, '0') + "5";
+    assertDoublesEqual(4.9406564584124654e-324, parse(tiny.c_str()), 0.0);
+  } // testParseExtremes
+
+  void testFormatIntegers()
+  {
+    assertEquals("0", format(0.0));
+    assertEquals("0", format(-0.0));
+    assertEquals("1", format(1.0));
+    assertEquals("-17", format(-17.0));
+    assertEquals("9007199254740992", format(9007199254740992.0));
+    assertEquals("100000000000000000000", format(1e20));
+    assertEquals("1000000000000000000000", format(1e21));
+  } // testFormatIntegers
+
+  void testFormatFractions()
+  {
+    assertEquals("0.1", format(0.1));
+    assertEquals("99.5", format(99.5));
+    assertEquals("-2.5", format(-2.5));
+    assertEquals("0.30000000000000004", format(0.1 + 0.2));
+    assertEquals("0.3333333333333333", format(1.0 / 3.0));
+    assertEquals("0.0000001", format(1e-7));
+    assertEquals("123.456", format(123.456));
+  } // testFormatFractions
+
+  void testFormatSpecialValues()
+  {
+    using namespace Arabica::XPath;
+    assertEquals("NaN", format(NaN));
+    assertEquals("Infinity", format(Infinity));
+    assertEquals("-Infinity", format(Negative_Infinity));
+  } // testFormatSpecialValues
+
+  void testRoundTrip()
+  {
+    std::srand(1);
+    for(int i = 0; i != 10000; ++i)
+    {
+      double d = (static_cast<double>(std::rand()) / RAND_MAX) * std::pow(10.0, (std::rand() % 40) - 20);
+      if(i % 2)
+        d = -d;
+      std::string s = format(d);
+      assertDoublesEqual(d, parse(s.c_str()), 0.0);
+    } // for ...
+  } // testRoundTrip
+
+  void testStringFunction()
+  {
+    using namespace Arabica::XPath;
+    XPath<string_type, string_adaptor> parser;
+    Arabica::DOM::Node<string_type, string_adaptor> dummy;
+    assertTrue(SA::construct_from_utf8("0.5") == parser.evaluate_expr(SA::construct_from_utf8("string(1 div 2)"), dummy).asString());
+    assertTrue(SA::construct_from_utf8("0") == parser.evaluate_expr(SA::construct_from_utf8("string(-0)"), dummy).asString());
+    assertTrue(SA::construct_from_utf8("1000000") == parser.evaluate_expr(SA::construct_from_utf8("string(1000 * 1000)"), dummy).asString());
+    assertTrue(SA::construct_from_utf8("NaN") == parser.evaluate_expr(SA::construct_from_utf8("string(number('1e5'))"), dummy).asString());
+    assertDoublesEqual(0.25, parser.evaluate_expr(SA::construct_from_utf8(".25"), dummy).asNumber(), 0.0);
+  } // testStringFunction
+
+private:
+  double parse(const char* str)
+  {
+    return Arabica::XPath::impl::stringAsNumber<string_type, string_adaptor>(SA::construct_from_utf8(str));
+  } // parse
+
+  std::string format(double value)
+  {
+    return SA::asStdString(Arabica::XPath::NumericValue<string_type, string_adaptor>(value).asString());
+  } // format
+}; // class NumberTest
+
+template<class string_type, class string_adaptor>
+TestSuite* NumberTest_suite()
+{
+  TestSuite* tests = new TestSuite;
+
+  tests->addTest(new TestCaller<NumberTest<string_type, string_adaptor> >("testParseInteger", &NumberTest<string_type, string_adaptor>::testParseInteger));
+  tests->addTest(new TestCaller<NumberTest<string_type, string_adaptor> >("testParseFraction", &NumberTest<string_type, string_adaptor>::testParseFraction));
+  tests->addTest(new TestCaller<NumberTest<string_type, string_adaptor> >("testParseWhitespace", &NumberTest<string_type, string_adaptor>::testParseWhitespace));
+  tests->addTest(new TestCaller<NumberTest<string_type, string_adaptor> >("testParseNotANumber", &NumberTest<string_type, string_adaptor>::testParseNotANumber));
+  tests->addTest(new TestCaller<NumberTest<string_type, string_adaptor> >("testParseNegativeZero", &NumberTest<string_type, string_adaptor>::testParseNegativeZero));
+  tests->addTest(new TestCaller<NumberTest<string_type, string_adaptor> >("testParseLongNumbers", &NumberTest<string_type, string_adaptor>::testParseLongNumbers));
+  tests->addTest(new TestCaller<NumberTest<string_type, string_adaptor> >("testParseExtremes", &NumberTest<string_type, string_adaptor>::testParseExtremes));
+  tests->addTest(new TestCaller<NumberTest<string_type, string_adaptor> >("testFormatIntegers", &NumberTest<string_type, string_adaptor>::testFormatIntegers));
+  tests->addTest(new TestCaller<NumberTest<string_type, string_adaptor> >("testFormatFractions", &NumberTest<string_type, string_adaptor>::testFormatFractions));
+  tests->addTest(new TestCaller<NumberTest<string_type, string_adaptor> >("testFormatSpecialValues", &NumberTest<string_type, string_adaptor>::testFormatSpecialValues));
+  tests->addTest(new TestCaller<NumberTest<string_type, string_adaptor> >("testRoundTrip", &NumberTest<string_type, string_adaptor>::testRoundTrip));
+  tests->addTest(new TestCaller<NumberTest<string_type, string_adaptor> >("testStringFunction", &NumberTest<string_type, string_adaptor>::testStringFunction));
+
+  return tests;
+} // NumberTest_suite
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef XPATHIC_OPTIMISE_TEST_H
+#define XPATHIC_OPTIMISE_TEST_H
+
+#include "../CppUnit/framework/TestCase.h"
+#include "../CppUnit/framework/TestSuite.h"
+#include "../CppUnit/framework/TestCaller.h"
+
+#include <XPath/XPath.hpp>
+#include <DOM/Simple/DOMImplementation.hpp>
+#include <sstream>
+
+template<class string_type, class string_adaptor>
+class CountingVariableResolver : public Arabica::XPath::VariableResolver<string_type, string_adaptor>
+{
+public:
+  CountingVariableResolver() : lookups_(0) { }
+
+  virtual Arabica::XPath::XPathValue<string_type, string_adaptor> resolveVariable(const string_type& /* namespace_uri */,
+                                                                     const string_type& /* name */) const
+  {
+    ++lookups_;
+    return Arabica::XPath::XPathValue<string_type, string_adaptor>(new Arabica::XPath::NumericValue<string_type, string_adaptor>(2));
+  } // resolveVariable
+
+  int lookups() const { return lookups_; }
+
+private:
+  mutable int lookups_;
+}; // CountingVariableResolver
+
+template<class string_type, class string_adaptor>
+class OptimiseTest : public TestCase
+{
+  typedef string_adaptor SA;
+  typedef Arabica::XPath::BoolValue<string_type, string_adaptor> BoolValue;
+  typedef Arabica::XPath::NumericValue<string_type, string_adaptor> NumericValue;
+  typedef Arabica::XPath::StringValue<string_type, string_adaptor> StringValue;
+
+public:
+  OptimiseTest(const std::string& name) : TestCase(name)
+  {
+  } // OptimiseTest
+
+  void setUp()
+  {
+    // items with v 1 to 6
+    document_ = createDocument(6);
+  } // setUp
+
+  void testFoldArithmetic()
+  {
+    using namespace Arabica::XPath;
+    XPathExpression<string_type, string_adaptor> expr = parser.compile_expr(SA::construct_from_utf8("1 + 2 * 3"));
+    assertTrue(dynamic_cast<const NumericValue*>(expr.get()) != 0);
+    assertDoublesEqual(7.0, expr.evaluateAsNumber(document_), 0.0);
+  } // testFoldArithmetic
+
+  void testFoldFunctions()
+  {
+    using namespace Arabica::XPath;
+    XPathExpression<string_type, string_adaptor> concat = parser.compile_expr(SA::construct_from_utf8("concat('a', substring('xbx', 2, 1))"));
+    assertTrue(dynamic_cast<const StringValue*>(concat.get()) != 0);
+    assertTrue(SA::construct_from_utf8("ab") == concat.evaluateAsString(document_));
+
+    XPathExpression<string_type, string_adaptor> length = parser.compile_expr(SA::construct_from_utf8("string-length('abc') = 3"));
+    assertTrue(dynamic_cast<const BoolValue*>(length.get()) != 0);
+    assertTrue(length.evaluateAsBool(document_));
+  } // testFoldFunctions
+
+  void testContextFunctionsNotFolded()
+  {
+    using namespace Arabica::XPath;
+    const char* exprs[] = { "string-length()", "position() + 1", "name()", "count(item) * 2", 0 };
+    for(const char** e = exprs; *e; ++e)
+    {
+      XPathExpression<string_type, string_adaptor> expr = parser.compile_expr(SA::construct_from_utf8(*e));
+      assertTrue(dynamic_cast<const NumericValue*>(expr.get()) == 0);
+      assertTrue(dynamic_cast<const StringValue*>(expr.get()) == 0);
+    } // for ...
+    assertDoublesEqual(12.0, parser.evaluate_expr(SA::construct_from_utf8("count(item) * 2"), document_.getDocumentElement()).asNumber(), 0.0);
+  } // testContextFunctionsNotFolded
+
+  void testFoldedPredicate()
+  {
+    assertDoublesEqual(3.0, count("//item[@v > 1 + 2]"), 0.0);
+    assertDoublesEqual(1.0, count("//item[last() - 1 * 2]"), 0.0);
+  } // testFoldedPredicate
+
+  void testInvariantPredicate()
+  {
+    assertDoublesEqual(3.0, count("//item[@v > count(/root/item) div 2]"), 0.0);
+    assertDoublesEqual(3.0, count("//item[@v > sum(//item/@v) div 6]"), 0.0);
+    assertDoublesEqual(1.0, count("//item[@v = count(/root/item[@v > 3])]"), 0.0);
+  } // testInvariantPredicate
+
+  void testInvariantPerDocument()
+  {
+    using namespace Arabica::XPath;
+    Arabica::DOM::Document<string_type, string_adaptor> other = createDocument(3);
+    XPathExpression<string_type, string_adaptor> expr = parser.compile_expr(SA::construct_from_utf8("count(//item[@v >= count(/root/item)])"));
+    assertDoublesEqual(1.0, expr.evaluateAsNumber(document_), 0.0);
+    assertDoublesEqual(1.0, expr.evaluateAsNumber(other), 0.0);
+  } // testInvariantPerDocument
+
+  void testVariableEvaluatedOnce()
+  {
+    using namespace Arabica::XPath;
+    CountingVariableResolver<string_type, string_adaptor> resolver;
+    parser.setVariableResolver(resolver);
+    assertDoublesEqual(2.0, parser.evaluate_expr(SA::construct_from_utf8("count(//item[@v > $limit * 2])"), document_).asNumber(), 0.0);
+    assertEquals(1, resolver.lookups());
+    parser.resetVariableResolver();
+  } // testVariableEvaluatedOnce
+
+  void testExplain()
+  {
+    std::string folded = explain("//item[@v > 1 + 2]");
+    assertTrue(folded.find("AdditiveExpr 1 + 2 : constant, folded to 3") != std::string::npos);
+
+    std::string hoisted = explain("//item[@v > count(/root/item) div 2]");
+    assertTrue(hoisted.find("count(/root/item) div 2 : evaluated once per document") != std::string::npos);
+
+    std::string variable = explain("//item[@v = $ids]");
+    assertTrue(variable.find("$ids : evaluated once, indexed when compared repeatedly") != std::string::npos);
+
+    std::string plain = explain("//item[@v = position()]");
+    assertTrue(plain.find(" : ") == std::string::npos);
+  } // testExplain
+
+private:
+  Arabica::DOM::Document<string_type, string_adaptor> createDocument(int items)
+  {
+    Arabica::DOM::DOMImplementation<string_type, string_adaptor> factory =
+        Arabica::SimpleDOM::DOMImplementation<string_type, string_adaptor>::getDOMImplementation();
+    Arabica::DOM::Document<string_type, string_adaptor> document = factory.createDocument(SA::construct_from_utf8(""), SA::construct_from_utf8("root"), 0);
+    for(int i = 1; i <= items; ++i)
+    {
+      std::ostringstream v;
+      v << i;
+      Arabica::DOM::Element<string_type, string_adaptor> item = document.createElement(SA::construct_from_utf8("item"));
+      item.setAttribute(SA::construct_from_utf8("v"), SA::construct_from_utf8(v.str().c_str()));
+      document.getDocumentElement().appendChild(item);
+    } // for ...
+    return document;
+  } // createDocument
+
+  double count(const char* path)
+  {
+    return parser.compile(SA::construct_from_utf8(path)).evaluateAsNodeSet(document_).size();
+  } // count
+
+  std::string explain(const char* expr)
+  {
+    return SA::asStdString(parser.explain(SA::construct_from_utf8(expr)));
+  } // explain
+
+  Arabica::XPath::XPath<string_type, string_adaptor> parser;
+  Arabica::DOM::Document<string_type, string_adaptor> document_;
+}; // class OptimiseTest
+
+template<class string_type, class string_adaptor>
+TestSuite* OptimiseTest_suite()
+{
+  TestSuite* tests = new TestSuite;
+
+  tests->addTest(new TestCaller<OptimiseTest<string_type, string_adaptor> >("testFoldArithmetic", &OptimiseTest<string_type, string_adaptor>::testFoldArithmetic));
+  tests->addTest(new TestCaller<OptimiseTest<string_type, string_adaptor> >("testFoldFunctions", &OptimiseTest<string_type, string_adaptor>::testFoldFunctions));
+  tests->addTest(new TestCaller<OptimiseTest<string_type, string_adaptor> >("testContextFunctionsNotFolded", &OptimiseTest<string_type, string_adaptor>::testContextFunctionsNotFolded));
+  tests->addTest(new TestCaller<OptimiseTest<string_type, string_adaptor> >("testFoldedPredicate", &OptimiseTest<string_type, string_adaptor>::testFoldedPredicate));
+  tests->addTest(new TestCaller<OptimiseTest<string_type, string_adaptor> >("testInvariantPredicate", &OptimiseTest<string_type, string_adaptor>::testInvariantPredicate));
+  tests->addTest(new TestCaller<OptimiseTest<string_type, string_adaptor> >("testInvariantPerDocument", &OptimiseTest<string_type, string_adaptor>::testInvariantPerDocument));
+  tests->addTest(new TestCaller<OptimiseTest<string_type, string_adaptor> >("testVariableEvaluatedOnce", &OptimiseTest<string_type, string_adaptor>::testVariableEvaluatedOnce));
+  tests->addTest(new TestCaller<OptimiseTest<string_type, string_adaptor> >("testExplain", &OptimiseTest<string_type, string_adaptor>::testExplain));
+
+  return tests;
+} // OptimiseTest_suite
+
+#endif
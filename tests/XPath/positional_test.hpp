@@ -0,0 +1,237 @@
+#ifndef XPATHIC_POSITIONAL_TEST_H
+#define XPATHIC_POSITIONAL_TEST_H
+
+#include "../CppUnit/framework/TestCase.h"
+#include "../CppUnit/framework/TestSuite.h"
+#include "../CppUnit/framework/TestCaller.h"
+
+#include <XPath/XPath.hpp>
+#include <DOM/Simple/DOMImplementation.hpp>
+
+template<class string_type, class string_adaptor>
+class PositionalTest : public TestCase
+{
+  typedef string_adaptor SA;
+
+public:
+  PositionalTest(const std::string& name) : TestCase(name)
+  {
+  } // PositionalTest
+
+  void setUp()
+  {
+    // <root>t t<b id='b1'/><c id='c1'/><b id='b2'/><b id='b3'/><c id='c2'/><b id='b4'/>t t</root>
+    Arabica::DOM::DOMImplementation<string_type, string_adaptor> factory =
+        Arabica::SimpleDOM::DOMImplementation<string_type, string_adaptor>::getDOMImplementation();
+    document_ = factory.createDocument(SA::construct_from_utf8(""), SA::construct_from_utf8("root"), 0);
+    root_ = document_.getDocumentElement();
+    text(root_, "first");
+    text(root_, "run");
+    const char* ids[] = { "b1", "c1", "b2", "b3", "c2", "b4", 0 };
+    for(const char** id = ids; *id; ++id)
+    {
+      Arabica::DOM::Element<string_type, string_adaptor> e = document_.createElement(SA::construct_from_utf8(std::string(*id, 1).c_str()));
+      e.setAttribute(SA::construct_from_utf8("id"), SA::construct_from_utf8(*id));
+      root_.appendChild(e);
+    } // for ...
+    text(root_, "last");
+    text(root_, "run");
+  } // setUp
+
+  void testNumber()
+  {
+    assertEquals("b1", ids("/root/b[1]"));
+    assertEquals("b3", ids("/root/b[3]"));
+    assertEquals("b2", ids("/root/b[1 + 1]"));
+    assertEquals("c2", ids("/root/*[5]"));
+    assertEquals("", ids("/root/b[9]"));
+    assertEquals("", ids("/root/b[0]"));
+    assertEquals("", ids("/root/b[-1]"));
+    assertEquals("", ids("/root/b[1.5]"));
+  } // testNumber
+
+  void testLast()
+  {
+    assertEquals("b4", ids("/root/b[last()]"));
+    assertEquals("c2", ids("/root/c[last()]"));
+    assertEquals("b4", ids("/root/*[last()]"));
+    assertEquals("b4", ids("/root/b[position() = last()]"));
+    assertEquals("b4", ids("/root/b[last() = position()]"));
+    assertEquals("b3", ids("/root/b[last() - 1]"));
+    assertEquals("", ids("/root/b/x[last()]"));
+  } // testLast
+
+  void testLastTextRun()
+  {
+    // adjacent text nodes are one node to XPath, found by its first part
+    assertTrue(SA::construct_from_utf8("last") == value("/root/node()[last()]"));
+    assertTrue(SA::construct_from_utf8("last") == value("/root/text()[last()]"));
+    assertTrue(SA::construct_from_utf8("first") == value("/root/text()[1]"));
+    assertDoublesEqual(8.0, count("/root/node()"), 0.0);
+  } // testLastTextRun
+
+  void testRanges()
+  {
+    assertEquals("b1 b2", ids("/root/b[position() < 3]"));
+    assertEquals("b1 b2", ids("/root/b[position() <= 2]"));
+    assertEquals("b3 b4", ids("/root/b[position() > 2]"));
+    assertEquals("b2 b3 b4", ids("/root/b[position() >= 2]"));
+    assertEquals("b1 b2", ids("/root/b[3 > position()]"));
+    assertEquals("b3 b4", ids("/root/b[2 < position()]"));
+    assertEquals("b1 b2", ids("/root/b[position() < 2.5]"));
+    assertEquals("b3 b4", ids("/root/b[position() >= 2.5]"));
+    assertEquals("b2 b3", ids("/root/b[position() > 1 and position() <= 3]"));
+    assertEquals("b2", ids("/root/b[position() = 2]"));
+    assertEquals("", ids("/root/b[position() > 3 and position() < 4]"));
+    assertEquals("", ids("/root/b[position() = 2.5]"));
+    assertEquals("", ids("/root/b[position() < number('x')]"));
+    assertEquals("b1 b2 b3 b4", ids("/root/b[position() < 1 div 0]"));
+  } // testRanges
+
+  void testNotPositional()
+  {
+    assertEquals("b1 b3 b4", ids("/root/b[position() != 2]"));
+    assertEquals("b2 b4", ids("/root/b[position() = 2 or position() = 4]"));
+    assertEquals("b2 b4", ids("/root/b[position() mod 2 = 0]"));
+    assertEquals("b1", ids("/root/b[position() < last() div 2]"));
+    // inside and, a number is true unless it is 0 or NaN
+    assertEquals("b2 b3 b4", ids("/root/b[position() > 1 and 3]"));
+    assertEquals("b1 b2 b3", ids("/root/b[2 and position() < 4]"));
+    assertEquals("b1 b2 b3 b4", ids("/root/b[2 and position() < 5]"));
+    assertEquals("", ids("/root/b[position() > 1 and 0]"));
+    assertEquals("b1 b2", ids("/root/b[position() < 3 and (1 and 4)]"));
+  } // testNotPositional
+
+  void testSiblings()
+  {
+    assertEquals("b2", ids("/root/b[@id='b3']/preceding-sibling::*[1]"));
+    assertEquals("b1", ids("/root/b[@id='b3']/preceding-sibling::*[last()]"));
+    assertEquals("b1", ids("/root/b[@id='b3']/preceding-sibling::b[last()]"));
+    assertEquals("c1 b2", ids("/root/b[@id='b3']/preceding-sibling::*[position() <= 2]"));
+    assertEquals("c2", ids("/root/b[@id='b3']/following-sibling::*[1]"));
+    assertEquals("b4", ids("/root/b[@id='b3']/following-sibling::*[last()]"));
+    assertEquals("c2", ids("/root/b[@id='b3']/following-sibling::c[last()]"));
+    assertEquals("", ids("/root/b[@id='b1']/preceding-sibling::*[last()]"));
+    assertEquals("", ids("/root/b[@id='b4']/following-sibling::*[last()]"));
+    assertTrue(SA::construct_from_utf8("first") == value("/root/b[@id='b3']/preceding-sibling::node()[last()]"));
+    assertTrue(SA::construct_from_utf8("last") == value("/root/b[@id='b3']/following-sibling::node()[last()]"));
+    assertEquals("", ids("/root/b[1]/@id/following-sibling::node()[last()]"));
+    assertEquals("", ids("/root/preceding-sibling::node()[last()]"));
+  } // testSiblings
+
+  void testOtherAxes()
+  {
+    assertEquals("b4", ids("/descendant::b[last()]"));
+    assertEquals("b2", ids("/descendant::b[2]"));
+    assertEquals("c1", ids("/root/b[@id='b2']/preceding::*[1]"));
+    assertEquals("c2", ids("//b[@id='b3']/following::*[1]"));
+  } // testOtherAxes
+
+  void testFurtherPredicates()
+  {
+    assertEquals("b2 b3", ids("/root/b[position() < 4][@id != 'b1']"));
+    assertEquals("b3", ids("/root/b[position() < 4][@id != 'b1'][2]"));
+    assertEquals("b2", ids("/root/b[2][@id = 'b2']"));
+    assertEquals("", ids("/root/b[2][@id = 'b1']"));
+    assertEquals("c2", ids("/root/*[@id][last() - 1][1]"));
+    assertEquals("b4", ids("/root/b[last()][1]"));
+    assertEquals("b3", ids("/root/*[starts-with(@id, 'b')][3]"));
+  } // testFurtherPredicates
+
+  void testEveryContextNode()
+  {
+    assertEquals("b1 b2 b3 b4", ids("/root/*/self::b[1]"));
+    assertEquals("b2 b3 b4", ids("/root/*/following-sibling::b[1]"));
+    assertEquals("c1 c2", ids("/root/*/preceding-sibling::c[1]"));
+  } // testEveryContextNode
+
+  void testFilterExpressions()
+  {
+    assertEquals("b1", ids("(/root/b)[1]"));
+    assertEquals("b4", ids("(/root/b)[last()]"));
+    assertEquals("b2 b3", ids("(/root/b)[position() > 1 and position() < 4]"));
+    assertEquals("b1", ids("(/root/b[@id='b3']/preceding-sibling::b)[1]"));
+  } // testFilterExpressions
+
+  void testMatch()
+  {
+    assertTrue(matches("b[1]", "b1"));
+    assertFalse(matches("b[1]", "b2"));
+    assertTrue(matches("b[last()]", "b4"));
+    assertFalse(matches("b[last()]", "b3"));
+    assertTrue(matches("b[position() > 2]", "b3"));
+    assertFalse(matches("b[position() > 2]", "b2"));
+    assertTrue(matches("root/*[2]", "c1"));
+  } // testMatch
+
+private:
+  void text(Arabica::DOM::Element<string_type, string_adaptor> parent, const char* data)
+  {
+    parent.appendChild(document_.createTextNode(SA::construct_from_utf8(data)));
+  } // text
+
+  // the ids of the nodes selected, in document order, space separated
+  std::string ids(const char* path)
+  {
+    Arabica::XPath::NodeSet<string_type, string_adaptor> nodes = parser.evaluate_expr(SA::construct_from_utf8(path), document_).asNodeSet();
+    nodes.to_document_order();
+    std::string result;
+    for(size_t n = 0; n != nodes.size(); ++n)
+    {
+      if(n != 0)
+        result += " ";
+      Arabica::DOM::Element<string_type, string_adaptor> e = static_cast<Arabica::DOM::Element<string_type, string_adaptor> >(nodes[n]);
+      result += SA::asStdString(e.getAttribute(SA::construct_from_utf8("id")));
+    } // for ...
+    return result;
+  } // ids
+
+  string_type value(const char* path)
+  {
+    Arabica::XPath::NodeSet<string_type, string_adaptor> nodes = parser.evaluate_expr(SA::construct_from_utf8(path), document_).asNodeSet();
+    assertEquals(1, nodes.size());
+    return nodes[0].getNodeValue();
+  } // value
+
+  double count(const char* path)
+  {
+    return parser.evaluate_expr(SA::construct_from_utf8(path), document_).asNodeSet().size();
+  } // count
+
+  bool matches(const char* pattern, const char* id)
+  {
+    Arabica::DOM::Node<string_type, string_adaptor> node = parser.evaluate_expr(SA::construct_from_utf8(("//*[@id='" + std::string(id) + "']").c_str()), document_).asNodeSet()[0];
+    std::vector<Arabica::XPath::MatchExpr<string_type, string_adaptor> > exprs = parser.compile_match(SA::construct_from_utf8(pattern));
+    Arabica::XPath::ExecutionContext<string_type, string_adaptor> context;
+    for(size_t m = 0; m != exprs.size(); ++m)
+      if(exprs[m].evaluate(node, context))
+        return true;
+    return false;
+  } // matches
+
+  Arabica::XPath::XPath<string_type, string_adaptor> parser;
+  Arabica::DOM::Document<string_type, string_adaptor> document_;
+  Arabica::DOM::Element<string_type, string_adaptor> root_;
+}; // class PositionalTest
+
+template<class string_type, class string_adaptor>
+TestSuite* PositionalTest_suite()
+{
+  TestSuite* tests = new TestSuite;
+
+  tests->addTest(new TestCaller<PositionalTest<string_type, string_adaptor> >("testNumber", &PositionalTest<string_type, string_adaptor>::testNumber));
+  tests->addTest(new TestCaller<PositionalTest<string_type, string_adaptor> >("testLast", &PositionalTest<string_type, string_adaptor>::testLast));
+  tests->addTest(new TestCaller<PositionalTest<string_type, string_adaptor> >("testLastTextRun", &PositionalTest<string_type, string_adaptor>::testLastTextRun));
+  tests->addTest(new TestCaller<PositionalTest<string_type, string_adaptor> >("testRanges", &PositionalTest<string_type, string_adaptor>::testRanges));
+  tests->addTest(new TestCaller<PositionalTest<string_type, string_adaptor> >("testNotPositional", &PositionalTest<string_type, string_adaptor>::testNotPositional));
+  tests->addTest(new TestCaller<PositionalTest<string_type, string_adaptor> >("testSiblings", &PositionalTest<string_type, string_adaptor>::testSiblings));
+  tests->addTest(new TestCaller<PositionalTest<string_type, string_adaptor> >("testOtherAxes", &PositionalTest<string_type, string_adaptor>::testOtherAxes));
+  tests->addTest(new TestCaller<PositionalTest<string_type, string_adaptor> >("testFurtherPredicates", &PositionalTest<string_type, string_adaptor>::testFurtherPredicates));
+  tests->addTest(new TestCaller<PositionalTest<string_type, string_adaptor> >("testEveryContextNode", &PositionalTest<string_type, string_adaptor>::testEveryContextNode));
+  tests->addTest(new TestCaller<PositionalTest<string_type, string_adaptor> >("testFilterExpressions", &PositionalTest<string_type, string_adaptor>::testFilterExpressions));
+  tests->addTest(new TestCaller<PositionalTest<string_type, string_adaptor> >("testMatch", &PositionalTest<string_type, string_adaptor>::testMatch));
+
+  return tests;
+} // PositionalTest_suite
+
+#endif
@@ -6,10 +6,13 @@
 #include "../CppUnit/framework/TestCaller.h"
 
 #include <XPath/XPath.hpp>
+#include <DOM/Simple/DOMImplementation.hpp>
 
 template<class string_type, class string_adaptor>
 class RelationalTest : public TestCase
 {
+  typedef string_adaptor SA;
+
 public:
   RelationalTest(const std::string& name) : TestCase(name)
   {
@@ -17,6 +20,37 @@ public:
 
   void setUp()
   {
+    // vip ids 2, 4, x - order customers 1, 2, 4, 5 - n 3, 7
+    Arabica::DOM::DOMImplementation<string_type, string_adaptor> factory = 
+        Arabica::SimpleDOM::DOMImplementation<string_type, string_adaptor>::getDOMImplementation();
+    document_ = factory.createDocument(SA::construct_from_utf8(""), SA::construct_from_utf8("root"), 0);
+    Arabica::DOM::Element<string_type, string_adaptor> root = document_.getDocumentElement();
+
+    const char* vips[] = { "2", "4", "x", 0 };
+    for(const char** v = vips; *v; ++v)
+    {
+      Arabica::DOM::Element<string_type, string_adaptor> vip = document_.createElement(SA::construct_from_utf8("vip"));
+      vip.setAttribute(SA::construct_from_utf8("id"), SA::construct_from_utf8(*v));
+      root.appendChild(vip);
+    } // for ...
+
+    const char* customers[] = { "1", "2", "4", "5", 0 };
+    for(const char** c = customers; *c; ++c)
+    {
+      Arabica::DOM::Element<string_type, string_adaptor> order = document_.createElement(SA::construct_from_utf8("order"));
+      Arabica::DOM::Element<string_type, string_adaptor> customer = document_.createElement(SA::construct_from_utf8("customer"));
+      customer.setAttribute(SA::construct_from_utf8("id"), SA::construct_from_utf8(*c));
+      order.appendChild(customer);
+      root.appendChild(order);
+    } // for ...
+
+    const char* ns[] = { "3", "7", 0 };
+    for(const char** n = ns; *n; ++n)
+    {
+      Arabica::DOM::Element<string_type, string_adaptor> e = document_.createElement(SA::construct_from_utf8("n"));
+      e.appendChild(document_.createTextNode(SA::construct_from_utf8(*n)));
+      root.appendChild(e);
+    } // for ...
   } // setUp
 
   void test1()
@@ -173,8 +207,60 @@ public:
     assertEquals(true, lessThanEquals4.evaluateAsBool(dummy_));
   } // testLessThanEquals3
 
+  void testNodeSetJoin()
+  {
+    assertDoublesEqual(2, count("//order[customer/@id = //vip/@id]"), 0.0);
+    assertDoublesEqual(2, count("//order[//vip/@id = customer/@id]"), 0.0);
+    assertDoublesEqual(4, count("//order[customer/@id != //vip/@id]"), 0.0);
+    assertDoublesEqual(0, count("//order[customer/@id = /root/nothing]"), 0.0);
+    assertDoublesEqual(0, count("//order[customer/@id != /root/nothing]"), 0.0);
+  } // testNodeSetJoin
+
+  void testNodeSetJoinWithValues()
+  {
+    assertDoublesEqual(2, count("//order[//vip/@id = customer/@id + 0]"), 0.0);
+    assertDoublesEqual(4, count("//order[//vip/@id != customer/@id + 0]"), 0.0);
+    assertDoublesEqual(1, count("//order[/root/n = customer/@id * 1.5]"), 0.0);
+    assertDoublesEqual(4, count("//order[/root/vip/@id = 'x']"), 0.0);
+    assertDoublesEqual(0, count("//order[/root/vip/@id = 'y']"), 0.0);
+    assertDoublesEqual(4, count("//order[/root/n != 3]"), 0.0);
+  } // testNodeSetJoinWithValues
+
+  void testNodeSetJoinRelational()
+  {
+    assertDoublesEqual(4, count("//order[customer/@id < //n]"), 0.0);
+    assertDoublesEqual(2, count("//order[customer/@id > //n]"), 0.0);
+    assertDoublesEqual(2, count("//order[customer/@id >= /root/n]"), 0.0);
+    assertDoublesEqual(2, count("//order[//n <= customer/@id]"), 0.0);
+    assertDoublesEqual(3, count("//order[customer/@id <= //vip/@id]"), 0.0);
+    assertDoublesEqual(2, count("//order[//vip/@id < customer/@id]"), 0.0);
+  } // testNodeSetJoinRelational
+
+  void testEmptyNodeSetRelational()
+  {
+    assertDoublesEqual(0, count("//order[/root/nothing < customer/@id]"), 0.0);
+    assertDoublesEqual(0, count("//order[customer/@id > /root/nothing]"), 0.0);
+    assertTrue(!evaluate("/root/nothing < /root/n"));
+    assertTrue(!evaluate("/root/n >= /root/nothing"));
+    assertTrue(!evaluate("/root/nothing <= 1"));
+  } // testEmptyNodeSetRelational
+
 private:
+  double count(const char* expr)
+  {
+    Arabica::XPath::XPath<string_type, string_adaptor> parser;
+    std::string counted = "count(" + std::string(expr) + ")";
+    return parser.evaluate_expr(SA::construct_from_utf8(counted.c_str()), document_).asNumber();
+  } // count
+
+  bool evaluate(const char* expr)
+  {
+    Arabica::XPath::XPath<string_type, string_adaptor> parser;
+    return parser.evaluate_expr(SA::construct_from_utf8(expr), document_).asBool();
+  } // evaluate
+
   Arabica::DOM::Node<string_type, string_adaptor> dummy_;
+  Arabica::DOM::Document<string_type, string_adaptor> document_;
 }; // class RelationalTest
 
 template<class string_type, class string_adaptor>
@@ -198,6 +284,11 @@ TestSuite* RelationalTest_suite()
   tests->addTest(new TestCaller<RelationalTest<string_type, string_adaptor> >("testLessThanEquals2", &RelationalTest<string_type, string_adaptor>::testLessThanEquals2));
   tests->addTest(new TestCaller<RelationalTest<string_type, string_adaptor> >("testLessThanEquals3", &RelationalTest<string_type, string_adaptor>::testLessThanEquals3));
 
+  tests->addTest(new TestCaller<RelationalTest<string_type, string_adaptor> >("testNodeSetJoin", &RelationalTest<string_type, string_adaptor>::testNodeSetJoin));
+  tests->addTest(new TestCaller<RelationalTest<string_type, string_adaptor> >("testNodeSetJoinWithValues", &RelationalTest<string_type, string_adaptor>::testNodeSetJoinWithValues));
+  tests->addTest(new TestCaller<RelationalTest<string_type, string_adaptor> >("testNodeSetJoinRelational", &RelationalTest<string_type, string_adaptor>::testNodeSetJoinRelational));
+  tests->addTest(new TestCaller<RelationalTest<string_type, string_adaptor> >("testEmptyNodeSetRelational", &RelationalTest<string_type, string_adaptor>::testEmptyNodeSetRelational));
+
   return tests;
 } // RelationalTest_suite
 
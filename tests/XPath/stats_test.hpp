@@ -0,0 +1,141 @@
+#ifndef STATS_TEST_HPP
+#define STATS_TEST_HPP
+
+#include "../CppUnit/framework/TestCase.h"
+#include "../CppUnit/framework/TestSuite.h"
+#include "../CppUnit/framework/TestCaller.h"
+
+#include <sstream>
+#include <Arabica/stats.hpp>
+#include <XPath/XPath.hpp>
+#include <DOM/SAX2DOM/SAX2DOM.hpp>
+#include <SAX/helpers/CatchErrorHandler.hpp>
+
+// Passes whether or not ARABICA_STATS is defined - when it isn't, every
+// figure stays at zero.
+template<class string_type, class string_adaptor>
+class StatsTest : public TestCase
+{
+  typedef string_adaptor SA;
+  typedef Arabica::stats::Snapshot Snapshot;
+
+public:
+  StatsTest(const std::string& name) : TestCase(name)
+  {
+  } // StatsTest
+
+  void setUp()
+  {
+  } // setUp
+
+  void testResetZeroes()
+  {
+    parseXML("<root><a/></root>");
+    Arabica::stats::reset();
+    Snapshot now = Arabica::stats::snapshot();
+    for(int c = 0; c != Arabica::stats::counter_count; ++c)
+      assertTrue(now.counters[c] == 0);
+    for(int t = 0; t != Arabica::stats::timer_count; ++t)
+      assertTrue(now.calls[t] == 0 && now.nanoseconds[t] == 0);
+  } // testResetZeroes
+
+  void testParseAndEvaluate()
+  {
+    Arabica::stats::Scope scope;
+
+    Arabica::DOM::Document<string_type, string_adaptor> doc = parseXML("<root><a/><b/><a><b/></a></root>");
+    Arabica::XPath::XPath<string_type, string_adaptor> xpath;
+    Arabica::XPath::NodeSet<string_type, string_adaptor> nodes =
+      xpath.compile_expr(SA::construct_from_utf8("//b | //a")).evaluateAsNodeSet(doc);
+    assertEquals(4, nodes.size());
+
+    Snapshot delta = scope.delta();
+    if(!Arabica::stats::enabled())
+    {
+      assertTrue(delta[Arabica::stats::axis_steps] == 0);
+      assertTrue(delta[Arabica::stats::dom_nodes_created] == 0);
+      assertTrue(delta.calls[Arabica::stats::sax_parse] == 0);
+      return;
+    } // if ...
+
+    assertTrue(delta.calls[Arabica::stats::sax_parse] == 1);
+    assertTrue(delta.calls[Arabica::stats::dom_build] == 1);
+    assertTrue(delta.calls[Arabica::stats::xpath_evaluate] == 1);
+    // the document and its five elements
+    assertTrue(delta[Arabica::stats::dom_nodes_created] >= 6);
+    // root, a and b are all new to the document's pool
+    assertTrue(delta[Arabica::stats::pool_strings] >= 3);
+    assertTrue(delta[Arabica::stats::pool_lookups] >= delta[Arabica::stats::pool_strings]);
+    assertTrue(delta[Arabica::stats::axis_walks] != 0);
+    assertTrue(delta[Arabica::stats::axis_steps] >= 6);
+    assertTrue(delta[Arabica::stats::nodeset_sorts] != 0);
+    assertTrue(delta[Arabica::stats::nodeset_sorted_nodes] >= 4);
+  } // testParseAndEvaluate
+
+  void testScopesNest()
+  {
+    Arabica::stats::Scope outer;
+    parseXML("<root/>");
+    Arabica::stats::Scope inner;
+    parseXML("<root/>");
+
+    assertTrue(inner.delta().calls[Arabica::stats::sax_parse] == (Arabica::stats::enabled() ? 1 : 0));
+    assertTrue(outer.delta().calls[Arabica::stats::sax_parse] == (Arabica::stats::enabled() ? 2 : 0));
+  } // testScopesNest
+
+  void testNodesDeleted()
+  {
+    Arabica::stats::Scope scope;
+    {
+      Arabica::DOM::Document<string_type, string_adaptor> doc = parseXML("<root><a/><b/></root>");
+    }
+    Snapshot delta = scope.delta();
+    assertTrue(delta[Arabica::stats::dom_nodes_created] == delta[Arabica::stats::dom_nodes_deleted]);
+  } // testNodesDeleted
+
+  void testOutput()
+  {
+    Snapshot snapshot;
+    snapshot.counters[Arabica::stats::axis_steps] = 12;
+    snapshot.calls[Arabica::stats::xpath_evaluate] = 2;
+    snapshot.nanoseconds[Arabica::stats::xpath_evaluate] = 1500000;
+
+    std::ostringstream os;
+    os << snapshot;
+    assertEquals("axis_steps 12\nxpath_evaluate 2 calls 1.5 ms\n", os.str());
+  } // testOutput
+
+private:
+  Arabica::DOM::Document<string_type, string_adaptor> parseXML(const char* xml)
+  {
+    std::stringstream ss;
+    ss << xml;
+
+    Arabica::SAX::InputSource<string_type, string_adaptor> is(ss);
+    Arabica::SAX::CatchErrorHandler<string_type, string_adaptor> eh;
+    Arabica::SAX2DOM::Parser<string_type, string_adaptor> parser;
+    parser.setErrorHandler(eh);
+    parser.parse(is);
+
+    if(eh.errorsReported())
+      throw std::runtime_error(eh.errors());
+
+    return parser.getDocument();
+  } // parseXML
+}; // class StatsTest
+
+template<class string_type, class string_adaptor>
+TestSuite* StatsTest_suite()
+{
+  TestSuite *suiteOfTests = new TestSuite;
+
+  suiteOfTests->addTest(new TestCaller<StatsTest<string_type, string_adaptor> >("testResetZeroes", &StatsTest<string_type, string_adaptor>::testResetZeroes));
+  suiteOfTests->addTest(new TestCaller<StatsTest<string_type, string_adaptor> >("testParseAndEvaluate", &StatsTest<string_type, string_adaptor>::testParseAndEvaluate));
+  suiteOfTests->addTest(new TestCaller<StatsTest<string_type, string_adaptor> >("testScopesNest", &StatsTest<string_type, string_adaptor>::testScopesNest));
+  suiteOfTests->addTest(new TestCaller<StatsTest<string_type, string_adaptor> >("testNodesDeleted", &StatsTest<string_type, string_adaptor>::testNodesDeleted));
+  suiteOfTests->addTest(new TestCaller<StatsTest<string_type, string_adaptor> >("testOutput", &StatsTest<string_type, string_adaptor>::testOutput));
+
+  return suiteOfTests;
+} // StatsTest_suite
+
+#endif
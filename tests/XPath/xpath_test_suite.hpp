@@ -7,8 +7,11 @@
 
 #include "parse_test.hpp"
 #include "value_test.hpp"
+#include "number_test.hpp"
 #include "arithmetic_test.hpp"
 #include "relational_test.hpp"
+#include "optimise_test.hpp"
+#include "positional_test.hpp"
 #include "logical_test.hpp"
 #include "axis_enumerator_test.hpp"
 #include "node_test_test.hpp"
@@ -18,6 +21,7 @@
 #include "match_test.hpp"
 #include "attr_value_test.hpp"
 #include "text_node_test.hpp"
+#include "stats_test.hpp"
 
 template<class string_type, class string_adaptor>
 bool XPath_test_suite(int argc, const char** argv)
@@ -25,8 +29,11 @@ bool XPath_test_suite(int argc, const char** argv)
   TestRunner runner;
 
   runner.addTest("ValueTest", ValueTest_suite<string_type, string_adaptor>());
+  runner.addTest("NumberTest", NumberTest_suite<string_type, string_adaptor>());
   runner.addTest("ArithmeticTest", ArithmeticTest_suite<string_type, string_adaptor>());
   runner.addTest("RelationalTest", RelationalTest_suite<string_type, string_adaptor>());
+  runner.addTest("OptimiseTest", OptimiseTest_suite<string_type, string_adaptor>());
+  runner.addTest("PositionalTest", PositionalTest_suite<string_type, string_adaptor>());
   runner.addTest("LogicalTest", LogicalTest_suite<string_type, string_adaptor>());
   runner.addTest("AxisEnumeratorTest", AxisEnumeratorTest_suite<string_type, string_adaptor>());
   runner.addTest("NodeTestTest", NodeTestTest_suite<string_type, string_adaptor>());
@@ -37,6 +44,7 @@ bool XPath_test_suite(int argc, const char** argv)
   runner.addTest("MatchTest", MatchTest_suite<string_type, string_adaptor>());
   runner.addTest("AttributeValueTest", AttributeValueTest_suite<string_type, string_adaptor>());
   runner.addTest("TextNodeTest", TextNodeTest_suite<string_type, string_adaptor>());
+  runner.addTest("StatsTest", StatsTest_suite<string_type, string_adaptor>());
 
   return runner.run(argc, argv);
 } // XPath_test_suite
@@ -0,0 +1,253 @@
+#ifndef XSLT_BATCH_TEST_HPP
+#define XSLT_BATCH_TEST_HPP
+
+#include <cstdio>
+#include <thread>
+#include <XSLT/BatchTransformer.hpp>
+
+// Every input is a list of items, and the stylesheet writes out how many
+// have type a, through key(), then the list's name, through apply-imports.
+// The files are written to the current directory, and removed afterwards.
+template<class string_type, class string_adaptor>
+class BatchTest : public TestCase
+{
+  typedef string_adaptor SA;
+  typedef Arabica::XSLT::Stylesheet<string_type, string_adaptor> StylesheetT;
+  typedef Arabica::XSLT::BatchTransformer<string_type, string_adaptor> BatchTransformerT;
+  typedef std::basic_ostringstream<typename string_adaptor::value_type> ostringstreamT;
+
+public:
+  BatchTest(std::string name) : TestCase(name)
+  {
+  } // BatchTest
+
+  void setUp()
+  {
+    write("BatchTestImported.xsl",
+          "<xsl:stylesheet version='1.0' xmlns:xsl='http://www.w3.org/1999/XSL/Transform'>\n"
+          "  <xsl:template match='list'><xsl:value-of select='@name'/></xsl:template>\n"
+          "</xsl:stylesheet>\n");
+    write("BatchTest.xsl",
+          "<xsl:stylesheet version='1.0' xmlns:xsl='http://www.w3.org/1999/XSL/Transform'>\n"
+          "  <xsl:import href='BatchTestImported.xsl'/>\n"
+          "  <xsl:output method='text'/>\n"
+          "  <xsl:key name='k' match='item' use='@type'/>\n"
+          "  <xsl:template match='/'><xsl:value-of select='count(key(\"k\", \"a\"))'/>:<xsl:apply-templates select='list'/></xsl:template>\n"
+          "  <xsl:template match='list'>[<xsl:apply-imports/>]</xsl:template>\n"
+          "  <xsl:template match='list[@fail]'><xsl:message terminate='yes'>failed</xsl:message></xsl:template>\n"
+          "</xsl:stylesheet>\n");
+    for(int i = 0; i != Inputs; ++i)
+      write(name(i, ".xml"), input(i));
+    write("BatchTestFails.xml", "<list name='f' fail='yes'><item type='a'/></list>");
+    write("BatchTestBroken.xml", "<list name='b'><item type='a'></list>");
+  } // setUp
+
+  void tearDown()
+  {
+    for(int i = 0; i != Inputs; ++i)
+    {
+      std::remove(name(i, ".xml").c_str());
+      std::remove(name(i, ".out").c_str());
+    } // for ...
+    const char* files[] = { "BatchTestImported.xsl", "BatchTest.xsl", "BatchTestFails.xml", "BatchTestFails.out",
+                            "BatchTestBroken.xml", "BatchTestBroken.out", 0 };
+    for(const char** f = files; *f; ++f)
+      std::remove(*f);
+  } // tearDown
+
+  void testBatch()
+  {
+    std::auto_ptr<StylesheetT> stylesheet = compile();
+    std::vector<string_type> inputs;
+    for(int i = 0; i != Inputs; ++i)
+      inputs.push_back(SA::construct_from_utf8(name(i, ".xml").c_str()));
+
+    BatchTransformerT batch(*stylesheet);
+    batch.set_threads(4);
+    batch.set_queue_size(3);
+    ostringstreamT errors;
+    batch.set_error_output(errors);
+    StringSinkFactory sinks(inputs.size());
+    Arabica::XSLT::BatchResults results = batch.transform(inputs.begin(), inputs.end(), sinks);
+
+    assertEquals(Inputs, results.documents());
+    assertEquals(0, results.failures());
+    assertEquals(Inputs, results.latencies().size());
+    assertTrue(results.percentile(0) <= results.percentile(1));
+    for(int i = 0; i != Inputs; ++i)
+      assertEquals(expected(i), sinks.output(i));
+    assertEquals("", SA::asStdString(SA::construct(errors.str())));
+  } // testBatch
+
+  void testFailures()
+  {
+    std::auto_ptr<StylesheetT> stylesheet = compile();
+    std::vector<string_type> inputs;
+    inputs.push_back(SA::construct_from_utf8(name(0, ".xml").c_str()));
+    inputs.push_back(SA::construct_from_utf8("BatchTestBroken.xml"));
+    inputs.push_back(SA::construct_from_utf8("BatchTestFails.xml"));
+    inputs.push_back(SA::construct_from_utf8("BatchTestMissing.xml"));
+    inputs.push_back(SA::construct_from_utf8(name(1, ".xml").c_str()));
+
+    BatchTransformerT batch(*stylesheet);
+    batch.set_threads(2);
+    ostringstreamT errors;
+    batch.set_error_output(errors);
+    StringSinkFactory sinks(inputs.size());
+    Arabica::XSLT::BatchResults results = batch.transform(inputs.begin(), inputs.end(), sinks);
+
+    assertEquals(5, results.documents());
+    assertEquals(3, results.failures());
+    assertEquals(5, results.latencies().size());
+    assertEquals(expected(0), sinks.output(0));
+    assertEquals(expected(1), sinks.output(4));
+
+    std::string messages = SA::asStdString(SA::construct(errors.str()));
+    assertTrue(messages.find("BatchTestBroken.xml: ") != std::string::npos);
+    assertTrue(messages.find("BatchTestFails.xml: ") != std::string::npos);
+    assertTrue(messages.find("BatchTestMissing.xml: ") != std::string::npos);
+    assertTrue(messages.find(name(0, ".xml")) == std::string::npos);
+  } // testFailures
+
+  void testDirectorySinkFactory()
+  {
+    std::auto_ptr<StylesheetT> stylesheet = compile();
+    std::vector<string_type> inputs;
+    inputs.push_back(SA::construct_from_utf8(name(2, ".xml").c_str()));
+    inputs.push_back(SA::construct_from_utf8("BatchTestFails.xml"));
+
+    BatchTransformerT batch(*stylesheet);
+    batch.set_threads(1);
+    ostringstreamT errors;
+    batch.set_error_output(errors);
+    Arabica::XSLT::DirectorySinkFactory<string_type, string_adaptor> sinks("", ".out");
+    assertEquals("dir/BatchTest2.out", Arabica::XSLT::DirectorySinkFactory<string_type, string_adaptor>("dir", ".out").path("in/BatchTest2.xml"));
+    Arabica::XSLT::BatchResults results = batch.transform(inputs.begin(), inputs.end(), sinks);
+
+    assertEquals(1, results.failures());
+    assertEquals(expected(2), read(name(2, ".out")));
+    // the failed transformation's output is opened, then removed
+    std::ifstream failed("BatchTestFails.out");
+    assertFalse(failed.is_open());
+  } // testDirectorySinkFactory
+
+  void testSharedStylesheet()
+  {
+    std::auto_ptr<StylesheetT> stylesheet = compile();
+    bool ok[2] = { false, false };
+    std::thread first(&BatchTest::transformRepeatedly, stylesheet.get(), 3, &ok[0]);
+    std::thread second(&BatchTest::transformRepeatedly, stylesheet.get(), 7, &ok[1]);
+    first.join();
+    second.join();
+    assertTrue(ok[0]);
+    assertTrue(ok[1]);
+  } // testSharedStylesheet
+
+private:
+  enum { Inputs = 12 };
+
+  // keeps each result in memory, by the input's index
+  class StringSinkFactory : public Arabica::XSLT::SinkFactory<string_type, string_adaptor>
+  {
+  public:
+    StringSinkFactory(size_t inputs) : outputs_(inputs) { }
+
+    virtual Arabica::XSLT::Sink<string_type, string_adaptor>* open(const string_type& /* systemId */, size_t index)
+    {
+      return new Arabica::XSLT::StreamSink<string_type, string_adaptor>(outputs_[index]);
+    } // open
+
+    std::string output(size_t index) const
+    {
+      return SA::asStdString(SA::construct(outputs_[index].str()));
+    } // output
+
+  private:
+    std::vector<ostringstreamT> outputs_;
+  }; // class StringSinkFactory
+
+  // each thread checks its own results, as a failed assertion can't be
+  // thrown from one
+  static void transformRepeatedly(const StylesheetT* stylesheet, int i, bool* ok)
+  {
+    try
+    {
+      Arabica::DOM::Document<string_type, string_adaptor> document = buildDOMFromString<string_type, string_adaptor>(input(i));
+      for(int run = 0; run != 200; ++run)
+      {
+        ostringstreamT output;
+        ostringstreamT errors;
+        Arabica::XSLT::StreamSink<string_type, string_adaptor> sink(output);
+        stylesheet->execute(document, sink, errors);
+        if(SA::asStdString(SA::construct(output.str())) != expected(i))
+          return;
+      } // for ...
+      *ok = true;
+    } // try
+    catch(const std::exception&)
+    {
+    } // catch
+  } // transformRepeatedly
+
+  std::auto_ptr<StylesheetT> compile()
+  {
+    Arabica::XSLT::StylesheetCompiler<string_type, string_adaptor> compiler;
+    Arabica::SAX::InputSource<string_type, string_adaptor> source(SA::construct_from_utf8("BatchTest.xsl"));
+    std::auto_ptr<StylesheetT> stylesheet = compiler.compile(source);
+    if(stylesheet.get() == 0)
+      assertImplementation(false, "Failed to compile : " + compiler.error());
+    return stylesheet;
+  } // compile
+
+  static std::string name(int i, const char* extension)
+  {
+    std::ostringstream n;
+    n << "BatchTest" << i << extension;
+    return n.str();
+  } // name
+
+  // i items of type a, and one of type b
+  static std::string input(int i)
+  {
+    std::ostringstream xml;
+    xml << "<list name='n" << i << "'><item type='b'/>";
+    for(int a = 0; a != i; ++a)
+      xml << "<item type='a'/>";
+    xml << "</list>";
+    return xml.str();
+  } // input
+
+  static std::string expected(int i)
+  {
+    std::ostringstream e;
+    e << i << ":[n" << i << "]";
+    return e.str();
+  } // expected
+
+  static void write(const std::string& filename, const std::string& content)
+  {
+    std::ofstream file(filename.c_str());
+    file << content;
+  } // write
+
+  static std::string read(const std::string& filename)
+  {
+    std::ifstream file(filename.c_str());
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  } // read
+}; // class BatchTest
+
+template<class string_type, class string_adaptor>
+TestSuite* BatchTest_suite()
+{
+  TestSuite *suiteOfTests = new TestSuite;
+
+  suiteOfTests->addTest(new TestCaller<BatchTest<string_type, string_adaptor> >("testBatch", &BatchTest<string_type, string_adaptor>::testBatch));
+  suiteOfTests->addTest(new TestCaller<BatchTest<string_type, string_adaptor> >("testFailures", &BatchTest<string_type, string_adaptor>::testFailures));
+  suiteOfTests->addTest(new TestCaller<BatchTest<string_type, string_adaptor> >("testDirectorySinkFactory", &BatchTest<string_type, string_adaptor>::testDirectorySinkFactory));
+  suiteOfTests->addTest(new TestCaller<BatchTest<string_type, string_adaptor> >("testSharedStylesheet", &BatchTest<string_type, string_adaptor>::testSharedStylesheet));
+
+  return suiteOfTests;
+} // BatchTest_suite
+
+#endif
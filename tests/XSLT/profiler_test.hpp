@@ -0,0 +1,162 @@
+#ifndef XSLT_PROFILER_TEST_HPP
+#define XSLT_PROFILER_TEST_HPP
+
+template<class string_type, class string_adaptor>
+class ProfilerTest : public TestCase
+{
+  typedef Arabica::XSLT::Profiler Profiler;
+  typedef Profiler::Entry Entry;
+
+public:
+  ProfilerTest(std::string name) : TestCase(name)
+  {
+  } // ProfilerTest
+
+  void testCounts()
+  {
+    Profiler profiler;
+    run(profiler, 1);
+
+    assertEquals(1, find(profiler, "template", "match=\"/\"").calls);
+    assertEquals(3, find(profiler, "template", "match=\"item\"").calls);
+    assertEquals(1, find(profiler, "apply-templates", "select=\"list/item\"").calls);
+    assertEquals(3, find(profiler, "apply-templates", "select=\"list/item\"").nodes);
+    assertEquals(1, find(profiler, "for-each", "select=\"list/item\"").calls);
+    assertEquals(3, find(profiler, "for-each", "select=\"list/item\"").nodes);
+    assertEquals(1, find(profiler, "sort", "select=\"@id\"").calls);
+    assertEquals(3, find(profiler, "sort", "select=\"@id\"").nodes);
+    assertEquals(3, find(profiler, "value-of", "select=\".\"").calls);
+    assertEquals(3, find(profiler, "value-of", "select=\"@id\"").calls);
+    // the key is looked up twice, but only indexed once
+    assertEquals(2, find(profiler, "key", "name=\"k\"").calls);
+    assertTrue(find(profiler, "key", "name=\"k\"").nodes >= 5);
+  } // testCounts
+
+  void testTimes()
+  {
+    Profiler profiler;
+    run(profiler, 1);
+
+    const Entry& root = find(profiler, "template", "match=\"/\"");
+    const Entry& apply = find(profiler, "apply-templates", "select=\"list/item\"");
+    const Entry& item = find(profiler, "template", "match=\"item\"");
+    assertTrue(root.inclusive >= root.exclusive);
+    assertTrue(root.inclusive >= apply.inclusive);
+    assertTrue(apply.inclusive >= item.inclusive);
+
+    long long exclusive = 0;
+    for(size_t e = 0; e != profiler.entries().size(); ++e)
+      exclusive += profiler.entries()[e].exclusive;
+    assertTrue(root.inclusive >= exclusive);
+  } // testTimes
+
+  void testLocations()
+  {
+    Profiler profiler;
+    run(profiler, 1);
+
+    assertEquals(3, find(profiler, "template", "match=\"/\"").site.line);
+    assertEquals(4, find(profiler, "apply-templates", "select=\"list/item\"").site.line);
+    assertEquals(9, find(profiler, "template", "match=\"item\"").site.line);
+  } // testLocations
+
+  void testAccumulates()
+  {
+    Profiler profiler;
+    run(profiler, 2);
+    assertEquals(2, find(profiler, "template", "match=\"/\"").calls);
+    assertEquals(6, find(profiler, "template", "match=\"item\"").calls);
+
+    profiler.reset();
+    assertEquals(0, profiler.entries().size());
+  } // testAccumulates
+
+  void testCSV()
+  {
+    Profiler profiler;
+    run(profiler, 1);
+
+    std::ostringstream csv;
+    profiler.write_csv(csv);
+
+    std::vector<std::string> lines;
+    std::istringstream is(csv.str());
+    for(std::string line; std::getline(is, line); )
+      lines.push_back(line.substr(0, line.find(",,")));
+
+    assertEquals(profiler.entries().size() + 1, lines.size());
+    assertEquals("kind,description,mode,stylesheet,line,calls,nodes,inclusive_us,exclusive_us", lines[0]);
+    // in stylesheet order
+    assertEquals("key,\"name=\"\"k\"\"\"", lines[1]);
+    assertEquals("template,\"match=\"\"/\"\"\"", lines[2]);
+    assertEquals("apply-templates,\"select=\"\"list/item\"\"\"", lines[3]);
+  } // testCSV
+
+  void testReport()
+  {
+    Profiler profiler;
+    run(profiler, 1);
+
+    std::ostringstream report;
+    profiler.report(report);
+    assertTrue(report.str().find("template match=\"item\"") != std::string::npos);
+    assertTrue(report.str().find("total\n") != std::string::npos);
+  } // testReport
+
+private:
+  void run(Profiler& profiler, int times)
+  {
+    std::stringstream xslt;
+    xslt << "<xsl:stylesheet version='1.0' xmlns:xsl='http://www.w3.org/1999/XSL/Transform'>\n"
+         << "  <xsl:key name='k' match='item' use='@id'/>\n"
+         << "  <xsl:template match='/'>\n"
+         << "    <xsl:apply-templates select='list/item'/>\n"
+         << "    <xsl:for-each select='list/item'><xsl:sort select='@id'/><xsl:value-of select='.'/></xsl:for-each>\n"
+         << "    <xsl:copy-of select='key(\"k\", \"2\")'/>\n"
+         << "    <xsl:copy-of select='key(\"k\", \"3\")'/>\n"
+         << "  </xsl:template>\n"
+         << "  <xsl:template match='item'><xsl:value-of select='@id'/></xsl:template>\n"
+         << "</xsl:stylesheet>\n";
+
+    Arabica::XSLT::StylesheetCompiler<string_type, string_adaptor> compiler;
+    Arabica::SAX::InputSource<string_type, string_adaptor> source(xslt);
+    std::auto_ptr<Arabica::XSLT::Stylesheet<string_type, string_adaptor> > stylesheet = compiler.compile(source);
+    if(stylesheet.get() == 0)
+      assertImplementation(false, "Failed to compile : " + compiler.error());
+
+    Arabica::XSLT::DOMSink<string_type, string_adaptor> output;
+    stylesheet->set_output(output);
+    stylesheet->set_profiler(&profiler);
+
+    Arabica::DOM::Document<string_type, string_adaptor> document =
+      buildDOMFromString<string_type, string_adaptor>("<list><item id='3'>c</item><item id='1'>a</item><item id='2'>b</item></list>");
+    for(int t = 0; t != times; ++t)
+      stylesheet->execute(document);
+  } // run
+
+  const Entry& find(const Profiler& profiler, const std::string& kind, const std::string& description)
+  {
+    for(size_t e = 0; e != profiler.entries().size(); ++e)
+      if(profiler.entries()[e].kind == kind && profiler.entries()[e].site.description == description)
+        return profiler.entries()[e];
+    assertImplementation(false, "No " + kind + " " + description + " profiled");
+    return profiler.entries()[0];
+  } // find
+}; // class ProfilerTest
+
+template<class string_type, class string_adaptor>
+TestSuite* ProfilerTest_suite()
+{
+  TestSuite *suiteOfTests = new TestSuite;
+
+  suiteOfTests->addTest(new TestCaller<ProfilerTest<string_type, string_adaptor> >("testCounts", &ProfilerTest<string_type, string_adaptor>::testCounts));
+  suiteOfTests->addTest(new TestCaller<ProfilerTest<string_type, string_adaptor> >("testTimes", &ProfilerTest<string_type, string_adaptor>::testTimes));
+  suiteOfTests->addTest(new TestCaller<ProfilerTest<string_type, string_adaptor> >("testLocations", &ProfilerTest<string_type, string_adaptor>::testLocations));
+  suiteOfTests->addTest(new TestCaller<ProfilerTest<string_type, string_adaptor> >("testAccumulates", &ProfilerTest<string_type, string_adaptor>::testAccumulates));
+  suiteOfTests->addTest(new TestCaller<ProfilerTest<string_type, string_adaptor> >("testCSV", &ProfilerTest<string_type, string_adaptor>::testCSV));
+  suiteOfTests->addTest(new TestCaller<ProfilerTest<string_type, string_adaptor> >("testReport", &ProfilerTest<string_type, string_adaptor>::testReport));
+
+  return suiteOfTests;
+} // ProfilerTest_suite
+
+#endif
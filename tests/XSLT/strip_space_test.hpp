@@ -0,0 +1,260 @@
+#ifndef XSLT_STRIP_SPACE_TEST_HPP
+#define XSLT_STRIP_SPACE_TEST_HPP
+
+// in describe's output, elements are name(children), text is 'text' and
+// CDATA sections are [text]
+template<class string_type, class string_adaptor>
+class StripSpaceTest : public TestCase
+{
+  typedef string_adaptor SA;
+  typedef Arabica::XSLT::WhitespaceRules<string_type, string_adaptor> Rules;
+  typedef Arabica::XSLT::Stylesheet<string_type, string_adaptor> StylesheetT;
+  typedef Arabica::DOM::Node<string_type, string_adaptor> DOMNode;
+  typedef Arabica::DOM::Document<string_type, string_adaptor> DOMDocument;
+
+public:
+  StripSpaceTest(std::string name) : TestCase(name)
+  {
+  } // StripSpaceTest
+
+  void testNameTests()
+  {
+    Rules rules;
+    assertFalse(rules.strips());
+    rules.add(S(""), S("pre"), false, false, Precedence::InitialPrecedence());
+    assertFalse(rules.strips());
+
+    rules.add(S(""), S("*"), true, true, Precedence::InitialPrecedence());
+    rules.add(S("urn:x"), S("*"), false, false, Precedence::InitialPrecedence());
+    assertTrue(rules.strips());
+    assertTrue(rules.strips(S(""), S("div")));
+    assertFalse(rules.strips(S(""), S("pre")));
+    assertFalse(rules.strips(S("urn:x"), S("div")));
+    assertTrue(rules.strips(S("urn:y"), S("pre")));
+  } // testNameTests
+
+  void testLastDeclaredWins()
+  {
+    Rules rules;
+    rules.add(S(""), S("p"), false, true, Precedence::InitialPrecedence());
+    rules.add(S(""), S("p"), false, false, Precedence::InitialPrecedence());
+    rules.add(S(""), S("q"), false, false, Precedence::InitialPrecedence());
+    rules.add(S(""), S("q"), false, true, Precedence::InitialPrecedence());
+    assertFalse(rules.strips(S(""), S("p")));
+    assertTrue(rules.strips(S(""), S("q")));
+  } // testLastDeclaredWins
+
+  void testImportPrecedence()
+  {
+    Precedence main(Precedence::InitialPrecedence());
+    Precedence first = main.next_generation();
+    Precedence second = main.next_generation();
+
+    // a vaguer name test in the importing stylesheet beats an exact one
+    // in an imported stylesheet, whatever order they're declared in
+    Rules rules;
+    rules.add(S(""), S("*"), true, false, main);
+    rules.add(S(""), S("p"), false, true, first);
+    assertFalse(rules.strips(S(""), S("p")));
+
+    Rules reversed;
+    reversed.add(S(""), S("p"), false, true, first);
+    reversed.add(S(""), S("*"), true, false, main);
+    assertFalse(reversed.strips(S(""), S("p")));
+
+    // and a later import beats an earlier one
+    Rules imports;
+    imports.add(S(""), S("p"), false, true, second);
+    imports.add(S(""), S("p"), false, false, first);
+    assertTrue(imports.strips(S(""), S("p")));
+  } // testImportPrecedence
+
+  void testStrip()
+  {
+    std::auto_ptr<StylesheetT> stylesheet = compile();
+    DOMDocument document = buildDOMFromString<string_type, string_adaptor>(input());
+    stylesheet->strip_whitespace(document);
+    assertEquals(stripped(), describe(document));
+  } // testStrip
+
+  void testStripFromElement()
+  {
+    std::auto_ptr<StylesheetT> stylesheet = compile();
+    DOMDocument document = buildDOMFromString<string_type, string_adaptor>(input());
+    stylesheet->strip_whitespace(document.getDocumentElement().getFirstChild());
+    assertEquals(stripped(), describe(document));
+  } // testStripFromElement
+
+  void testFilter()
+  {
+    std::auto_ptr<StylesheetT> stylesheet = compile();
+    std::stringstream ss;
+    ss << input();
+    Arabica::SAX::InputSource<string_type, string_adaptor> is(ss);
+    Arabica::XSLT::StripSpaceFilter<string_type, string_adaptor> stripper(*stylesheet);
+    Arabica::SAX2DOM::Parser<string_type, string_adaptor> parser;
+    parser.setFilter(stripper);
+    parser.parse(is);
+    assertEquals(stripped(), describe(parser.getDocument()));
+  } // testFilter
+
+  void testFilterStripsNothingElse()
+  {
+    std::auto_ptr<StylesheetT> stylesheet = compile();
+    std::stringstream ss;
+    ss << "<r><!-- c --> <?pi d?> <a> x <b/> </a> <![CDATA[]]> </r>";
+    Arabica::SAX::InputSource<string_type, string_adaptor> is(ss);
+    Arabica::XSLT::StripSpaceFilter<string_type, string_adaptor> stripper(*stylesheet);
+    Arabica::SAX2DOM::Parser<string_type, string_adaptor> parser;
+    parser.setFilter(stripper);
+    parser.parse(is);
+    assertEquals("r(#comment#pia(' x 'b()))", describe(parser.getDocument()));
+  } // testFilterStripsNothingElse
+
+  void testExecuteStrips()
+  {
+    std::auto_ptr<StylesheetT> stylesheet = compile();
+    DOMDocument document = buildDOMFromString<string_type, string_adaptor>(input());
+    assertEquals("'7'", execute(*stylesheet, document));
+    // from the element, the built-in templates copy out the text left
+    assertEquals("'      x  '", execute(*stylesheet, document.getDocumentElement()));
+  } // testExecuteStrips
+
+  void testExecuteLeavesInputAlone()
+  {
+    std::auto_ptr<StylesheetT> stylesheet = compile();
+    DOMDocument document = buildDOMFromString<string_type, string_adaptor>(input());
+    std::string unstripped = describe(document);
+    DOMNode first = document.getDocumentElement().getFirstChild();
+
+    execute(*stylesheet, document);
+    assertEquals(unstripped, describe(document));
+    assertTrue(first == document.getDocumentElement().getFirstChild());
+
+    stylesheet->strip_whitespace(document);
+    assertEquals(stripped(), describe(document));
+    assertEquals("'7'", execute(*stylesheet, document));
+    assertEquals(stripped(), describe(document));
+  } // testExecuteLeavesInputAlone
+
+  void testExecuteRestoresAfterError()
+  {
+    std::stringstream xslt;
+    xslt << "<xsl:stylesheet version='1.0' xmlns:xsl='http://www.w3.org/1999/XSL/Transform'>\n"
+         << "  <xsl:strip-space elements='*'/>\n"
+         << "  <xsl:template match='/'><xsl:message terminate='yes'>stop</xsl:message></xsl:template>\n"
+         << "</xsl:stylesheet>\n";
+    Arabica::XSLT::StylesheetCompiler<string_type, string_adaptor> compiler;
+    Arabica::SAX::InputSource<string_type, string_adaptor> source(xslt);
+    std::auto_ptr<StylesheetT> stylesheet = compiler.compile(source);
+    assertTrue(stylesheet.get() != 0);
+
+    DOMDocument document = buildDOMFromString<string_type, string_adaptor>(input());
+    std::string unstripped = describe(document);
+    bool threw = false;
+    try
+    {
+      execute(*stylesheet, document);
+    }
+    catch(const Arabica::SAX::SAXException&)
+    {
+      threw = true;
+    } // catch
+    assertTrue(threw);
+    assertEquals(unstripped, describe(document));
+  } // testExecuteRestoresAfterError
+
+private:
+  static std::string execute(const StylesheetT& stylesheet, const DOMNode& node)
+  {
+    Arabica::XSLT::DOMSink<string_type, string_adaptor> output;
+    std::basic_ostringstream<typename string_adaptor::value_type> errors;
+    stylesheet.execute(node, output, errors);
+    return describe(output.node());
+  } // execute
+
+  static string_type S(const char* str)
+  {
+    return SA::construct_from_utf8(str);
+  } // S
+
+  std::auto_ptr<StylesheetT> compile()
+  {
+    std::stringstream xslt;
+    xslt << "<xsl:stylesheet version='1.0' xmlns:xsl='http://www.w3.org/1999/XSL/Transform' xmlns:x='urn:x'>\n"
+         << "  <xsl:strip-space elements='*'/>\n"
+         << "  <xsl:preserve-space elements='pre x:*'/>\n"
+         << "  <xsl:template match='/'><xsl:value-of select='count(//text())'/></xsl:template>\n"
+         << "</xsl:stylesheet>\n";
+
+    Arabica::XSLT::StylesheetCompiler<string_type, string_adaptor> compiler;
+    Arabica::SAX::InputSource<string_type, string_adaptor> source(xslt);
+    std::auto_ptr<StylesheetT> stylesheet = compiler.compile(source);
+    if(stylesheet.get() == 0)
+      assertImplementation(false, "Failed to compile : " + compiler.error());
+    return stylesheet;
+  } // compile
+
+  static std::string input()
+  {
+    return "<r> <a> </a> <pre> </pre> "
+           "<b xml:space='preserve'> <c> </c> <d xml:space='default'> </d> </b> "
+           "<e> <![CDATA[ ]]> </e> <f> <![CDATA[x]]> </f> "
+           "<x:g xmlns:x='urn:x'> </x:g> </r>";
+  } // input
+
+  // xml:space, x:* and pre keep their whitespace, and text and CDATA
+  // sections next to each other are kept or stripped together
+  static std::string stripped()
+  {
+    return "r(a()pre(' ')b(' 'c(' ')' 'd()' ')e()f(' '[x]' ')g(' '))";
+  } // stripped
+
+  static std::string describe(const DOMNode& node)
+  {
+    switch(node.getNodeType())
+    {
+      case Arabica::DOM::Node_base::ELEMENT_NODE:
+        return SA::asStdString(node.getLocalName()) + "(" + describeChildren(node) + ")";
+      case Arabica::DOM::Node_base::TEXT_NODE:
+        return "'" + SA::asStdString(node.getNodeValue()) + "'";
+      case Arabica::DOM::Node_base::CDATA_SECTION_NODE:
+        return "[" + SA::asStdString(node.getNodeValue()) + "]";
+      case Arabica::DOM::Node_base::COMMENT_NODE:
+        return "#comment";
+      case Arabica::DOM::Node_base::PROCESSING_INSTRUCTION_NODE:
+        return "#pi";
+      default:
+        return describeChildren(node);
+    } // switch
+  } // describe
+
+  static std::string describeChildren(const DOMNode& node)
+  {
+    std::string description;
+    for(DOMNode child = node.getFirstChild(); child != 0; child = child.getNextSibling())
+      description += describe(child);
+    return description;
+  } // describeChildren
+}; // class StripSpaceTest
+
+template<class string_type, class string_adaptor>
+TestSuite* StripSpaceTest_suite()
+{
+  TestSuite *suiteOfTests = new TestSuite;
+
+  suiteOfTests->addTest(new TestCaller<StripSpaceTest<string_type, string_adaptor> >("testNameTests", &StripSpaceTest<string_type, string_adaptor>::testNameTests));
+  suiteOfTests->addTest(new TestCaller<StripSpaceTest<string_type, string_adaptor> >("testLastDeclaredWins", &StripSpaceTest<string_type, string_adaptor>::testLastDeclaredWins));
+  suiteOfTests->addTest(new TestCaller<StripSpaceTest<string_type, string_adaptor> >("testImportPrecedence", &StripSpaceTest<string_type, string_adaptor>::testImportPrecedence));
+  suiteOfTests->addTest(new TestCaller<StripSpaceTest<string_type, string_adaptor> >("testStrip", &StripSpaceTest<string_type, string_adaptor>::testStrip));
+  suiteOfTests->addTest(new TestCaller<StripSpaceTest<string_type, string_adaptor> >("testStripFromElement", &StripSpaceTest<string_type, string_adaptor>::testStripFromElement));
+  suiteOfTests->addTest(new TestCaller<StripSpaceTest<string_type, string_adaptor> >("testFilter", &StripSpaceTest<string_type, string_adaptor>::testFilter));
+  suiteOfTests->addTest(new TestCaller<StripSpaceTest<string_type, string_adaptor> >("testFilterStripsNothingElse", &StripSpaceTest<string_type, string_adaptor>::testFilterStripsNothingElse));
+  suiteOfTests->addTest(new TestCaller<StripSpaceTest<string_type, string_adaptor> >("testExecuteStrips", &StripSpaceTest<string_type, string_adaptor>::testExecuteStrips));
+  suiteOfTests->addTest(new TestCaller<StripSpaceTest<string_type, string_adaptor> >("testExecuteLeavesInputAlone", &StripSpaceTest<string_type, string_adaptor>::testExecuteLeavesInputAlone));
+  suiteOfTests->addTest(new TestCaller<StripSpaceTest<string_type, string_adaptor> >("testExecuteRestoresAfterError", &StripSpaceTest<string_type, string_adaptor>::testExecuteRestoresAfterError));
+
+  return suiteOfTests;
+} // StripSpaceTest_suite
+
+#endif
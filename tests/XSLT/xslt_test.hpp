@@ -11,6 +11,7 @@
 #include "../CppUnit/framework/Test.h"
 #include "../CppUnit/framework/TestCase.h"
 #include "../CppUnit/framework/TestSuite.h"
+#include "../CppUnit/framework/TestCaller.h"
 
 #include "../CppUnit/framework/Test.h"
 #include "../CppUnit/framework/TestCase.h"
@@ -725,6 +726,10 @@ TestSuite* Loader<string_type, string_adaptor>::ArabicaTest_suite(const std::str
   return suite(path, "arabica-catalog.xml");
 } // ArabicaTest_suite
 
+#include "profiler_test.hpp"
+#include "strip_space_test.hpp"
+#include "batch_test.hpp"
+
 std::set<std::string> parse_tests_to_run(int argc, const char* argv[]);
 
 template<class string_type, class string_adaptor>
@@ -761,6 +766,12 @@ bool XSLT_test_suite(int argc, const char* argv[])
   std::set<std::string> tests_to_run = parse_tests_to_run(argc, argv);
 
   // runner.addTest("ScopeTest", ScopeTest_suite<string_type, string_adaptor>());
+  if(tests_to_run.empty() || (tests_to_run.find("ProfilerTest") != tests_to_run.end()))
+    runner.addTest("ProfilerTest", ProfilerTest_suite<string_type, string_adaptor>());
+  if(tests_to_run.empty() || (tests_to_run.find("StripSpaceTest") != tests_to_run.end()))
+    runner.addTest("StripSpaceTest", StripSpaceTest_suite<string_type, string_adaptor>());
+  if(tests_to_run.empty() || (tests_to_run.find("BatchTest") != tests_to_run.end()))
+    runner.addTest("BatchTest", BatchTest_suite<string_type, string_adaptor>());
 
   Loader<string_type, string_adaptor> loader;
 